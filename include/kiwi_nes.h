@@ -21,9 +21,11 @@
 #include "base/strings/string_util.h"
 #include "base/strings/stringprintf.h"
 #include "base/task/single_thread_task_executor.h"
+#include "base/task/thread_pool.h"
 #include "nes/debug/debug_port.h"
 #include "nes/debug/disassembly.h"
 #include "nes/emulator.h"
+#include "nes/emulator_batch.h"
 #include "nes/io_devices.h"
 #include "nes/mapper.h"
 #include "nes/palette.h"
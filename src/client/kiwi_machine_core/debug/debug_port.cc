@@ -66,7 +66,8 @@ DebugPortObserver::DebugPortObserver() = default;
 DebugPortObserver::~DebugPortObserver() = default;
 void DebugPortObserver::OnFrameEnd(int since_last_frame_duration_ms,
                                    int cpu_last_frame_duration_ms,
-                                   int ppu_last_frame_duration_ms) {}
+                                   int ppu_last_frame_duration_ms,
+                                   int run_ahead_last_frame_duration_ms) {}
 
 DebugPort::DebugPort(kiwi::nes::Emulator* emulator) : Base(emulator) {}
 DebugPort::~DebugPort() = default;
@@ -79,7 +80,8 @@ void DebugPort::OnFrameEnd() {
     observer->OnFrameEnd(
         frame_duration_ms,
         performance_counter().CPUDurationPerFrameInMilliseconds(),
-        performance_counter().PPUDurationPerFrameInMilliseconds());
+        performance_counter().PPUDurationPerFrameInMilliseconds(),
+        performance_counter().RunAheadDurationPerFrameInMilliseconds());
   }
 }
 
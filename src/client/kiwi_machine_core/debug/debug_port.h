@@ -27,7 +27,8 @@ class DebugPortObserver {
  public:
   virtual void OnFrameEnd(int since_last_frame_duration_ms,
                           int cpu_last_frame_duration_ms,
-                          int ppu_last_frame_duration_ms);
+                          int ppu_last_frame_duration_ms,
+                          int run_ahead_last_frame_duration_ms);
 };
 
 class DebugPort : public kiwi::nes::DebugPort {
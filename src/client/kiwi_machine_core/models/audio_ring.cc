@@ -0,0 +1,134 @@
+// Copyright (C) 2026 Yisi Yu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#include "models/audio_ring.h"
+
+#include <SDL.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+// Gains of the rate control, per frame, for the latency off the target by
+// the target. The proportional term reacts first, and the integral term
+// slowly takes over cancelling the drift, in less than half a minute.
+constexpr double kProportionalGain = 0.01;
+constexpr double kIntegralGain = 0.00002;
+}  // namespace
+
+AudioRing::AudioRing(size_t capacity)
+    : buffer_(capacity), mask_(capacity - 1) {
+  SDL_assert(capacity > 0 && (capacity & mask_) == 0);
+}
+
+AudioRing::~AudioRing() = default;
+
+void AudioRing::set_target_latency(size_t samples) {
+  target_latency_.store(std::min(samples, capacity()),
+                        std::memory_order_relaxed);
+}
+
+size_t AudioRing::Write(const kiwi::nes::Sample* samples, size_t count) {
+  size_t write_position = write_position_.load(std::memory_order_relaxed);
+  size_t read_position = read_position_.load(std::memory_order_acquire);
+  size_t space = capacity() - (write_position - read_position);
+  size_t written = std::min(count, space);
+  if (written < count) {
+    dropped_samples_.fetch_add(count - written, std::memory_order_relaxed);
+  }
+
+  size_t offset = write_position & mask_;
+  size_t first = std::min(written, capacity() - offset);
+  memcpy(buffer_.data() + offset, samples, first * sizeof(kiwi::nes::Sample));
+  memcpy(buffer_.data(), samples + first,
+         (written - first) * sizeof(kiwi::nes::Sample));
+
+  write_position_.store(write_position + written, std::memory_order_release);
+  return written;
+}
+
+double AudioRing::UpdateRateRatio() {
+  size_t target = target_latency_.load(std::memory_order_relaxed);
+  if (!target)
+    return 1.0;
+
+  size_t write_position = write_position_.load(std::memory_order_relaxed);
+  size_t read_position = read_position_.load(std::memory_order_acquire);
+  double error = std::clamp(
+      (static_cast<double>(target) - (write_position - read_position)) /
+          target,
+      -1.0, 1.0);
+  rate_drift_ = std::clamp(rate_drift_ + kIntegralGain * error,
+                           -kMaxRateDelta, kMaxRateDelta);
+  double ratio =
+      1.0 + std::clamp(kProportionalGain * error + rate_drift_, -kMaxRateDelta,
+                       kMaxRateDelta);
+  rate_ratio_.store(ratio, std::memory_order_relaxed);
+  return ratio;
+}
+
+void AudioRing::Read(kiwi::nes::Sample* samples, size_t count) {
+  size_t read_position = read_position_.load(std::memory_order_relaxed);
+  size_t write_position = write_position_.load(std::memory_order_acquire);
+  size_t available = write_position - read_position;
+
+  // If twice the target would be left after this read, the writer is so far
+  // ahead that the rate control would take long to catch up, such as after
+  // a hitch. The oldest samples are skipped, down to the target.
+  size_t target = target_latency_.load(std::memory_order_relaxed);
+  size_t limit = target + count;
+  if (available > limit + target) {
+    dropped_samples_.fetch_add(available - limit, std::memory_order_relaxed);
+    read_position = write_position - limit;
+    available = limit;
+  }
+  latency_.store(available, std::memory_order_relaxed);
+
+  size_t read = std::min(count, available);
+  size_t offset = read_position & mask_;
+  size_t first = std::min(read, capacity() - offset);
+  memcpy(samples, buffer_.data() + offset, first * sizeof(kiwi::nes::Sample));
+  memcpy(samples + first, buffer_.data(),
+         (read - first) * sizeof(kiwi::nes::Sample));
+  read_position_.store(read_position + read, std::memory_order_release);
+
+  if (read > 0)
+    last_sample_ = samples[read - 1];
+
+  if (read < count) {
+    // Holding the last sample, rather than dropping to silence, avoids a
+    // click when samples come back.
+    std::fill(samples + read, samples + count, last_sample_);
+    if (!starving_)
+      underruns_.fetch_add(1, std::memory_order_relaxed);
+    starving_ = true;
+  } else {
+    starving_ = false;
+  }
+}
+
+void AudioRing::Clear() {
+  read_position_.store(write_position_.load(std::memory_order_relaxed),
+                       std::memory_order_relaxed);
+  starving_ = true;
+  last_sample_ = 0;
+  latency_.store(0, std::memory_order_relaxed);
+}
+
+AudioRing::Stats AudioRing::GetStats() const {
+  Stats stats;
+  stats.latency = latency_.load(std::memory_order_relaxed);
+  stats.underruns = underruns_.load(std::memory_order_relaxed);
+  stats.dropped_samples = dropped_samples_.load(std::memory_order_relaxed);
+  stats.rate_ratio = rate_ratio_.load(std::memory_order_relaxed);
+  return stats;
+}
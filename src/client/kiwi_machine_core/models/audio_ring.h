@@ -0,0 +1,106 @@
+// Copyright (C) 2026 Yisi Yu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#ifndef MODELS_AUDIO_RING_H_
+#define MODELS_AUDIO_RING_H_
+
+#include <kiwi_nes.h>
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+// AudioRing passes samples from the emulator, which writes a frame of them at
+// a time, to the audio device, which reads as many as its callback asks for.
+// There must be a single writer and a single reader, each on its own thread,
+// and neither of them ever waits for the other.
+//
+// The latency, which is how many samples are queued, is kept around a target.
+// The writer asks for a rate ratio after each frame, and resamples its next
+// frame by it, which slowly makes up for its clock running faster or slower
+// than the reader's. If the writer gets far ahead anyway, the reader skips the
+// oldest samples, and if it falls behind, the last sample is held until more
+// samples arrive.
+class AudioRing {
+ public:
+  struct Stats {
+    // Samples queued when the reader last read.
+    size_t latency = 0;
+    // Times the reader ran out of samples.
+    uint64_t underruns = 0;
+    // Samples which were written when the ring was full, or skipped by the
+    // reader to catch up.
+    uint64_t dropped_samples = 0;
+    // The last ratio from UpdateRateRatio().
+    double rate_ratio = 1.0;
+  };
+
+  // The most the rate ratio differs from 1. Pitch changes of 0.5% can hardly
+  // be heard.
+  static constexpr double kMaxRateDelta = 0.005;
+
+  // |capacity| must be a power of two.
+  explicit AudioRing(size_t capacity);
+  ~AudioRing();
+
+  AudioRing(const AudioRing&) = delete;
+  AudioRing& operator=(const AudioRing&) = delete;
+
+  // Sets how many samples the reader leaves queued. It can be called on any
+  // thread.
+  void set_target_latency(size_t samples);
+  size_t target_latency() const { return target_latency_; }
+  size_t capacity() const { return buffer_.size(); }
+
+  // Writes |count| samples. Samples which don't fit are dropped. Returns
+  // how many samples are written. Writer only.
+  size_t Write(const kiwi::nes::Sample* samples, size_t count);
+
+  // Gets the ratio the writer should resample its next frame by, so that the
+  // latency goes to the target. It should be called after each frame is
+  // written. Writer only.
+  double UpdateRateRatio();
+
+  // Fills |samples| with |count| samples. Reader only.
+  void Read(kiwi::nes::Sample* samples, size_t count);
+
+  // Drops all queued samples. Neither the writer nor the reader may run
+  // meanwhile.
+  void Clear();
+
+  Stats GetStats() const;
+
+ private:
+  std::vector<kiwi::nes::Sample> buffer_;
+  size_t mask_ = 0;
+  std::atomic<size_t> target_latency_{0};
+
+  // Positions only increase, they are masked when the buffer is accessed.
+  std::atomic<size_t> write_position_{0};
+  std::atomic<size_t> read_position_{0};
+
+  // Writer's state. Integrates how far the latency is off the target, which
+  // is what it takes to cancel the clock drift.
+  double rate_drift_ = 0;
+
+  // Reader's states. The ring starts out starving, so that waiting for the
+  // first samples is not an underrun.
+  bool starving_ = true;
+  kiwi::nes::Sample last_sample_ = 0;
+
+  std::atomic<size_t> latency_{0};
+  std::atomic<uint64_t> underruns_{0};
+  std::atomic<uint64_t> dropped_samples_{0};
+  std::atomic<double> rate_ratio_{1.0};
+};
+
+#endif  // MODELS_AUDIO_RING_H_
@@ -0,0 +1,203 @@
+// Copyright (C) 2026 Yisi Yu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#include <cmath>
+#include <iostream>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+#include "models/audio_ring.h"
+#include "third_party/googletest-release-1.12.1/googletest/include/gtest/gtest.h"
+
+namespace {
+std::vector<kiwi::nes::Sample> Sequence(kiwi::nes::Sample first,
+                                        size_t count) {
+  std::vector<kiwi::nes::Sample> samples(count);
+  std::iota(samples.begin(), samples.end(), first);
+  return samples;
+}
+}  // namespace
+
+TEST(AudioRingTest, ReadsWhatIsWritten) {
+  AudioRing ring(16);
+  ring.set_target_latency(16);
+
+  // Wraps around the end of the buffer.
+  std::vector<kiwi::nes::Sample> out(10);
+  for (kiwi::nes::Sample first = 0; first < 50; first += 10) {
+    EXPECT_EQ(ring.Write(Sequence(first, 10).data(), 10), 10u);
+    ring.Read(out.data(), out.size());
+    EXPECT_EQ(out, Sequence(first, 10));
+  }
+
+  AudioRing::Stats stats = ring.GetStats();
+  EXPECT_EQ(stats.latency, 10u);
+  EXPECT_EQ(stats.underruns, 0u);
+  EXPECT_EQ(stats.dropped_samples, 0u);
+}
+
+TEST(AudioRingTest, DropsWhenFull) {
+  AudioRing ring(16);
+  ring.set_target_latency(16);
+  EXPECT_EQ(ring.Write(Sequence(0, 12).data(), 12), 12u);
+  EXPECT_EQ(ring.Write(Sequence(12, 12).data(), 12), 4u);
+  EXPECT_EQ(ring.GetStats().dropped_samples, 8u);
+
+  std::vector<kiwi::nes::Sample> out(16);
+  ring.Read(out.data(), out.size());
+  EXPECT_EQ(out, Sequence(0, 16));
+}
+
+TEST(AudioRingTest, SkipsToTargetLatency) {
+  AudioRing ring(64);
+  ring.set_target_latency(8);
+  ring.Write(Sequence(0, 40).data(), 40);
+
+  // More than twice the target would be left, so the oldest 28 samples are
+  // skipped, and 8 samples are left queued after reading 4.
+  std::vector<kiwi::nes::Sample> out(4);
+  ring.Read(out.data(), out.size());
+  EXPECT_EQ(out, Sequence(28, 4));
+
+  AudioRing::Stats stats = ring.GetStats();
+  EXPECT_EQ(stats.latency, 12u);
+  EXPECT_EQ(stats.dropped_samples, 28u);
+}
+
+TEST(AudioRingTest, HoldsLastSampleOnUnderrun) {
+  AudioRing ring(16);
+  ring.set_target_latency(8);
+
+  // Waiting for the first samples is not an underrun.
+  std::vector<kiwi::nes::Sample> out(4);
+  ring.Read(out.data(), out.size());
+  EXPECT_EQ(out, std::vector<kiwi::nes::Sample>(4, 0));
+  EXPECT_EQ(ring.GetStats().underruns, 0u);
+
+  ring.Write(Sequence(1, 6).data(), 6);
+  ring.Read(out.data(), out.size());
+  ring.Read(out.data(), out.size());
+  EXPECT_EQ(out, std::vector<kiwi::nes::Sample>({5, 6, 6, 6}));
+  EXPECT_EQ(ring.GetStats().underruns, 1u);
+
+  // Starving on, it's still the same underrun.
+  ring.Read(out.data(), out.size());
+  EXPECT_EQ(ring.GetStats().underruns, 1u);
+
+  ring.Write(Sequence(7, 8).data(), 8);
+  ring.Read(out.data(), out.size());
+  ring.Read(out.data(), out.size());
+  ring.Read(out.data(), out.size());
+  EXPECT_EQ(ring.GetStats().underruns, 2u);
+}
+
+TEST(AudioRingTest, ClearDropsQueuedSamples) {
+  AudioRing ring(16);
+  ring.set_target_latency(16);
+  ring.Write(Sequence(1, 8).data(), 8);
+  ring.Clear();
+
+  std::vector<kiwi::nes::Sample> out(4);
+  ring.Read(out.data(), out.size());
+  EXPECT_EQ(out, std::vector<kiwi::nes::Sample>(4, 0));
+  EXPECT_EQ(ring.GetStats().underruns, 0u);
+}
+
+// Simulates an emulator whose frames come slightly faster or slower than the
+// audio device's clock. The writer resamples each frame by the rate ratio,
+// and the reader reads 512 samples a time at 44100Hz.
+TEST(AudioRingTest, RateControlFollowsReaderClock) {
+  constexpr double kFrameRate = 60;
+  constexpr double kSampleRate = 44100;
+  constexpr size_t kTarget = 1764;
+  constexpr size_t kReadSize = 512;
+  constexpr int kFrames = 3600;
+  for (double drift : {0.003, -0.003, 0.0}) {
+    AudioRing ring(8192);
+    ring.set_target_latency(kTarget);
+    std::vector<kiwi::nes::Sample> buffer(2048);
+    double ratio = 1.0;
+    double to_write = 0;
+    double to_read = 0;
+    size_t written = 0;
+    size_t read = 0;
+    double max_error = 0;
+    for (int frame = 0; frame < kFrames; ++frame) {
+      to_write += kSampleRate / kFrameRate * (1 + drift) * ratio;
+      size_t count = static_cast<size_t>(to_write);
+      to_write -= count;
+      written += ring.Write(buffer.data(), count);
+      ratio = ring.UpdateRateRatio();
+      EXPECT_LE(std::abs(ratio - 1), AudioRing::kMaxRateDelta + 1e-9);
+
+      // The latency is measured when a frame is written, as the rate control
+      // does, after it settles.
+      if (frame >= kFrames / 2) {
+        double latency = static_cast<double>(written - read);
+        max_error = std::max(max_error, std::abs(latency - kTarget) / kTarget);
+      }
+
+      to_read += kSampleRate / kFrameRate;
+      for (; to_read >= kReadSize; to_read -= kReadSize) {
+        ring.Read(buffer.data(), kReadSize);
+        read += kReadSize;
+      }
+    }
+
+    AudioRing::Stats stats = ring.GetStats();
+    EXPECT_NEAR(stats.rate_ratio, 1 / (1 + drift), 0.001) << drift;
+    EXPECT_EQ(stats.underruns, 0u) << drift;
+    EXPECT_EQ(stats.dropped_samples, 0u) << drift;
+    EXPECT_LT(max_error, 0.25) << drift;
+    std::cout << "Drift " << drift << ": latency is off the target by "
+              << max_error * 100 << "% at most" << std::endl;
+  }
+}
+
+TEST(AudioRingTest, WriterAndReaderOnTheirOwnThreads) {
+  constexpr size_t kChunk = 7;
+  constexpr size_t kTotal = kChunk * 4000;
+  AudioRing ring(256);
+  ring.set_target_latency(256);
+
+  // The writer retries what doesn't fit, so the reader sees every sample in
+  // order, apart from held ones. Samples start
+  // from 1, which tells them from the silence before the first write.
+  std::thread writer([&ring]() {
+    size_t written = 0;
+    while (written < kTotal) {
+      std::vector<kiwi::nes::Sample> samples = Sequence(
+          static_cast<kiwi::nes::Sample>(written + 1), kChunk);
+      size_t count = ring.Write(samples.data(), samples.size());
+      written += count;
+      if (count < kChunk)
+        std::this_thread::yield();
+    }
+  });
+
+  kiwi::nes::Sample expected = 1;
+  size_t read = 0;
+  std::vector<kiwi::nes::Sample> out(5);
+  while (read < kTotal) {
+    ring.Read(out.data(), out.size());
+    for (kiwi::nes::Sample sample : out) {
+      if (sample == expected) {
+        ++expected;
+        ++read;
+      } else {
+        ASSERT_EQ(sample, static_cast<kiwi::nes::Sample>(expected - 1));
+      }
+    }
+  }
+  writer.join();
+}
@@ -0,0 +1,368 @@
+// Copyright (C) 2026 Yisi Yu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#include "models/auto_save_ring.h"
+
+#include <SDL.h>
+#include <zlib.h>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+
+namespace {
+
+// Layout of the index file:
+// Header: | Magic (16 bytes) | Version (4 bytes) | Capacity (4 bytes) |
+// Records, one per slot:
+// | Sequence (8 bytes) | Timestamp (8 bytes) | Data size (4 bytes) |
+// | Data CRC (4 bytes) | Reserved (4 bytes) | Record CRC (4 bytes) |
+constexpr char kIndexMagic[16] = "KIWI_AUTO_SAVES";
+constexpr uint32_t kIndexVersion = 1;
+constexpr int kHeaderSize = sizeof(kIndexMagic) + sizeof(uint32_t) * 2;
+constexpr int kRecordSize = 32;
+constexpr int kRecordCRCOffset = kRecordSize - sizeof(uint32_t);
+
+template <typename T>
+void WriteField(char* buffer, int& offset, T value) {
+  memcpy(buffer + offset, &value, sizeof(value));
+  offset += sizeof(value);
+}
+
+template <typename T>
+T ReadField(const char* buffer, int& offset) {
+  T value;
+  memcpy(&value, buffer + offset, sizeof(value));
+  offset += sizeof(value);
+  return value;
+}
+
+uint32_t CalculateCRC(const void* data, size_t size) {
+  return crc32(0, reinterpret_cast<const Bytef*>(data), size);
+}
+
+void SerializeRecord(const AutoSaveRing::Entry& entry, char* record) {
+  memset(record, 0, kRecordSize);
+  int offset = 0;
+  WriteField(record, offset, entry.sequence);
+  WriteField(record, offset, entry.timestamp);
+  WriteField(record, offset, entry.data_size);
+  WriteField(record, offset, entry.data_crc);
+  offset = kRecordCRCOffset;
+  WriteField(record, offset, CalculateCRC(record, kRecordCRCOffset));
+}
+
+kiwi::base::FilePath GetIndexPath(const kiwi::base::FilePath& path) {
+  return path.Append(FILE_PATH_LITERAL("index"));
+}
+
+kiwi::base::FilePath GetDataPath(const kiwi::base::FilePath& state_path) {
+  return state_path.Append(FILE_PATH_LITERAL("data"));
+}
+
+kiwi::base::FilePath GetThumbnailPath(const kiwi::base::FilePath& state_path) {
+  return state_path.Append(FILE_PATH_LITERAL("thumbnail"));
+}
+
+// base::CopyFile() is only implemented on Windows.
+bool CopyStateFile(const kiwi::base::FilePath& from_path,
+                   const kiwi::base::FilePath& to_path) {
+  std::optional<std::vector<uint8_t>> data =
+      kiwi::base::ReadFileToBytes(from_path);
+  return data && kiwi::base::WriteFile(to_path, *data);
+}
+
+// A state found by AutoSaveRing::Recover().
+struct FoundState {
+  kiwi::base::FilePath path;
+  std::filesystem::file_time_type modified_time;
+  int slot = -1;  // -1 if the state isn't in a slot.
+};
+
+bool GetModifiedTime(const kiwi::base::FilePath& path,
+                     std::filesystem::file_time_type* modified_time) {
+  std::error_code error;
+  *modified_time = std::filesystem::last_write_time(
+      std::filesystem::path(path.value()), error);
+  return !error;
+}
+
+uint64_t ToTimestamp(std::filesystem::file_time_type modified_time) {
+  auto time = std::chrono::file_clock::to_sys(modified_time);
+  return std::chrono::duration_cast<std::chrono::seconds>(
+             time.time_since_epoch())
+      .count();
+}
+
+}  // namespace
+
+AutoSaveRing::AutoSaveRing(const kiwi::base::FilePath& path, int capacity)
+    : path_(path), capacity_(capacity) {
+  SDL_assert(capacity_ > 0);
+  entries_.resize(capacity_);
+  for (int i = 0; i < capacity_; ++i)
+    entries_[i].slot = i;
+}
+
+AutoSaveRing::~AutoSaveRing() = default;
+
+bool AutoSaveRing::Load() {
+  for (Entry& entry : entries_)
+    entry = Entry{entry.slot};
+
+  std::optional<std::vector<uint8_t>> index =
+      kiwi::base::ReadFileToBytes(GetIndexPath(path_));
+  if (!index || index->size() < kHeaderSize)
+    return false;
+
+  const char* buffer = reinterpret_cast<const char*>(index->data());
+  if (memcmp(buffer, kIndexMagic, sizeof(kIndexMagic)) != 0)
+    return false;
+
+  int offset = sizeof(kIndexMagic);
+  uint32_t version = ReadField<uint32_t>(buffer, offset);
+  uint32_t capacity = ReadField<uint32_t>(buffer, offset);
+  if (version != kIndexVersion || capacity != capacity_) {
+    SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION,
+                "Auto saved index %s is not compatible, ignored.",
+                path_.AsUTF8Unsafe().c_str());
+    return false;
+  }
+
+  if (index->size() != kHeaderSize + capacity_ * kRecordSize)
+    return false;
+
+  for (int slot = 0; slot < capacity_; ++slot) {
+    const char* record = buffer + kHeaderSize + slot * kRecordSize;
+    int record_crc_offset = kRecordCRCOffset;
+    if (CalculateCRC(record, kRecordCRCOffset) !=
+        ReadField<uint32_t>(record, record_crc_offset)) {
+      // A torn record, which may be caused by a crash.
+      continue;
+    }
+
+    int field_offset = 0;
+    Entry& entry = entries_[slot];
+    entry.sequence = ReadField<uint64_t>(record, field_offset);
+    entry.timestamp = ReadField<uint64_t>(record, field_offset);
+    entry.data_size = ReadField<uint32_t>(record, field_offset);
+    entry.data_crc = ReadField<uint32_t>(record, field_offset);
+  }
+  return true;
+}
+
+bool AutoSaveRing::Recover() {
+  for (Entry& entry : entries_)
+    entry = Entry{entry.slot};
+
+  if (!kiwi::base::DirectoryExists(path_))
+    return true;
+
+  // Directories named by numbers which are smaller than the capacity are
+  // slots. Other ones named by numbers are states saved by timestamps before.
+  std::vector<FoundState> slot_states;
+  std::vector<FoundState> legacy_states;
+  kiwi::base::FileEnumerator enumerator(
+      path_, false, kiwi::base::FileEnumerator::DIRECTORIES);
+  for (kiwi::base::FilePath state_path = enumerator.Next();
+       !state_path.empty(); state_path = enumerator.Next()) {
+    uint64_t number;
+    if (!kiwi::base::StringToUint64(state_path.BaseName().AsUTF8Unsafe(),
+                                    &number)) {
+      continue;
+    }
+
+    FoundState state{state_path};
+    if (!GetModifiedTime(GetDataPath(state_path), &state.modified_time))
+      continue;
+
+    if (number < static_cast<uint64_t>(capacity_)) {
+      state.slot = static_cast<int>(number);
+      slot_states.push_back(state);
+    } else {
+      legacy_states.push_back(state);
+    }
+  }
+
+  // Moves the newest legacy states into empty slots. The legacy directories
+  // are deleted only after the index has their records.
+  std::sort(legacy_states.begin(), legacy_states.end(),
+            [](const FoundState& lhs, const FoundState& rhs) {
+              return lhs.modified_time > rhs.modified_time;
+            });
+  std::vector<bool> occupied(capacity_, false);
+  for (const FoundState& state : slot_states)
+    occupied[state.slot] = true;
+
+  std::vector<kiwi::base::FilePath> migrated_paths;
+  std::vector<FoundState> states = slot_states;
+  int slot = 0;
+  for (const FoundState& state : legacy_states) {
+    while (slot < capacity_ && occupied[slot])
+      ++slot;
+    if (slot == capacity_)
+      break;
+
+    kiwi::base::FilePath slot_path = GetSlotPath(slot);
+    kiwi::base::CreateDirectory(slot_path);
+    if (!CopyStateFile(GetDataPath(state.path), GetDataPath(slot_path))) {
+      SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION,
+                  "Can't move auto saved state %s into slot %d.",
+                  state.path.AsUTF8Unsafe().c_str(), slot);
+      continue;
+    }
+    CopyStateFile(GetThumbnailPath(state.path), GetThumbnailPath(slot_path));
+
+    occupied[slot] = true;
+    states.push_back({state.path, state.modified_time, slot});
+    migrated_paths.push_back(state.path);
+  }
+
+  if (states.empty())
+    return true;
+
+  // Sequences follow the modified time, from the oldest state.
+  std::sort(states.begin(), states.end(),
+            [](const FoundState& lhs, const FoundState& rhs) {
+              return lhs.modified_time < rhs.modified_time;
+            });
+  uint64_t sequence = 0;
+  for (const FoundState& state : states) {
+    std::optional<std::vector<uint8_t>> data =
+        kiwi::base::ReadFileToBytes(GetDataPath(GetSlotPath(state.slot)));
+    if (!data)
+      continue;
+
+    entries_[state.slot] =
+        Entry{state.slot, ++sequence, ToTimestamp(state.modified_time),
+              static_cast<uint32_t>(data->size()),
+              CalculateCRC(data->data(), data->size())};
+  }
+
+  SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION,
+              "Recovered %d auto saved states in %s.",
+              static_cast<int>(sequence), path_.AsUTF8Unsafe().c_str());
+  if (!WriteIndex(entries_))
+    return false;
+
+  for (const kiwi::base::FilePath& path : migrated_paths)
+    kiwi::base::DeletePathRecursively(path);
+  return true;
+}
+
+std::vector<AutoSaveRing::Entry> AutoSaveRing::GetEntries() const {
+  std::vector<Entry> result;
+  for (const Entry& entry : entries_) {
+    if (entry.sequence)
+      result.push_back(entry);
+  }
+
+  std::sort(result.begin(), result.end(),
+            [](const Entry& lhs, const Entry& rhs) {
+              return lhs.sequence > rhs.sequence;
+            });
+  return result;
+}
+
+int AutoSaveRing::GetNextSlot() const {
+  // Empty slots have the smallest sequence, so they are used first.
+  auto oldest = std::min_element(entries_.begin(), entries_.end(),
+                                 [](const Entry& lhs, const Entry& rhs) {
+                                   return lhs.sequence < rhs.sequence;
+                                 });
+  return oldest->slot;
+}
+
+bool AutoSaveRing::Invalidate(int slot) {
+  SDL_assert(slot >= 0 && slot < capacity_);
+  entries_[slot] = Entry{slot};
+  return WriteRecord(slot, entries_[slot]);
+}
+
+bool AutoSaveRing::Commit(int slot,
+                          uint64_t timestamp,
+                          const kiwi::nes::Bytes& data) {
+  SDL_assert(slot >= 0 && slot < capacity_);
+  uint64_t max_sequence = 0;
+  for (const Entry& entry : entries_)
+    max_sequence = std::max(max_sequence, entry.sequence);
+
+  Entry entry{slot, max_sequence + 1, timestamp,
+              static_cast<uint32_t>(data.size()),
+              CalculateCRC(data.data(), data.size())};
+  if (!WriteRecord(slot, entry))
+    return false;
+
+  entries_[slot] = entry;
+  return true;
+}
+
+bool AutoSaveRing::Verify(const Entry& entry, const kiwi::nes::Bytes& data) {
+  return entry.sequence && entry.data_size == data.size() &&
+         entry.data_crc == CalculateCRC(data.data(), data.size());
+}
+
+kiwi::base::FilePath AutoSaveRing::GetSlotPath(int slot) const {
+  return path_.Append(
+      kiwi::base::FilePath::FromUTF8Unsafe(kiwi::base::NumberToString(slot)));
+}
+
+bool AutoSaveRing::WriteRecord(int slot, const Entry& entry) {
+  char record[kRecordSize];
+  SerializeRecord(entry, record);
+
+  kiwi::base::FilePath index_path = GetIndexPath(path_);
+  int64_t index_size = -1;
+  if (kiwi::base::PathExists(index_path)) {
+    kiwi::base::File index(index_path, kiwi::base::File::FLAG_OPEN |
+                                           kiwi::base::File::FLAG_READ);
+    if (index.IsValid())
+      index_size = index.GetLength();
+  }
+
+  if (index_size != kHeaderSize + capacity_ * kRecordSize) {
+    // The index doesn't exist or is broken, creates a new one with all known
+    // records.
+    std::vector<Entry> entries = entries_;
+    entries[slot] = entry;
+    return WriteIndex(entries);
+  }
+
+  // Only overwrites the record of |slot|.
+  kiwi::base::File file(index_path, kiwi::base::File::FLAG_OPEN |
+                                        kiwi::base::File::FLAG_WRITE);
+  if (!file.IsValid())
+    return false;
+
+  file.Seek(kiwi::base::File::FROM_BEGIN, kHeaderSize + slot * kRecordSize);
+  return file.WriteAtCurrentPos(record, kRecordSize) == kRecordSize;
+}
+
+bool AutoSaveRing::WriteIndex(const std::vector<Entry>& entries) {
+  SDL_assert(entries.size() == static_cast<size_t>(capacity_));
+  if (!kiwi::base::PathExists(path_))
+    kiwi::base::CreateDirectory(path_);
+
+  const int size = kHeaderSize + capacity_ * kRecordSize;
+  std::vector<char> buffer(size, 0);
+  memcpy(buffer.data(), kIndexMagic, sizeof(kIndexMagic));
+  int offset = sizeof(kIndexMagic);
+  WriteField(buffer.data(), offset, kIndexVersion);
+  WriteField(buffer.data(), offset, static_cast<uint32_t>(capacity_));
+  for (int i = 0; i < capacity_; ++i) {
+    if (entries[i].sequence) {
+      SerializeRecord(entries[i],
+                      buffer.data() + kHeaderSize + i * kRecordSize);
+    }
+  }
+  return kiwi::base::WriteFile(GetIndexPath(path_), buffer.data(), size) ==
+         size;
+}
@@ -0,0 +1,87 @@
+// Copyright (C) 2026 Yisi Yu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#ifndef MODELS_AUTO_SAVE_RING_H_
+#define MODELS_AUTO_SAVE_RING_H_
+
+#include <kiwi_nes.h>
+#include <vector>
+
+// AutoSaveRing stores auto-saved states in a fixed number of numbered slots,
+// described by a small index file, so that nothing needs to enumerate the
+// directory:
+// ./AutoSaved/index
+// ./AutoSaved/{Slot}/data
+// ./AutoSaved/{Slot}/thumbnail
+//
+// A new state always overwrites the oldest slot. The slot's record is
+// invalidated before its files are written, and committed afterwards, so if
+// the application crashes in the middle, the slot is ignored and the prior
+// entry becomes the newest one.
+class AutoSaveRing {
+ public:
+  struct Entry {
+    int slot = -1;
+    // Sequence increases by each save, it orders entries even if the clock
+    // changes. Zero means the slot is empty.
+    uint64_t sequence = 0;
+    uint64_t timestamp = 0;
+    uint32_t data_size = 0;
+    uint32_t data_crc = 0;
+  };
+
+  AutoSaveRing(const kiwi::base::FilePath& path, int capacity);
+  ~AutoSaveRing();
+
+  // Reads the index file. Records which are torn or corrupted are treated as
+  // empty slots. Returns false if the index doesn't exist or can't be used.
+  bool Load();
+
+  // Rebuilds the index from the files, if Load() fails. Slots which have data
+  // are kept, ordered by their modified time. States which were saved in
+  // directories named by timestamps, before there were slots, are moved into
+  // empty slots, from the newest one. Nothing else is deleted. Returns false if
+  // the index can't be written.
+  bool Recover();
+
+  // Gets all valid entries, the newest one comes first.
+  std::vector<Entry> GetEntries() const;
+
+  // Gets the slot which the next state should be written to, which is an
+  // empty slot, or the oldest one.
+  int GetNextSlot() const;
+
+  // Marks |slot| as empty. Must be called before overwriting its files.
+  bool Invalidate(int slot);
+
+  // Records that |data| has been written to |slot|. Only the record of |slot|
+  // is rewritten.
+  bool Commit(int slot, uint64_t timestamp, const kiwi::nes::Bytes& data);
+
+  // Checks whether |data| is exactly what |entry| was committed with.
+  static bool Verify(const Entry& entry, const kiwi::nes::Bytes& data);
+
+  kiwi::base::FilePath GetSlotPath(int slot) const;
+  const Entry& entry(int slot) const { return entries_[slot]; }
+  int capacity() const { return capacity_; }
+
+ private:
+  bool WriteRecord(int slot, const Entry& entry);
+  bool WriteIndex(const std::vector<Entry>& entries);
+
+ private:
+  kiwi::base::FilePath path_;
+  int capacity_ = 0;
+  std::vector<Entry> entries_;
+};
+
+#endif  // MODELS_AUTO_SAVE_RING_H_
@@ -0,0 +1,224 @@
+// Copyright (C) 2026 Yisi Yu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+
+#include "models/auto_save_ring.h"
+#include "third_party/googletest-release-1.12.1/googletest/include/gtest/gtest.h"
+
+class AutoSaveRingTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    std::filesystem::path path =
+        std::filesystem::temp_directory_path() /
+        (std::string("kiwi_auto_save_ring_") +
+         testing::UnitTest::GetInstance()->current_test_info()->name());
+    std::filesystem::remove_all(path);
+    path_ = kiwi::base::FilePath::FromUTF8Unsafe(path.string());
+  }
+
+  void TearDown() override {
+    std::filesystem::remove_all(path_.AsUTF8Unsafe());
+  }
+
+  // Invalidates and commits the next slot, as the auto saving does.
+  int Save(AutoSaveRing& ring, uint64_t timestamp, kiwi::nes::Byte content) {
+    int slot = ring.GetNextSlot();
+    EXPECT_TRUE(ring.Invalidate(slot));
+    EXPECT_TRUE(ring.Commit(slot, timestamp, kiwi::nes::Bytes(16, content)));
+    return slot;
+  }
+
+  // Writes a state into |name| under the directory, modified at |seconds|
+  // after now.
+  void WriteState(const std::string& name,
+                  kiwi::nes::Byte content,
+                  int seconds) {
+    std::filesystem::path state_path =
+        std::filesystem::path(path_.AsUTF8Unsafe()) / name;
+    std::filesystem::create_directories(state_path);
+    std::ofstream(state_path / "data", std::ios::binary)
+        << std::string(16, content);
+    std::ofstream(state_path / "thumbnail", std::ios::binary) << name;
+    std::filesystem::last_write_time(
+        state_path / "data", std::filesystem::file_time_type::clock::now() +
+                                 std::chrono::seconds(seconds));
+  }
+
+  bool Exists(const std::string& name) {
+    return std::filesystem::exists(
+        std::filesystem::path(path_.AsUTF8Unsafe()) / name);
+  }
+
+  kiwi::base::FilePath path_;
+};
+
+TEST_F(AutoSaveRingTest, OverwritesOldestSlot) {
+  AutoSaveRing ring(path_, 3);
+  EXPECT_FALSE(ring.Load());
+  EXPECT_TRUE(ring.GetEntries().empty());
+
+  int first = Save(ring, 100, 1);
+  int second = Save(ring, 200, 2);
+  int third = Save(ring, 300, 3);
+  EXPECT_NE(first, second);
+  EXPECT_NE(second, third);
+  EXPECT_NE(first, third);
+
+  // The ring is full, the oldest slot is reused.
+  EXPECT_EQ(Save(ring, 400, 4), first);
+  EXPECT_EQ(Save(ring, 500, 5), second);
+
+  std::vector<AutoSaveRing::Entry> entries = ring.GetEntries();
+  ASSERT_EQ(entries.size(), 3u);
+  EXPECT_EQ(entries[0].timestamp, 500u);
+  EXPECT_EQ(entries[1].timestamp, 400u);
+  EXPECT_EQ(entries[2].timestamp, 300u);
+}
+
+TEST_F(AutoSaveRingTest, PersistsIndex) {
+  {
+    AutoSaveRing ring(path_, 4);
+    Save(ring, 100, 1);
+    Save(ring, 200, 2);
+  }
+
+  AutoSaveRing ring(path_, 4);
+  EXPECT_TRUE(ring.Load());
+  std::vector<AutoSaveRing::Entry> entries = ring.GetEntries();
+  ASSERT_EQ(entries.size(), 2u);
+  EXPECT_EQ(entries[0].timestamp, 200u);
+  EXPECT_TRUE(AutoSaveRing::Verify(entries[0], kiwi::nes::Bytes(16, 2)));
+  EXPECT_FALSE(AutoSaveRing::Verify(entries[0], kiwi::nes::Bytes(16, 1)));
+  EXPECT_FALSE(AutoSaveRing::Verify(entries[0], kiwi::nes::Bytes(15, 2)));
+
+  // The sequence continues after reloading.
+  Save(ring, 50, 3);
+  EXPECT_EQ(ring.GetEntries()[0].timestamp, 50u);
+
+  // An index with a different capacity is ignored.
+  AutoSaveRing other_ring(path_, 5);
+  EXPECT_FALSE(other_ring.Load());
+  EXPECT_TRUE(other_ring.GetEntries().empty());
+}
+
+TEST_F(AutoSaveRingTest, InterruptedSaveFallsBack) {
+  {
+    AutoSaveRing ring(path_, 2);
+    Save(ring, 100, 1);
+    Save(ring, 200, 2);
+
+    // Simulates a crash after the slot is invalidated, but before its data is
+    // committed.
+    ring.Invalidate(ring.GetNextSlot());
+  }
+
+  AutoSaveRing ring(path_, 2);
+  EXPECT_TRUE(ring.Load());
+  std::vector<AutoSaveRing::Entry> entries = ring.GetEntries();
+  ASSERT_EQ(entries.size(), 1u);
+  EXPECT_EQ(entries[0].timestamp, 200u);
+
+  // The invalidated slot is reused first.
+  EXPECT_NE(ring.GetNextSlot(), entries[0].slot);
+}
+
+TEST_F(AutoSaveRingTest, TornRecordIsIgnored) {
+  int torn_slot;
+  {
+    AutoSaveRing ring(path_, 2);
+    torn_slot = Save(ring, 100, 1);
+    Save(ring, 200, 2);
+  }
+
+  // Corrupts the first record.
+  std::string index_path =
+      path_.Append(FILE_PATH_LITERAL("index")).AsUTF8Unsafe();
+  std::fstream index(index_path,
+                     std::ios::in | std::ios::out | std::ios::binary);
+  ASSERT_TRUE(index.is_open());
+  index.seekp(24 + torn_slot * 32 + 4);
+  index.put('\x5a');
+  index.close();
+
+  AutoSaveRing ring(path_, 2);
+  EXPECT_TRUE(ring.Load());
+  std::vector<AutoSaveRing::Entry> entries = ring.GetEntries();
+  ASSERT_EQ(entries.size(), 1u);
+  EXPECT_EQ(entries[0].timestamp, 200u);
+  EXPECT_EQ(ring.GetNextSlot(), torn_slot);
+}
+
+TEST_F(AutoSaveRingTest, RecoverMovesLegacyStates) {
+  // States named by timestamps, and a directory which isn't a state.
+  WriteState("1700000000", 1, -300);
+  WriteState("1700000100", 2, -200);
+  WriteState("1700000200", 3, -100);
+  std::filesystem::create_directories(
+      std::filesystem::path(path_.AsUTF8Unsafe()) / "unknown");
+
+  AutoSaveRing ring(path_, 2);
+  EXPECT_FALSE(ring.Load());
+  EXPECT_TRUE(ring.Recover());
+
+  // The newest ones are moved into slots, the oldest one is left.
+  std::vector<AutoSaveRing::Entry> entries = ring.GetEntries();
+  ASSERT_EQ(entries.size(), 2u);
+  EXPECT_TRUE(AutoSaveRing::Verify(entries[0], kiwi::nes::Bytes(16, 3)));
+  EXPECT_TRUE(AutoSaveRing::Verify(entries[1], kiwi::nes::Bytes(16, 2)));
+  EXPECT_GT(entries[0].timestamp, entries[1].timestamp);
+  EXPECT_TRUE(Exists("0/thumbnail"));
+  EXPECT_TRUE(Exists("1/thumbnail"));
+  EXPECT_FALSE(Exists("1700000100"));
+  EXPECT_FALSE(Exists("1700000200"));
+  EXPECT_TRUE(Exists("1700000000"));
+  EXPECT_TRUE(Exists("unknown"));
+
+  AutoSaveRing loaded_ring(path_, 2);
+  EXPECT_TRUE(loaded_ring.Load());
+  EXPECT_EQ(loaded_ring.GetEntries().size(), 2u);
+}
+
+TEST_F(AutoSaveRingTest, RecoverKeepsSlots) {
+  {
+    AutoSaveRing ring(path_, 3);
+    Save(ring, 100, 1);
+    Save(ring, 200, 2);
+  }
+  WriteState("0", 1, -100);
+  WriteState("1", 2, -50);
+
+  // An index which can't be used, such as it's from another version.
+  std::string index_path =
+      path_.Append(FILE_PATH_LITERAL("index")).AsUTF8Unsafe();
+  std::fstream index(index_path,
+                     std::ios::in | std::ios::out | std::ios::binary);
+  ASSERT_TRUE(index.is_open());
+  index.put('\x5a');
+  index.close();
+
+  AutoSaveRing ring(path_, 3);
+  EXPECT_FALSE(ring.Load());
+  EXPECT_TRUE(ring.Recover());
+  std::vector<AutoSaveRing::Entry> entries = ring.GetEntries();
+  ASSERT_EQ(entries.size(), 2u);
+  EXPECT_EQ(entries[0].slot, 1);
+  EXPECT_TRUE(AutoSaveRing::Verify(entries[0], kiwi::nes::Bytes(16, 2)));
+  EXPECT_EQ(entries[1].slot, 0);
+  EXPECT_TRUE(AutoSaveRing::Verify(entries[1], kiwi::nes::Bytes(16, 1)));
+
+  // Saving continues after the recovered states.
+  EXPECT_EQ(Save(ring, 300, 3), 2);
+  EXPECT_EQ(ring.GetEntries()[0].timestamp, 300u);
+}
@@ -0,0 +1,136 @@
+// Copyright (C) 2026 Yisi Yu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#include "models/frame_uploader.h"
+
+#include <algorithm>
+#include <cstring>
+
+FrameUploader::FrameUploader() = default;
+
+FrameUploader::~FrameUploader() = default;
+
+bool FrameUploader::IsUploaded(uint64_t frame_sequence) const {
+  return has_uploaded_frame_ && uploaded_frame_sequence_ == frame_sequence;
+}
+
+bool FrameUploader::Upload(SDL_Texture* texture,
+                           int width,
+                           int height,
+                           const kiwi::nes::Colors& frame,
+                           const kiwi::nes::Emulator::FrameChanges& changes) {
+  SDL_assert(frame.size() == static_cast<size_t>(width) * height);
+  if (IsUploaded(changes.sequence))
+    return true;
+
+  int first_row = 0;
+  int end_row = 0;
+  GetRowsToWrite(changes, height, &first_row, &end_row);
+  const int rows = end_row - first_row;
+  int pitch = 0;
+  kiwi::nes::Color* pixels =
+      Lock(texture, SDL_Rect{0, first_row, width, rows}, &pitch);
+  if (!pixels)
+    return false;
+
+  const kiwi::nes::Color* source = frame.data() + first_row * width;
+  if (pitch == width) {
+    memcpy(pixels, source, rows * width * sizeof(kiwi::nes::Color));
+  } else {
+    for (int row = 0; row < rows; ++row) {
+      memcpy(pixels + row * pitch, source + row * width,
+             width * sizeof(kiwi::nes::Color));
+    }
+  }
+  Unlock(texture, changes.sequence);
+  return true;
+}
+
+bool FrameUploader::UploadScaled(SDL_Texture* texture,
+                                 PixelScaler* scaler,
+                                 PixelScaler::Filter filter,
+                                 int width,
+                                 int height,
+                                 const kiwi::nes::Colors& frame,
+                                 const kiwi::nes::Emulator::FrameChanges&
+                                     changes) {
+  SDL_assert(scaler);
+  if (IsUploaded(changes.sequence))
+    return true;
+
+  // Scaled rows depend on the rows around them as well.
+  int first_row = 0;
+  int end_row = 0;
+  GetRowsToWrite(changes, height, &first_row, &end_row);
+  first_row = std::max(first_row - PixelScaler::GetNeighborRows(), 0);
+  end_row = std::min(end_row + PixelScaler::GetNeighborRows(), height);
+
+  const int factor = PixelScaler::GetScaleFactor(filter);
+  int pitch = 0;
+  kiwi::nes::Color* pixels =
+      Lock(texture,
+           SDL_Rect{0, first_row * factor, width * factor,
+                    (end_row - first_row) * factor},
+           &pitch);
+  if (!pixels)
+    return false;
+
+  scaler->ScaleRows(filter, width, height, frame, first_row, end_row, pixels,
+                    pitch);
+  Unlock(texture, changes.sequence);
+  return true;
+}
+
+void FrameUploader::Invalidate() {
+  has_uploaded_frame_ = false;
+}
+
+void FrameUploader::GetRowsToWrite(
+    const kiwi::nes::Emulator::FrameChanges& changes,
+    int height,
+    int* first_row,
+    int* end_row) const {
+  if (IsUploaded(changes.base_sequence)) {
+    SDL_assert(0 <= changes.first_row && changes.first_row < changes.end_row &&
+               changes.end_row <= height);
+    *first_row = changes.first_row;
+    *end_row = changes.end_row;
+  } else {
+    *first_row = 0;
+    *end_row = height;
+  }
+}
+
+kiwi::nes::Color* FrameUploader::Lock(SDL_Texture* texture,
+                                      const SDL_Rect& rect,
+                                      int* pitch) {
+  SDL_assert(texture);
+  // The texture's contents are unknown from now on, until it's unlocked.
+  Invalidate();
+
+  void* pixels = nullptr;
+  int pitch_bytes = 0;
+  if (SDL_LockTexture(texture, &rect, &pixels, &pitch_bytes) != 0) {
+    SDL_LogError(SDL_LOG_CATEGORY_RENDER, "Can't lock the frame texture: %s",
+                 SDL_GetError());
+    return nullptr;
+  }
+  SDL_assert(pitch_bytes % sizeof(kiwi::nes::Color) == 0);
+  *pitch = pitch_bytes / sizeof(kiwi::nes::Color);
+  return static_cast<kiwi::nes::Color*>(pixels);
+}
+
+void FrameUploader::Unlock(SDL_Texture* texture, uint64_t frame_sequence) {
+  SDL_UnlockTexture(texture);
+  has_uploaded_frame_ = true;
+  uploaded_frame_sequence_ = frame_sequence;
+}
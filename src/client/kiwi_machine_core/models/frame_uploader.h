@@ -0,0 +1,84 @@
+// Copyright (C) 2026 Yisi Yu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#ifndef MODELS_FRAME_UPLOADER_H_
+#define MODELS_FRAME_UPLOADER_H_
+
+#include <SDL.h>
+#include <kiwi_nes.h>
+
+#include "utility/pixel_scaler.h"
+
+// FrameUploader writes NES frames into a streaming texture. Pixels are written
+// straight into the locked texture, rather than through SDL_UpdateTexture()'s
+// copy, and scaled frames are scaled straight into it. Frames are told by their
+// changes, see Emulator::GetPresentedFrameChanges(). A frame which is the one
+// in the texture isn't written again, so that a still frame, like a title
+// screen or a menu, is neither scaled nor uploaded. If the texture holds the
+// frame before it, only the changed rows are locked and written, and scaled
+// with the rows around them.
+class FrameUploader {
+ public:
+  FrameUploader();
+  ~FrameUploader();
+
+  FrameUploader(const FrameUploader&) = delete;
+  FrameUploader& operator=(const FrameUploader&) = delete;
+
+  // Whether the frame of |frame_sequence| is the one in the texture.
+  bool IsUploaded(uint64_t frame_sequence) const;
+
+  // Writes |frame|, which is |width| x |height| pixels, into |texture|, a
+  // streaming SDL_PIXELFORMAT_ARGB8888 texture of the same size. Returns false
+  // if the texture can't be locked.
+  bool Upload(SDL_Texture* texture,
+              int width,
+              int height,
+              const kiwi::nes::Colors& frame,
+              const kiwi::nes::Emulator::FrameChanges& changes);
+
+  // Like Upload(), but |frame| is scaled by |filter| into |texture|, which is
+  // as large as the scaled frame.
+  bool UploadScaled(SDL_Texture* texture,
+                    PixelScaler* scaler,
+                    PixelScaler::Filter filter,
+                    int width,
+                    int height,
+                    const kiwi::nes::Colors& frame,
+                    const kiwi::nes::Emulator::FrameChanges& changes);
+
+  // Makes the next upload write the frame, whatever its sequence is, such as
+  // when the texture is recreated.
+  void Invalidate();
+
+ private:
+  // Gets the rows of a frame of |height| rows which must be written: the
+  // changed ones if the texture holds the frame before it, or all of them.
+  void GetRowsToWrite(const kiwi::nes::Emulator::FrameChanges& changes,
+                      int height,
+                      int* first_row,
+                      int* end_row) const;
+
+  // Locks |rect| of |texture|. Returns its pixels, and sets |pitch| to pixels
+  // between rows, or returns null if it can't be locked. Locked pixels are
+  // write-only, so that every pixel of |rect| must be written.
+  kiwi::nes::Color* Lock(SDL_Texture* texture,
+                         const SDL_Rect& rect,
+                         int* pitch);
+  void Unlock(SDL_Texture* texture, uint64_t frame_sequence);
+
+  // Whether |uploaded_frame_sequence_| is the frame in the texture.
+  bool has_uploaded_frame_ = false;
+  uint64_t uploaded_frame_sequence_ = 0;
+};
+
+#endif  // MODELS_FRAME_UPLOADER_H_
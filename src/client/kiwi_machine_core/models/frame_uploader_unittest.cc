@@ -0,0 +1,244 @@
+// Copyright (C) 2026 Yisi Yu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#include "models/frame_uploader.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+#include "third_party/googletest-release-1.12.1/googletest/include/gtest/gtest.h"
+
+namespace {
+
+using FrameChanges = kiwi::nes::Emulator::FrameChanges;
+
+constexpr int kFrameWidth = 256;
+constexpr int kFrameHeight = 240;
+
+kiwi::nes::Colors CreateFrame(kiwi::nes::Color seed) {
+  kiwi::nes::Colors frame(kFrameWidth * kFrameHeight);
+  for (int y = 0; y < kFrameHeight; ++y) {
+    for (int x = 0; x < kFrameWidth; ++x)
+      frame[y * kFrameWidth + x] = 0xff000000 | (seed * 7 + x * 131 + y);
+  }
+  return frame;
+}
+
+// Copies rows [|first_row|, |end_row|) of |from| into |to|.
+void CopyRows(const kiwi::nes::Colors& from,
+              int first_row,
+              int end_row,
+              kiwi::nes::Colors* to) {
+  std::copy(from.begin() + first_row * kFrameWidth,
+            from.begin() + end_row * kFrameWidth,
+            to->begin() + first_row * kFrameWidth);
+}
+
+// A frame which is the frame of |base_sequence| but for rows
+// [|first_row|, |end_row|), or which is unrelated to any if |base_sequence| is
+// 0.
+FrameChanges CreateChanges(uint64_t sequence,
+                           uint64_t base_sequence = 0,
+                           int first_row = 0,
+                           int end_row = kFrameHeight) {
+  return FrameChanges{sequence, base_sequence, first_row, end_row};
+}
+
+}  // namespace
+
+// Frames are uploaded with the software renderer, and read back from its
+// target.
+class FrameUploaderTest : public testing::Test {
+ protected:
+  void SetUp() override { CreateTexture(1); }
+
+  void TearDown() override { DestroyTexture(); }
+
+  // Creates a texture |scale| times as large as a frame.
+  void CreateTexture(int scale) {
+    DestroyTexture();
+    width_ = kFrameWidth * scale;
+    height_ = kFrameHeight * scale;
+    target_ = SDL_CreateRGBSurfaceWithFormat(0, width_, height_, 32,
+                                             SDL_PIXELFORMAT_ARGB8888);
+    ASSERT_TRUE(target_);
+    renderer_ = SDL_CreateSoftwareRenderer(target_);
+    ASSERT_TRUE(renderer_);
+    texture_ = SDL_CreateTexture(renderer_, SDL_PIXELFORMAT_ARGB8888,
+                                 SDL_TEXTUREACCESS_STREAMING, width_, height_);
+    ASSERT_TRUE(texture_);
+    SDL_SetTextureBlendMode(texture_, SDL_BLENDMODE_NONE);
+    uploader_.Invalidate();
+  }
+
+  void DestroyTexture() {
+    if (texture_)
+      SDL_DestroyTexture(texture_);
+    if (renderer_)
+      SDL_DestroyRenderer(renderer_);
+    if (target_)
+      SDL_FreeSurface(target_);
+    texture_ = nullptr;
+    renderer_ = nullptr;
+    target_ = nullptr;
+  }
+
+  kiwi::nes::Colors ReadTexture() {
+    SDL_RenderCopy(renderer_, texture_, nullptr, nullptr);
+    kiwi::nes::Colors pixels(width_ * height_);
+    SDL_RenderReadPixels(renderer_, nullptr, SDL_PIXELFORMAT_ARGB8888,
+                         pixels.data(), width_ * sizeof(kiwi::nes::Color));
+    return pixels;
+  }
+
+  bool Upload(const kiwi::nes::Colors& frame, const FrameChanges& changes) {
+    return uploader_.Upload(texture_, kFrameWidth, kFrameHeight, frame,
+                            changes);
+  }
+
+  int width_ = 0;
+  int height_ = 0;
+  SDL_Surface* target_ = nullptr;
+  SDL_Renderer* renderer_ = nullptr;
+  SDL_Texture* texture_ = nullptr;
+  FrameUploader uploader_;
+};
+
+TEST_F(FrameUploaderTest, SkipsUploadedSequence) {
+  kiwi::nes::Colors frame = CreateFrame(1);
+  EXPECT_FALSE(uploader_.IsUploaded(1));
+  EXPECT_TRUE(Upload(frame, CreateChanges(1)));
+  EXPECT_TRUE(uploader_.IsUploaded(1));
+  EXPECT_EQ(ReadTexture(), frame);
+
+  // A frame of the same sequence has the same pixels, so that it isn't
+  // written. These pixels differ only to tell whether it is.
+  EXPECT_TRUE(Upload(CreateFrame(2), CreateChanges(1)));
+  EXPECT_EQ(ReadTexture(), frame);
+
+  frame = CreateFrame(2);
+  EXPECT_TRUE(Upload(frame, CreateChanges(2)));
+  EXPECT_FALSE(uploader_.IsUploaded(1));
+  EXPECT_TRUE(uploader_.IsUploaded(2));
+  EXPECT_EQ(ReadTexture(), frame);
+}
+
+TEST_F(FrameUploaderTest, Invalidate) {
+  EXPECT_TRUE(Upload(CreateFrame(1), CreateChanges(1)));
+  uploader_.Invalidate();
+  EXPECT_FALSE(uploader_.IsUploaded(1));
+
+  kiwi::nes::Colors frame = CreateFrame(2);
+  EXPECT_TRUE(Upload(frame, CreateChanges(1)));
+  EXPECT_EQ(ReadTexture(), frame);
+}
+
+// Only the changed rows are written if the texture holds the frame before,
+// and every row otherwise.
+TEST_F(FrameUploaderTest, WritesChangedRows) {
+  constexpr int kFirstRow = 100;
+  constexpr int kEndRow = 116;
+  kiwi::nes::Colors frame = CreateFrame(1);
+  EXPECT_TRUE(Upload(frame, CreateChanges(1)));
+
+  // Rows other than the changed ones differ only to tell whether they are
+  // written.
+  kiwi::nes::Colors next_frame = CreateFrame(2);
+  kiwi::nes::Colors expected = frame;
+  CopyRows(next_frame, kFirstRow, kEndRow, &expected);
+  EXPECT_TRUE(Upload(next_frame, CreateChanges(2, 1, kFirstRow, kEndRow)));
+  EXPECT_TRUE(uploader_.IsUploaded(2));
+  EXPECT_EQ(ReadTexture(), expected);
+
+  // The texture doesn't hold the frame of sequence 3.
+  EXPECT_TRUE(Upload(next_frame, CreateChanges(4, 3, kFirstRow, kEndRow)));
+  EXPECT_EQ(ReadTexture(), next_frame);
+}
+
+// A scaled frame is scaled straight into the texture, and has the same pixels
+// as one scaled into a buffer, whether all of it or its changed rows are.
+TEST_F(FrameUploaderTest, UploadsScaledFrames) {
+  constexpr int kFirstRow = 100;
+  constexpr int kEndRow = 116;
+  PixelScaler scaler(2);
+  kiwi::nes::Colors frame = CreateFrame(1);
+  kiwi::nes::Colors next_frame = frame;
+  CopyRows(CreateFrame(2), kFirstRow, kEndRow, &next_frame);
+  for (PixelScaler::Filter filter :
+       {PixelScaler::Filter::kScale2x, PixelScaler::Filter::kHQ3x,
+        PixelScaler::Filter::kXBR}) {
+    CreateTexture(PixelScaler::GetScaleFactor(filter));
+    kiwi::nes::Colors expected;
+    scaler.Scale(filter, kFrameWidth, kFrameHeight, frame, &expected);
+    EXPECT_TRUE(uploader_.UploadScaled(texture_, &scaler, filter, kFrameWidth,
+                                       kFrameHeight, frame, CreateChanges(1)));
+    EXPECT_TRUE(uploader_.IsUploaded(1));
+    EXPECT_EQ(ReadTexture(), expected) << PixelScaler::GetFilterName(filter);
+
+    scaler.Scale(filter, kFrameWidth, kFrameHeight, next_frame, &expected);
+    EXPECT_TRUE(uploader_.UploadScaled(
+        texture_, &scaler, filter, kFrameWidth, kFrameHeight, next_frame,
+        CreateChanges(2, 1, kFirstRow, kEndRow)));
+    EXPECT_EQ(ReadTexture(), expected) << PixelScaler::GetFilterName(filter);
+  }
+}
+
+// Measures an upload of every row with SDL_UpdateTexture() and with the
+// uploader, of 16 changed rows, and of a still frame, each the best of several
+// rounds. Changed rows and still frames must take less than
+// SDL_UpdateTexture().
+TEST_F(FrameUploaderTest, DISABLED_Cost) {
+  constexpr int kRoundCount = 5;
+  constexpr int kUploadCount = 1000;
+  using Duration = std::chrono::duration<double, std::micro>;
+  kiwi::nes::Colors frame = CreateFrame(1);
+  auto measure = [&](auto upload) {
+    Duration fastest = Duration::max();
+    for (int round = 0; round < kRoundCount; ++round) {
+      auto start = std::chrono::steady_clock::now();
+      for (int i = 0; i < kUploadCount; ++i)
+        upload(round * kUploadCount + i + 1);
+      fastest = std::min<Duration>(
+          fastest, (std::chrono::steady_clock::now() - start) / kUploadCount);
+    }
+    return fastest;
+  };
+
+  Duration update_texture = measure([&](uint64_t) {
+    SDL_UpdateTexture(texture_, nullptr, frame.data(),
+                      kFrameWidth * sizeof(kiwi::nes::Color));
+  });
+  Duration every_row = measure(
+      [&](uint64_t sequence) { Upload(frame, CreateChanges(sequence)); });
+  uploader_.Invalidate();
+  Upload(frame, CreateChanges(1));
+  Duration changed_rows = measure([&](uint64_t sequence) {
+    Upload(frame, CreateChanges(sequence + 1, sequence, 100, 116));
+  });
+  const uint64_t still_sequence = kRoundCount * kUploadCount + 1;
+  Duration still =
+      measure([&](uint64_t) { Upload(frame, CreateChanges(still_sequence)); });
+  EXPECT_EQ(ReadTexture(), frame);
+
+  RecordProperty("update_texture_us", static_cast<int>(update_texture.count()));
+  RecordProperty("every_row_us", static_cast<int>(every_row.count()));
+  RecordProperty("changed_rows_us", static_cast<int>(changed_rows.count()));
+  RecordProperty("still_us", static_cast<int>(still.count()));
+  std::cout << "Upload: " << update_texture.count()
+            << " us (SDL_UpdateTexture), " << every_row.count()
+            << " us (every row), " << changed_rows.count()
+            << " us (16 changed rows), " << still.count() << " us (still)"
+            << std::endl;
+  EXPECT_LT(changed_rows, update_texture);
+  EXPECT_LT(still, update_texture);
+}
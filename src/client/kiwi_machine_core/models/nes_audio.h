@@ -16,13 +16,19 @@
 #include <SDL.h>
 #include <kiwi_nes.h>
 
-#include <array>
-#include <atomic>
-
+#include "models/audio_ring.h"
 #include "models/nes_runtime.h"
 
 class NESAudio : public kiwi::nes::IODevices::AudioDevice {
  public:
+  // Bounds of the target latency, which is how long samples are queued before
+  // the audio device plays them, not counting the device's own buffer.
+  enum {
+    kMinLatencyMS = 20,
+    kMaxLatencyMS = 100,
+    kDefaultLatencyMS = 40,
+  };
+
   explicit NESAudio(NESRuntimeID runtime_id);
   ~NESAudio() override;
 
@@ -31,41 +37,39 @@ class NESAudio : public kiwi::nes::IODevices::AudioDevice {
   void Start();
   void Reset();
 
+  // Sets the target latency, which is clamped to [kMinLatencyMS,
+  // kMaxLatencyMS].
+  void SetTargetLatency(int latency_ms);
+  int target_latency_ms() const { return target_latency_ms_; }
+
+  // Latency is in samples, see AudioRing::Stats.
+  AudioRing::Stats GetStats() const { return ring_.GetStats(); }
+
  private:
   static void ReadAudioBuffer(void* userdata, Uint8* stream, int len);
 
  private:
-  void ResetBuffer();
-  void ReadAudioBuffer(Uint8* stream, int count);
-  void Write(kiwi::nes::Sample* samples, size_t count);
+  void ReadAudioBuffer(Uint8* stream, int len);
 
  protected:
   // kiwi::nes::IODevices::AudioDevice:
   void OnSampleArrived(kiwi::nes::Sample* samples, size_t count) override;
+  double GetSampleRateRatio() override;
 
  private:
   enum {
-    kBufferSize = 512,
-    kBufferCount = 48,
+    // Samples the audio device asks for in a callback.
+    kDeviceBufferSize = 512,
+    // Holds kMaxLatencyMS, a device buffer and a frame of samples.
+    kRingCapacity = 8192,
   };
 
   NESRuntimeID runtime_id_ = 0;
   NESRuntime::Data* runtime_data_ = nullptr;
   SDL_AudioDeviceID audio_device_id_ = 0;
   SDL_AudioSpec audio_spec_;
-
-  // Buffers - use atomic counters for simplified synchronization
-  std::array<std::array<kiwi::nes::Sample, kBufferSize>, kBufferCount> buffers_;
-  // Temporary accumulation buffer
-  std::array<kiwi::nes::Sample, kBufferSize> temp_buffer_;
-  // Current position in temp buffer
-  size_t temp_pos_ = 0;
-  // Next buffer index to write
-  std::atomic<size_t> write_buf_{0};
-  // Next buffer index to read
-  std::atomic<size_t> read_buf_{0};
-  // Number of filled buffers
-  std::atomic<size_t> filled_count_{0};
+  int target_latency_ms_ = kDefaultLatencyMS;
+  AudioRing ring_{kRingCapacity};
 };
 
-#endif  // MODELS_NES_AUDIO_H
+#endif  // MODELS_NES_AUDIO_H_
@@ -12,6 +12,8 @@
 
 #include "models/nes_config.h"
 
+#include <algorithm>
+
 #include "build/kiwi_defines.h"
 #include "ui/application.h"
 
@@ -60,21 +62,32 @@ bool SaveConfigOnIOThread(const kiwi::base::FilePath& profile_path,
 
 }  // namespace
 
+// Fields which are missing in the settings file keep their default values.
 #if KIWI_MOBILE
-NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(NESConfig::Data,
-                                   window_scale,
-                                   is_fullscreen,
-                                   volume,
-                                   last_index,
-                                   is_stretch_mode,
-                                   language);
+NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE_WITH_DEFAULT(NESConfig::Data,
+                                                window_scale,
+                                                is_fullscreen,
+                                                volume,
+                                                last_index,
+                                                is_stretch_mode,
+                                                language,
+                                                run_ahead_frames,
+                                                run_ahead_second_instance,
+                                                audio_latency_ms,
+                                                fast_forward_speed,
+                                                pixel_scaler_filter);
 #else
-NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(NESConfig::Data,
-                                   window_scale,
-                                   is_fullscreen,
-                                   volume,
-                                   last_index,
-                                   language);
+NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE_WITH_DEFAULT(NESConfig::Data,
+                                                window_scale,
+                                                is_fullscreen,
+                                                volume,
+                                                last_index,
+                                                language,
+                                                run_ahead_frames,
+                                                run_ahead_second_instance,
+                                                audio_latency_ms,
+                                                fast_forward_speed,
+                                                pixel_scaler_filter);
 #endif
 
 NESConfig::NESConfig(const kiwi::base::FilePath& profile_path)
@@ -82,6 +95,13 @@ NESConfig::NESConfig(const kiwi::base::FilePath& profile_path)
 
 NESConfig::~NESConfig() = default;
 
+int NESConfig::GetRunAheadFrames(int crc32) {
+  char key[9];
+  SDL_snprintf(key, sizeof(key), "%08X", static_cast<uint32_t>(crc32));
+  auto iter = data_.run_ahead_frames.find(key);
+  return iter == data_.run_ahead_frames.end() ? 0 : std::max(iter->second, 0);
+}
+
 void NESConfig::LoadConfigAndWait() {
   LoadFromUTF8Json(LoadConfigBlocked(profile_path_));
 }
@@ -14,6 +14,7 @@
 #define NES_CONFIG_H_
 
 #include <kiwi_nes.h>
+#include <map>
 #include <string>
 
 #include "build/kiwi_defines.h"
@@ -29,6 +30,15 @@ class NESConfig : public kiwi::base::RefCounted<NESConfig> {
     float volume = 1.f;
     int last_index = 0;
     int language = -1;  // -1 means automatic (follows system's locale)
+    // Frames to run ahead for each game, keyed by its CRC32 in hex.
+    std::map<std::string, int> run_ahead_frames;
+    bool run_ahead_second_instance = false;
+    // Target latency of the audio output, see NESAudio::SetTargetLatency().
+    int audio_latency_ms = 40;
+    // Speed while the fast-forward key is held, from 2 to 8.
+    int fast_forward_speed = 4;
+    // Filter which frames are scaled by, a PixelScaler::Filter.
+    int pixel_scaler_filter = 0;
 #if KIWI_MOBILE
     bool is_stretch_mode = true;
 #endif
@@ -42,6 +52,9 @@ class NESConfig : public kiwi::base::RefCounted<NESConfig> {
 
   Data& data() { return data_; }
 
+  // Gets how many frames to run ahead for the game, 0 if it doesn't run ahead.
+  int GetRunAheadFrames(int crc32);
+
   // LoadConfigAndWait will block current thread, read config from disk device.
   void LoadConfigAndWait();
   void SaveConfig();
@@ -32,7 +32,20 @@ void NESFrame::RemoveObserver(NESFrameObserver* observer) {
   observers_.erase(observer);
 }
 
+void NESFrame::SetPixelScalerFilter(PixelScaler::Filter filter) {
+  if (pixel_scaler_filter_ == filter)
+    return;
+
+  pixel_scaler_filter_ = filter;
+  // The texture's size depends on the filter, so that it is recreated by the
+  // next frame.
+  render_width_ = 0;
+  render_height_ = 0;
+}
+
 void NESFrame::Render(int width, int height, const kiwi::nes::Colors& buffer) {
+  const int scale_factor = PixelScaler::GetScaleFactor(pixel_scaler_filter_);
+
   // Creates texture if not exists or size changed
   if (render_width_ != width || render_height_ != height) {
     render_width_ = width;
@@ -46,14 +59,28 @@ void NESFrame::Render(int width, int height, const kiwi::nes::Colors& buffer) {
       SDL_assert(render_width_ > 0 && render_height_ > 0);
       screen_texture_ = SDL_CreateTexture(
           window_->renderer(), SDL_PIXELFORMAT_ARGB8888,
-          SDL_TEXTUREACCESS_STREAMING, render_width_, render_height_);
+          SDL_TEXTUREACCESS_STREAMING, render_width_ * scale_factor,
+          render_height_ * scale_factor);
+      uploader_.Invalidate();
     }
   }
 
-  // Updates contents
-  int result = SDL_UpdateTexture(screen_texture_, nullptr, buffer.data(),
-                                 render_width_ * sizeof(buffer[0]));
-  SDL_assert(result == 0);
+  // Updates contents, which are scaled by the filter if there's one. A frame
+  // which is already in the texture is neither scaled nor uploaded again.
+  const kiwi::nes::Emulator::FrameChanges frame_changes =
+      runtime_data_->emulator->GetPresentedFrameChanges();
+  bool result;
+  if (pixel_scaler_filter_ != PixelScaler::Filter::kNone) {
+    if (!pixel_scaler_)
+      pixel_scaler_ = std::make_unique<PixelScaler>();
+    result = uploader_.UploadScaled(screen_texture_, pixel_scaler_.get(),
+                                    pixel_scaler_filter_, width, height,
+                                    buffer, frame_changes);
+  } else {
+    result = uploader_.Upload(screen_texture_, width, height, buffer,
+                              frame_changes);
+  }
+  SDL_assert(result);
 
   // Notifies observers
   if (!observers_.empty()) {
@@ -16,9 +16,12 @@
 #include <SDL.h>
 #include <kiwi_nes.h>
 #include <chrono>
+#include <memory>
 #include <set>
 
+#include "models/frame_uploader.h"
 #include "models/nes_runtime.h"
+#include "utility/pixel_scaler.h"
 #include "utility/timer.h"
 
 class WindowBase;
@@ -46,6 +49,12 @@ class NESFrame : public kiwi::base::RefCounted<NESFrame>,
   void Render(int width, int height, const kiwi::nes::Colors& buffer) override;
   bool NeedRender() override;
 
+  // Scales frames by |filter| before they are uploaded. The texture gets
+  // larger by the filter's scale factor, while width() and height() stay the
+  // size of the frames.
+  void SetPixelScalerFilter(PixelScaler::Filter filter);
+  PixelScaler::Filter pixel_scaler_filter() { return pixel_scaler_filter_; }
+
   int width() { return render_width_; }
   int height() { return render_height_; }
   SDL_Texture* texture() { return screen_texture_; }
@@ -57,8 +66,11 @@ class NESFrame : public kiwi::base::RefCounted<NESFrame>,
   NESRuntime::Data* runtime_data_ = nullptr;
 
   SDL_Texture* screen_texture_ = nullptr;
+  FrameUploader uploader_;
   int render_width_ = 0;   // UI thread access only
   int render_height_ = 0;  // UI thread access only
+  PixelScaler::Filter pixel_scaler_filter_ = PixelScaler::Filter::kNone;
+  std::unique_ptr<PixelScaler> pixel_scaler_;  // Created by the first use.
   Timer frame_elapsed_counter_;
   std::set<NESFrameObserver*> observers_;
 };
@@ -15,11 +15,11 @@
 #include <SDL.h>
 #include <SDL_image.h>
 #include <time.h>
-#include <tiny_jpeg.h>
 #include <chrono>
-#include <set>
 #include <vector>
 
+#include "models/auto_save_ring.h"
+#include "models/state_thumbnail.h"
 #include "ui/application.h"
 #include "ui/widgets/canvas.h"
 
@@ -30,19 +30,6 @@
 namespace {
 std::vector<std::unique_ptr<NESRuntime::Data>> g_runtime_data;
 
-struct FilePathSorter {
-  bool operator()(const kiwi::base::FilePath& lhs,
-                  const kiwi::base::FilePath& rhs) const {
-    uint64_t timestamp_lhs;
-    kiwi::base::StringToUint64(lhs.BaseName().AsUTF8Unsafe(), &timestamp_lhs);
-
-    uint64_t timestamp_rhs;
-    kiwi::base::StringToUint64(rhs.BaseName().AsUTF8Unsafe(), &timestamp_rhs);
-
-    return timestamp_lhs > timestamp_rhs;
-  }
-};
-
 kiwi::base::FilePath GetProfilePath(const std::string& name) {
 #if KIWI_WASM
   // In WASM, use /persistent directory for IDBFS
@@ -112,11 +99,10 @@ kiwi::base::FilePath GetSnapshotThumbnailPath(
   return GetSnapshotThumbnailPath(GetSnapshotPath(profile_path, crc32, slot));
 }
 
-bool SaveStateByPathOnIOThread(
-    const kiwi::base::FilePath& path_to_data,
-    const kiwi::base::FilePath& path_to_thumbnail,
-    const kiwi::nes::Bytes& state_data,
-    const kiwi::nes::IODevices::RenderDevice::Buffer& thumbnail_data) {
+bool SaveStateByPathOnIOThread(const kiwi::base::FilePath& path_to_data,
+                               const kiwi::base::FilePath& path_to_thumbnail,
+                               const kiwi::nes::Bytes& state_data,
+                               const StateThumbnail& thumbnail) {
   if (!kiwi::base::PathExists(path_to_data.DirName()))
     kiwi::base::CreateDirectory(path_to_data.DirName());
 
@@ -136,15 +122,9 @@ bool SaveStateByPathOnIOThread(
     if (!file.IsValid())
       return false;
 
-    // Transfer thumbnail data to jpeg to save space.
-    tje_encode_with_func(
-        [](void* context, void* data, int size) {
-          kiwi::base::File* file = reinterpret_cast<kiwi::base::File*>(context);
-          file->WriteAtCurrentPos(reinterpret_cast<const char*>(data), size);
-        },
-        &file, 2, Canvas::kNESFrameDefaultWidth, Canvas::kNESFrameDefaultHeight,
-        4, reinterpret_cast<const unsigned char*>(thumbnail_data.data()),
-        Canvas::kNESFrameDefaultWidth * sizeof(thumbnail_data[0]));
+    kiwi::nes::Bytes thumbnail_data = EncodeStateThumbnail(thumbnail);
+    file.Write(0, reinterpret_cast<const char*>(thumbnail_data.data()),
+               thumbnail_data.size());
   }
 
 #if KIWI_WASM
@@ -154,85 +134,87 @@ bool SaveStateByPathOnIOThread(
   return true;
 }
 
+StateThumbnail CreateThumbnailFromFrame(
+    const kiwi::nes::IODevices::RenderDevice::Buffer& frame) {
+  return CreateStateThumbnail(frame, Canvas::kNESFrameDefaultWidth,
+                              Canvas::kNESFrameDefaultHeight);
+}
+
 bool SaveStateOnIOThread(
+    StateThumbnailCache* thumbnail_cache,
     const kiwi::base::FilePath& profile_path,
     int crc32,
     int slot,
     const kiwi::nes::Bytes& state_data,
-    const kiwi::nes::IODevices::RenderDevice::Buffer& thumbnail_data) {
+    const kiwi::nes::IODevices::RenderDevice::Buffer& frame) {
   kiwi::base::FilePath path_to_data =
       GetSnapshotDataPath(profile_path, crc32, slot);
   kiwi::base::FilePath path_to_thumbnail =
       GetSnapshotThumbnailPath(profile_path, crc32, slot);
 
-  return SaveStateByPathOnIOThread(path_to_data, path_to_thumbnail, state_data,
-                                   thumbnail_data);
+  StateThumbnailCache::Key key{crc32, false, slot};
+  thumbnail_cache->Invalidate(key);
+  StateThumbnail thumbnail = CreateThumbnailFromFrame(frame);
+  if (!SaveStateByPathOnIOThread(path_to_data, path_to_thumbnail, state_data,
+                                 thumbnail)) {
+    return false;
+  }
+
+  // Manual states are always found by slots, so they have only one version.
+  thumbnail_cache->Put(key, 0, thumbnail);
+  return true;
+}
+
+// Loads the index of auto-saved states. If it can't be used, such as the states
+// were saved by timestamps before, it's rebuilt from the files.
+void LoadAutoSaveRing(AutoSaveRing* ring) {
+  if (!ring->Load())
+    ring->Recover();
 }
 
-bool SaveAutoSavedStateOnIOThread(
+bool SaveAutoSavedStateOnAutoSaveThread(
+    StateThumbnailCache* thumbnail_cache,
     time_t timestamp,
     const kiwi::base::FilePath& profile_path,
     int crc32,
     const kiwi::nes::Bytes& state_data,
-    const kiwi::nes::IODevices::RenderDevice::Buffer& thumbnail_data) {
+    const kiwi::nes::IODevices::RenderDevice::Buffer& frame) {
   kiwi::base::FilePath auto_saved_snapshot_path =
       GetAutoSavedStatePath(profile_path, crc32);
-  std::string timestamp_str = std::to_string(timestamp);
-  kiwi::base::FilePath state_path = auto_saved_snapshot_path.Append(
-      kiwi::base::FilePath::FromUTF8Unsafe(timestamp_str));
-  bool success = SaveStateByPathOnIOThread(GetSnapshotDataPath(state_path),
-                                           GetSnapshotThumbnailPath(state_path),
-                                           state_data, thumbnail_data);
-
-  if (success) {
-    // Check all auto save states, delete redundant states.
-    kiwi::base::FileEnumerator fe(auto_saved_snapshot_path, false,
-                                  kiwi::base::FileEnumerator::DIRECTORIES);
-    kiwi::base::FilePath path = fe.Next();
-    std::set<kiwi::base::FilePath, FilePathSorter> files;
-    while (!path.empty()) {
-      // Sorted by base name (to utc)
-      files.insert(path);
-      path = fe.Next();
-    }
-
-    int max_auto_save_states = NESRuntime::Data::MaxAutoSaveStates;
-    while (files.size() > max_auto_save_states) {
-      bool deleted = kiwi::base::DeletePathRecursively(*files.rbegin());
-      SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "Delete %s %s.",
-                   files.begin()->BaseName().AsUTF8Unsafe().c_str(),
-                   deleted ? "successfully" : "failed");
-      if (!deleted) {
-        // Increase max states count, the deletion failed entry will be deleted
-        // next time.
-        ++max_auto_save_states;
-      }
-      files.erase(*files.rbegin());
-    }
+  AutoSaveRing ring(auto_saved_snapshot_path,
+                    NESRuntime::Data::MaxAutoSaveStates);
+  LoadAutoSaveRing(&ring);
+
+  // Overwrites the oldest slot. The slot is invalidated first, so that a crash
+  // during writing makes the prior entry the newest one.
+  int slot = ring.GetNextSlot();
+  StateThumbnailCache::Key key{crc32, true, slot};
+  thumbnail_cache->Invalidate(key);
+  if (!ring.Invalidate(slot))
+    return false;
+
+  kiwi::base::FilePath state_path = ring.GetSlotPath(slot);
+  StateThumbnail thumbnail = CreateThumbnailFromFrame(frame);
+  if (!SaveStateByPathOnIOThread(GetSnapshotDataPath(state_path),
+                                 GetSnapshotThumbnailPath(state_path),
+                                 state_data, thumbnail)) {
+    return false;
   }
 
-  return success;
+  if (!ring.Commit(slot, timestamp, state_data))
+    return false;
+
+  thumbnail_cache->Put(key, ring.entry(slot).sequence, thumbnail);
+  return true;
 }
 
-int GetAutoSavedStatesCountOnIOThread(const kiwi::base::FilePath& profile_path,
-                                      int crc32) {
-  kiwi::base::FilePath auto_saved_snapshot_path =
-      GetAutoSavedStatePath(profile_path, crc32);
-  if (!kiwi::base::PathExists(auto_saved_snapshot_path))
-    kiwi::base::CreateDirectory(auto_saved_snapshot_path);
-
-  kiwi::base::FileEnumerator fe(auto_saved_snapshot_path, false,
-                                kiwi::base::FileEnumerator::DIRECTORIES);
-  kiwi::base::FilePath path = fe.Next();
-  std::set<kiwi::base::FilePath, FilePathSorter> files;
-  int count = 0;
-  while (!path.empty()) {
-    // Sorted by base name (to utc)
-    files.insert(path);
-    path = fe.Next();
-    ++count;
-  }
-  return count;
+int GetAutoSavedStatesCountOnAutoSaveThread(
+    const kiwi::base::FilePath& profile_path,
+    int crc32) {
+  AutoSaveRing ring(GetAutoSavedStatePath(profile_path, crc32),
+                    NESRuntime::Data::MaxAutoSaveStates);
+  LoadAutoSaveRing(&ring);
+  return ring.GetEntries().size();
 }
 
 kiwi::nes::Bytes ReadDataFromProfile(const std::string& path) {
@@ -247,118 +229,145 @@ kiwi::nes::Bytes ReadDataFromProfile(const std::string& path) {
   return data;
 }
 
-NESRuntime::Data::StateResult GetStateByPathOnIOThread(
-    const kiwi::base::FilePath& path_to_data,
-    const kiwi::base::FilePath& path_to_thumbnail) {
-  NESRuntime::Data::StateResult sr{false};
-  sr.state_data = ReadDataFromProfile(path_to_data.AsUTF8Unsafe());
-
-  // Thumbnail is JPEG format, convert it to pixel data:
-  kiwi::nes::Bytes source =
-      ReadDataFromProfile(path_to_thumbnail.AsUTF8Unsafe());
-  if (!source.empty()) {
-    SDL_RWops* rw = SDL_RWFromConstMem(source.data(), source.size());
-    SDL_Surface* surface = IMG_Load_RW(rw, true);
-    if (surface->format->format == SDL_PIXELFORMAT_RGB24) {
-      sr.thumbnail_data.resize(4 * surface->w * surface->h);
-      kiwi::nes::Byte* ptr = reinterpret_cast<unsigned char*>(surface->pixels);
-      kiwi::nes::Byte* end = reinterpret_cast<unsigned char*>(surface->pixels) +
-                             (surface->pitch * surface->h);
-      size_t index = 0;
-      while (ptr < end) {
-        sr.thumbnail_data.at(index++) = ptr[0];
-        sr.thumbnail_data.at(index++) = ptr[1];
-        sr.thumbnail_data.at(index++) = ptr[2];
-        sr.thumbnail_data.at(index++) = 0xff;
-        ptr += 3;
-      }
-
-    } else if (surface->format->format == SDL_PIXELFORMAT_RGBA8888) {
-      sr.thumbnail_data.resize(surface->pitch * surface->h);
-      memcpy(sr.thumbnail_data.data(), surface->pixels,
-             sr.thumbnail_data.size());
-    } else {
-      SDL_assert(false);  // Format doesn't support.
+// Reads the thumbnail of a state, or takes it from |thumbnail_cache| if it
+// has been read or saved before.
+bool GetThumbnailByPath(StateThumbnailCache* thumbnail_cache,
+                        const StateThumbnailCache::Key& key,
+                        uint64_t version,
+                        const kiwi::base::FilePath& path_to_thumbnail,
+                        NESRuntime::Data::StateResult* state_result) {
+  StateThumbnail thumbnail;
+  if (!thumbnail_cache->Get(key, version, &thumbnail)) {
+    if (!DecodeStateThumbnail(
+            ReadDataFromProfile(path_to_thumbnail.AsUTF8Unsafe()),
+            &thumbnail)) {
+      SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Can't decode thumbnail %s",
+                  path_to_thumbnail.AsUTF8Unsafe().c_str());
+      return false;
     }
-    SDL_FreeSurface(surface);
+    thumbnail_cache->Put(key, version, thumbnail);
   }
 
-  sr.success = !sr.state_data.empty() && !sr.thumbnail_data.empty();
-  return sr;
+  state_result->thumbnail_width = thumbnail.width;
+  state_result->thumbnail_height = thumbnail.height;
+  state_result->thumbnail_data = std::move(thumbnail.pixels);
+  return true;
 }
 
 NESRuntime::Data::StateResult GetStateOnIOThread(
     const kiwi::base::FilePath& profile_path,
     int crc32,
     int slot) {
-  kiwi::base::FilePath path_to_data =
-      GetSnapshotDataPath(profile_path, crc32, slot);
-  kiwi::base::FilePath path_to_thumbnail =
-      GetSnapshotThumbnailPath(profile_path, crc32, slot);
-  NESRuntime::Data::StateResult sr =
-      GetStateByPathOnIOThread(path_to_data, path_to_thumbnail);
+  NESRuntime::Data::StateResult sr{false};
+  sr.state_data = ReadDataFromProfile(
+      GetSnapshotDataPath(profile_path, crc32, slot).AsUTF8Unsafe());
+  sr.success = !sr.state_data.empty();
   sr.slot_or_timestamp = slot;
   return sr;
 }
 
-NESRuntime::Data::StateResult GetAutoSavedStateByTimestampOnIOThread(
+NESRuntime::Data::StateResult GetStateThumbnailOnIOThread(
+    StateThumbnailCache* thumbnail_cache,
+    const kiwi::base::FilePath& profile_path,
+    int crc32,
+    int slot) {
+  NESRuntime::Data::StateResult sr{false};
+  sr.slot_or_timestamp = slot;
+  if (kiwi::base::PathExists(GetSnapshotDataPath(profile_path, crc32, slot))) {
+    sr.success = GetThumbnailByPath(
+        thumbnail_cache, StateThumbnailCache::Key{crc32, false, slot}, 0,
+        GetSnapshotThumbnailPath(profile_path, crc32, slot), &sr);
+  }
+  return sr;
+}
+
+// Reads the state of |entry|, and checks whether it is what the index
+// recorded.
+NESRuntime::Data::StateResult GetAutoSavedStateByEntry(
+    const AutoSaveRing& ring,
+    const AutoSaveRing::Entry& entry) {
+  NESRuntime::Data::StateResult sr{false};
+  sr.state_data = ReadDataFromProfile(
+      GetSnapshotDataPath(ring.GetSlotPath(entry.slot)).AsUTF8Unsafe());
+  sr.success = AutoSaveRing::Verify(entry, sr.state_data);
+  if (!sr.success) {
+    SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION,
+                "Auto saved state in slot %d is corrupted.", entry.slot);
+  }
+  sr.slot_or_timestamp = entry.timestamp;
+  return sr;
+}
+
+// Maps |slot| to the index of auto-saved entries, which are sorted from the
+// newest one.
+int GetAutoSavedEntryIndex(int slot, int count) {
+  SDL_assert(count > 0);
+  int index = slot < 0 ? (count + slot - 1) : slot % count;
+  if (index < 0)
+    index = 0;
+  SDL_assert(index >= 0 && index < count);
+  return index;
+}
+
+NESRuntime::Data::StateResult GetAutoSavedStateByTimestampOnAutoSaveThread(
     const kiwi::base::FilePath& profile_path,
     int crc32,
     uint64_t timestamp) {
-  kiwi::base::FilePath auto_saved_snapshot_path =
-      GetAutoSavedStatePath(profile_path, crc32);
-  kiwi::base::FilePath state_path = auto_saved_snapshot_path.Append(
-      kiwi::base::FilePath::FromUTF8Unsafe(std::to_string(timestamp)));
+  AutoSaveRing ring(GetAutoSavedStatePath(profile_path, crc32),
+                    NESRuntime::Data::MaxAutoSaveStates);
+  LoadAutoSaveRing(&ring);
+  for (const AutoSaveRing::Entry& entry : ring.GetEntries()) {
+    if (entry.timestamp == timestamp)
+      return GetAutoSavedStateByEntry(ring, entry);
+  }
 
-  NESRuntime::Data::StateResult sr = GetStateByPathOnIOThread(
-      GetSnapshotDataPath(state_path), GetSnapshotThumbnailPath(state_path));
+  NESRuntime::Data::StateResult sr{false};
   sr.slot_or_timestamp = timestamp;
   return sr;
 }
 
-NESRuntime::Data::StateResult GetAutoSavedStateOnIOThread(
+NESRuntime::Data::StateResult GetAutoSavedStateOnAutoSaveThread(
     const kiwi::base::FilePath& profile_path,
     int crc32,
     int slot) {
   NESRuntime::Data::StateResult sr{false};
-  kiwi::base::FilePath auto_saved_snapshot_path =
-      GetAutoSavedStatePath(profile_path, crc32);
-  if (!kiwi::base::PathExists(auto_saved_snapshot_path)) {
-    bool created = kiwi::base::CreateDirectory(auto_saved_snapshot_path);
-    if (!created) {
-      SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
-                   "Can't open or create auto saved entry at %s",
-                   profile_path.AsUTF8Unsafe().c_str());
-      return sr;
-    }
-  }
+  AutoSaveRing ring(GetAutoSavedStatePath(profile_path, crc32),
+                    NESRuntime::Data::MaxAutoSaveStates);
+  LoadAutoSaveRing(&ring);
+  std::vector<AutoSaveRing::Entry> entries = ring.GetEntries();
+  if (entries.empty())
+    return sr;
 
-  kiwi::base::FileEnumerator fe(auto_saved_snapshot_path, false,
-                                kiwi::base::FileEnumerator::DIRECTORIES);
-  kiwi::base::FilePath path = fe.Next();
-  std::set<kiwi::base::FilePath, FilePathSorter> files;
-  while (!path.empty()) {
-    // Sorted by base name (to utc)
-    files.insert(path);
-    path = fe.Next();
+  // If the state is broken, falls back to older ones.
+  for (int index = GetAutoSavedEntryIndex(slot, entries.size());
+       index < entries.size(); ++index) {
+    sr = GetAutoSavedStateByEntry(ring, entries[index]);
+    if (sr.success)
+      break;
   }
+  return sr;
+}
 
-  std::vector<kiwi::base::FilePath> random_files(files.begin(), files.end());
-  if (random_files.empty())
+NESRuntime::Data::StateResult GetAutoSavedStateThumbnailOnAutoSaveThread(
+    StateThumbnailCache* thumbnail_cache,
+    const kiwi::base::FilePath& profile_path,
+    int crc32,
+    int slot) {
+  NESRuntime::Data::StateResult sr{false};
+  AutoSaveRing ring(GetAutoSavedStatePath(profile_path, crc32),
+                    NESRuntime::Data::MaxAutoSaveStates);
+  LoadAutoSaveRing(&ring);
+  std::vector<AutoSaveRing::Entry> entries = ring.GetEntries();
+  if (entries.empty())
     return sr;
 
-  // Gets state file from the end of the vector.
-  int index = slot < 0 ? (static_cast<int>(random_files.size()) + slot - 1)
-                       : slot % random_files.size();
-  if (index < 0)
-    index = 0;
-  SDL_assert(index >= 0 && index < random_files.size());
-  const kiwi::base::FilePath& target_file = random_files[index];
-  sr = GetStateByPathOnIOThread(GetSnapshotDataPath(target_file),
-                                GetSnapshotThumbnailPath(target_file));
-  uint64_t timestamp;
-  kiwi::base::StringToUint64(target_file.BaseName().AsUTF8Unsafe(), &timestamp);
-  sr.slot_or_timestamp = timestamp;
+  const AutoSaveRing::Entry& entry =
+      entries[GetAutoSavedEntryIndex(slot, entries.size())];
+  sr.slot_or_timestamp = entry.timestamp;
+  sr.success = GetThumbnailByPath(
+      thumbnail_cache, StateThumbnailCache::Key{crc32, true, entry.slot},
+      entry.sequence, GetSnapshotThumbnailPath(ring.GetSlotPath(entry.slot)),
+      &sr);
   return sr;
 }
 
@@ -379,18 +388,18 @@ void NESRuntime::Data::SaveState(
     kiwi::base::OnceCallback<void(bool)> callback) {
   Application::Get()->GetIOTaskRunner()->PostTaskAndReplyWithResult(
       FROM_HERE,
-      kiwi::base::BindOnce(&SaveStateOnIOThread, profile_path, crc32, slot,
-                           saved_state, thumbnail),
+      kiwi::base::BindOnce(&SaveStateOnIOThread, &thumbnail_cache_,
+                           profile_path, crc32, slot, saved_state, thumbnail),
       std::move(callback));
 }
 
 void NESRuntime::Data::GetAutoSavedStatesCount(
     int crc32,
     kiwi::base::OnceCallback<void(int)> callback) {
-  Application::Get()->GetIOTaskRunner()->PostTaskAndReplyWithResult(
+  Application::Get()->GetAutoSaveTaskRunner()->PostTaskAndReplyWithResult(
       FROM_HERE,
-      kiwi::base::BindOnce(&GetAutoSavedStatesCountOnIOThread, profile_path,
-                           crc32),
+      kiwi::base::BindOnce(&GetAutoSavedStatesCountOnAutoSaveThread,
+                           profile_path, crc32),
       std::move(callback));
 }
 
@@ -398,10 +407,10 @@ void NESRuntime::Data::GetAutoSavedState(
     int crc32,
     int slot,
     kiwi::base::OnceCallback<void(const StateResult&)> load_callback) {
-  Application::Get()->GetIOTaskRunner()->PostTaskAndReplyWithResult(
+  Application::Get()->GetAutoSaveTaskRunner()->PostTaskAndReplyWithResult(
       FROM_HERE,
-      kiwi::base::BindOnce(&GetAutoSavedStateOnIOThread, profile_path, crc32,
-                           slot),
+      kiwi::base::BindOnce(&GetAutoSavedStateOnAutoSaveThread, profile_path,
+                           crc32, slot),
       std::move(load_callback));
 }
 
@@ -409,9 +418,9 @@ void NESRuntime::Data::GetAutoSavedStateByTimestamp(
     int crc32,
     uint64_t timestamp,
     kiwi::base::OnceCallback<void(const StateResult&)> load_callback) {
-  Application::Get()->GetIOTaskRunner()->PostTaskAndReplyWithResult(
+  Application::Get()->GetAutoSaveTaskRunner()->PostTaskAndReplyWithResult(
       FROM_HERE,
-      kiwi::base::BindOnce(&GetAutoSavedStateByTimestampOnIOThread,
+      kiwi::base::BindOnce(&GetAutoSavedStateByTimestampOnAutoSaveThread,
                            profile_path, crc32, timestamp),
       std::move(load_callback));
 }
@@ -426,6 +435,28 @@ void NESRuntime::Data::GetState(
       std::move(load_callback));
 }
 
+void NESRuntime::Data::GetStateThumbnail(
+    int crc32,
+    int slot,
+    kiwi::base::OnceCallback<void(const StateResult&)> load_callback) {
+  Application::Get()->GetIOTaskRunner()->PostTaskAndReplyWithResult(
+      FROM_HERE,
+      kiwi::base::BindOnce(&GetStateThumbnailOnIOThread, &thumbnail_cache_,
+                           profile_path, crc32, slot),
+      std::move(load_callback));
+}
+
+void NESRuntime::Data::GetAutoSavedStateThumbnail(
+    int crc32,
+    int slot,
+    kiwi::base::OnceCallback<void(const StateResult&)> load_callback) {
+  Application::Get()->GetAutoSaveTaskRunner()->PostTaskAndReplyWithResult(
+      FROM_HERE,
+      kiwi::base::BindOnce(&GetAutoSavedStateThumbnailOnAutoSaveThread,
+                           &thumbnail_cache_, profile_path, crc32, slot),
+      std::move(load_callback));
+}
+
 kiwi::base::RepeatingClosure NESRuntime::Data::CreateAutoSaveClosure(
     kiwi::base::TimeDelta delta,
     GetThumbnailCallback thumbnail) {
@@ -444,11 +475,12 @@ kiwi::base::RepeatingClosure NESRuntime::Data::CreateAutoSaveClosure(
                  kiwi::base::TimeDelta delta, GetThumbnailCallback thumbnail,
                  kiwi::nes::Bytes data) {
                 Application::Get()
-                    ->GetIOTaskRunner()
+                    ->GetAutoSaveTaskRunner()
                     ->PostTaskAndReplyWithResult(
                         FROM_HERE,
                         kiwi::base::BindOnce(
-                            &SaveAutoSavedStateOnIOThread,
+                            &SaveAutoSavedStateOnAutoSaveThread,
+                            &runtime_data->thumbnail_cache_,
                             std::chrono::system_clock::to_time_t(
                                 std::chrono::system_clock::now()),
                             runtime_data->profile_path, crc, data,
@@ -512,10 +544,29 @@ kiwi::nes::Bytes NESRuntime::Data::ReadSaveStateThumbnail(int crc32, int slot) {
     return {};
   }
   auto result = kiwi::base::ReadFileToBytes(path_to_thumbnail);
-  if (result.has_value()) {
-    return result.value();
+  StateThumbnail thumbnail;
+  if (!result.has_value() || !DecodeStateThumbnail(*result, &thumbnail)) {
+    return {};
+  }
+
+  // Browsers can't show the indexed thumbnail, converts it to BMP.
+  constexpr int kBMPHeaderReservedSize = 1024;
+  SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormatFrom(
+      thumbnail.pixels.data(), thumbnail.width, thumbnail.height, 32,
+      thumbnail.width * sizeof(kiwi::nes::Color), SDL_PIXELFORMAT_ARGB8888);
+  if (!surface) {
+    return {};
+  }
+  kiwi::nes::Bytes bmp(thumbnail.pixels.size() + kBMPHeaderReservedSize);
+  SDL_RWops* rw = SDL_RWFromMem(bmp.data(), bmp.size());
+  if (SDL_SaveBMP_RW(surface, rw, 0) == 0) {
+    bmp.resize(SDL_RWtell(rw));
+  } else {
+    bmp.clear();
   }
-  return {};
+  SDL_RWclose(rw);
+  SDL_FreeSurface(surface);
+  return bmp;
 }
 
 bool NESRuntime::Data::DeleteSaveState(int crc32, int slot) {
@@ -20,6 +20,7 @@
 #include "build/kiwi_defines.h"
 #include "debug/debug_port.h"
 #include "models/nes_config.h"
+#include "models/state_thumbnail.h"
 
 using NESRuntimeID = size_t;
 class NESRuntime {
@@ -69,8 +70,11 @@ class NESRuntime {
     struct StateResult {
       bool success;
       kiwi::nes::Bytes state_data;
-      kiwi::nes::Bytes thumbnail_data;  // Thumbnail data with 3 components
+      // Thumbnail pixels in ARGB8888, only filled by thumbnail requests.
+      kiwi::nes::Bytes thumbnail_data;
       int slot_or_timestamp;
+      int thumbnail_width;
+      int thumbnail_height;
     };
 
     void GetAutoSavedStatesCount(int crc32,
@@ -91,11 +95,23 @@ class NESRuntime {
         int slot,
         kiwi::base::OnceCallback<void(const StateResult&)> load_callback);
 
+    // Gets thumbnails only, without reading the states. Thumbnails are cached
+    // until their slots are saved again.
+    void GetStateThumbnail(
+        int crc32,
+        int slot,
+        kiwi::base::OnceCallback<void(const StateResult&)> load_callback);
+
+    void GetAutoSavedStateThumbnail(
+        int crc32,
+        int slot,
+        kiwi::base::OnceCallback<void(const StateResult&)> load_callback);
+
 #if KIWI_WASM
     // Checks if a save state exists for the given CRC and slot.
     bool SaveStateExists(int crc32, int slot);
 
-    // Reads the raw JPEG thumbnail data for the given save state.
+    // Reads the thumbnail for the given save state, encoded as BMP.
     kiwi::nes::Bytes ReadSaveStateThumbnail(int crc32, int slot);
 
     // Deletes a save state for the given CRC and slot.
@@ -117,6 +133,7 @@ class NESRuntime {
     void TriggerDelayedAutoSave(kiwi::base::TimeDelta delta,
                                 GetThumbnailCallback thumbnail);
     bool auto_save_started_ = false;
+    StateThumbnailCache thumbnail_cache_;
   };
 
  private:
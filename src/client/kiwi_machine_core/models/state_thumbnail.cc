@@ -0,0 +1,232 @@
+// Copyright (C) 2026 Yisi Yu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#include "models/state_thumbnail.h"
+
+#include <SDL.h>
+#include <SDL_image.h>
+#include <unordered_map>
+
+namespace {
+
+// Layout of an encoded thumbnail:
+// | Magic (4 bytes) | Version (1 byte) | Reserved (1 byte) | Width (2 bytes) |
+// | Height (2 bytes) | Palette size (2 bytes) | Palette (4 bytes each) |
+// | Pixels (1 byte each, or 4 bytes each if palette size is 0) |
+constexpr char kThumbnailMagic[4] = {'K', 'T', 'H', 'M'};
+constexpr uint8_t kThumbnailVersion = 1;
+constexpr int kThumbnailHeaderSize = 12;
+constexpr int kThumbnailScale = 2;
+constexpr int kMaxPaletteSize = 256;
+
+template <typename T>
+void AppendField(kiwi::nes::Bytes& data, T value) {
+  size_t offset = data.size();
+  data.resize(offset + sizeof(value));
+  memcpy(data.data() + offset, &value, sizeof(value));
+}
+
+template <typename T>
+T ReadField(const kiwi::nes::Bytes& data, size_t offset) {
+  T value;
+  memcpy(&value, data.data() + offset, sizeof(value));
+  return value;
+}
+
+// Decodes JPEG thumbnails, which were written before the indexed format.
+bool DecodeLegacyThumbnail(const kiwi::nes::Bytes& data,
+                           StateThumbnail* thumbnail) {
+  SDL_RWops* rw = SDL_RWFromConstMem(data.data(), data.size());
+  SDL_Surface* surface = IMG_Load_RW(rw, true);
+  if (!surface)
+    return false;
+
+  bool success = true;
+  thumbnail->width = surface->w;
+  thumbnail->height = surface->h;
+  thumbnail->pixels.resize(4 * surface->w * surface->h);
+  if (surface->format->format == SDL_PIXELFORMAT_RGB24) {
+    kiwi::nes::Byte* target = thumbnail->pixels.data();
+    for (int y = 0; y < surface->h; ++y) {
+      const kiwi::nes::Byte* source =
+          reinterpret_cast<const kiwi::nes::Byte*>(surface->pixels) +
+          y * surface->pitch;
+      for (int x = 0; x < surface->w; ++x) {
+        *target++ = source[0];
+        *target++ = source[1];
+        *target++ = source[2];
+        *target++ = 0xff;
+        source += 3;
+      }
+    }
+  } else if (surface->format->format == SDL_PIXELFORMAT_RGBA8888) {
+    for (int y = 0; y < surface->h; ++y) {
+      memcpy(thumbnail->pixels.data() + y * surface->w * 4,
+             reinterpret_cast<const kiwi::nes::Byte*>(surface->pixels) +
+                 y * surface->pitch,
+             surface->w * 4);
+    }
+  } else {
+    success = false;
+  }
+
+  SDL_FreeSurface(surface);
+  return success;
+}
+
+}  // namespace
+
+StateThumbnail CreateStateThumbnail(
+    const kiwi::nes::IODevices::RenderDevice::Buffer& frame,
+    int frame_width,
+    int frame_height) {
+  SDL_assert(frame.size() >= frame_width * frame_height);
+  StateThumbnail thumbnail;
+  thumbnail.width = frame_width / kThumbnailScale;
+  thumbnail.height = frame_height / kThumbnailScale;
+  thumbnail.pixels.resize(thumbnail.width * thumbnail.height *
+                          sizeof(kiwi::nes::Color));
+
+  // Nearest sampling keeps the colors of the NES palette, so that the
+  // thumbnail can still be indexed.
+  kiwi::nes::Color* target =
+      reinterpret_cast<kiwi::nes::Color*>(thumbnail.pixels.data());
+  for (int y = 0; y < thumbnail.height; ++y) {
+    const kiwi::nes::Color* source =
+        frame.data() + y * kThumbnailScale * frame_width;
+    for (int x = 0; x < thumbnail.width; ++x)
+      *target++ = source[x * kThumbnailScale];
+  }
+  return thumbnail;
+}
+
+kiwi::nes::Bytes EncodeStateThumbnail(const StateThumbnail& thumbnail) {
+  const kiwi::nes::Color* pixels =
+      reinterpret_cast<const kiwi::nes::Color*>(thumbnail.pixels.data());
+  const int pixel_count = thumbnail.width * thumbnail.height;
+
+  std::vector<kiwi::nes::Color> palette;
+  std::unordered_map<kiwi::nes::Color, uint8_t> palette_indices;
+  for (int i = 0; i < pixel_count && palette.size() <= kMaxPaletteSize; ++i) {
+    if (palette_indices.find(pixels[i]) == palette_indices.end()) {
+      palette_indices[pixels[i]] = static_cast<uint8_t>(palette.size());
+      palette.push_back(pixels[i]);
+    }
+  }
+
+  if (palette.size() > kMaxPaletteSize)
+    palette.clear();
+
+  kiwi::nes::Bytes data;
+  data.reserve(kThumbnailHeaderSize +
+               palette.size() * sizeof(kiwi::nes::Color) +
+               (palette.empty() ? thumbnail.pixels.size() : pixel_count));
+  data.insert(data.end(), std::begin(kThumbnailMagic),
+              std::end(kThumbnailMagic));
+  AppendField(data, kThumbnailVersion);
+  AppendField(data, static_cast<uint8_t>(0));
+  AppendField(data, static_cast<uint16_t>(thumbnail.width));
+  AppendField(data, static_cast<uint16_t>(thumbnail.height));
+  AppendField(data, static_cast<uint16_t>(palette.size()));
+  for (kiwi::nes::Color color : palette)
+    AppendField(data, color);
+
+  if (palette.empty()) {
+    data.insert(data.end(), thumbnail.pixels.begin(), thumbnail.pixels.end());
+  } else {
+    for (int i = 0; i < pixel_count; ++i)
+      data.push_back(palette_indices[pixels[i]]);
+  }
+  return data;
+}
+
+bool DecodeStateThumbnail(const kiwi::nes::Bytes& data,
+                          StateThumbnail* thumbnail) {
+  SDL_assert(thumbnail);
+  if (data.size() < kThumbnailHeaderSize ||
+      memcmp(data.data(), kThumbnailMagic, sizeof(kThumbnailMagic)) != 0) {
+    return !data.empty() && DecodeLegacyThumbnail(data, thumbnail);
+  }
+
+  if (ReadField<uint8_t>(data, 4) != kThumbnailVersion)
+    return false;
+
+  int width = ReadField<uint16_t>(data, 6);
+  int height = ReadField<uint16_t>(data, 8);
+  int palette_size = ReadField<uint16_t>(data, 10);
+  const int pixel_count = width * height;
+  size_t palette_offset = kThumbnailHeaderSize;
+  size_t pixels_offset =
+      palette_offset + palette_size * sizeof(kiwi::nes::Color);
+  size_t expected_size =
+      pixels_offset + (palette_size ? pixel_count
+                                    : pixel_count * sizeof(kiwi::nes::Color));
+  if (palette_size > kMaxPaletteSize || data.size() != expected_size)
+    return false;
+
+  thumbnail->width = width;
+  thumbnail->height = height;
+  thumbnail->pixels.resize(pixel_count * sizeof(kiwi::nes::Color));
+  if (!palette_size) {
+    memcpy(thumbnail->pixels.data(), data.data() + pixels_offset,
+           thumbnail->pixels.size());
+    return true;
+  }
+
+  kiwi::nes::Color palette[kMaxPaletteSize] = {0};
+  memcpy(palette, data.data() + palette_offset,
+         palette_size * sizeof(kiwi::nes::Color));
+  kiwi::nes::Color* target =
+      reinterpret_cast<kiwi::nes::Color*>(thumbnail->pixels.data());
+  const kiwi::nes::Byte* indices = data.data() + pixels_offset;
+  for (int i = 0; i < pixel_count; ++i)
+    target[i] = palette[indices[i]];
+  return true;
+}
+
+StateThumbnailCache::StateThumbnailCache() = default;
+
+StateThumbnailCache::~StateThumbnailCache() = default;
+
+bool StateThumbnailCache::Get(const Key& key,
+                              uint64_t version,
+                              StateThumbnail* thumbnail) {
+  std::lock_guard<std::mutex> lock(lock_);
+  if (key.crc32 != crc32_)
+    return false;
+
+  auto iter = entries_.find(std::make_pair(key.auto_saved, key.slot));
+  if (iter == entries_.end() || iter->second.version != version)
+    return false;
+
+  *thumbnail = iter->second.thumbnail;
+  return true;
+}
+
+void StateThumbnailCache::Put(const Key& key,
+                              uint64_t version,
+                              const StateThumbnail& thumbnail) {
+  std::lock_guard<std::mutex> lock(lock_);
+  if (key.crc32 != crc32_) {
+    // Another game is running, thumbnails of the previous one are dropped.
+    entries_.clear();
+    crc32_ = key.crc32;
+  }
+
+  entries_[std::make_pair(key.auto_saved, key.slot)] = Entry{version, thumbnail};
+}
+
+void StateThumbnailCache::Invalidate(const Key& key) {
+  std::lock_guard<std::mutex> lock(lock_);
+  if (key.crc32 == crc32_)
+    entries_.erase(std::make_pair(key.auto_saved, key.slot));
+}
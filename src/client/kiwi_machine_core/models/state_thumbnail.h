@@ -0,0 +1,75 @@
+// Copyright (C) 2026 Yisi Yu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#ifndef MODELS_STATE_THUMBNAIL_H_
+#define MODELS_STATE_THUMBNAIL_H_
+
+#include <kiwi_nes.h>
+#include <map>
+#include <mutex>
+
+// A decoded thumbnail of a saved state. Pixels are in SDL_PIXELFORMAT_ARGB8888,
+// the same as NES frames, and rows are tightly packed.
+struct StateThumbnail {
+  int width = 0;
+  int height = 0;
+  kiwi::nes::Bytes pixels;
+};
+
+// Downscales |frame| by 2 into a thumbnail.
+StateThumbnail CreateStateThumbnail(
+    const kiwi::nes::IODevices::RenderDevice::Buffer& frame,
+    int frame_width,
+    int frame_height);
+
+// Thumbnails are stored palette-indexed: a NES frame rarely has more than a
+// few dozen colors, so one byte per pixel is lossless, and decoding is a table
+// lookup. Frames with more than 256 colors are stored as raw pixels.
+kiwi::nes::Bytes EncodeStateThumbnail(const StateThumbnail& thumbnail);
+
+// Decodes |data| encoded by EncodeStateThumbnail(). JPEG thumbnails written by
+// earlier versions are decoded as well.
+bool DecodeStateThumbnail(const kiwi::nes::Bytes& data,
+                          StateThumbnail* thumbnail);
+
+// StateThumbnailCache keeps decoded thumbnails of the current game's states,
+// so that browsing the slots doesn't read and decode files again. Only one
+// game's thumbnails are kept. It can be accessed from any thread.
+class StateThumbnailCache {
+ public:
+  struct Key {
+    int crc32;
+    bool auto_saved;
+    int slot;
+  };
+
+  StateThumbnailCache();
+  ~StateThumbnailCache();
+
+  // |version| distinguishes states written to the same slot at different
+  // times. An entry is only found if its version matches.
+  bool Get(const Key& key, uint64_t version, StateThumbnail* thumbnail);
+  void Put(const Key& key, uint64_t version, const StateThumbnail& thumbnail);
+  void Invalidate(const Key& key);
+
+ private:
+  struct Entry {
+    uint64_t version;
+    StateThumbnail thumbnail;
+  };
+
+  std::mutex lock_;
+  int crc32_ = 0;
+  std::map<std::pair<bool, int>, Entry> entries_;
+};
+
+#endif  // MODELS_STATE_THUMBNAIL_H_
@@ -0,0 +1,105 @@
+// Copyright (C) 2026 Yisi Yu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#include "models/state_thumbnail.h"
+#include "third_party/googletest-release-1.12.1/googletest/include/gtest/gtest.h"
+
+namespace {
+
+constexpr int kFrameWidth = 256;
+constexpr int kFrameHeight = 240;
+
+kiwi::nes::Color GetPixel(const StateThumbnail& thumbnail, int x, int y) {
+  kiwi::nes::Color color;
+  memcpy(&color,
+         thumbnail.pixels.data() +
+             (y * thumbnail.width + x) * sizeof(kiwi::nes::Color),
+         sizeof(color));
+  return color;
+}
+
+}  // namespace
+
+TEST(StateThumbnailTest, IndexedRoundTrip) {
+  kiwi::nes::IODevices::RenderDevice::Buffer frame(kFrameWidth * kFrameHeight);
+  for (int y = 0; y < kFrameHeight; ++y) {
+    for (int x = 0; x < kFrameWidth; ++x)
+      frame[y * kFrameWidth + x] = 0xff000000 | ((x / 16) << 8) | (y / 16);
+  }
+
+  StateThumbnail thumbnail =
+      CreateStateThumbnail(frame, kFrameWidth, kFrameHeight);
+  EXPECT_EQ(thumbnail.width, kFrameWidth / 2);
+  EXPECT_EQ(thumbnail.height, kFrameHeight / 2);
+  EXPECT_EQ(GetPixel(thumbnail, 10, 20), frame[40 * kFrameWidth + 20]);
+
+  // 16 x 15 colors, so one byte per pixel.
+  kiwi::nes::Bytes data = EncodeStateThumbnail(thumbnail);
+  EXPECT_LT(data.size(), thumbnail.pixels.size() / 3);
+
+  StateThumbnail decoded;
+  ASSERT_TRUE(DecodeStateThumbnail(data, &decoded));
+  EXPECT_EQ(decoded.width, thumbnail.width);
+  EXPECT_EQ(decoded.height, thumbnail.height);
+  EXPECT_EQ(decoded.pixels, thumbnail.pixels);
+}
+
+TEST(StateThumbnailTest, RawRoundTrip) {
+  StateThumbnail thumbnail;
+  thumbnail.width = 32;
+  thumbnail.height = 16;
+  thumbnail.pixels.resize(thumbnail.width * thumbnail.height *
+                          sizeof(kiwi::nes::Color));
+  // Every pixel has a different color, which can't be indexed.
+  for (size_t i = 0; i < thumbnail.pixels.size(); ++i)
+    thumbnail.pixels[i] = static_cast<kiwi::nes::Byte>(i * 7 + i / 256);
+
+  kiwi::nes::Bytes data = EncodeStateThumbnail(thumbnail);
+  StateThumbnail decoded;
+  ASSERT_TRUE(DecodeStateThumbnail(data, &decoded));
+  EXPECT_EQ(decoded.pixels, thumbnail.pixels);
+
+  // Truncated data is rejected.
+  data.pop_back();
+  EXPECT_FALSE(DecodeStateThumbnail(data, &decoded));
+  EXPECT_FALSE(DecodeStateThumbnail(kiwi::nes::Bytes(), &decoded));
+}
+
+TEST(StateThumbnailTest, Cache) {
+  StateThumbnailCache cache;
+  StateThumbnail thumbnail;
+  thumbnail.width = 1;
+  thumbnail.height = 1;
+  thumbnail.pixels = {1, 2, 3, 4};
+
+  StateThumbnailCache::Key manual{100, false, 1};
+  StateThumbnailCache::Key auto_saved{100, true, 1};
+  StateThumbnail result;
+  EXPECT_FALSE(cache.Get(manual, 0, &result));
+
+  cache.Put(manual, 0, thumbnail);
+  cache.Put(auto_saved, 5, thumbnail);
+  ASSERT_TRUE(cache.Get(manual, 0, &result));
+  EXPECT_EQ(result.pixels, thumbnail.pixels);
+
+  // The auto-saved slot has been overwritten by a newer state.
+  EXPECT_FALSE(cache.Get(auto_saved, 6, &result));
+  EXPECT_TRUE(cache.Get(auto_saved, 5, &result));
+
+  cache.Invalidate(manual);
+  EXPECT_FALSE(cache.Get(manual, 0, &result));
+  EXPECT_TRUE(cache.Get(auto_saved, 5, &result));
+
+  // Thumbnails of another game drop the previous ones.
+  cache.Put(StateThumbnailCache::Key{200, false, 1}, 0, thumbnail);
+  EXPECT_FALSE(cache.Get(auto_saved, 5, &result));
+}
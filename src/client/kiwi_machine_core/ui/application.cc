@@ -260,6 +260,26 @@ scoped_refptr<kiwi::base::SequencedTaskRunner> Application::GetIOTaskRunner() {
 #endif
 }
 
+scoped_refptr<kiwi::base::SequencedTaskRunner>
+Application::GetDecodeTaskRunner() {
+#if KIWI_WASM
+  return kiwi::base::SingleThreadTaskRunner::GetCurrentDefault();
+#else
+  SDL_assert(decode_thread_);
+  return decode_thread_->task_runner();
+#endif
+}
+
+scoped_refptr<kiwi::base::SequencedTaskRunner>
+Application::GetAutoSaveTaskRunner() {
+#if KIWI_WASM
+  return kiwi::base::SingleThreadTaskRunner::GetCurrentDefault();
+#else
+  SDL_assert(auto_save_thread_);
+  return auto_save_thread_->task_runner();
+#endif
+}
+
 void Application::Initialize(kiwi::base::OnceClosure other_io_task,
                              kiwi::base::OnceClosure callback) {
   if (!initialized_) {
@@ -304,6 +324,18 @@ void Application::InitializeApplication(int& argc, char** argv) {
   kiwi::base::Thread::Options options;
   options.message_pump_type = kiwi::base::MessagePumpType::IO;
   io_thread_->StartWithOptions(std::move(options));
+
+  // Creates a decode thread to decode images, such as box arts.
+  decode_thread_ =
+      std::make_unique<kiwi::base::Thread>("Kiwi Machine Decode Thread");
+  decode_thread_->StartWithOptions(kiwi::base::Thread::Options());
+
+  // Creates an auto save thread, all auto-saved states are accessed on it.
+  auto_save_thread_ =
+      std::make_unique<kiwi::base::Thread>("Kiwi Machine Auto Save Thread");
+  kiwi::base::Thread::Options auto_save_options;
+  auto_save_options.message_pump_type = kiwi::base::MessagePumpType::IO;
+  auto_save_thread_->StartWithOptions(std::move(auto_save_options));
 #endif
 
   // Using gflags to parse command line.
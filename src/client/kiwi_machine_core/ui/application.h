@@ -47,6 +47,12 @@ class Application {
  public:
   static Application* Get();
   scoped_refptr<kiwi::base::SequencedTaskRunner> GetIOTaskRunner();
+  // Decode task runner is used for CPU-bound works, such as decoding images,
+  // which shouldn't block the UI thread and the IO thread.
+  scoped_refptr<kiwi::base::SequencedTaskRunner> GetDecodeTaskRunner();
+  // Auto save task runner writes and reads auto-saved states, so that periodic
+  // auto saving doesn't compete with loading games on the IO thread.
+  scoped_refptr<kiwi::base::SequencedTaskRunner> GetAutoSaveTaskRunner();
   // Initialize application's necessary data.
   void Initialize(kiwi::base::OnceClosure other_io_task,
                   kiwi::base::OnceClosure callback);
@@ -98,6 +104,8 @@ class Application {
   scoped_refptr<NESConfig> config_;
 #if !KIWI_WASM
   std::unique_ptr<kiwi::base::Thread> io_thread_;
+  std::unique_ptr<kiwi::base::Thread> decode_thread_;
+  std::unique_ptr<kiwi::base::Thread> auto_save_thread_;
 #endif
   Timer frame_elapsed_counter_;
   Timer render_counter_;
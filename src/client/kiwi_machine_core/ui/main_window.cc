@@ -21,6 +21,7 @@
 #include "preset_roms/preset_roms.h"
 #include "resources/image_resources.h"
 #include "ui/application.h"
+#include "ui/styles.h"
 #include "ui/widgets/about_widget.h"
 #include "ui/widgets/canvas.h"
 #include "ui/widgets/card_widget.h"
@@ -40,11 +41,13 @@
 #include "ui/widgets/toast.h"
 #include "utility/algorithm.h"
 #include "utility/audio_effects.h"
+#include "utility/boxart_atlas.h"
 #include "utility/fps_counter.h"
 #include "utility/key_mapping_util.h"
 #include "utility/localization.h"
 #include "utility/logging.h"
 #include "utility/math.h"
+#include "utility/pixel_scaler.h"
 #include "utility/zip_reader.h"
 
 DEFINE_bool(enable_debug, false, "Shows a menu bar at the top of the window.");
@@ -208,13 +211,13 @@ std::string ROMTitleUpdater::GetCollateStringHint() {
 
 bool ROMTitleUpdater::IsTitleMatchedFilter(const std::string& filter,
                                            int& similarity) {
-  if (HasString(filter, preset_rom_.name)) {
+  if (HasString(preset_rom_.name, filter)) {
     similarity = std::string_view(preset_rom_.name).size() - filter.size();
     return true;
   }
 
   std::string hint = language_conversion::KanaToRomaji(GetCollateStringHint());
-  if (HasString(filter, hint)) {
+  if (HasString(hint, filter)) {
     similarity = hint.size() - filter.size();
     return true;
   }
@@ -394,7 +397,7 @@ std::string MainWindow::GetSaveStateThumbnail_WASM(int slot) {
   if (thumbnail_data.empty()) {
     return "";
   }
-  return "data:image/jpeg;base64," +
+  return "data:image/bmp;base64," +
          Base64Encode(thumbnail_data.data(), thumbnail_data.size());
 }
 
@@ -476,6 +479,17 @@ int MainWindow::Scaled(int i) {
   return i * window_scale();
 }
 
+BoxArtAtlas* MainWindow::GetBoxArtAtlas() {
+  if (!boxart_atlas_) {
+    boxart_atlas_ = std::make_unique<BoxArtAtlas>(
+        renderer(), styles::flex_item_widget::GetBoxArtCellWidth(),
+        styles::flex_item_widget::GetBoxArtCellHeight(),
+        styles::flex_item_widget::GetBoxArtAtlasColumns(),
+        styles::flex_item_widget::GetBoxArtAtlasRows());
+  }
+  return boxart_atlas_.get();
+}
+
 void MainWindow::ChangeFocus(MainFocus focus) {
   SDL_assert(side_menu_);
   switch (focus) {
@@ -610,6 +624,10 @@ void MainWindow::HandleKeyEvent(SDL_KeyboardEvent* event) {
       pressing_keys_.insert(event->keysym.sym);
     else if (event->type == SDL_KEYUP)
       pressing_keys_.erase(event->keysym.sym);
+
+    // Holding Tab fast-forwards.
+    if (event->keysym.sym == SDLK_TAB && !event->repeat)
+      SetFastForward(event->type == SDL_KEYDOWN);
   }
 
   WindowBase::HandleKeyEvent(event);
@@ -771,6 +789,7 @@ void MainWindow::ResetAudio() {
 void MainWindow::InitializeAudio() {
   SDL_assert(!audio_);
   audio_ = std::make_unique<NESAudio>(runtime_id_);
+  audio_->SetTargetLatency(config_->data().audio_latency_ms);
   audio_->Initialize();
   audio_->Start();
   OnSetAudioVolume(config_->data().volume);
@@ -1003,6 +1022,10 @@ void MainWindow::InitializeUI() {
   canvas_->set_visible(false);
   canvas_->AddObserver(this);
   canvas_->set_frame_scale(2.f);
+  canvas_->frame()->SetPixelScalerFilter(
+      static_cast<PixelScaler::Filter>(std::clamp(
+          config_->data().pixel_scaler_filter, 0,
+          static_cast<int>(PixelScaler::Filter::kLast))));
   canvas_->set_in_menu_trigger_callback(kiwi::base::BindRepeating(
       &MainWindow::OnInGameMenuTrigger, kiwi::base::Unretained(this)));
   AddWidget(std::move(canvas));
@@ -1050,7 +1073,8 @@ void MainWindow::InitializeUI() {
 
     std::unique_ptr<PerformanceWidget> performance_widget =
         std::make_unique<PerformanceWidget>(this, canvas_->frame(),
-                                            runtime_data_->debug_port.get());
+                                            runtime_data_->debug_port.get(),
+                                            audio_.get());
     performance_widget_ = performance_widget.get();
     performance_widget_->set_visible(false);
     AddWidget(std::move(performance_widget));
@@ -1211,6 +1235,21 @@ std::vector<MenuBar::Menu> MainWindow::GetMenuModel() {
       emulator.menu_items.push_back(std::move(screen_size));
     }
 
+    // Screen filter
+    {
+      MenuBar::MenuItem screen_filter;
+      screen_filter.title = "Screen filter";
+      for (int i = 0; i <= static_cast<int>(PixelScaler::Filter::kLast); ++i) {
+        screen_filter.sub_items.push_back(
+            {PixelScaler::GetFilterName(static_cast<PixelScaler::Filter>(i)),
+             kiwi::base::BindRepeating(&MainWindow::OnSetPixelScalerFilter,
+                                       kiwi::base::Unretained(this), i),
+             kiwi::base::BindRepeating(&MainWindow::PixelScalerFilterIs,
+                                       kiwi::base::Unretained(this), i)});
+      }
+      emulator.menu_items.push_back(std::move(screen_filter));
+    }
+
     // Controllers
     {
       MenuBar::MenuItem controllers;
@@ -1664,6 +1703,7 @@ void MainWindow::OnRomLoaded(const std::string& name,
   SetTitle(name);
   StartAutoSave();
   PauseGameIfDisassemblyVisible();
+  ApplyRunAhead();
 
   if (!success) {
     Toast::ShowToast(this,
@@ -1672,6 +1712,24 @@ void MainWindow::OnRomLoaded(const std::string& name,
   }
 }
 
+void MainWindow::ApplyRunAhead() {
+  SDL_assert(runtime_data_->emulator);
+  auto* rom_data = runtime_data_->emulator->GetRomData();
+  int frames = rom_data ? config_->GetRunAheadFrames(rom_data->crc) : 0;
+  runtime_data_->emulator->SetRunAhead(
+      frames, config_->data().run_ahead_second_instance
+                  ? kiwi::nes::Emulator::RunAheadMode::kSecondInstance
+                  : kiwi::nes::Emulator::RunAheadMode::kSingleInstance);
+}
+
+void MainWindow::SetFastForward(bool enabled) {
+  SDL_assert(runtime_data_->emulator);
+  int speed = enabled ? std::clamp(config_->data().fast_forward_speed, 2,
+                                   kiwi::nes::Emulator::kMaxFastForwardSpeed)
+                      : 1;
+  runtime_data_->emulator->SetFastForward(speed);
+}
+
 void MainWindow::OnQuit() {
   SDL_Event quit_event;
   quit_event.type = SDL_QUIT;
@@ -1827,8 +1885,10 @@ void MainWindow::OnTogglePause() {
 
 void MainWindow::OnPause() {
   StopAutoSave();
-  // Cleanup all pressing keys when pausing.
+  // Cleanup all pressing keys when pausing. Fast-forward stops as well, since
+  // its key can be released meanwhile.
   pressing_keys_.clear();
+  SetFastForward(false);
   runtime_data_->emulator->Pause();
   if (memory_widget_)
     memory_widget_->UpdateMemory();
@@ -1952,6 +2012,22 @@ bool MainWindow::ScreenScaleIs(float scale) {
   return canvas_->frame_scale() == scale;
 }
 
+void MainWindow::OnSetPixelScalerFilter(int filter) {
+  SDL_assert(canvas_);
+  if (config_->data().pixel_scaler_filter != filter) {
+    config_->data().pixel_scaler_filter = filter;
+    config_->SaveConfig();
+  }
+  canvas_->frame()->SetPixelScalerFilter(
+      static_cast<PixelScaler::Filter>(filter));
+}
+
+bool MainWindow::PixelScalerFilterIs(int filter) {
+  SDL_assert(canvas_);
+  return canvas_->frame()->pixel_scaler_filter() ==
+         static_cast<PixelScaler::Filter>(filter);
+}
+
 void MainWindow::OnTogglePaletteWidget() {
   SDL_assert(palette_widget_);
   palette_widget_->set_visible(!palette_widget_->visible());
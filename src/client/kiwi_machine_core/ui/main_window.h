@@ -36,6 +36,7 @@ class MemoryWidget;
 class DisassemblyWidget;
 class FlexItemsWidget;
 class CardWidget;
+class BoxArtAtlas;
 class Splash;
 class FpsCounter;
 
@@ -113,6 +114,8 @@ class MainWindow : public WindowBase,
   ImVec2 Scaled(const ImVec2& vec2);
   int Scaled(int i);
   void ChangeFocus(MainFocus focus);
+  // Box arts of all flex items share one atlas, which is created on demand.
+  BoxArtAtlas* GetBoxArtAtlas();
 
   void AddObserver(Observer* observer);
   void RemoveObserver(Observer* observer);
@@ -186,6 +189,8 @@ class MainWindow : public WindowBase,
   void OnRomLoaded(const std::string& name,
                    bool load_from_finger_gesture,
                    bool success);
+  void ApplyRunAhead();
+  void SetFastForward(bool enabled);
   void OnQuit();
   void OnResetROM();
   void OnBackToMainMenu();
@@ -213,6 +218,8 @@ class MainWindow : public WindowBase,
   void OnSetFullscreen();
   void OnUnsetFullscreen(float scale);
   bool ScreenScaleIs(float scale);
+  void OnSetPixelScalerFilter(int filter);
+  bool PixelScalerFilterIs(int filter);
   void OnTogglePaletteWidget();
   bool IsPaletteWidgetShown();
   void OnTogglePatternWidget();
@@ -310,6 +317,7 @@ class MainWindow : public WindowBase,
   NESRuntime::Data* runtime_data_ = nullptr;
   std::unique_ptr<NESAudio> audio_;
   scoped_refptr<NESConfig> config_;
+  std::unique_ptr<BoxArtAtlas> boxart_atlas_;
 
   bool virtual_controller_button_states_[2][static_cast<int>(
       kiwi::nes::ControllerButton::kMax)]{false};
@@ -60,6 +60,32 @@ int GetBadgeSize() {
 #endif
 }
 
+int GetBoxArtCellHeight() {
+  // Leaves room for the highlighted item, which is a bit larger.
+  return flex_items_widget::GetItemHeightHint() +
+         flex_items_widget::GetItemHighlightedSize() * 2;
+}
+
+int GetBoxArtCellWidth() {
+  return GetBoxArtCellHeight() * 5 / 4;
+}
+
+int GetBoxArtAtlasColumns() {
+#if KIWI_ANDROID
+  return 5;
+#else
+  return 8;
+#endif
+}
+
+int GetBoxArtAtlasRows() {
+#if KIWI_ANDROID
+  return 7;
+#else
+  return 16;
+#endif
+}
+
 }  // namespace flex_item_widget
 
 namespace in_game_menu {
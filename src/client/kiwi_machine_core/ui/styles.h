@@ -31,6 +31,11 @@ PreferredFontSize GetFilterFontSize();
 namespace flex_item_widget {
 
 int GetBadgeSize();
+// Box arts are downscaled to fit one atlas cell.
+int GetBoxArtCellWidth();
+int GetBoxArtCellHeight();
+int GetBoxArtAtlasColumns();
+int GetBoxArtAtlasRows();
 
 }  // namespace flex_item_widget
 
@@ -65,10 +65,10 @@ void Canvas::Paint() {
     observer->OnAboutToRenderFrame(this, frame_.get());
   }
 
-  SDL_Rect src_rect = {0, 0, frame_->width(), frame_->height()};
+  // The whole texture is drawn, which is larger than the frame if it's scaled
+  // by a pixel scaler.
   SDL_Rect dest_rect = bounds();
-  SDL_RenderCopy(window()->renderer(), frame_->texture(), &src_rect,
-                 &dest_rect);
+  SDL_RenderCopy(window()->renderer(), frame_->texture(), nullptr, &dest_rect);
 }
 
 bool Canvas::IsWindowless() {
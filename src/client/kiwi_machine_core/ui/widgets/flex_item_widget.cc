@@ -12,7 +12,6 @@
 
 #include "ui/widgets/flex_item_widget.h"
 
-#include <SDL_image.h>
 #include <imgui.h>
 
 #include "ui/application.h"
@@ -61,40 +60,51 @@ FlexItemWidget::FlexItemWidget(
       GetImage(window()->renderer(), image_resources::ImageID::kItemBadge);
 }
 
-FlexItemWidget::~FlexItemWidget() {
-  for (std::unique_ptr<Data>& data : sub_data_) {
-    if (data->image_texture)
-      SDL_DestroyTexture(data->image_texture);
-  }
+FlexItemWidget::~FlexItemWidget() = default;
+
+void FlexItemWidget::RequestImageIfNotExists(BoxArtAtlas* atlas) {
+  Data* data = current_data();
+  if (data->requesting_image || atlas->Contains(data->image_key))
+    return;
+
+  // Make sure we only request once
+  data->requesting_image = true;
+  Application::Get()->GetIOTaskRunner()->PostTaskAndReplyWithResult(
+      FROM_HERE, data->image_loader,
+      kiwi::base::BindOnce(&FlexItemWidget::OnImageLoaded,
+                           kiwi::base::Unretained(this), data));
 }
 
-void FlexItemWidget::CreateTextureIfNotExists() {
-  if (!current_data()->image_texture &&
-      !current_data()->requesting_or_requested_texture_) {
-    // Make sure we only request once
-    current_data()->requesting_or_requested_texture_ = true;
-
-    // If there's no texture yet, post a task to request a new one.
-    Application::Get()->GetIOTaskRunner()->PostTaskAndReplyWithResult(
-        FROM_HERE, current_data()->image_loader,
-        kiwi::base::BindOnce(
-            [](FlexItemWidget* this_widget, const kiwi::nes::Bytes& data) {
-              SDL_Texture* texture =
-                  this_widget->LoadImageAndCreateTexture(data);
-              this_widget->current_data()->image_texture.exchange(texture);
-            },
-            this));
+void FlexItemWidget::OnImageLoaded(Data* data,
+                                   const kiwi::nes::Bytes& image_data) {
+  // The item may have been scrolled out of the visible region while loading.
+  // Don't waste time to decode it, it will be requested again once painted.
+  if (!visible() || filtered()) {
+    data->requesting_image = false;
+    return;
   }
+
+  BoxArtAtlas* atlas = main_window_->GetBoxArtAtlas();
+  Application::Get()->GetDecodeTaskRunner()->PostTaskAndReplyWithResult(
+      FROM_HERE,
+      kiwi::base::BindOnce(&BoxArtAtlas::DecodeBoxArt, image_data,
+                           atlas->cell_width(), atlas->cell_height()),
+      kiwi::base::BindOnce(&FlexItemWidget::OnImageDecoded,
+                           kiwi::base::Unretained(this), data));
 }
 
-SDL_Texture* FlexItemWidget::LoadImageAndCreateTexture(
-    const kiwi::nes::Bytes& data) {
-  SDL_RWops* bg_res =
-      SDL_RWFromConstMem(const_cast<unsigned char*>(data.data()), data.size());
-  SDL_Texture* image_texture =
-      IMG_LoadTextureTyped_RW(window()->renderer(), bg_res, 1, nullptr);
-  SDL_SetTextureScaleMode(image_texture, SDL_ScaleModeBest);
-  return image_texture;
+void FlexItemWidget::OnImageDecoded(Data* data, SDL_Surface* surface) {
+  if (!surface) {
+    // Keeps |requesting_image|, so that a broken image won't be requested
+    // again and again.
+    SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Can't decode box art: %s",
+                data->title_updater->GetLocalizedString().c_str());
+    return;
+  }
+
+  main_window_->GetBoxArtAtlas()->Upload(data->image_key, surface);
+  SDL_FreeSurface(surface);
+  data->requesting_image = false;
 }
 
 bool FlexItemWidget::MatchFilter(const std::string& filter,
@@ -156,17 +166,24 @@ void FlexItemWidget::Paint() {
   if (filtered())
     return;
 
-  CreateTextureIfNotExists();
-  const SDL_Rect kBoundsToWindow = MapToWindow(bounds());
+  BoxArtAtlas* atlas = main_window_->GetBoxArtAtlas();
+  RequestImageIfNotExists(atlas);
+  const SDL_Rect kBoundsToWindow = parent_->MapItemToWindow(bounds());
   ImDrawList* draw_list = ImGui::GetWindowDrawList();
 
   // Draw stretched image
-  if (current_data()->image_texture) {
+  SDL_Rect image_rect;
+  if (atlas->Lookup(current_data()->image_key, &image_rect)) {
+    const float kAtlasWidth = atlas->texture_width();
+    const float kAtlasHeight = atlas->texture_height();
     draw_list->AddImage(
-        reinterpret_cast<ImTextureID>(current_data()->image_texture.load()),
+        reinterpret_cast<ImTextureID>(atlas->texture()),
         ImVec2(kBoundsToWindow.x, kBoundsToWindow.y),
         ImVec2(kBoundsToWindow.x + kBoundsToWindow.w,
-               kBoundsToWindow.y + kBoundsToWindow.h));
+               kBoundsToWindow.y + kBoundsToWindow.h),
+        ImVec2(image_rect.x / kAtlasWidth, image_rect.y / kAtlasHeight),
+        ImVec2((image_rect.x + image_rect.w) / kAtlasWidth,
+               (image_rect.y + image_rect.h) / kAtlasHeight));
   } else {
     // Texture is not ready yet, so draw a loading spin and a rectangle
     SDL_Rect loading_widget_bounds =
@@ -211,3 +228,7 @@ void FlexItemWidget::Paint() {
     }
   }
 }
+
+bool FlexItemWidget::IsWindowless() {
+  return true;
+}
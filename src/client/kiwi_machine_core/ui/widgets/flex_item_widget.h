@@ -14,10 +14,10 @@
 #define UI_WIDGETS_FLEX_ITEM_WIDGET_H_
 
 #include <kiwi_nes.h>
-#include <atomic>
 
 #include "ui/widgets/loading_widget.h"
 #include "ui/widgets/widget.h"
+#include "utility/boxart_atlas.h"
 #include "utility/localization.h"
 #include "utility/timer.h"
 
@@ -36,8 +36,10 @@ class FlexItemWidget : public Widget {
     std::unique_ptr<LocalizedStringUpdater> title_updater;
     LoadImageCallback image_loader;
     TriggerCallback on_trigger_callback;
-    std::atomic<SDL_Texture*> image_texture = nullptr;
-    bool requesting_or_requested_texture_ = false;
+    // Box art is stored in the main window's atlas by this key. It may be
+    // evicted at any time, and will be requested again when painting.
+    BoxArtAtlas::Key image_key = BoxArtAtlas::GenerateKey();
+    bool requesting_image = false;
     int image_width = 0;
     int image_height = 0;
   };
@@ -62,6 +64,10 @@ class FlexItemWidget : public Widget {
   void set_column_index(int column_index) { column_index_ = column_index; }
   int row_index() { return row_index_; }
   int column_index() { return column_index_; }
+  void set_bounds_without_scrolling(const SDL_Rect& bounds) {
+    bounds_without_scrolling_ = bounds;
+  }
+  SDL_Rect bounds_without_scrolling() { return bounds_without_scrolling_; }
   Data* current_data() { return current_data_; }
 
   SDL_Rect GetSuggestedSize(int item_height);
@@ -78,11 +84,16 @@ class FlexItemWidget : public Widget {
   bool SwapToNextSubItem();
 
  private:
-  void CreateTextureIfNotExists();
-  SDL_Texture* LoadImageAndCreateTexture(const kiwi::nes::Bytes& data);
+  // Box art is loaded on the IO thread, decoded and downscaled on the decode
+  // thread, and uploaded to the atlas on the UI thread.
+  void RequestImageIfNotExists(BoxArtAtlas* atlas);
+  void OnImageLoaded(Data* data, const kiwi::nes::Bytes& image_data);
+  void OnImageDecoded(Data* data, SDL_Surface* surface);
 
  protected:
   void Paint() override;
+  // Items are rendered by FlexItemsWidget directly, not as its children.
+  bool IsWindowless() override;
 
  private:
   MainWindow* main_window_ = nullptr;
@@ -94,6 +105,7 @@ class FlexItemWidget : public Widget {
   // Location
   int row_index_ = 0;
   int column_index_ = 0;
+  SDL_Rect bounds_without_scrolling_ = {0, 0, 0, 0};
 
   // Fade
   Timer fade_timer_;
@@ -13,6 +13,7 @@
 #include "ui/widgets/flex_items_widget.h"
 
 #include <imgui.h>
+#include <algorithm>
 #include <set>
 
 #include "ui/main_window.h"
@@ -34,6 +35,9 @@ constexpr int kDetailWidgetPadding = 5;
 constexpr int kFilterWidgetMargin = kDetailWidgetMargin;
 constexpr int kFilterWidgetPadding = kDetailWidgetPadding;
 constexpr int kItemHoverDurationMs = 1000;
+// Items in this margin above and below the view are painted, even if they are
+// not in the view, so that they request their images as soon as possible.
+constexpr int kPrefetchMargin = 200;
 
 struct AutoReset {
   AutoReset(bool& value) : value_(value) {}
@@ -81,10 +85,14 @@ size_t FlexItemsWidget::AddItem(
     std::unique_ptr<FlexItemWidget> item = std::make_unique<FlexItemWidget>(
         main_window_, this, std::move(title_updater), image_width, image_height,
         image_loader, on_trigger);
+    // Items are not children of this widget. Only items in the visible window
+    // are rendered, see Paint().
+    item->set_visible(false);
     items_.push_back(item.get());
     all_items_.push_back(item.get());
-    AddWidget(std::move(item));
-    need_layout_all_ = true;
+    item_widgets_.push_back(std::move(item));
+    // Cached filter results don't have the new item.
+    filter_results_.clear();
   } else {
     SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION,
                 "Boxart width or height is zero. Won't added to widget: %s",
@@ -103,6 +111,14 @@ void FlexItemsWidget::AddSubItem(
   SDL_assert(item_index < items_.size());
   items_[item_index]->AddSubItem(std::move(title_updater), image_width,
                                  image_height, image_loader, on_trigger);
+  // The new title may match cached filters.
+  filter_results_.clear();
+}
+
+SDL_Rect FlexItemsWidget::MapItemToWindow(const SDL_Rect& item_bounds) {
+  return MapToWindow(SDL_Rect{bounds().x + item_bounds.x,
+                              bounds().y + item_bounds.y, item_bounds.w,
+                              item_bounds.h});
 }
 
 void FlexItemsWidget::SetIndex(size_t index) {
@@ -151,7 +167,7 @@ void FlexItemsWidget::ScrollWith(int scrolling_delta,
 
   // Avoid exceeding the bottom of the widget
   FlexItemWidget* last_item = items_[items_.size() - 1];
-  SDL_Rect last_item_absolute_bounds = bounds_map_without_scrolling_[last_item];
+  SDL_Rect last_item_absolute_bounds = last_item->bounds_without_scrolling();
   if (last_item_absolute_bounds.y + last_item_absolute_bounds.h +
           target_view_scrolling_ <
       bounds().h) {
@@ -160,8 +176,7 @@ void FlexItemsWidget::ScrollWith(int scrolling_delta,
   }
 
   FlexItemWidget* first_item = items_[0];
-  SDL_Rect first_item_absolute_bounds =
-      bounds_map_without_scrolling_[first_item];
+  SDL_Rect first_item_absolute_bounds = first_item->bounds_without_scrolling();
   if (first_item_absolute_bounds.y + target_view_scrolling_ > 0) {
     target_view_scrolling_ = first_item_absolute_bounds.y;
   }
@@ -195,7 +210,7 @@ void FlexItemsWidget::ShowFilterWidget() {
 }
 
 void FlexItemsWidget::Layout(LayoutOption option) {
-  if (need_layout_all_)
+  if (need_layout_all_ || laid_out_count_ < items_.size())
     LayoutAll(option);
   else
     LayoutPartial(option);
@@ -207,49 +222,54 @@ void FlexItemsWidget::LayoutAll(LayoutOption option) {
     return;
 
   original_view_scrolling_ = target_view_scrolling_;
-  int anchor_x = 0, anchor_y = 0;
-  int column_index = 0, row_index = 0;
-  size_t index = 0;
-  rows_to_first_item_.clear();
-  rows_to_first_item_[0] = 0;
-  bounds_map_without_scrolling_.clear();
+  if (need_layout_all_) {
+    // Widget's size or items have been changed, lays out from the first item.
+    HideVisibleItems();
+    laid_out_count_ = 0;
+    layout_anchor_x_ = 0;
+    layout_anchor_y_ = 0;
+    layout_column_index_ = 0;
+    rows_ = 0;
+    rows_to_first_item_.assign(1, 0);
+  }
 
-  bool current_index_exceeded_bottom = false;
-  for (auto* item : items_) {
+  // Items which have been laid out won't move when new items are appended, so
+  // only the rest items are laid out.
+  for (size_t index = laid_out_count_; index < items_.size(); ++index) {
+    FlexItemWidget* item = items_[index];
     SDL_Rect item_bounds = item->GetSuggestedSize(kItemHeightHint);
-    if (anchor_x + item_bounds.w > bounds().w) {
-      anchor_y += item_bounds.h;
-      anchor_x = 0;
-      row_index++;
-      column_index = 0;
-      rows_to_first_item_[row_index] = index;
+    if (layout_anchor_x_ + item_bounds.w > bounds().w) {
+      layout_anchor_y_ += item_bounds.h;
+      layout_anchor_x_ = 0;
+      rows_++;
+      layout_column_index_ = 0;
+      rows_to_first_item_.push_back(index);
     } else {
-      column_index++;
+      layout_column_index_++;
     }
 
-    item->set_row_index(row_index);
-    item->set_column_index(column_index);
-
-    item_bounds.x = anchor_x;
-    item_bounds.y = anchor_y;
-    anchor_x += item_bounds.w;
+    item->set_row_index(rows_);
+    item->set_column_index(layout_column_index_);
 
-    bounds_map_without_scrolling_[item] = item_bounds;
-    if (IsItemSelected(item)) {
-      current_index_exceeded_bottom = HighlightItem(item, option);
-    }
+    item_bounds.x = layout_anchor_x_;
+    item_bounds.y = layout_anchor_y_;
+    layout_anchor_x_ += item_bounds.w;
 
-    if (target_view_scrolling_ == 0) {
-      // Applying scrolling above won't set visibility when view_scrolling_ is
-      // zero. So we set it here.
-      item->set_visible(SDL_HasIntersection(&item_bounds, &kLocalBounds));
-    }
+    item->set_bounds_without_scrolling(item_bounds);
+  }
+  laid_out_count_ = items_.size();
 
-    index++;
+  bool current_index_exceeded_bottom = false;
+  if (!items_.empty()) {
+    current_index_exceeded_bottom =
+        HighlightItem(items_[current_index_], option);
   }
 
-  // Updates max row index:
-  rows_ = row_index;
+  if (target_view_scrolling_ == 0) {
+    // Applying scrolling in Paint() won't set visibility when view_scrolling_
+    // is zero. So we set it here.
+    ApplyScrolling(0);
+  }
 
   // If the current index is the last row, viewport need to be adjusted.
   if (current_index_exceeded_bottom)
@@ -276,7 +296,7 @@ void FlexItemsWidget::LayoutPartial(LayoutOption option) {
 }
 
 bool FlexItemsWidget::HighlightItem(FlexItemWidget* item, LayoutOption option) {
-  return HighlightItem(item, option, bounds_map_without_scrolling_[item]);
+  return HighlightItem(item, option, item->bounds_without_scrolling());
 }
 
 bool FlexItemsWidget::HighlightItem(
@@ -465,21 +485,55 @@ void FlexItemsWidget::ApplyScrolling(int scrolling) {
   if (SDL_RectEmpty(&kLocalBounds))
     return;
 
-  // Extends the view's bounds, make more item to be painted, even if them are
-  // not in the FlexItemsWidget view.
-  // By doing this, we can make sure items which recently be painted will
-  // request its image as soon as possible.
-  constexpr int kExtended = 200;
-  SDL_Rect extended_local_bounds = kLocalBounds;
-  extended_local_bounds.x -= kExtended;
-  extended_local_bounds.h += kExtended;
-
-  for (auto* item : items_) {
-    SDL_Rect bounds = bounds_map_without_scrolling_[item];
+  // Only items in the visible window and the prefetch margin are updated, so
+  // the cost doesn't depend on how many items there are.
+  size_t begin, end;
+  FindItemsInRange(-scrolling - kPrefetchMargin,
+                   -scrolling + kLocalBounds.h + kPrefetchMargin, begin, end);
+
+  for (size_t i = visible_begin_; i < visible_end_; ++i) {
+    if (i < begin || i >= end)
+      items_[i]->set_visible(false);
+  }
+
+  for (size_t i = begin; i < end; ++i) {
+    SDL_Rect bounds = items_[i]->bounds_without_scrolling();
     bounds.y += scrolling;
-    item->set_bounds(bounds);
-    item->set_visible(SDL_HasIntersection(&bounds, &extended_local_bounds));
+    items_[i]->set_bounds(bounds);
+    items_[i]->set_visible(true);
   }
+
+  visible_begin_ = begin;
+  visible_end_ = end;
+}
+
+void FlexItemsWidget::FindItemsInRange(int top,
+                                       int bottom,
+                                       size_t& begin_out,
+                                       size_t& end_out) {
+  // Rows are sorted by their y coordinate, so binary search them.
+  auto first_row = std::partition_point(
+      rows_to_first_item_.begin(), rows_to_first_item_.end(),
+      [this, top](size_t first_item) {
+        const SDL_Rect kBounds = items_[first_item]->bounds_without_scrolling();
+        return kBounds.y + kBounds.h <= top;
+      });
+  auto end_row = std::partition_point(
+      first_row, rows_to_first_item_.end(), [this, bottom](size_t first_item) {
+        return items_[first_item]->bounds_without_scrolling().y < bottom;
+      });
+
+  begin_out = first_row == rows_to_first_item_.end() ? laid_out_count_
+                                                     : *first_row;
+  end_out =
+      end_row == rows_to_first_item_.end() ? laid_out_count_ : *end_row;
+}
+
+void FlexItemsWidget::HideVisibleItems() {
+  for (size_t i = visible_begin_; i < visible_end_; ++i)
+    items_[i]->set_visible(false);
+
+  visible_begin_ = visible_end_ = 0;
 }
 
 size_t FlexItemsWidget::FindNextIndex(Direction direction) {
@@ -544,7 +598,7 @@ size_t FlexItemsWidget::FindNextIndex(bool down) {
   for (int i = start_index; i <= end_index; ++i) {
     SDL_assert(i >= 0 && i <= items_.size());
     int intersection_area =
-        CalculateIntersectionArea(bounds_map_without_scrolling_[items_[i]],
+        CalculateIntersectionArea(items_[i]->bounds_without_scrolling(),
                                   current_item_original_bounds_);
 
     if (intersection_area < 0)
@@ -565,37 +619,8 @@ bool FlexItemsWidget::FindItemIndexByMousePosition(int x_in_window,
   if (items_.empty())
     return false;
 
-  // A faster way to find the hovered item.
-  int current_row_index = 0;
-  if (current_item_widget_) {
-    SDL_assert(!rows_to_first_item_.empty());
-    current_row_index = current_item_widget_->row_index();
-  }
-
-  int r = current_row_index;
-  int first_item_of_row = rows_to_first_item_[r];
-  while (first_item_of_row > 0 &&
-         (items_[first_item_of_row]->bounds().y +
-          items_[first_item_of_row]->bounds().h) >= 0) {
-    --r;
-    first_item_of_row = rows_to_first_item_[r];
-  }
-  int index_lower = first_item_of_row;
-
-  r = current_row_index;
-  first_item_of_row = rows_to_first_item_[r];
-  bool broke = false;
-  while (items_[first_item_of_row]->bounds().y <= bounds().h) {
-    ++r;
-    if (rows_to_first_item_.find(r) == rows_to_first_item_.end()) {
-      broke = true;
-      break;
-    }
-    first_item_of_row = rows_to_first_item_[r];
-  }
-  int index_upper = broke ? items_.size() - 1 : first_item_of_row;
-
-  for (int i = index_lower; i <= index_upper; ++i) {
+  // Only items in the visible window can be hovered.
+  for (size_t i = visible_begin_; i < visible_end_; ++i) {
     SDL_Rect item_bounds_to_window = MapToWindow(items_[i]->bounds());
     if (Contains(item_bounds_to_window, x_in_window, y_in_window)) {
       index_out = i;
@@ -624,7 +649,7 @@ void FlexItemsWidget::RefreshCurrentItemBounds() {
       items_[current_index_]->GetSuggestedSize(kItemHeightHint);
 
   // The new bound is center aligned
-  const SDL_Rect& kBounds = bounds_map_without_scrolling_[item];
+  const SDL_Rect kBounds = item->bounds_without_scrolling();
   const int kMiddleX = kBounds.x + kBounds.w / 2;
   item_bounds.x = kMiddleX - item_bounds.w / 2;
   item_bounds.y = kBounds.y;
@@ -900,6 +925,10 @@ void FlexItemsWidget::Paint() {
       ImVec2(rect_in_window.x + rect_in_window.w,
              rect_in_window.y + rect_in_window.h),
       ImColor(48, 48, 48));
+
+  // Only items in the visible window are rendered.
+  for (size_t i = visible_begin_; i < visible_end_; ++i)
+    items_[i]->Render();
 }
 
 void FlexItemsWidget::OnFilter(const std::string& filter) {
@@ -907,20 +936,21 @@ void FlexItemsWidget::OnFilter(const std::string& filter) {
     return;
 
   filter_contents_ = filter;
+  RestoreCurrentItemToDefault();
+  HideVisibleItems();
+  for (FlexItemWidget* item : items_)
+    item->set_filtered(true);
+
   if (!filter.empty()) {
-    RestoreCurrentItemToDefault();
     items_ = CalculateFilteredResult(filter);
-    for (FlexItemWidget* item : all_items_) {
-      item->set_filtered(std::find(items_.begin(), items_.end(), item) ==
-                         items_.end());
-    }
   } else {
-    RestoreCurrentItemToDefault();
     items_ = all_items_;
-    for (FlexItemWidget* item : all_items_) {
-      item->set_filtered(false);
-    }
+    filter_results_.clear();
   }
+
+  for (FlexItemWidget* item : items_)
+    item->set_filtered(false);
+
   original_view_scrolling_ = target_view_scrolling_ = 0;
   need_layout_all_ = true;
   current_index_ = 0;
@@ -929,20 +959,45 @@ void FlexItemsWidget::OnFilter(const std::string& filter) {
 
 std::vector<FlexItemWidget*> FlexItemsWidget::CalculateFilteredResult(
     const std::string& filter) {
+  // Drops cached results which are not the prefixes of |filter|, such as
+  // characters have been deleted.
+  while (!filter_results_.empty() &&
+         !filter.starts_with(filter_results_.back().filter)) {
+    filter_results_.pop_back();
+  }
+
+  // An item matches |filter| only if it matches all prefixes of |filter|, so
+  // only the result of the longest cached prefix needs to be scanned.
   std::vector<std::pair<FlexItemWidget*, int>> result;
-  for (auto* item : all_items_) {
-    int similarity;
-    if (item->MatchFilter(filter, similarity))
-      result.push_back({item, similarity});
+  if (filter_results_.empty()) {
+    for (auto* item : all_items_) {
+      int similarity;
+      if (item->MatchFilter(filter, similarity))
+        result.push_back({item, similarity});
+    }
+  } else if (filter_results_.back().filter == filter) {
+    result = filter_results_.back().matches;
+  } else {
+    for (const auto& candidate : filter_results_.back().matches) {
+      int similarity;
+      if (candidate.first->MatchFilter(filter, similarity))
+        result.push_back({candidate.first, similarity});
+    }
   }
 
-  std::sort(result.begin(), result.end(),
-            [filter](const std::pair<FlexItemWidget*, int>& lhs,
-                     const std::pair<FlexItemWidget*, int>& rhs) {
-              return lhs.second < rhs.second;
-            });
+  if (filter_results_.empty() || filter_results_.back().filter != filter)
+    filter_results_.push_back({filter, result});
+
+  // Sorting is stable, so the result doesn't depend on which prefix it comes
+  // from.
+  std::stable_sort(result.begin(), result.end(),
+                   [](const std::pair<FlexItemWidget*, int>& lhs,
+                      const std::pair<FlexItemWidget*, int>& rhs) {
+                     return lhs.second < rhs.second;
+                   });
 
   std::vector<FlexItemWidget*> ret;
+  ret.reserve(result.size());
   for (const auto& i : result) {
     ret.push_back(i.first);
   }
@@ -977,6 +1032,17 @@ void FlexItemsWidget::OnWindowResized() {
   Layout(LayoutOption::kAdjustScrolling);
 }
 
+void FlexItemsWidget::OnLocaleChanged() {
+  // Titles are matched in the new language, so that cached filter results are
+  // stale, and the current filter is applied again.
+  filter_results_.clear();
+  if (!filter_contents_.empty()) {
+    std::string filter;
+    filter.swap(filter_contents_);
+    OnFilter(filter);
+  }
+}
+
 bool FlexItemsWidget::OnKeyPressed(SDL_KeyboardEvent* event) {
   return HandleInputEvent(event, nullptr);
 }
@@ -53,6 +53,9 @@ class FlexItemsWidget : public Widget {
   bool empty() { return items_.empty(); }
   size_t size() { return items_.size(); }
   size_t current_index() { return current_index_; }
+  // Items are not children of this widget, this maps |item_bounds| to window
+  // as if they were.
+  SDL_Rect MapItemToWindow(const SDL_Rect& item_bounds);
   // Triggers when the widget is about to lose focus.
   void set_back_callback(kiwi::base::RepeatingClosure callback) {
     back_callback_ = callback;
@@ -76,6 +79,13 @@ class FlexItemsWidget : public Widget {
   bool HandleInputEvent(SDL_KeyboardEvent* k, SDL_ControllerButtonEvent* c);
   bool TriggerCurrentItem(bool triggered_by_finger);
   void ApplyScrolling(int scrolling);
+  // Finds items whose rows intersect [top, bottom), in coordinates without
+  // scrolling. The result is [begin_out, end_out) of items_.
+  void FindItemsInRange(int top,
+                        int bottom,
+                        size_t& begin_out,
+                        size_t& end_out);
+  void HideVisibleItems();
 
   enum Direction { kUp, kDown, kLeft, kRight };
   size_t FindNextIndex(Direction direction);
@@ -120,6 +130,7 @@ class FlexItemsWidget : public Widget {
   void Paint() override;
   void PostPaint() override;
   void OnWindowResized() override;
+  void OnLocaleChanged() override;
   bool OnKeyPressed(SDL_KeyboardEvent* event) override;
   bool OnMouseMove(SDL_MouseMotionEvent* event) override;
   bool OnMouseWheel(SDL_MouseWheelEvent* event) override;
@@ -145,6 +156,7 @@ class FlexItemsWidget : public Widget {
   // all_items_ are all items called by AddItem().
   std::vector<FlexItemWidget*> items_;
   std::vector<FlexItemWidget*> all_items_;
+  std::vector<std::unique_ptr<FlexItemWidget>> item_widgets_;
   bool first_paint_ = true;
   size_t current_index_ = 0;
   FlexItemWidget* current_item_widget_ = nullptr;
@@ -152,16 +164,27 @@ class FlexItemsWidget : public Widget {
   SDL_Rect current_item_target_bounds_;
   bool need_layout_all_ = true;
 
+  // Layout is incremental. Items in [0, laid_out_count_) of items_ have been
+  // laid out, and the next item will be placed at the anchor.
+  size_t laid_out_count_ = 0;
+  int layout_anchor_x_ = 0;
+  int layout_anchor_y_ = 0;
+  int layout_column_index_ = 0;
+
+  // Visible window, which is [visible_begin_, visible_end_) of items_. Only
+  // these items are updated and painted.
+  size_t visible_begin_ = 0;
+  size_t visible_end_ = 0;
+
   // Scrolling
   int original_view_scrolling_ = 0;
   int target_view_scrolling_ = 0;
   bool updating_view_scrolling_ = false;
-  std::map<FlexItemWidget*, SDL_Rect> bounds_map_without_scrolling_;
   bool gesture_locked_ = false;
 
   bool activate_ = false;
   int rows_ = 0;
-  std::unordered_map<int, int> rows_to_first_item_;
+  std::vector<size_t> rows_to_first_item_{0};
   Timer selection_item_timer_;
   Timer scrolling_timer_;
 
@@ -172,6 +195,13 @@ class FlexItemsWidget : public Widget {
   FilterWidget* filter_widget_ = nullptr;
   // If filter_contents_ is empty, show all results.
   std::string filter_contents_;
+  // Results of the filters which are being typed. Each filter is a prefix of
+  // the next one, and matches are in the order of all_items_.
+  struct FilterResult {
+    std::string filter;
+    std::vector<std::pair<FlexItemWidget*, int>> matches;
+  };
+  std::vector<FilterResult> filter_results_;
 
   Timer gesture_locked_timer_;
   MouseButton gesture_locked_button_ = MouseButton::kLeftButton;
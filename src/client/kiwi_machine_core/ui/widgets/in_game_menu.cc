@@ -405,12 +405,12 @@ void InGameMenu::RequestCurrentThumbnail() {
   // Settings menu also use this class, but no ROM is loaded.
   if (rom_data) {
     if (current_menu_ == MenuItem::kLoadAutoSave) {
-      runtime_data_->GetAutoSavedState(
+      runtime_data_->GetAutoSavedStateThumbnail(
           rom_data->crc, which_autosave_state_slot_,
           kiwi::base::BindOnce(&InGameMenu::OnGotState,
                                kiwi::base::Unretained(this)));
     } else {
-      runtime_data_->GetState(
+      runtime_data_->GetStateThumbnail(
           rom_data->crc, which_state_,
           kiwi::base::BindOnce(&InGameMenu::OnGotState,
                                kiwi::base::Unretained(this)));
@@ -432,19 +432,30 @@ void InGameMenu::RequestCurrentSaveStatesCount() {
 
 void InGameMenu::OnGotState(const NESRuntime::Data::StateResult& state_result) {
   is_loading_snapshot_ = false;
-  if (state_result.success && !state_result.state_data.empty()) {
+  if (state_result.success) {
     currently_has_snapshot_ = true;
     SDL_assert(!state_result.thumbnail_data.empty());
+    if (snapshot_) {
+      // Thumbnails saved by earlier versions are larger.
+      int width, height;
+      SDL_QueryTexture(snapshot_, nullptr, nullptr, &width, &height);
+      if (width != state_result.thumbnail_width ||
+          height != state_result.thumbnail_height) {
+        SDL_DestroyTexture(snapshot_);
+        snapshot_ = nullptr;
+      }
+    }
+
     if (!snapshot_) {
       snapshot_ = SDL_CreateTexture(
           window()->renderer(), SDL_PIXELFORMAT_ARGB8888,
-          SDL_TEXTUREACCESS_STREAMING, Canvas::kNESFrameDefaultWidth,
-          Canvas::kNESFrameDefaultHeight);
+          SDL_TEXTUREACCESS_STREAMING, state_result.thumbnail_width,
+          state_result.thumbnail_height);
     }
 
     constexpr int kColorComponents = 4;
     SDL_UpdateTexture(snapshot_, nullptr, state_result.thumbnail_data.data(),
-                      Canvas::kNESFrameDefaultWidth * kColorComponents *
+                      state_result.thumbnail_width * kColorComponents *
                           sizeof(state_result.thumbnail_data.data()[0]));
 
     // state_timestamp_ will only be used in showing auto-saved state's title.
@@ -18,9 +18,14 @@ constexpr ImVec2 kGraphSize(300, 150);
 
 PerformanceWidget::PerformanceWidget(WindowBase* window_base,
                                      scoped_refptr<NESFrame> frame,
-                                     DebugPort* debug_port)
-    : Widget(window_base), frame_(frame), debug_port_(debug_port) {
+                                     DebugPort* debug_port,
+                                     NESAudio* audio)
+    : Widget(window_base),
+      frame_(frame),
+      debug_port_(debug_port),
+      audio_(audio) {
   SDL_assert(frame_);
+  SDL_assert(audio_);
   frame_->AddObserver(this);
   debug_port_->AddObserver(this);
   Application::Get()->AddObserver(this);
@@ -67,6 +72,26 @@ void PerformanceWidget::Paint() {
                        nes_ppu_ms_costs_per_frame_.index,
                        "NES PPU costs per frame (ms)", 0.f, 20.f, kGraphSize);
 
+      ImGui::PlotLines("", nes_run_ahead_ms_costs_per_frame_.samples,
+                       kSampleCount, nes_run_ahead_ms_costs_per_frame_.index,
+                       "NES run-ahead costs per frame (ms)", 0.f, 20.f,
+                       kGraphSize);
+
+      ImGui::EndTabItem();
+    }
+    if (ImGui::BeginTabItem("Audio")) {
+      ImGui::PlotLines("", audio_latency_ms_.samples, kSampleCount,
+                       audio_latency_ms_.index, "Audio latency (ms)", 0.f,
+                       NESAudio::kMaxLatencyMS * 2, kGraphSize);
+
+      AudioRing::Stats stats = audio_->GetStats();
+      ImGui::Text("Target latency: %d ms", audio_->target_latency_ms());
+      ImGui::Text("Rate ratio: %.4f", stats.rate_ratio);
+      ImGui::Text("Underruns: %llu",
+                  static_cast<unsigned long long>(stats.underruns));
+      ImGui::Text("Dropped samples: %llu",
+                  static_cast<unsigned long long>(stats.dropped_samples));
+
       ImGui::EndTabItem();
     }
 
@@ -89,10 +114,15 @@ void PerformanceWidget::OnPreRender(int since_last_frame_ms) {
 
 void PerformanceWidget::OnFrameEnd(int since_last_frame_duration_ms,
                                    int cpu_last_frame_duration_ms,
-                                   int ppu_last_frame_duration_ms) {
+                                   int ppu_last_frame_duration_ms,
+                                   int run_ahead_last_frame_duration_ms) {
   Update(&nes_frame_generate_, 1000.f / since_last_frame_duration_ms);
   Update(&nes_cpu_ppu_total_ms_costs_per_frame_,
          cpu_last_frame_duration_ms + ppu_last_frame_duration_ms);
   Update(&nes_cpu_ms_costs_per_frame_, cpu_last_frame_duration_ms);
   Update(&nes_ppu_ms_costs_per_frame_, ppu_last_frame_duration_ms);
+  Update(&nes_run_ahead_ms_costs_per_frame_, run_ahead_last_frame_duration_ms);
+  Update(&audio_latency_ms_,
+         audio_->GetStats().latency * 1000.f /
+             static_cast<float>(kiwi::nes::IODevices::AudioDevice::kFrequency));
 }
\ No newline at end of file
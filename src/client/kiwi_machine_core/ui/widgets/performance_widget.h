@@ -16,6 +16,7 @@
 #include <kiwi_nes.h>
 
 #include "debug/debug_port.h"
+#include "models/nes_audio.h"
 #include "models/nes_frame.h"
 #include "ui/application.h"
 #include "ui/widgets/widget.h"
@@ -33,7 +34,8 @@ class PerformanceWidget : public Widget,
 
   explicit PerformanceWidget(WindowBase* window_base,
                              scoped_refptr<NESFrame> frame,
-                             DebugPort* debug_port);
+                             DebugPort* debug_port,
+                             NESAudio* audio);
   ~PerformanceWidget() override;
 
  protected:
@@ -49,7 +51,8 @@ class PerformanceWidget : public Widget,
   // DebugPortObserver:
   void OnFrameEnd(int since_last_frame_duration_ms,
                   int cpu_last_frame_duration_ms,
-                  int ppu_last_frame_duration_ms) override;
+                  int ppu_last_frame_duration_ms,
+                  int run_ahead_last_frame_duration_ms) override;
 
  private:
   struct Plot {
@@ -63,6 +66,7 @@ class PerformanceWidget : public Widget,
  private:
   scoped_refptr<NESFrame> frame_;
   DebugPort* debug_port_ = nullptr;
+  NESAudio* audio_ = nullptr;
 
   Plot app_frame_since_last_;
   Plot nes_frame_generate_;
@@ -70,6 +74,8 @@ class PerformanceWidget : public Widget,
   Plot nes_cpu_ppu_total_ms_costs_per_frame_;
   Plot nes_cpu_ms_costs_per_frame_;
   Plot nes_ppu_ms_costs_per_frame_;
+  Plot nes_run_ahead_ms_costs_per_frame_;
+  Plot audio_latency_ms_;
 };
 
 #endif  // UI_WIDGETS_FRAME_RATE_WIDGET_H_
\ No newline at end of file
@@ -0,0 +1,203 @@
+// Copyright (C) 2026 Yisi Yu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#include "utility/boxart_atlas.h"
+
+#include <SDL_image.h>
+#include <algorithm>
+#include <atomic>
+
+namespace {
+std::atomic<BoxArtAtlas::Key> g_next_key = 1;
+
+// Copies |surface|, which must be locked, into a surface with a border of
+// |padding| pixels on each side, which repeats its edge pixels.
+SDL_Surface* CreatePaddedSurface(SDL_Surface* surface, int padding) {
+  const int width = surface->w + padding * 2;
+  const int height = surface->h + padding * 2;
+  SDL_Surface* padded = SDL_CreateRGBSurfaceWithFormat(0, width, height, 32,
+                                                       SDL_PIXELFORMAT_RGBA32);
+  if (!padded)
+    return nullptr;
+
+  for (int y = 0; y < height; ++y) {
+    const int source_y = std::clamp(y - padding, 0, surface->h - 1);
+    const Uint32* source = reinterpret_cast<const Uint32*>(
+        static_cast<const Uint8*>(surface->pixels) + source_y * surface->pitch);
+    Uint32* row = reinterpret_cast<Uint32*>(
+        static_cast<Uint8*>(padded->pixels) + y * padded->pitch);
+    std::fill_n(row, padding, source[0]);
+    std::copy_n(source, surface->w, row + padding);
+    std::fill_n(row + padding + surface->w, padding, source[surface->w - 1]);
+  }
+  return padded;
+}
+}  // namespace
+
+BoxArtAtlas::BoxArtAtlas(SDL_Renderer* renderer,
+                         int cell_width,
+                         int cell_height,
+                         int columns,
+                         int rows)
+    : renderer_(renderer),
+      cell_width_(cell_width),
+      cell_height_(cell_height),
+      columns_(columns),
+      rows_(rows) {
+  SDL_assert(renderer_);
+  SDL_assert(cell_width_ > 0 && cell_height_ > 0 && columns > 0 && rows > 0);
+  texture_ = SDL_CreateTexture(renderer_, SDL_PIXELFORMAT_RGBA32,
+                               SDL_TEXTUREACCESS_STATIC, texture_width(),
+                               texture_height());
+  if (!texture_) {
+    SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                 "Can't create box art atlas texture: %s", SDL_GetError());
+    return;
+  }
+  SDL_SetTextureBlendMode(texture_, SDL_BLENDMODE_BLEND);
+  SDL_SetTextureScaleMode(texture_, SDL_ScaleModeBest);
+
+  cells_.reserve(columns * rows);
+  free_cells_.reserve(columns * rows);
+  for (int row = 0; row < rows; ++row) {
+    for (int column = 0; column < columns; ++column) {
+      cells_.push_back(
+          SDL_Point{column * (cell_width_ + kCellPadding * 2) + kCellPadding,
+                    row * (cell_height_ + kCellPadding * 2) + kCellPadding});
+    }
+  }
+
+  // Cells are acquired from the back, so the first cell is used first.
+  for (int i = static_cast<int>(cells_.size()) - 1; i >= 0; --i)
+    free_cells_.push_back(i);
+}
+
+BoxArtAtlas::~BoxArtAtlas() {
+  if (texture_)
+    SDL_DestroyTexture(texture_);
+}
+
+SDL_Surface* BoxArtAtlas::DecodeBoxArt(const kiwi::nes::Bytes& data,
+                                       int max_width,
+                                       int max_height) {
+  if (data.empty())
+    return nullptr;
+
+  SDL_RWops* rw = SDL_RWFromConstMem(data.data(), data.size());
+  SDL_Surface* decoded = IMG_Load_RW(rw, 1);
+  if (!decoded)
+    return nullptr;
+
+  SDL_Surface* rgba =
+      SDL_ConvertSurfaceFormat(decoded, SDL_PIXELFORMAT_RGBA32, 0);
+  SDL_FreeSurface(decoded);
+  if (!rgba)
+    return nullptr;
+
+  // Box arts are only shrunk, never enlarged.
+  float scale = std::min({1.f, static_cast<float>(max_width) / rgba->w,
+                           static_cast<float>(max_height) / rgba->h});
+  int width = std::max(1, static_cast<int>(rgba->w * scale));
+  int height = std::max(1, static_cast<int>(rgba->h * scale));
+  if (width == rgba->w && height == rgba->h)
+    return rgba;
+
+  SDL_Surface* scaled = SDL_CreateRGBSurfaceWithFormat(0, width, height, 32,
+                                                       SDL_PIXELFORMAT_RGBA32);
+  if (scaled && SDL_SoftStretchLinear(rgba, nullptr, scaled, nullptr) != 0) {
+    SDL_FreeSurface(scaled);
+    scaled = nullptr;
+  }
+  SDL_FreeSurface(rgba);
+  return scaled;
+}
+
+BoxArtAtlas::Key BoxArtAtlas::GenerateKey() {
+  return g_next_key++;
+}
+
+bool BoxArtAtlas::Upload(Key key, SDL_Surface* surface) {
+  if (!texture_ || !surface || surface->w > cell_width_ ||
+      surface->h > cell_height_ ||
+      surface->format->format != SDL_PIXELFORMAT_RGBA32) {
+    return false;
+  }
+
+  // Re-uploading a key reuses its cell.
+  Remove(key);
+
+  int cell_index = AcquireCell();
+  SDL_Rect rect{cells_[cell_index].x, cells_[cell_index].y, surface->w,
+                surface->h};
+  if (SDL_LockSurface(surface) != 0) {
+    free_cells_.push_back(cell_index);
+    return false;
+  }
+  SDL_Surface* padded = CreatePaddedSurface(surface, kCellPadding);
+  SDL_UnlockSurface(surface);
+  if (!padded) {
+    free_cells_.push_back(cell_index);
+    return false;
+  }
+  SDL_Rect padded_rect{rect.x - kCellPadding, rect.y - kCellPadding, padded->w,
+                       padded->h};
+  int result = SDL_UpdateTexture(texture_, &padded_rect, padded->pixels,
+                                 padded->pitch);
+  SDL_FreeSurface(padded);
+  if (result != 0) {
+    free_cells_.push_back(cell_index);
+    return false;
+  }
+
+  lru_.push_front(key);
+  entries_[key] = Entry{cell_index, rect, lru_.begin()};
+  return true;
+}
+
+bool BoxArtAtlas::Lookup(Key key, SDL_Rect* src_rect) {
+  auto iter = entries_.find(key);
+  if (iter == entries_.end())
+    return false;
+
+  Entry& entry = iter->second;
+  lru_.splice(lru_.begin(), lru_, entry.lru_iterator);
+  if (src_rect)
+    *src_rect = entry.rect;
+  return true;
+}
+
+bool BoxArtAtlas::Contains(Key key) const {
+  return entries_.find(key) != entries_.end();
+}
+
+void BoxArtAtlas::Remove(Key key) {
+  auto iter = entries_.find(key);
+  if (iter == entries_.end())
+    return;
+
+  free_cells_.push_back(iter->second.cell_index);
+  lru_.erase(iter->second.lru_iterator);
+  entries_.erase(iter);
+}
+
+int BoxArtAtlas::AcquireCell() {
+  if (free_cells_.empty()) {
+    SDL_assert(!lru_.empty());
+    Remove(lru_.back());
+    ++eviction_count_;
+  }
+
+  SDL_assert(!free_cells_.empty());
+  int cell_index = free_cells_.back();
+  free_cells_.pop_back();
+  return cell_index;
+}
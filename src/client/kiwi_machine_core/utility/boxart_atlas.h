@@ -0,0 +1,110 @@
+// Copyright (C) 2026 Yisi Yu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#ifndef UTILITY_BOXART_ATLAS_H_
+#define UTILITY_BOXART_ATLAS_H_
+
+#include <SDL.h>
+#include <kiwi_nes.h>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+// BoxArtAtlas packs many downscaled box arts into one shared texture, which is
+// divided into fixed-size cells. When all cells are occupied, the least
+// recently used one is evicted, so the memory cost doesn't grow with the size
+// of the library.
+// Each cell has a border of kCellPadding pixels around its box art, which
+// repeats the box art's edge pixels, so that filtering near the edges never
+// samples the box arts next to it.
+// Decoding happens on worker threads by DecodeBoxArt(), while Upload() and
+// Lookup() must be called on the thread which owns the renderer.
+class BoxArtAtlas {
+ public:
+  using Key = uint32_t;
+
+  static constexpr int kCellPadding = 1;
+
+  BoxArtAtlas(SDL_Renderer* renderer,
+              int cell_width,
+              int cell_height,
+              int columns,
+              int rows);
+  ~BoxArtAtlas();
+
+  BoxArtAtlas(const BoxArtAtlas&) = delete;
+  BoxArtAtlas& operator=(const BoxArtAtlas&) = delete;
+
+  // Decodes |data| and downscales it to fit |max_width| x |max_height|,
+  // keeping its aspect ratio. The result is a SDL_PIXELFORMAT_RGBA32 surface,
+  // which should be freed by the caller, or nullptr if decoding failed.
+  // This function is thread-safe.
+  static SDL_Surface* DecodeBoxArt(const kiwi::nes::Bytes& data,
+                                   int max_width,
+                                   int max_height);
+
+  // Generates a key which is never reused during the application's lifetime.
+  static Key GenerateKey();
+
+  // Copies |surface| into a free cell, evicting the least recently used one if
+  // necessary. |surface| must not be larger than a cell. Returns false if the
+  // surface can't be uploaded.
+  bool Upload(Key key, SDL_Surface* surface);
+
+  // Finds the region of |key| in the atlas texture, and marks it as the most
+  // recently used one. Returns false if |key| is not uploaded, or has been
+  // evicted.
+  bool Lookup(Key key, SDL_Rect* src_rect);
+  bool Contains(Key key) const;
+  void Remove(Key key);
+
+  SDL_Texture* texture() { return texture_; }
+  int texture_width() const {
+    return (cell_width_ + kCellPadding * 2) * columns_;
+  }
+  int texture_height() const {
+    return (cell_height_ + kCellPadding * 2) * rows_;
+  }
+  int cell_width() const { return cell_width_; }
+  int cell_height() const { return cell_height_; }
+  size_t capacity() const { return cells_.size(); }
+  size_t size() const { return entries_.size(); }
+  size_t eviction_count() const { return eviction_count_; }
+
+ private:
+  struct Entry {
+    int cell_index;
+    SDL_Rect rect;
+    std::list<Key>::iterator lru_iterator;
+  };
+
+  int AcquireCell();
+
+ private:
+  SDL_Renderer* renderer_ = nullptr;
+  SDL_Texture* texture_ = nullptr;
+  int cell_width_ = 0;
+  int cell_height_ = 0;
+  int columns_ = 0;
+  int rows_ = 0;
+
+  // The origin of each cell's box art in the atlas texture, which is inside
+  // the cell's border.
+  std::vector<SDL_Point> cells_;
+  std::vector<int> free_cells_;
+  std::unordered_map<Key, Entry> entries_;
+  // Front is the most recently used key.
+  std::list<Key> lru_;
+  size_t eviction_count_ = 0;
+};
+
+#endif  // UTILITY_BOXART_ATLAS_H_
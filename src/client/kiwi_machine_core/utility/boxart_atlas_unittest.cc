@@ -0,0 +1,206 @@
+// Copyright (C) 2026 Yisi Yu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#include "third_party/googletest-release-1.12.1/googletest/include/gtest/gtest.h"
+#include "utility/boxart_atlas.h"
+
+namespace {
+
+// Encodes a solid color image as BMP, which can be decoded by SDL_image.
+kiwi::nes::Bytes CreateBMP(int width, int height, Uint32 rgba) {
+  SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat(
+      0, width, height, 32, SDL_PIXELFORMAT_RGBA32);
+  SDL_FillRect(surface, nullptr,
+               SDL_MapRGBA(surface->format, rgba >> 24, (rgba >> 16) & 0xff,
+                           (rgba >> 8) & 0xff, rgba & 0xff));
+
+  kiwi::nes::Bytes result(width * height * 4 + 1024);
+  SDL_RWops* rw = SDL_RWFromMem(result.data(), result.size());
+  SDL_SaveBMP_RW(surface, rw, 0);
+  result.resize(SDL_RWtell(rw));
+  SDL_RWclose(rw);
+  SDL_FreeSurface(surface);
+  return result;
+}
+
+SDL_Surface* CreateSolidSurface(int width, int height, Uint8 r, Uint8 g,
+                                Uint8 b) {
+  SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat(
+      0, width, height, 32, SDL_PIXELFORMAT_RGBA32);
+  SDL_FillRect(surface, nullptr, SDL_MapRGBA(surface->format, r, g, b, 255));
+  return surface;
+}
+
+}  // namespace
+
+class BoxArtAtlasTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    target_ = SDL_CreateRGBSurfaceWithFormat(0, 64, 64, 32,
+                                             SDL_PIXELFORMAT_RGBA32);
+    ASSERT_TRUE(target_);
+    renderer_ = SDL_CreateSoftwareRenderer(target_);
+    ASSERT_TRUE(renderer_);
+  }
+
+  void TearDown() override {
+    SDL_DestroyRenderer(renderer_);
+    SDL_FreeSurface(target_);
+  }
+
+  // Draws |rect| of the atlas to the top-left of the target, and reads the
+  // center pixel.
+  SDL_Color ReadPixel(BoxArtAtlas& atlas, const SDL_Rect& rect) {
+    SDL_RenderClear(renderer_);
+    SDL_Rect dest{0, 0, rect.w, rect.h};
+    SDL_SetTextureBlendMode(atlas.texture(), SDL_BLENDMODE_NONE);
+    SDL_RenderCopy(renderer_, atlas.texture(), &rect, &dest);
+    Uint32 pixel = 0;
+    SDL_Rect point{rect.w / 2, rect.h / 2, 1, 1};
+    SDL_RenderReadPixels(renderer_, &point, SDL_PIXELFORMAT_RGBA32, &pixel,
+                         sizeof(pixel));
+    SDL_Color color;
+    SDL_PixelFormat* format = SDL_AllocFormat(SDL_PIXELFORMAT_RGBA32);
+    SDL_GetRGBA(pixel, format, &color.r, &color.g, &color.b, &color.a);
+    SDL_FreeFormat(format);
+    return color;
+  }
+
+  SDL_Surface* target_ = nullptr;
+  SDL_Renderer* renderer_ = nullptr;
+};
+
+TEST_F(BoxArtAtlasTest, DecodeKeepsAspectRatio) {
+  SDL_Surface* surface =
+      BoxArtAtlas::DecodeBoxArt(CreateBMP(200, 100, 0xff0000ff), 50, 50);
+  ASSERT_TRUE(surface);
+  EXPECT_EQ(surface->w, 50);
+  EXPECT_EQ(surface->h, 25);
+  EXPECT_EQ(surface->format->format, SDL_PIXELFORMAT_RGBA32);
+  SDL_FreeSurface(surface);
+
+  // Small images won't be enlarged.
+  surface = BoxArtAtlas::DecodeBoxArt(CreateBMP(10, 20, 0xff0000ff), 50, 50);
+  ASSERT_TRUE(surface);
+  EXPECT_EQ(surface->w, 10);
+  EXPECT_EQ(surface->h, 20);
+  SDL_FreeSurface(surface);
+}
+
+TEST_F(BoxArtAtlasTest, DecodeInvalidData) {
+  EXPECT_FALSE(BoxArtAtlas::DecodeBoxArt(kiwi::nes::Bytes(), 50, 50));
+  EXPECT_FALSE(BoxArtAtlas::DecodeBoxArt(kiwi::nes::Bytes(64, 0x5a), 50, 50));
+}
+
+TEST_F(BoxArtAtlasTest, UploadAndLookup) {
+  BoxArtAtlas atlas(renderer_, 16, 16, 2, 1);
+  ASSERT_TRUE(atlas.texture());
+  EXPECT_EQ(atlas.capacity(), 2u);
+
+  SDL_Surface* red = CreateSolidSurface(16, 8, 255, 0, 0);
+  SDL_Surface* green = CreateSolidSurface(8, 16, 0, 255, 0);
+  BoxArtAtlas::Key red_key = BoxArtAtlas::GenerateKey();
+  BoxArtAtlas::Key green_key = BoxArtAtlas::GenerateKey();
+  EXPECT_NE(red_key, green_key);
+  EXPECT_TRUE(atlas.Upload(red_key, red));
+  EXPECT_TRUE(atlas.Upload(green_key, green));
+
+  SDL_Rect red_rect, green_rect;
+  ASSERT_TRUE(atlas.Lookup(red_key, &red_rect));
+  ASSERT_TRUE(atlas.Lookup(green_key, &green_rect));
+  EXPECT_EQ(red_rect.w, 16);
+  EXPECT_EQ(red_rect.h, 8);
+  EXPECT_EQ(green_rect.w, 8);
+  EXPECT_EQ(green_rect.h, 16);
+  EXPECT_FALSE(SDL_HasIntersection(&red_rect, &green_rect));
+
+  SDL_Color color = ReadPixel(atlas, red_rect);
+  EXPECT_EQ(color.r, 255);
+  EXPECT_EQ(color.g, 0);
+  color = ReadPixel(atlas, green_rect);
+  EXPECT_EQ(color.r, 0);
+  EXPECT_EQ(color.g, 255);
+
+  // Surfaces larger than a cell are rejected.
+  SDL_Surface* large = CreateSolidSurface(17, 16, 0, 0, 255);
+  EXPECT_FALSE(atlas.Upload(BoxArtAtlas::GenerateKey(), large));
+  EXPECT_EQ(atlas.size(), 2u);
+
+  SDL_FreeSurface(red);
+  SDL_FreeSurface(green);
+  SDL_FreeSurface(large);
+}
+
+// The border of a cell repeats the edges of its box art, so filtering never
+// blends in the box art of the next cell.
+TEST_F(BoxArtAtlasTest, BordersRepeatEdges) {
+  BoxArtAtlas atlas(renderer_, 8, 8, 2, 1);
+  EXPECT_EQ(atlas.texture_width(), (8 + BoxArtAtlas::kCellPadding * 2) * 2);
+  EXPECT_EQ(atlas.texture_height(), 8 + BoxArtAtlas::kCellPadding * 2);
+
+  SDL_Surface* red = CreateSolidSurface(6, 8, 255, 0, 0);
+  SDL_Surface* green = CreateSolidSurface(8, 8, 0, 255, 0);
+  BoxArtAtlas::Key red_key = BoxArtAtlas::GenerateKey();
+  BoxArtAtlas::Key green_key = BoxArtAtlas::GenerateKey();
+  EXPECT_TRUE(atlas.Upload(red_key, red));
+  EXPECT_TRUE(atlas.Upload(green_key, green));
+
+  SDL_Rect rect;
+  ASSERT_TRUE(atlas.Lookup(red_key, &rect));
+  const SDL_Rect borders[] = {
+      {rect.x - 1, rect.y, 1, rect.h},
+      {rect.x + rect.w, rect.y, 1, rect.h},
+      {rect.x, rect.y - 1, rect.w, 1},
+      {rect.x, rect.y + rect.h, rect.w, 1},
+  };
+  for (const SDL_Rect& border : borders) {
+    SDL_Color color = ReadPixel(atlas, border);
+    EXPECT_EQ(color.r, 255);
+    EXPECT_EQ(color.g, 0);
+  }
+
+  SDL_FreeSurface(red);
+  SDL_FreeSurface(green);
+}
+
+TEST_F(BoxArtAtlasTest, EvictsLeastRecentlyUsed) {
+  BoxArtAtlas atlas(renderer_, 8, 8, 2, 1);
+  SDL_Surface* surface = CreateSolidSurface(8, 8, 0, 0, 255);
+  BoxArtAtlas::Key keys[] = {BoxArtAtlas::GenerateKey(),
+                             BoxArtAtlas::GenerateKey(),
+                             BoxArtAtlas::GenerateKey()};
+
+  EXPECT_TRUE(atlas.Upload(keys[0], surface));
+  EXPECT_TRUE(atlas.Upload(keys[1], surface));
+
+  // Touches keys[0], so keys[1] becomes the least recently used one.
+  EXPECT_TRUE(atlas.Lookup(keys[0], nullptr));
+  EXPECT_TRUE(atlas.Upload(keys[2], surface));
+  EXPECT_EQ(atlas.eviction_count(), 1u);
+  EXPECT_TRUE(atlas.Contains(keys[0]));
+  EXPECT_FALSE(atlas.Contains(keys[1]));
+  EXPECT_TRUE(atlas.Contains(keys[2]));
+
+  // An evicted key can be uploaded again, which evicts keys[0] now.
+  EXPECT_TRUE(atlas.Upload(keys[1], surface));
+  EXPECT_EQ(atlas.eviction_count(), 2u);
+  EXPECT_FALSE(atlas.Contains(keys[0]));
+  EXPECT_EQ(atlas.size(), 2u);
+
+  // Removing a key frees its cell without evicting others.
+  atlas.Remove(keys[2]);
+  EXPECT_TRUE(atlas.Upload(keys[0], surface));
+  EXPECT_EQ(atlas.eviction_count(), 2u);
+  EXPECT_TRUE(atlas.Contains(keys[1]));
+
+  SDL_FreeSurface(surface);
+}
@@ -0,0 +1,753 @@
+// Copyright (C) 2026 Yisi Yu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#include "utility/pixel_scaler.h"
+
+#include <SDL.h>
+#include <algorithm>
+#include <cmath>
+#include <latch>
+#include <thread>
+#include <utility>
+
+#include "utility/pixel_scaler_kernels.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PIXEL_SCALER_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace pixel_scaler_internal {
+
+// A band, and its buffers which are kept for later frames.
+struct Band {
+  Job job;
+  std::vector<Color> pixels;
+  std::vector<uint32_t> yuv;
+  std::vector<uint32_t> masks;
+  std::vector<uint32_t> down_right_distances;
+  std::vector<uint32_t> up_right_distances;
+};
+
+namespace {
+
+#if PIXEL_SCALER_SSE2
+struct SSE2Vector {
+  using Type = __m128i;
+  static constexpr int kSize = 4;
+
+  static Type Load(const uint32_t* p) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+  }
+  static void Store(uint32_t* p, Type v) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v);
+  }
+  static void StoreInterleaved(uint32_t* p, Type a, Type b) {
+    Store(p, _mm_unpacklo_epi32(a, b));
+    Store(p + 4, _mm_unpackhi_epi32(a, b));
+  }
+  static Type Set(uint32_t v) { return _mm_set1_epi32(static_cast<int>(v)); }
+  static Type Equal(Type a, Type b) { return _mm_cmpeq_epi32(a, b); }
+  static Type And(Type a, Type b) { return _mm_and_si128(a, b); }
+  static Type Or(Type a, Type b) { return _mm_or_si128(a, b); }
+  static Type AndNot(Type a, Type b) { return _mm_andnot_si128(a, b); }
+  static Type Select(Type mask, Type a, Type b) {
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+  }
+
+  static Type AbsDiffBytes(Type a, Type b) {
+    return _mm_or_si128(_mm_subs_epu8(a, b), _mm_subs_epu8(b, a));
+  }
+  static Type Differs(Type a, Type b) {
+    Type excess = _mm_subs_epu8(AbsDiffBytes(a, b), Set(kYUVThresholds));
+    return _mm_xor_si128(_mm_cmpeq_epi32(excess, _mm_setzero_si128()),
+                         Set(0xffffffff));
+  }
+  // Components are less than 256, so that their products fit in 16 bits.
+  static Type Distance(Type a, Type b) {
+    Type diff = AbsDiffBytes(a, b);
+    Type y = _mm_srli_epi32(diff, 16);
+    Type u = _mm_and_si128(_mm_srli_epi32(diff, 8), Set(0xff));
+    Type v = _mm_and_si128(diff, Set(0xff));
+    return _mm_add_epi32(
+        _mm_add_epi32(_mm_mullo_epi16(y, Set(kYWeight)),
+                      _mm_mullo_epi16(u, Set(kUWeight))),
+        _mm_mullo_epi16(v, Set(kVWeight)));
+  }
+};
+#endif
+
+uint32_t ToYUV(Color color) {
+  int r = (color >> 16) & 0xff;
+  int g = (color >> 8) & 0xff;
+  int b = color & 0xff;
+  int y = (77 * r + 150 * g + 29 * b + 128) >> 8;
+  int u = ((-43 * r - 84 * g + 127 * b) >> 8) + 128;
+  int v = ((127 * r - 106 * g - 21 * b) >> 8) + 128;
+  return (y << 16) | (u << 8) | v;
+}
+
+bool Differs(uint32_t yuv_a, uint32_t yuv_b) {
+  return ScalarVector::Differs(yuv_a, yuv_b) != 0;
+}
+
+uint32_t Distance(uint32_t yuv_a, uint32_t yuv_b) {
+  return ScalarVector::Distance(yuv_a, yuv_b);
+}
+
+// Returns (a * (256 - weight) + b * weight) / 256 of each channel.
+Color Mix(Color a, Color b, uint32_t weight) {
+  uint32_t rb = ((a & 0xff00ff) * (256 - weight) +
+                 (b & 0xff00ff) * weight + 0x800080) >>
+                8;
+  uint32_t ag = (((a >> 8) & 0xff00ff) * (256 - weight) +
+                 ((b >> 8) & 0xff00ff) * weight + 0x800080) >>
+                8;
+  return (rb & 0xff00ff) | ((ag & 0xff00ff) << 8);
+}
+
+// Returns (a * weight_a + b * weight_b + c * weight_c) / 8 of each channel.
+// Weights must sum up to 8.
+Color Mix3(Color a,
+           uint32_t weight_a,
+           Color b,
+           uint32_t weight_b,
+           Color c,
+           uint32_t weight_c) {
+  uint32_t rb = ((a & 0xff00ff) * weight_a + (b & 0xff00ff) * weight_b +
+                 (c & 0xff00ff) * weight_c + 0x40004) >>
+                3;
+  uint32_t ag =
+      (((a >> 8) & 0xff00ff) * weight_a + ((b >> 8) & 0xff00ff) * weight_b +
+       ((c >> 8) & 0xff00ff) * weight_c + 0x40004) >>
+      3;
+  return (rb & 0xff00ff) | ((ag & 0xff00ff) << 8);
+}
+
+// How a corner of a pixel E is blended by HQx, which is decided by its
+// diagonal neighbor A and its neighbors B and D on both sides of A.
+//   A B
+//   D E
+enum class HQCorner {
+  kKeep,
+  // B and D are alike, and differ from E and A: an edge along B and D cuts
+  // the corner.
+  kEdge,
+  // B and D are alike, and differ from E, but A is like E: E is part of a
+  // thin diagonal line, which is softened only.
+  kLine,
+  // Only A differs from E: the corner of a concave shape, which is rounded.
+  kRound,
+};
+
+// The bit of neighbor (dx, dy) of a pixel in HQx masks.
+constexpr int HQMaskBit(int dx, int dy) {
+  int index = (dy + 1) * 3 + dx + 1;
+  return index > 4 ? index - 1 : index;
+}
+
+template <int kDx, int kDy>
+HQCorner ClassifyHQCorner(uint32_t mask, const uint32_t* yuv, int stride) {
+  const bool diagonal = mask & (1 << HQMaskBit(kDx, kDy));
+  const bool vertical = mask & (1 << HQMaskBit(0, kDy));
+  const bool horizontal = mask & (1 << HQMaskBit(kDx, 0));
+  if (vertical && horizontal) {
+    if (Differs(yuv[kDy * stride], yuv[kDx]))
+      return HQCorner::kKeep;
+    return diagonal ? HQCorner::kEdge : HQCorner::kLine;
+  }
+  if (!vertical && !horizontal && diagonal)
+    return HQCorner::kRound;
+  return HQCorner::kKeep;
+}
+
+// The corner pixel of HQ2x, or of HQ3x if |is_hq3x|, which is further from E
+// and so sharper.
+template <int kDx, int kDy>
+Color BlendHQCorner(HQCorner corner,
+                    const Color* pixel,
+                    int stride,
+                    bool is_hq3x) {
+  const Color e = pixel[0];
+  switch (corner) {
+    case HQCorner::kEdge:
+      return is_hq3x ? Mix3(e, 2, pixel[kDy * stride], 3, pixel[kDx], 3)
+                     : Mix3(e, 4, pixel[kDy * stride], 2, pixel[kDx], 2);
+    case HQCorner::kLine:
+      return Mix3(e, 6, pixel[kDy * stride], 1, pixel[kDx], 1);
+    case HQCorner::kRound:
+      return Mix3(e, 6, pixel[kDy * stride + kDx], 2, e, 0);
+    default:
+      return e;
+  }
+}
+
+// An edge at either end of a side of HQ3x's block tints the middle of the side
+// by an eighth each.
+Color BlendHQSide(Color e, Color neighbor, HQCorner corner0, HQCorner corner1) {
+  uint32_t weight = (corner0 == HQCorner::kEdge) + (corner1 == HQCorner::kEdge);
+  return weight ? Mix3(e, 8 - weight, neighbor, weight, e, 0) : e;
+}
+
+// Regions of xBR's blocks which a corner's edge covers, see
+// GetXBRCoverage().
+enum XBRRegion {
+  // Only the corner's pixel is blended by half.
+  kXBRCorner,
+  // A 45 degree edge.
+  kXBRDiagonal,
+  // A shallow edge, along the bottom of the block.
+  kXBRShallow,
+  // A steep edge, along the right of the block.
+  kXBRSteep,
+  kXBRShallowAndSteep,
+
+  kXBRRegionCount,
+};
+
+constexpr int kXBRCells = kXBRScale * kXBRScale;
+
+// The part of each pixel of a block, by 256, which the edge of the
+// bottom-right corner covers. The edges go through the middle of the block's
+// right and bottom sides, and the shallow and steep ones through its
+// bottom-left and top-right corners, which is what xBR's blends are.
+struct XBRCoverage {
+  uint32_t weights[kXBRRegionCount][kXBRCells];
+};
+
+struct Point {
+  double x;
+  double y;
+};
+
+// The half plane a * x + b * y >= c.
+struct HalfPlane {
+  double a;
+  double b;
+  double c;
+};
+
+std::vector<Point> Clip(const std::vector<Point>& polygon, HalfPlane plane) {
+  std::vector<Point> result;
+  for (size_t i = 0; i < polygon.size(); ++i) {
+    const Point& p = polygon[i];
+    const Point& q = polygon[(i + 1) % polygon.size()];
+    double fp = plane.a * p.x + plane.b * p.y - plane.c;
+    double fq = plane.a * q.x + plane.b * q.y - plane.c;
+    if (fp >= 0)
+      result.push_back(p);
+    if ((fp >= 0) != (fq >= 0)) {
+      double t = fp / (fp - fq);
+      result.push_back({p.x + t * (q.x - p.x), p.y + t * (q.y - p.y)});
+    }
+  }
+  return result;
+}
+
+double Area(const std::vector<Point>& polygon) {
+  double area = 0;
+  for (size_t i = 0; i < polygon.size(); ++i) {
+    const Point& p = polygon[i];
+    const Point& q = polygon[(i + 1) % polygon.size()];
+    area += p.x * q.y - q.x * p.y;
+  }
+  return std::abs(area) / 2;
+}
+
+const XBRCoverage& GetXBRCoverage() {
+  static const XBRCoverage coverage = [] {
+    constexpr double kSize = kXBRScale;
+    const HalfPlane kDiagonal = {2, 2, kSize * 3};
+    const HalfPlane kShallow = {1, 2, kSize * 2};
+    const HalfPlane kSteep = {2, 1, kSize * 2};
+    XBRCoverage result = {};
+    for (int y = 0; y < kXBRScale; ++y) {
+      for (int x = 0; x < kXBRScale; ++x) {
+        const std::vector<Point> cell = {
+            {double(x), double(y)},
+            {double(x + 1), double(y)},
+            {double(x + 1), double(y + 1)},
+            {double(x), double(y + 1)}};
+        double shallow = Area(Clip(cell, kShallow));
+        double steep = Area(Clip(cell, kSteep));
+        double both = Area(Clip(Clip(cell, kShallow), kSteep));
+        const double areas[kXBRRegionCount] = {
+            0, Area(Clip(cell, kDiagonal)), shallow, steep,
+            shallow + steep - both};
+        for (int region = 0; region < kXBRRegionCount; ++region) {
+          result.weights[region][y * kXBRScale + x] =
+              static_cast<uint32_t>(std::lround(areas[region] * 256));
+        }
+      }
+    }
+    result.weights[kXBRCorner][kXBRCells - 1] = 128;
+    return result;
+  }();
+  return coverage;
+}
+
+// Neighbors of a pixel, by offsets of the bottom-right corner, turned to
+// another corner. Corners from kRotation 0 to 3 are bottom-right, top-right,
+// top-left and bottom-left.
+template <int kRotation>
+struct XBRWindow {
+  static constexpr int RotateX(int dx, int dy) {
+    for (int i = 0; i < kRotation; ++i) {
+      int x = dy;
+      dy = -dx;
+      dx = x;
+    }
+    return dx;
+  }
+  static constexpr int RotateY(int dx, int dy) {
+    for (int i = 0; i < kRotation; ++i) {
+      int x = dy;
+      dy = -dx;
+      dx = x;
+    }
+    return dy;
+  }
+
+  // The cell of the block at (x, y) of the bottom-right corner.
+  static constexpr int Cell(int x, int y) {
+    for (int i = 0; i < kRotation; ++i) {
+      int rotated = y;
+      y = kXBRScale - 1 - x;
+      x = rotated;
+    }
+    return y * kXBRScale + x;
+  }
+
+  int Offset(int dx, int dy) const {
+    return RotateY(dx, dy) * stride + RotateX(dx, dy);
+  }
+  Color pixel(int dx, int dy) const { return pixels[Offset(dx, dy)]; }
+  uint32_t yuv(int dx, int dy) const { return yuvs[Offset(dx, dy)]; }
+
+  // The distance between diagonal neighbors (dx0, dy0) and (dx1, dy1).
+  uint32_t DiagonalDistance(int dx0, int dy0, int dx1, int dy1) const {
+    int x0 = RotateX(dx0, dy0), y0 = RotateY(dx0, dy0);
+    int x1 = RotateX(dx1, dy1), y1 = RotateY(dx1, dy1);
+    if (x1 < x0) {
+      std::swap(x0, x1);
+      std::swap(y0, y1);
+    }
+    int offset = y0 * stride + x0;
+    return y1 > y0 ? down_right_distances[offset] : up_right_distances[offset];
+  }
+
+  bool Alike(int dx0, int dy0, int dx1, int dy1) const {
+    return !Differs(yuv(dx0, dy0), yuv(dx1, dy1));
+  }
+
+  const Color* pixels;
+  const uint32_t* yuvs;
+  const uint32_t* down_right_distances;
+  const uint32_t* up_right_distances;
+  int stride;
+};
+
+// Blends a corner of |block| by xBR level 2. In the bottom-right corner,
+// neighbors are:
+//         A1 B1 C1
+//      A0 A  B  C  C4
+//      D0 D  E  F  F4
+//      G0 G  H  I  I4
+//         G5 H5 I5
+template <int kRotation>
+void BlendXBRCorner(const XBRWindow<kRotation>& w,
+                    Color* block,
+                    int block_stride) {
+  const Color e = w.pixel(0, 0);
+  const Color f = w.pixel(1, 0);
+  const Color h = w.pixel(0, 1);
+  if (e == f || e == h)
+    return;
+
+  // Weights of an edge along E-I (H-F), and of one along H-F (E-I).
+  uint32_t edge_ei = w.DiagonalDistance(0, 0, 1, -1) +   // E-C
+                     w.DiagonalDistance(-1, 1, 0, 0) +   // G-E
+                     w.DiagonalDistance(1, 1, 2, 0) +    // I-F4
+                     w.DiagonalDistance(0, 2, 1, 1) +    // H5-I
+                     w.DiagonalDistance(0, 1, 1, 0) * 4;  // H-F
+  uint32_t edge_hf = w.DiagonalDistance(-1, 0, 0, 1) +   // D-H
+                     w.DiagonalDistance(0, 1, 1, 2) +    // H-I5
+                     w.DiagonalDistance(1, 0, 2, 1) +    // F-I4
+                     w.DiagonalDistance(0, -1, 1, 0) +   // B-F
+                     w.DiagonalDistance(0, 0, 1, 1) * 4;  // E-I
+  const uint32_t e_yuv = w.yuv(0, 0);
+  const Color px = Distance(e_yuv, w.yuv(1, 0)) <= Distance(e_yuv, w.yuv(0, 1))
+                       ? f
+                       : h;
+
+  XBRRegion region;
+  if (edge_ei < edge_hf &&
+      ((!w.Alike(1, 0, 0, -1) && !w.Alike(0, 1, -1, 0)) ||
+       (w.Alike(0, 0, 1, 1) && !w.Alike(1, 0, 2, 1) &&
+        !w.Alike(0, 1, 1, 2)) ||
+       w.Alike(0, 0, -1, 1) || w.Alike(0, 0, 1, -1))) {
+    const Color c = w.pixel(1, -1);
+    const Color g = w.pixel(-1, 1);
+    uint32_t fg = Distance(w.yuv(1, 0), w.yuv(-1, 1));
+    uint32_t hc = Distance(w.yuv(0, 1), w.yuv(1, -1));
+    bool shallow = fg * 2 <= hc && e != g && w.pixel(-1, 0) != g;
+    bool steep = fg >= hc * 2 && e != c && w.pixel(0, -1) != c;
+    if (shallow && steep)
+      region = kXBRShallowAndSteep;
+    else if (shallow)
+      region = kXBRShallow;
+    else if (steep)
+      region = kXBRSteep;
+    else
+      region = kXBRDiagonal;
+  } else if (edge_ei <= edge_hf) {
+    region = kXBRCorner;
+  } else {
+    return;
+  }
+
+  const uint32_t* weights = GetXBRCoverage().weights[region];
+  for (int y = 0; y < kXBRScale; ++y) {
+    for (int x = 0; x < kXBRScale; ++x) {
+      uint32_t weight = weights[y * kXBRScale + x];
+      if (weight) {
+        int cell = XBRWindow<kRotation>::Cell(x, y);
+        Color* output =
+            block + cell / kXBRScale * block_stride + cell % kXBRScale;
+        *output = Mix(*output, px, weight);
+      }
+    }
+  }
+}
+
+template <int kRotation>
+XBRWindow<kRotation> MakeXBRWindow(const Job& job, int x, int y) {
+  int index = PixelIndex(job, x, y);
+  return {job.pixels + index, job.yuv + index,
+          job.down_right_distances + index, job.up_right_distances + index,
+          PixelStride(job)};
+}
+
+void ScaleBandScalar(const Job& job) {
+  ScaleBand<ScalarVector>(job);
+}
+
+#if PIXEL_SCALER_SSE2
+void ScaleBandSSE2(const Job& job) {
+  ScaleBand<SSE2Vector>(job);
+}
+#endif
+
+}  // namespace
+
+void PreparePixels(const Job& job) {
+  const int rows = job.end_row - job.first_row;
+  for (int y = -kBorder; y < rows + kBorder; ++y) {
+    int source_row = std::clamp(job.first_row + y, 0, job.height - 1);
+    const Color* source = job.source + source_row * job.width;
+    Color* pixels = job.pixels + PixelIndex(job, 0, y);
+    std::copy(source, source + job.width, pixels);
+    for (int x = 1; x <= kBorder; ++x) {
+      pixels[-x] = source[0];
+      pixels[job.width - 1 + x] = source[job.width - 1];
+    }
+  }
+
+  if (job.yuv) {
+    const int size = (rows + kBorder * 2) * PixelStride(job);
+    for (int i = 0; i < size; ++i)
+      job.yuv[i] = ToYUV(job.pixels[i]);
+  }
+}
+
+void ApplyHQ2x(const Job& job) {
+  const int stride = PixelStride(job);
+  for (int y = 0; y < job.end_row - job.first_row; ++y) {
+    Color* output0 = job.output + y * 2 * job.output_pitch;
+    Color* output1 = output0 + job.output_pitch;
+    for (int x = 0; x < job.width; ++x) {
+      const int index = PixelIndex(job, x, y);
+      const Color* pixel = job.pixels + index;
+      const uint32_t* yuv = job.yuv + index;
+      const uint32_t mask = job.masks[y * job.width + x];
+      if (!mask) {
+        output0[x * 2] = output0[x * 2 + 1] = output1[x * 2] =
+            output1[x * 2 + 1] = pixel[0];
+        continue;
+      }
+
+      output0[x * 2] = BlendHQCorner<-1, -1>(
+          ClassifyHQCorner<-1, -1>(mask, yuv, stride), pixel, stride, false);
+      output0[x * 2 + 1] = BlendHQCorner<1, -1>(
+          ClassifyHQCorner<1, -1>(mask, yuv, stride), pixel, stride, false);
+      output1[x * 2] = BlendHQCorner<-1, 1>(
+          ClassifyHQCorner<-1, 1>(mask, yuv, stride), pixel, stride, false);
+      output1[x * 2 + 1] = BlendHQCorner<1, 1>(
+          ClassifyHQCorner<1, 1>(mask, yuv, stride), pixel, stride, false);
+    }
+  }
+}
+
+void ApplyHQ3x(const Job& job) {
+  const int stride = PixelStride(job);
+  for (int y = 0; y < job.end_row - job.first_row; ++y) {
+    Color* output0 = job.output + y * 3 * job.output_pitch;
+    Color* output1 = output0 + job.output_pitch;
+    Color* output2 = output1 + job.output_pitch;
+    for (int x = 0; x < job.width; ++x) {
+      const int index = PixelIndex(job, x, y);
+      const Color* pixel = job.pixels + index;
+      const Color e = pixel[0];
+      const uint32_t* yuv = job.yuv + index;
+      const uint32_t mask = job.masks[y * job.width + x];
+      if (!mask) {
+        std::fill_n(output0 + x * 3, 3, e);
+        std::fill_n(output1 + x * 3, 3, e);
+        std::fill_n(output2 + x * 3, 3, e);
+        continue;
+      }
+
+      HQCorner top_left = ClassifyHQCorner<-1, -1>(mask, yuv, stride);
+      HQCorner top_right = ClassifyHQCorner<1, -1>(mask, yuv, stride);
+      HQCorner bottom_left = ClassifyHQCorner<-1, 1>(mask, yuv, stride);
+      HQCorner bottom_right = ClassifyHQCorner<1, 1>(mask, yuv, stride);
+      output0[x * 3] = BlendHQCorner<-1, -1>(top_left, pixel, stride, true);
+      output0[x * 3 + 1] =
+          BlendHQSide(e, pixel[-stride], top_left, top_right);
+      output0[x * 3 + 2] = BlendHQCorner<1, -1>(top_right, pixel, stride, true);
+      output1[x * 3] = BlendHQSide(e, pixel[-1], top_left, bottom_left);
+      output1[x * 3 + 1] = e;
+      output1[x * 3 + 2] = BlendHQSide(e, pixel[1], top_right, bottom_right);
+      output2[x * 3] = BlendHQCorner<-1, 1>(bottom_left, pixel, stride, true);
+      output2[x * 3 + 1] =
+          BlendHQSide(e, pixel[stride], bottom_left, bottom_right);
+      output2[x * 3 + 2] =
+          BlendHQCorner<1, 1>(bottom_right, pixel, stride, true);
+    }
+  }
+}
+
+void ApplyXBR(const Job& job) {
+  const int stride = PixelStride(job);
+  for (int y = 0; y < job.end_row - job.first_row; ++y) {
+    Color* output = job.output + y * kXBRScale * job.output_pitch;
+    for (int x = 0; x < job.width; ++x) {
+      Color* block = output + x * kXBRScale;
+      const Color* pixel = job.pixels + PixelIndex(job, x, y);
+      const Color e = pixel[0];
+      for (int row = 0; row < kXBRScale; ++row)
+        std::fill_n(block + row * job.output_pitch, kXBRScale, e);
+
+      // A corner isn't blended if E equals one of its two sides, so most pixels
+      // skip all of them.
+      const bool right = e == pixel[1];
+      const bool down = e == pixel[stride];
+      const bool left = e == pixel[-1];
+      const bool up = e == pixel[-stride];
+      if ((right || down) && (up || right) && (left || up) && (down || left))
+        continue;
+
+      // Corners are blended in xBR's order, where later ones blend over
+      // earlier ones.
+      BlendXBRCorner(MakeXBRWindow<0>(job, x, y), block, job.output_pitch);
+      BlendXBRCorner(MakeXBRWindow<1>(job, x, y), block, job.output_pitch);
+      BlendXBRCorner(MakeXBRWindow<2>(job, x, y), block, job.output_pitch);
+      BlendXBRCorner(MakeXBRWindow<3>(job, x, y), block, job.output_pitch);
+    }
+  }
+}
+
+}  // namespace pixel_scaler_internal
+
+namespace {
+using pixel_scaler_internal::Band;
+using pixel_scaler_internal::Job;
+
+void ScaleBand(const Job* job,
+               PixelScaler::InstructionSet instruction_set,
+               std::latch* done) {
+  switch (instruction_set) {
+    case PixelScaler::InstructionSet::kAVX2:
+      if (pixel_scaler_internal::ScaleAVX2(*job))
+        break;
+      [[fallthrough]];
+    case PixelScaler::InstructionSet::kSSE2:
+#if PIXEL_SCALER_SSE2
+      pixel_scaler_internal::ScaleBandSSE2(*job);
+      break;
+#else
+      [[fallthrough]];
+#endif
+    case PixelScaler::InstructionSet::kScalar:
+      pixel_scaler_internal::ScaleBandScalar(*job);
+      break;
+  }
+  if (done)
+    done->count_down();
+}
+
+}  // namespace
+
+PixelScaler::PixelScaler(int thread_count)
+    : instruction_set_(GetSupportedInstructionSet()) {
+  if (thread_count <= 0) {
+    thread_count =
+        std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+  }
+  thread_count_ = thread_count;
+  if (thread_count_ > 1)
+    thread_pool_ = std::make_unique<kiwi::base::ThreadPool>(thread_count_ - 1);
+}
+
+PixelScaler::~PixelScaler() = default;
+
+int PixelScaler::GetScaleFactor(Filter filter) {
+  switch (filter) {
+    case Filter::kScale2x:
+    case Filter::kHQ2x:
+      return 2;
+    case Filter::kScale3x:
+    case Filter::kHQ3x:
+      return 3;
+    case Filter::kXBR:
+      return pixel_scaler_internal::kXBRScale;
+    default:
+      return 1;
+  }
+}
+
+int PixelScaler::GetNeighborRows() {
+  return pixel_scaler_internal::kBorder;
+}
+
+const char* PixelScaler::GetFilterName(Filter filter) {
+  switch (filter) {
+    case Filter::kScale2x:
+      return "Scale2x";
+    case Filter::kScale3x:
+      return "Scale3x";
+    case Filter::kHQ2x:
+      return "HQ2x";
+    case Filter::kHQ3x:
+      return "HQ3x";
+    case Filter::kXBR:
+      return "xBR";
+    default:
+      return "None";
+  }
+}
+
+PixelScaler::InstructionSet PixelScaler::GetSupportedInstructionSet() {
+  if (pixel_scaler_internal::HasAVX2Kernels() && SDL_HasAVX2())
+    return InstructionSet::kAVX2;
+#if PIXEL_SCALER_SSE2
+  if (SDL_HasSSE2())
+    return InstructionSet::kSSE2;
+#endif
+  return InstructionSet::kScalar;
+}
+
+void PixelScaler::Scale(Filter filter,
+                        int width,
+                        int height,
+                        const kiwi::nes::Colors& source,
+                        kiwi::nes::Colors* output) {
+  const int factor = GetScaleFactor(filter);
+  output->resize(width * factor * height * factor);
+  Scale(filter, width, height, source, output->data(), width * factor);
+}
+
+void PixelScaler::Scale(Filter filter,
+                        int width,
+                        int height,
+                        const kiwi::nes::Colors& source,
+                        kiwi::nes::Color* output,
+                        int output_pitch) {
+  ScaleRows(filter, width, height, source, 0, height, output, output_pitch);
+}
+
+void PixelScaler::ScaleRows(Filter filter,
+                            int width,
+                            int height,
+                            const kiwi::nes::Colors& source,
+                            int first_row,
+                            int end_row,
+                            kiwi::nes::Color* output,
+                            int output_pitch) {
+  SDL_assert(filter != Filter::kNone);
+  SDL_assert(width > 0 && height > 0);
+  SDL_assert(0 <= first_row && first_row < end_row && end_row <= height);
+  SDL_assert(source.size() >= static_cast<size_t>(width * height));
+  const int factor = GetScaleFactor(filter);
+  SDL_assert(output_pitch >= width * factor);
+
+  // Bands are at least a few rows high, so that rows which are copied for
+  // their neighbors don't outnumber their own.
+  constexpr int kMinRowsPerBand = 8;
+  const int rows = end_row - first_row;
+  const int band_count = std::clamp(rows / kMinRowsPerBand, 1, thread_count_);
+  while (bands_.size() < static_cast<size_t>(band_count))
+    bands_.push_back(std::make_unique<Band>());
+
+  for (int i = 0; i < band_count; ++i) {
+    Band* band = bands_[i].get();
+    Job& job = band->job;
+    job.filter = filter;
+    job.width = width;
+    job.height = height;
+    job.first_row = first_row + rows * i / band_count;
+    job.end_row = first_row + rows * (i + 1) / band_count;
+    job.source = source.data();
+    job.output =
+        output + (job.first_row - first_row) * factor * output_pitch;
+    job.output_pitch = output_pitch;
+
+    const size_t size =
+        (job.end_row - job.first_row + pixel_scaler_internal::kBorder * 2) *
+        (width + pixel_scaler_internal::kBorder * 2);
+    band->pixels.resize(size);
+    job.pixels = band->pixels.data();
+    job.yuv = nullptr;
+    job.masks = nullptr;
+    job.down_right_distances = nullptr;
+    job.up_right_distances = nullptr;
+    if (filter == Filter::kHQ2x || filter == Filter::kHQ3x ||
+        filter == Filter::kXBR) {
+      band->yuv.resize(size);
+      job.yuv = band->yuv.data();
+    }
+    if (filter == Filter::kHQ2x || filter == Filter::kHQ3x) {
+      band->masks.resize(width * (job.end_row - job.first_row));
+      job.masks = band->masks.data();
+    }
+    if (filter == Filter::kXBR) {
+      band->down_right_distances.resize(size);
+      band->up_right_distances.resize(size);
+      job.down_right_distances = band->down_right_distances.data();
+      job.up_right_distances = band->up_right_distances.data();
+    }
+  }
+
+  // The first band is scaled on the calling thread, while the others are on
+  // the pool.
+  std::latch done(band_count - 1);
+  for (int i = 1; i < band_count; ++i) {
+    bool posted = thread_pool_->PostTask(
+        FROM_HERE, kiwi::base::TaskPriority::kUserBlocking,
+        kiwi::base::BindOnce(&ScaleBand, &bands_[i]->job, instruction_set_,
+                             &done));
+    SDL_assert(posted);
+  }
+  ScaleBand(&bands_[0]->job, instruction_set_, nullptr);
+  done.wait();
+}
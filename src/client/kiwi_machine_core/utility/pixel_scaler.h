@@ -0,0 +1,122 @@
+// Copyright (C) 2026 Yisi Yu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#ifndef UTILITY_PIXEL_SCALER_H_
+#define UTILITY_PIXEL_SCALER_H_
+
+#include <kiwi_nes.h>
+#include <memory>
+#include <vector>
+
+namespace pixel_scaler_internal {
+struct Band;
+}
+
+// PixelScaler upscales frames by pixel-art filters on the CPU, so that they
+// look smooth when they are presented much larger than the NES resolution,
+// where the renderer only has nearest and linear filtering.
+// Each filter scales by its own factor, see GetScaleFactor(), and the
+// renderer stretches the result the rest of the way. Rows of a frame are
+// split into bands which are scaled in parallel, on a thread pool and the
+// calling thread. The data-parallel steps of each filter are vectorized with
+// SSE2 or AVX2, whichever the CPU supports.
+class PixelScaler {
+ public:
+  enum class Filter {
+    kNone,
+    // AdvMAME2x and AdvMAME3x, which extend edges without blending.
+    kScale2x,
+    kScale3x,
+    // Blends neighbors which differ from a pixel by hqx's YUV thresholds.
+    kHQ2x,
+    kHQ3x,
+    // Hyllian's xBR, level 2, at 4x.
+    kXBR,
+
+    kLast = kXBR,
+  };
+
+  enum class InstructionSet {
+    kScalar,
+    kSSE2,
+    kAVX2,
+  };
+
+  // Scales by |thread_count| threads, including the calling thread. If
+  // |thread_count| is 0, hardware concurrency is used.
+  explicit PixelScaler(int thread_count = 0);
+  ~PixelScaler();
+
+  PixelScaler(const PixelScaler&) = delete;
+  PixelScaler& operator=(const PixelScaler&) = delete;
+
+  // How many times larger a frame is scaled by |filter|, which is 1 for
+  // kNone.
+  static int GetScaleFactor(Filter filter);
+
+  // Rows above and below a row which its scaled rows depend on, so that
+  // changing a row changes the scaled rows of as many rows around it.
+  static int GetNeighborRows();
+  static const char* GetFilterName(Filter filter);
+
+  // The best instruction set which the CPU supports, and which the kernels are
+  // compiled for.
+  static InstructionSet GetSupportedInstructionSet();
+
+  // Scales |source|, which is |width| x |height| pixels, by |filter| into
+  // |output|, which is resized to fit. |filter| must not be kNone.
+  void Scale(Filter filter,
+             int width,
+             int height,
+             const kiwi::nes::Colors& source,
+             kiwi::nes::Colors* output);
+
+  // Like above, but scales into |output|, whose rows are |output_pitch|
+  // pixels apart, such as a locked texture. It must hold |height| times the
+  // scale factor rows.
+  void Scale(Filter filter,
+             int width,
+             int height,
+             const kiwi::nes::Colors& source,
+             kiwi::nes::Color* output,
+             int output_pitch);
+
+  // Like above, but only scales rows [|first_row|, |end_row|) of |source|.
+  // |output| holds their scaled rows only.
+  void ScaleRows(Filter filter,
+                 int width,
+                 int height,
+                 const kiwi::nes::Colors& source,
+                 int first_row,
+                 int end_row,
+                 kiwi::nes::Color* output,
+                 int output_pitch);
+
+  int thread_count() const { return thread_count_; }
+
+  // Uses |instruction_set| instead of the supported one, which is for tests
+  // comparing results of each instruction set. The CPU must support it.
+  void set_instruction_set(InstructionSet instruction_set) {
+    instruction_set_ = instruction_set;
+  }
+  InstructionSet instruction_set() const { return instruction_set_; }
+
+ private:
+  int thread_count_ = 1;
+  InstructionSet instruction_set_;
+  std::unique_ptr<kiwi::base::ThreadPool> thread_pool_;
+
+  // Buffers of each band, which are kept to be reused by later frames.
+  std::vector<std::unique_ptr<pixel_scaler_internal::Band>> bands_;
+};
+
+#endif  // UTILITY_PIXEL_SCALER_H_
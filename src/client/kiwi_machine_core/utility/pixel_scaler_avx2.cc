@@ -0,0 +1,96 @@
+// Copyright (C) 2026 Yisi Yu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// This file is compiled with AVX2 enabled on x86, and its code only runs if
+// the CPU supports AVX2, see PixelScaler::GetSupportedInstructionSet().
+
+#include "utility/pixel_scaler_kernels.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace pixel_scaler_internal {
+
+#if defined(__AVX2__)
+namespace {
+
+// See ScalarVector.
+struct AVX2Vector {
+  using Type = __m256i;
+  static constexpr int kSize = 8;
+
+  static Type Load(const uint32_t* p) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+  }
+  static void Store(uint32_t* p, Type v) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v);
+  }
+  // Unpacking interleaves each 128-bit half, which are put in order after.
+  static void StoreInterleaved(uint32_t* p, Type a, Type b) {
+    Type low = _mm256_unpacklo_epi32(a, b);
+    Type high = _mm256_unpackhi_epi32(a, b);
+    Store(p, _mm256_permute2x128_si256(low, high, 0x20));
+    Store(p + 8, _mm256_permute2x128_si256(low, high, 0x31));
+  }
+  static Type Set(uint32_t v) {
+    return _mm256_set1_epi32(static_cast<int>(v));
+  }
+  static Type Equal(Type a, Type b) { return _mm256_cmpeq_epi32(a, b); }
+  static Type And(Type a, Type b) { return _mm256_and_si256(a, b); }
+  static Type Or(Type a, Type b) { return _mm256_or_si256(a, b); }
+  static Type AndNot(Type a, Type b) { return _mm256_andnot_si256(a, b); }
+  static Type Select(Type mask, Type a, Type b) {
+    return _mm256_blendv_epi8(b, a, mask);
+  }
+
+  static Type AbsDiffBytes(Type a, Type b) {
+    return _mm256_or_si256(_mm256_subs_epu8(a, b), _mm256_subs_epu8(b, a));
+  }
+  static Type Differs(Type a, Type b) {
+    Type excess = _mm256_subs_epu8(AbsDiffBytes(a, b), Set(kYUVThresholds));
+    return _mm256_xor_si256(
+        _mm256_cmpeq_epi32(excess, _mm256_setzero_si256()), Set(0xffffffff));
+  }
+  static Type Distance(Type a, Type b) {
+    Type diff = AbsDiffBytes(a, b);
+    Type y = _mm256_srli_epi32(diff, 16);
+    Type u = _mm256_and_si256(_mm256_srli_epi32(diff, 8), Set(0xff));
+    Type v = _mm256_and_si256(diff, Set(0xff));
+    return _mm256_add_epi32(
+        _mm256_add_epi32(_mm256_mullo_epi16(y, Set(kYWeight)),
+                         _mm256_mullo_epi16(u, Set(kUWeight))),
+        _mm256_mullo_epi16(v, Set(kVWeight)));
+  }
+};
+
+}  // namespace
+
+bool ScaleAVX2(const Job& job) {
+  ScaleBand<AVX2Vector>(job);
+  return true;
+}
+
+bool HasAVX2Kernels() {
+  return true;
+}
+#else
+bool ScaleAVX2(const Job& job) {
+  return false;
+}
+
+bool HasAVX2Kernels() {
+  return false;
+}
+#endif
+
+}  // namespace pixel_scaler_internal
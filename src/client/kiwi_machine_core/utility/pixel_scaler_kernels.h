@@ -0,0 +1,376 @@
+// Copyright (C) 2026 Yisi Yu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#ifndef UTILITY_PIXEL_SCALER_KERNELS_H_
+#define UTILITY_PIXEL_SCALER_KERNELS_H_
+
+#include <cstdint>
+#include <cstdlib>
+
+#include "utility/pixel_scaler.h"
+
+// Kernels of PixelScaler. The data-parallel steps are templates over a vector
+// type, which are instantiated by pixel_scaler.cc for the scalar and SSE2
+// types, and by pixel_scaler_avx2.cc, which is compiled with AVX2 enabled, for
+// the AVX2 type. The other steps are plain functions in pixel_scaler.cc.
+namespace pixel_scaler_internal {
+
+using kiwi::nes::Color;
+
+// Pixels on each side of a band's rows, which repeat the frame's edges, so that
+// kernels never check bounds.
+constexpr int kBorder = 2;
+
+// xBR scales by 4 only.
+constexpr int kXBRScale = 4;
+
+// hqx's thresholds of Y, U and V, by which neighbors are considered different,
+// packed like YUV values, see ToYUV().
+constexpr uint32_t kYUVThresholds = (0x30 << 16) | (0x07 << 8) | 0x06;
+
+// Weights of Y, U and V in the distance of two colors, which are xBR's.
+constexpr uint32_t kYWeight = 48;
+constexpr uint32_t kUWeight = 7;
+constexpr uint32_t kVWeight = 6;
+
+// A band of rows [first_row, end_row) of a frame, which is scaled by one
+// thread. Buffers hold rows [first_row - kBorder, end_row + kBorder) of the
+// frame, with kBorder pixels on each side, see PixelIndex(). Buffers which
+// the filter doesn't use are null.
+struct Job {
+  PixelScaler::Filter filter;
+  int width;
+  int height;
+  int first_row;
+  int end_row;
+  const Color* source;
+  // The scaled rows of |first_row|, and of the rows after it.
+  Color* output;
+  // Pixels between rows of |output|.
+  int output_pitch;
+
+  Color* pixels;
+  // YUV values of |pixels|, see ToYUV().
+  uint32_t* yuv;
+  // HQx: bits of the neighbors of each pixel in the band which differ from it,
+  // see ComputeHQMasks(). It has width x (end_row - first_row) entries.
+  uint32_t* masks;
+  // xBR: distances of each pixel in |yuv| to its down-right and its up-right
+  // neighbors.
+  uint32_t* down_right_distances;
+  uint32_t* up_right_distances;
+};
+
+// Steps which are not vectorized, in pixel_scaler.cc.
+// Copies the band's rows into |pixels|, and converts them into |yuv|.
+void PreparePixels(const Job& job);
+void ApplyHQ2x(const Job& job);
+void ApplyHQ3x(const Job& job);
+void ApplyXBR(const Job& job);
+
+// Scales by the AVX2 kernels. Returns false if they aren't compiled, which is
+// when the target isn't x86.
+bool ScaleAVX2(const Job& job);
+bool HasAVX2Kernels();
+
+// Everything below is compiled into each translation unit on its own, so that
+// code compiled with AVX2 is never shared with the others.
+namespace {
+
+inline int PixelStride(const Job& job) {
+  return job.width + kBorder * 2;
+}
+
+// The index in |pixels| and |yuv| of pixel (x, y) of the band, where y is
+// relative to |first_row|.
+inline int PixelIndex(const Job& job, int x, int y) {
+  return (y + kBorder) * PixelStride(job) + x + kBorder;
+}
+
+inline uint32_t AbsDiff(uint32_t a, uint32_t b) {
+  return a > b ? a - b : b - a;
+}
+
+// A vector of one pixel, which the other vector types fall back to for pixels
+// which don't fill a vector.
+// Masks have all bits of a lane set or cleared. AndNot(a, b) is ~a & b.
+struct ScalarVector {
+  using Type = uint32_t;
+  static constexpr int kSize = 1;
+
+  static Type Load(const uint32_t* p) { return *p; }
+  static void Store(uint32_t* p, Type v) { *p = v; }
+  // Stores a[0], b[0], a[1], b[1], ...
+  static void StoreInterleaved(uint32_t* p, Type a, Type b) {
+    p[0] = a;
+    p[1] = b;
+  }
+  static Type Set(uint32_t v) { return v; }
+  static Type Equal(Type a, Type b) { return a == b ? 0xffffffff : 0; }
+  static Type And(Type a, Type b) { return a & b; }
+  static Type Or(Type a, Type b) { return a | b; }
+  static Type AndNot(Type a, Type b) { return ~a & b; }
+  static Type Select(Type mask, Type a, Type b) {
+    return (a & mask) | (b & ~mask);
+  }
+
+  // Whether YUV values |a| and |b| differ by more than kYUVThresholds.
+  static Type Differs(Type a, Type b) {
+    return AbsDiff(a >> 16, b >> 16) > (kYUVThresholds >> 16) ||
+                   AbsDiff((a >> 8) & 0xff, (b >> 8) & 0xff) >
+                       ((kYUVThresholds >> 8) & 0xff) ||
+                   AbsDiff(a & 0xff, b & 0xff) > (kYUVThresholds & 0xff)
+               ? 0xffffffff
+               : 0;
+  }
+
+  // Weighted distance of YUV values |a| and |b|.
+  static Type Distance(Type a, Type b) {
+    return AbsDiff(a >> 16, b >> 16) * kYWeight +
+           AbsDiff((a >> 8) & 0xff, (b >> 8) & 0xff) * kUWeight +
+           AbsDiff(a & 0xff, b & 0xff) * kVWeight;
+  }
+};
+
+template <typename V>
+void StoreInterleaved3(uint32_t* p,
+                       typename V::Type a,
+                       typename V::Type b,
+                       typename V::Type c) {
+  uint32_t lanes[3][V::kSize];
+  V::Store(lanes[0], a);
+  V::Store(lanes[1], b);
+  V::Store(lanes[2], c);
+  for (int i = 0; i < V::kSize; ++i) {
+    p[i * 3] = lanes[0][i];
+    p[i * 3 + 1] = lanes[1][i];
+    p[i * 3 + 2] = lanes[2][i];
+  }
+}
+
+// Scale2x (AdvMAME2x) of pixels [begin, end) of a row, whose rows above and
+// below are |up| and |down|.
+//   A B C     E0 E1
+//   D E F     E2 E3
+//   G H I
+template <typename V>
+void Scale2xRow(const Color* up,
+                const Color* center,
+                const Color* down,
+                int begin,
+                int end,
+                Color* output0,
+                Color* output1) {
+  using T = typename V::Type;
+  int x = begin;
+  for (; x + V::kSize <= end; x += V::kSize) {
+    T b = V::Load(up + x);
+    T d = V::Load(center + x - 1);
+    T e = V::Load(center + x);
+    T f = V::Load(center + x + 1);
+    T h = V::Load(down + x);
+    // Edges are only extended if B != H and D != F.
+    T blocked = V::Or(V::Equal(b, h), V::Equal(d, f));
+    T e0 = V::Select(V::AndNot(blocked, V::Equal(d, b)), d, e);
+    T e1 = V::Select(V::AndNot(blocked, V::Equal(b, f)), f, e);
+    T e2 = V::Select(V::AndNot(blocked, V::Equal(d, h)), d, e);
+    T e3 = V::Select(V::AndNot(blocked, V::Equal(h, f)), f, e);
+    V::StoreInterleaved(output0 + x * 2, e0, e1);
+    V::StoreInterleaved(output1 + x * 2, e2, e3);
+  }
+  if constexpr (V::kSize > 1) {
+    Scale2xRow<ScalarVector>(up, center, down, x, end, output0, output1);
+  }
+}
+
+// Scale3x (AdvMAME3x), like Scale2xRow().
+//   A B C     E0 E1 E2
+//   D E F     E3 E4 E5
+//   G H I     E6 E7 E8
+template <typename V>
+void Scale3xRow(const Color* up,
+                const Color* center,
+                const Color* down,
+                int begin,
+                int end,
+                Color* output0,
+                Color* output1,
+                Color* output2) {
+  using T = typename V::Type;
+  int x = begin;
+  for (; x + V::kSize <= end; x += V::kSize) {
+    T a = V::Load(up + x - 1);
+    T b = V::Load(up + x);
+    T c = V::Load(up + x + 1);
+    T d = V::Load(center + x - 1);
+    T e = V::Load(center + x);
+    T f = V::Load(center + x + 1);
+    T g = V::Load(down + x - 1);
+    T h = V::Load(down + x);
+    T i = V::Load(down + x + 1);
+    T blocked = V::Or(V::Equal(b, h), V::Equal(d, f));
+    T db = V::AndNot(blocked, V::Equal(d, b));
+    T bf = V::AndNot(blocked, V::Equal(b, f));
+    T dh = V::AndNot(blocked, V::Equal(d, h));
+    T hf = V::AndNot(blocked, V::Equal(h, f));
+    T ea = V::Equal(e, a);
+    T ec = V::Equal(e, c);
+    T eg = V::Equal(e, g);
+    T ei = V::Equal(e, i);
+    T e0 = V::Select(db, d, e);
+    T e1 = V::Select(V::Or(V::AndNot(ec, db), V::AndNot(ea, bf)), b, e);
+    T e2 = V::Select(bf, f, e);
+    T e3 = V::Select(V::Or(V::AndNot(eg, db), V::AndNot(ea, dh)), d, e);
+    T e5 = V::Select(V::Or(V::AndNot(ei, bf), V::AndNot(ec, hf)), f, e);
+    T e6 = V::Select(dh, d, e);
+    T e7 = V::Select(V::Or(V::AndNot(ei, dh), V::AndNot(eg, hf)), h, e);
+    T e8 = V::Select(hf, f, e);
+    StoreInterleaved3<V>(output0 + x * 3, e0, e1, e2);
+    StoreInterleaved3<V>(output1 + x * 3, e3, e, e5);
+    StoreInterleaved3<V>(output2 + x * 3, e6, e7, e8);
+  }
+  if constexpr (V::kSize > 1) {
+    Scale3xRow<ScalarVector>(up, center, down, x, end, output0, output1,
+                             output2);
+  }
+}
+
+// Bits of the neighbors in HQx masks.
+//   0 1 2
+//   3 E 4
+//   5 6 7
+template <typename V>
+void HQMaskRow(const uint32_t* up,
+               const uint32_t* center,
+               const uint32_t* down,
+               int begin,
+               int end,
+               uint32_t* masks) {
+  using T = typename V::Type;
+  int x = begin;
+  for (; x + V::kSize <= end; x += V::kSize) {
+    T e = V::Load(center + x);
+    T mask = V::And(V::Differs(e, V::Load(up + x - 1)), V::Set(1 << 0));
+    mask = V::Or(mask, V::And(V::Differs(e, V::Load(up + x)), V::Set(1 << 1)));
+    mask = V::Or(mask,
+                 V::And(V::Differs(e, V::Load(up + x + 1)), V::Set(1 << 2)));
+    mask = V::Or(mask,
+                 V::And(V::Differs(e, V::Load(center + x - 1)), V::Set(1 << 3)));
+    mask = V::Or(mask,
+                 V::And(V::Differs(e, V::Load(center + x + 1)), V::Set(1 << 4)));
+    mask = V::Or(mask,
+                 V::And(V::Differs(e, V::Load(down + x - 1)), V::Set(1 << 5)));
+    mask =
+        V::Or(mask, V::And(V::Differs(e, V::Load(down + x)), V::Set(1 << 6)));
+    mask = V::Or(mask,
+                 V::And(V::Differs(e, V::Load(down + x + 1)), V::Set(1 << 7)));
+    V::Store(masks + x, mask);
+  }
+  if constexpr (V::kSize > 1)
+    HQMaskRow<ScalarVector>(up, center, down, x, end, masks);
+}
+
+// Computes distances[i] = Distance(a[i], b[i]) for i in [begin, end).
+template <typename V>
+void DistanceRow(const uint32_t* a,
+                 const uint32_t* b,
+                 int begin,
+                 int end,
+                 uint32_t* distances) {
+  int x = begin;
+  for (; x + V::kSize <= end; x += V::kSize)
+    V::Store(distances + x, V::Distance(V::Load(a + x), V::Load(b + x)));
+  if constexpr (V::kSize > 1)
+    DistanceRow<ScalarVector>(a, b, x, end, distances);
+}
+
+template <typename V>
+void Scale2x(const Job& job) {
+  for (int y = 0; y < job.end_row - job.first_row; ++y) {
+    Color* output = job.output + y * 2 * job.output_pitch;
+    Scale2xRow<V>(job.pixels + PixelIndex(job, 0, y - 1),
+                  job.pixels + PixelIndex(job, 0, y),
+                  job.pixels + PixelIndex(job, 0, y + 1), 0, job.width, output,
+                  output + job.output_pitch);
+  }
+}
+
+template <typename V>
+void Scale3x(const Job& job) {
+  for (int y = 0; y < job.end_row - job.first_row; ++y) {
+    Color* output = job.output + y * 3 * job.output_pitch;
+    Scale3xRow<V>(job.pixels + PixelIndex(job, 0, y - 1),
+                  job.pixels + PixelIndex(job, 0, y),
+                  job.pixels + PixelIndex(job, 0, y + 1), 0, job.width, output,
+                  output + job.output_pitch, output + job.output_pitch * 2);
+  }
+}
+
+template <typename V>
+void ComputeHQMasks(const Job& job) {
+  for (int y = 0; y < job.end_row - job.first_row; ++y) {
+    HQMaskRow<V>(job.yuv + PixelIndex(job, 0, y - 1),
+                 job.yuv + PixelIndex(job, 0, y),
+                 job.yuv + PixelIndex(job, 0, y + 1), 0, job.width,
+                 job.masks + y * job.width);
+  }
+}
+
+// Computes distances of every pixel which has the neighbor in the buffers.
+template <typename V>
+void ComputeXBRDistances(const Job& job) {
+  const int rows = job.end_row - job.first_row;
+  const int end = job.width + kBorder - 1;
+  for (int y = -kBorder; y < rows + kBorder; ++y) {
+    const int index = PixelIndex(job, 0, y);
+    if (y + 1 < rows + kBorder) {
+      DistanceRow<V>(job.yuv + index, job.yuv + PixelIndex(job, 1, y + 1),
+                     -kBorder, end, job.down_right_distances + index);
+    }
+    if (y > -kBorder) {
+      DistanceRow<V>(job.yuv + index, job.yuv + PixelIndex(job, 1, y - 1),
+                     -kBorder, end, job.up_right_distances + index);
+    }
+  }
+}
+
+template <typename V>
+void ScaleBand(const Job& job) {
+  PreparePixels(job);
+  switch (job.filter) {
+    case PixelScaler::Filter::kScale2x:
+      Scale2x<V>(job);
+      break;
+    case PixelScaler::Filter::kScale3x:
+      Scale3x<V>(job);
+      break;
+    case PixelScaler::Filter::kHQ2x:
+      ComputeHQMasks<V>(job);
+      ApplyHQ2x(job);
+      break;
+    case PixelScaler::Filter::kHQ3x:
+      ComputeHQMasks<V>(job);
+      ApplyHQ3x(job);
+      break;
+    case PixelScaler::Filter::kXBR:
+      ComputeXBRDistances<V>(job);
+      ApplyXBR(job);
+      break;
+    default:
+      break;
+  }
+}
+
+}  // namespace
+}  // namespace pixel_scaler_internal
+
+#endif  // UTILITY_PIXEL_SCALER_KERNELS_H_
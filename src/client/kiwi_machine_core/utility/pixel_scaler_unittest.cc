@@ -0,0 +1,307 @@
+// Copyright (C) 2026 Yisi Yu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#include "utility/pixel_scaler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "third_party/googletest-release-1.12.1/googletest/include/gtest/gtest.h"
+
+namespace {
+
+using Filter = PixelScaler::Filter;
+using InstructionSet = PixelScaler::InstructionSet;
+
+constexpr kiwi::nes::Color kBlack = 0xff000000;
+constexpr kiwi::nes::Color kWhite = 0xfffcfcfc;
+constexpr kiwi::nes::Color kRed = 0xffa81000;
+constexpr kiwi::nes::Color kBlue = 0xff0058f8;
+constexpr kiwi::nes::Color kSky = 0xff3cbcfc;
+constexpr kiwi::nes::Color kGreen = 0xff00a800;
+
+constexpr Filter kFilters[] = {Filter::kScale2x, Filter::kScale3x,
+                               Filter::kHQ2x, Filter::kHQ3x, Filter::kXBR};
+
+// An image drawn by rows of '#' and '.', which are white and black, and of
+// characters in |colors|.
+kiwi::nes::Colors FromRows(
+    const std::vector<std::string>& rows,
+    const std::map<char, kiwi::nes::Color>& colors = {}) {
+  kiwi::nes::Colors image;
+  for (const std::string& row : rows) {
+    for (char c : row) {
+      if (c == '#')
+        image.push_back(kWhite);
+      else if (c == '.')
+        image.push_back(kBlack);
+      else
+        image.push_back(colors.at(c));
+    }
+  }
+  return image;
+}
+
+// A frame of shapes whose edges have several slopes, with dithering and an
+// odd size, so that it covers vectors' remainders.
+kiwi::nes::Colors CreateTestFrame(int width, int height) {
+  kiwi::nes::Colors frame(width * height);
+  for (int y = 0; y < height; ++y) {
+    for (int x = 0; x < width; ++x) {
+      kiwi::nes::Color color = kSky;
+      int dx = x - width / 2;
+      int dy = y - height / 2;
+      if (dx * dx + dy * dy < height * height / 9)
+        color = kRed;
+      if (std::abs(x - y) < 2)
+        color = kWhite;
+      if (std::abs(x - 2 * dy) < 2)
+        color = kBlue;
+      if (std::abs(2 * x - y - width / 2) < 2)
+        color = kGreen;
+      if (x < width / 4 && y > height * 3 / 4 && (x + y) % 2)
+        color = kBlack;
+      frame[y * width + x] = color;
+    }
+  }
+  return frame;
+}
+
+uint32_t Hash(const kiwi::nes::Colors& image) {
+  uint32_t hash = 2166136261u;
+  for (kiwi::nes::Color color : image) {
+    for (int i = 0; i < 4; ++i) {
+      hash ^= (color >> (i * 8)) & 0xff;
+      hash *= 16777619u;
+    }
+  }
+  return hash;
+}
+
+kiwi::nes::Colors Scale(PixelScaler* scaler,
+                        Filter filter,
+                        int width,
+                        int height,
+                        const kiwi::nes::Colors& source) {
+  kiwi::nes::Colors output;
+  scaler->Scale(filter, width, height, source, &output);
+  return output;
+}
+
+}  // namespace
+
+TEST(PixelScalerTest, Scale2xGolden) {
+  PixelScaler scaler(1);
+  kiwi::nes::Colors source = FromRows({
+      "#...",
+      ".#..",
+      "..#.",
+      "...#",
+  });
+  kiwi::nes::Colors expected = FromRows({
+      "##......",
+      "#.#.....",
+      ".###....",
+      "..###...",
+      "...###..",
+      "....###.",
+      ".....#.#",
+      "......##",
+  });
+  EXPECT_EQ(Scale(&scaler, Filter::kScale2x, 4, 4, source), expected);
+}
+
+TEST(PixelScalerTest, Scale3xGolden) {
+  PixelScaler scaler(1);
+  kiwi::nes::Colors source = FromRows({
+      "#..",
+      ".#.",
+      "..#",
+  });
+  kiwi::nes::Colors expected = FromRows({
+      "###......",
+      "##.#.....",
+      "#..#.....",
+      ".#####...",
+      "...###...",
+      "...#####.",
+      ".....#..#",
+      ".....#.##",
+      "......###",
+  });
+  EXPECT_EQ(Scale(&scaler, Filter::kScale3x, 3, 3, source), expected);
+}
+
+// Worked out by hand from HQx's rules. Pixels of the line get their corners
+// along it softened by an eighth of black on each side (6), and the others cut
+// by an edge (4). Black pixels next to the line get its edge (2), like the
+// ones whose corners only touch it, which are rounded by a quarter.
+TEST(PixelScalerTest, HQ2xGolden) {
+  PixelScaler scaler(1);
+  kiwi::nes::Colors source = FromRows({
+      "#...",
+      ".#..",
+      "..#.",
+      "...#",
+  });
+  // Eighths of white, mixed with black.
+  const std::map<char, kiwi::nes::Color> grays = {
+      {'2', 0xff3f3f3f}, {'4', 0xff7e7e7e}, {'6', 0xffbdbdbd}};
+  kiwi::nes::Colors expected = FromRows(
+      {
+          "##......",
+          "#62.2...",
+          ".264....",
+          "..462.2.",
+          ".2.264..",
+          "....462.",
+          "...2.26#",
+          "......##",
+      },
+      grays);
+  EXPECT_EQ(Scale(&scaler, Filter::kHQ2x, 4, 4, source), expected);
+}
+
+// Worked out by hand from xBR's rules. Only the black pixel's top-left corner
+// has both neighbors differ, and both of its diagonal edges are shallow and
+// steep, so that white covers the block by the areas of both edges, which go
+// through the middles of its top and left sides. Cells on the edges are a
+// quarter (1), three quarters (3) or a third (t) white.
+TEST(PixelScalerTest, XBRGolden) {
+  PixelScaler scaler(1);
+  kiwi::nes::Colors source = FromRows({
+      "##",
+      "#.",
+  });
+  const std::map<char, kiwi::nes::Color> grays = {
+      {'1', 0xff3f3f3f}, {'3', 0xffbdbdbd}, {'t', 0xff545454}};
+  kiwi::nes::Colors expected = FromRows(
+      {
+          "########",
+          "########",
+          "########",
+          "########",
+          "######31",
+          "#####t..",
+          "####3...",
+          "####1...",
+      },
+      grays);
+  EXPECT_EQ(Scale(&scaler, Filter::kXBR, 2, 2, source), expected);
+}
+
+// The outputs of a test frame, which are checked by their hashes. The hashes
+// change only if the filters do.
+TEST(PixelScalerTest, GoldenHashes) {
+  constexpr int kWidth = 61;
+  constexpr int kHeight = 47;
+  constexpr uint32_t kHashes[] = {1091139161u, 3279362396u, 1424986071u,
+                                  1585939683u, 4187406815u};
+  kiwi::nes::Colors source = CreateTestFrame(kWidth, kHeight);
+  PixelScaler scaler;
+  for (size_t i = 0; i < std::size(kFilters); ++i) {
+    kiwi::nes::Colors output =
+        Scale(&scaler, kFilters[i], kWidth, kHeight, source);
+    int factor = PixelScaler::GetScaleFactor(kFilters[i]);
+    EXPECT_EQ(output.size(), kWidth * factor * kHeight * factor);
+    EXPECT_EQ(Hash(output), kHashes[i])
+        << PixelScaler::GetFilterName(kFilters[i]);
+  }
+}
+
+TEST(PixelScalerTest, FlatFramesStayFlat) {
+  kiwi::nes::Colors source(16 * 15, kRed);
+  PixelScaler scaler;
+  for (Filter filter : kFilters) {
+    kiwi::nes::Colors output = Scale(&scaler, filter, 16, 15, source);
+    int factor = PixelScaler::GetScaleFactor(filter);
+    EXPECT_EQ(output, kiwi::nes::Colors(16 * factor * 15 * factor, kRed))
+        << PixelScaler::GetFilterName(filter);
+  }
+}
+
+// Vectorized kernels and the scalar ones give the same outputs.
+TEST(PixelScalerTest, InstructionSetsMatch) {
+  constexpr int kWidth = 61;
+  constexpr int kHeight = 47;
+  kiwi::nes::Colors source = CreateTestFrame(kWidth, kHeight);
+  PixelScaler scalar(1);
+  scalar.set_instruction_set(InstructionSet::kScalar);
+  PixelScaler vectorized(1);
+  const int supported =
+      static_cast<int>(PixelScaler::GetSupportedInstructionSet());
+  for (int i = static_cast<int>(InstructionSet::kSSE2); i <= supported; ++i) {
+    vectorized.set_instruction_set(static_cast<InstructionSet>(i));
+    for (Filter filter : kFilters) {
+      EXPECT_EQ(Scale(&vectorized, filter, kWidth, kHeight, source),
+                Scale(&scalar, filter, kWidth, kHeight, source))
+          << PixelScaler::GetFilterName(filter) << ", instruction set " << i;
+    }
+  }
+}
+
+// Bands which are scaled on different threads join without seams.
+TEST(PixelScalerTest, ThreadsMatch) {
+  constexpr int kWidth = 256;
+  constexpr int kHeight = 240;
+  kiwi::nes::Colors source = CreateTestFrame(kWidth, kHeight);
+  PixelScaler single_thread(1);
+  PixelScaler threads(5);
+  EXPECT_EQ(threads.thread_count(), 5);
+  for (Filter filter : kFilters) {
+    EXPECT_EQ(Scale(&threads, filter, kWidth, kHeight, source),
+              Scale(&single_thread, filter, kWidth, kHeight, source))
+        << PixelScaler::GetFilterName(filter);
+  }
+}
+
+// Measures the time of each filter for a frame, on one thread and on all
+// threads, each the best of several frames. On one thread, every filter must
+// take less than 2 ms, which is the budget of a frame presented at 4x.
+TEST(PixelScalerTest, DISABLED_Cost) {
+  constexpr int kWidth = 256;
+  constexpr int kHeight = 240;
+  constexpr int kRoundCount = 20;
+  kiwi::nes::Colors source = CreateTestFrame(kWidth, kHeight);
+  kiwi::nes::Colors output;
+  PixelScaler single_thread(1);
+  PixelScaler threads;
+  for (Filter filter : kFilters) {
+    double elapsed_us[2];
+    PixelScaler* scalers[] = {&single_thread, &threads};
+    for (int i = 0; i < 2; ++i) {
+      scalers[i]->Scale(filter, kWidth, kHeight, source, &output);
+      elapsed_us[i] = std::numeric_limits<double>::max();
+      for (int round = 0; round < kRoundCount; ++round) {
+        auto start = std::chrono::steady_clock::now();
+        scalers[i]->Scale(filter, kWidth, kHeight, source, &output);
+        std::chrono::duration<double, std::micro> elapsed =
+            std::chrono::steady_clock::now() - start;
+        elapsed_us[i] = std::min(elapsed_us[i], elapsed.count());
+      }
+    }
+    std::string name = PixelScaler::GetFilterName(filter);
+    RecordProperty(name + "_single_thread_us", static_cast<int>(elapsed_us[0]));
+    RecordProperty(name + "_us", static_cast<int>(elapsed_us[1]));
+    std::cout << name << ": " << elapsed_us[0] << " us (1 thread), "
+              << elapsed_us[1] << " us (" << threads.thread_count()
+              << " threads)" << std::endl;
+    EXPECT_LT(elapsed_us[0], 2000) << name;
+  }
+}
+
@@ -0,0 +1,149 @@
+// Copyright (C) 2026 Yisi Yu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#ifndef BASE_CONTAINERS_MPSC_QUEUE_H_
+#define BASE_CONTAINERS_MPSC_QUEUE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+
+namespace kiwi::base {
+
+// Items of MPSCQueue derive from MPSCQueueNode, which links them, so that
+// pushing an item allocates nothing.
+class MPSCQueueNode {
+ public:
+  MPSCQueueNode() = default;
+  MPSCQueueNode(const MPSCQueueNode&) = delete;
+  MPSCQueueNode& operator=(const MPSCQueueNode&) = delete;
+
+ private:
+  template <typename T>
+  friend class MPSCQueue;
+
+  std::atomic<MPSCQueueNode*> next_{nullptr};
+};
+
+// MPSCQueue is an intrusive, lock-free, first-in first-out queue, which any
+// number of threads can push to, and a single thread pops from. Pushing is an
+// atomic exchange, and never waits for other threads.
+//
+// A push links the item in two steps, so that while a producer is between
+// them, items pushed after its item can't be popped yet. Pop() returns null
+// then, and the items are popped once the producer finishes. Consumers which
+// are woken up by producers should pop after each wake up, rather than expect
+// an item for each.
+//
+// It is Dmitry Vyukov's intrusive MPSC queue.
+template <typename T>
+class MPSCQueue {
+  static_assert(std::is_base_of_v<MPSCQueueNode, T>,
+                "Items must derive from MPSCQueueNode.");
+
+ public:
+  MPSCQueue() : head_(&stub_), tail_(&stub_) {}
+
+  // No producer may push meanwhile.
+  ~MPSCQueue() {
+    while (Pop()) {
+    }
+  }
+
+  MPSCQueue(const MPSCQueue&) = delete;
+  MPSCQueue& operator=(const MPSCQueue&) = delete;
+
+  // Can be called on any thread.
+  void Push(std::unique_ptr<T> item) { PushNode(item.release()); }
+
+  // Returns the oldest item, or null if there is none which can be popped.
+  // Consumer only.
+  std::unique_ptr<T> Pop() {
+    MPSCQueueNode* tail = tail_;
+    MPSCQueueNode* next = tail->next_.load(std::memory_order_acquire);
+    if (tail == &stub_) {
+      if (!next)
+        return nullptr;
+      tail_ = next;
+      tail = next;
+      next = next->next_.load(std::memory_order_acquire);
+    }
+
+    if (next) {
+      tail_ = next;
+      return TakeItem(tail);
+    }
+
+    // |tail| is the last item, unless a producer is linking one after it.
+    if (tail != head_.load(std::memory_order_acquire))
+      return nullptr;
+
+    // The stub takes the place of the last item, so that it can be popped.
+    PushNode(&stub_);
+    next = tail->next_.load(std::memory_order_acquire);
+    if (next) {
+      tail_ = next;
+      return TakeItem(tail);
+    }
+    return nullptr;
+  }
+
+  // Pops items and runs |function| with each of them, up to the last one
+  // pushed when this is called, so that it ends even if |function| or other
+  // threads keep pushing. Returns how many items are popped. Consumer only.
+  template <typename Function>
+  size_t Drain(Function function) {
+    MPSCQueueNode* last = head_.load(std::memory_order_acquire);
+    size_t count = 0;
+    while (true) {
+      // If the stub was pushed last, which Pop() does, items before it are
+      // the ones to pop. They may still be there, if a producer pushed while
+      // Pop() was pushing the stub.
+      if (last == &stub_ && tail_ == &stub_)
+        break;
+
+      std::unique_ptr<T> item = Pop();
+      if (!item)
+        break;
+
+      bool is_last = static_cast<MPSCQueueNode*>(item.get()) == last;
+      function(std::move(item));
+      ++count;
+      if (is_last)
+        break;
+    }
+    return count;
+  }
+
+ private:
+  void PushNode(MPSCQueueNode* node) {
+    node->next_.store(nullptr, std::memory_order_relaxed);
+    MPSCQueueNode* prev = head_.exchange(node, std::memory_order_acq_rel);
+    prev->next_.store(node, std::memory_order_release);
+  }
+
+  static std::unique_ptr<T> TakeItem(MPSCQueueNode* node) {
+    return std::unique_ptr<T>(static_cast<T*>(node));
+  }
+
+ private:
+  // Producers' and the consumer's ends are on different cache lines, so that
+  // they don't invalidate each other's.
+  alignas(64) std::atomic<MPSCQueueNode*> head_;
+  alignas(64) MPSCQueueNode* tail_;
+  MPSCQueueNode stub_;
+};
+
+}  // namespace kiwi::base
+
+#endif  // BASE_CONTAINERS_MPSC_QUEUE_H_
@@ -0,0 +1,181 @@
+// Copyright (C) 2026 Yisi Yu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#include "base/containers/mpsc_queue.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "third_party/googletest-release-1.12.1/googletest/include/gtest/gtest.h"
+
+namespace kiwi::base {
+namespace testing {
+
+namespace {
+struct Item : public MPSCQueueNode {
+  Item(int producer, int value, std::atomic<int>* live_items = nullptr)
+      : producer(producer), value(value), live_items(live_items) {
+    if (live_items)
+      ++*live_items;
+  }
+  ~Item() {
+    if (live_items)
+      --*live_items;
+  }
+
+  int producer;
+  int value;
+  std::atomic<int>* live_items;
+};
+}  // namespace
+
+TEST(MPSCQueueTest, FirstInFirstOut) {
+  MPSCQueue<Item> queue;
+  EXPECT_FALSE(queue.Pop());
+  for (int i = 0; i < 10; ++i)
+    queue.Push(std::make_unique<Item>(0, i));
+  for (int i = 0; i < 10; ++i) {
+    std::unique_ptr<Item> item = queue.Pop();
+    ASSERT_TRUE(item);
+    EXPECT_EQ(item->value, i);
+  }
+  EXPECT_FALSE(queue.Pop());
+
+  // The queue keeps working after it's been emptied.
+  queue.Push(std::make_unique<Item>(0, 10));
+  EXPECT_EQ(queue.Pop()->value, 10);
+  EXPECT_FALSE(queue.Pop());
+}
+
+TEST(MPSCQueueTest, DrainStopsAtLastItem) {
+  MPSCQueue<Item> queue;
+  EXPECT_EQ(queue.Drain([](std::unique_ptr<Item>) {}), 0u);
+
+  for (int i = 0; i < 3; ++i)
+    queue.Push(std::make_unique<Item>(0, i));
+  // Items pushed while draining are left for next time.
+  std::vector<int> values;
+  size_t count = queue.Drain([&](std::unique_ptr<Item> item) {
+    values.push_back(item->value);
+    queue.Push(std::make_unique<Item>(0, item->value + 3));
+  });
+  EXPECT_EQ(count, 3u);
+  EXPECT_EQ(values, std::vector<int>({0, 1, 2}));
+
+  values.clear();
+  queue.Drain(
+      [&](std::unique_ptr<Item> item) { values.push_back(item->value); });
+  EXPECT_EQ(values, std::vector<int>({3, 4, 5}));
+}
+
+TEST(MPSCQueueTest, DeletesItemsLeft) {
+  std::atomic<int> live_items{0};
+  {
+    MPSCQueue<Item> queue;
+    for (int i = 0; i < 5; ++i)
+      queue.Push(std::make_unique<Item>(0, i, &live_items));
+    queue.Pop();
+    EXPECT_EQ(live_items, 4);
+  }
+  EXPECT_EQ(live_items, 0);
+}
+
+// Producers push while the consumer pops. Each producer's items must come out
+// in the order they are pushed, and none may be lost.
+TEST(MPSCQueueTest, KeepsOrderPerProducer) {
+  constexpr int kProducerCount = 4;
+  constexpr int kItemCount = 200000;
+  MPSCQueue<Item> queue;
+  std::atomic<int> live_items{0};
+  std::atomic_bool start{false};
+
+  std::vector<std::thread> producers;
+  for (int i = 0; i < kProducerCount; ++i) {
+    producers.emplace_back([&, i] {
+      while (!start) {
+      }
+      for (int j = 0; j < kItemCount; ++j)
+        queue.Push(std::make_unique<Item>(i, j, &live_items));
+    });
+  }
+
+  std::vector<int> next_values(kProducerCount, 0);
+  int popped = 0;
+  bool in_order = true;
+  auto check = [&](std::unique_ptr<Item> item) {
+    in_order &= item->value == next_values[item->producer];
+    next_values[item->producer] = item->value + 1;
+    ++popped;
+  };
+
+  start = true;
+  // Pops one at a time and in batches by turns.
+  for (int turn = 0; popped < kProducerCount * kItemCount; ++turn) {
+    if (turn % 2) {
+      queue.Drain(check);
+    } else if (std::unique_ptr<Item> item = queue.Pop()) {
+      check(std::move(item));
+    }
+  }
+  for (std::thread& producer : producers)
+    producer.join();
+
+  EXPECT_TRUE(in_order);
+  EXPECT_EQ(next_values, std::vector<int>(kProducerCount, kItemCount));
+  EXPECT_FALSE(queue.Pop());
+  EXPECT_EQ(live_items, 0);
+}
+
+// The consumer only drains, so that nothing else finds items which a drain
+// misses. Once the producers finish, one more drain must get every item left.
+TEST(MPSCQueueTest, DrainGetsEveryItem) {
+  constexpr int kProducerCount = 4;
+  constexpr int kItemCount = 200000;
+  MPSCQueue<Item> queue;
+  std::atomic<int> live_items{0};
+  std::atomic_bool start{false};
+  std::atomic<int> finished_producers{0};
+
+  std::vector<std::thread> producers;
+  for (int i = 0; i < kProducerCount; ++i) {
+    producers.emplace_back([&, i] {
+      while (!start) {
+      }
+      for (int j = 0; j < kItemCount; ++j)
+        queue.Push(std::make_unique<Item>(i, j, &live_items));
+      ++finished_producers;
+    });
+  }
+
+  std::vector<int> next_values(kProducerCount, 0);
+  bool in_order = true;
+  auto check = [&](std::unique_ptr<Item> item) {
+    in_order &= item->value == next_values[item->producer];
+    next_values[item->producer] = item->value + 1;
+  };
+
+  start = true;
+  while (finished_producers < kProducerCount)
+    queue.Drain(check);
+  for (std::thread& producer : producers)
+    producer.join();
+  queue.Drain(check);
+
+  EXPECT_TRUE(in_order);
+  EXPECT_EQ(next_values, std::vector<int>(kProducerCount, kItemCount));
+  EXPECT_EQ(queue.Drain(check), 0u);
+  EXPECT_EQ(live_items, 0);
+}
+
+}  // namespace testing
+}  // namespace kiwi::base
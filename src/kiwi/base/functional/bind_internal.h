@@ -951,8 +951,21 @@ struct BindState final : BindStateBase {
   using IsCancellable = std::bool_constant<
       CallbackCancellationTraits<Functor,
                                  std::tuple<BoundArgs...>>::is_cancellable>;
+
+  // Whether the state can be stored in a callback's inline storage, which
+  // needs it to be moved when the callback is.
+  static constexpr bool FitsInline() {
+    return sizeof(BindState) <= OnceCallbackBase::kInlineStorageSize &&
+           alignof(BindState) <= OnceCallbackBase::kInlineStorageAlignment &&
+           std::is_nothrow_move_constructible_v<Functor> &&
+           (std::is_nothrow_move_constructible_v<BoundArgs> && ...);
+  }
+
+  // Creates the state in |inline_storage|, if it isn't null and the state
+  // fits, or on the heap.
   template <typename ForwardFunctor, typename... ForwardBoundArgs>
-  static BindState* Create(BindStateBase::InvokeFuncStorage invoke_func,
+  static BindState* Create(void* inline_storage,
+                           BindStateBase::InvokeFuncStorage invoke_func,
                            ForwardFunctor&& functor,
                            ForwardBoundArgs&&... bound_args) {
     // Ban ref counted receivers that were not yet fully constructed to avoid
@@ -962,7 +975,15 @@ struct BindState final : BindStateBase {
     // IsCancellable is std::false_type if
     // CallbackCancellationTraits<>::IsCancelled returns always false.
     // Otherwise, it's std::true_type.
-    return new BindState(IsCancellable{}, invoke_func,
+    if constexpr (FitsInline()) {
+      if (inline_storage) {
+        return new (inline_storage)
+            BindState(IsCancellable{}, std::true_type{}, invoke_func,
+                      std::forward<ForwardFunctor>(functor),
+                      std::forward<ForwardBoundArgs>(bound_args)...);
+      }
+    }
+    return new BindState(IsCancellable{}, std::false_type{}, invoke_func,
                          std::forward<ForwardFunctor>(functor),
                          std::forward<ForwardBoundArgs>(bound_args)...);
   }
@@ -974,14 +995,18 @@ struct BindState final : BindStateBase {
   static constexpr bool is_nested_callback =
       MakeFunctorTraits<Functor>::is_callback;
 
-  template <typename ForwardFunctor, typename... ForwardBoundArgs>
+  template <typename IsInline,
+            typename ForwardFunctor,
+            typename... ForwardBoundArgs>
   explicit BindState(std::true_type,
+                     IsInline,
                      BindStateBase::InvokeFuncStorage invoke_func,
                      ForwardFunctor&& functor,
                      ForwardBoundArgs&&... bound_args)
       : BindStateBase(invoke_func,
-                      &Destroy,
-                      &QueryCancellationTraits<BindState>),
+                      GetDestroyFunc<IsInline>(),
+                      &QueryCancellationTraits<BindState>,
+                      GetRelocateFunc<IsInline>()),
         functor_(std::forward<ForwardFunctor>(functor)),
         bound_args_(std::forward<ForwardBoundArgs>(bound_args)...) {
     // We check the validity of nested callbacks (e.g., Bind(callback, ...)) in
@@ -995,12 +1020,17 @@ struct BindState final : BindStateBase {
     }
   }
 
-  template <typename ForwardFunctor, typename... ForwardBoundArgs>
+  template <typename IsInline,
+            typename ForwardFunctor,
+            typename... ForwardBoundArgs>
   explicit BindState(std::false_type,
+                     IsInline,
                      BindStateBase::InvokeFuncStorage invoke_func,
                      ForwardFunctor&& functor,
                      ForwardBoundArgs&&... bound_args)
-      : BindStateBase(invoke_func, &Destroy),
+      : BindStateBase(invoke_func,
+                      GetDestroyFunc<IsInline>(),
+                      GetRelocateFunc<IsInline>()),
         functor_(std::forward<ForwardFunctor>(functor)),
         bound_args_(std::forward<ForwardBoundArgs>(bound_args)...) {
     // See above for assert/assert rationale.
@@ -1011,11 +1041,50 @@ struct BindState final : BindStateBase {
     }
   }
 
+  // Used by Relocate() only. The moved state has the same functions as
+  // |other|.
+  BindState(BindState&& other) noexcept
+      : BindStateBase(other.polymorphic_invoke_,
+                      other.destructor_,
+                      other.query_cancellation_traits_,
+                      other.relocate_),
+        functor_(std::move(other.functor_)),
+        bound_args_(std::move(other.bound_args_)) {}
+
   ~BindState() = default;
 
   static void Destroy(const BindStateBase* self) {
     delete static_cast<const BindState*>(self);
   }
+
+  static void DestroyInline(const BindStateBase* self) {
+    static_cast<const BindState*>(self)->~BindState();
+  }
+
+  static BindStateBase* Relocate(BindStateBase* from, void* to) {
+    BindState* state = static_cast<BindState*>(from);
+    BindState* moved = new (to) BindState(std::move(*state));
+    state->~BindState();
+    return moved;
+  }
+
+  template <typename IsInline>
+  static constexpr auto GetDestroyFunc() {
+    if constexpr (IsInline::value)
+      return &DestroyInline;
+    else
+      return &Destroy;
+  }
+
+  // Relocate() is instantiated for inline states only, as others may not be
+  // movable.
+  template <typename IsInline>
+  static constexpr BindStateBase::RelocateFunc GetRelocateFunc() {
+    if constexpr (IsInline::value)
+      return &Relocate;
+    else
+      return nullptr;
+  }
 };
 
 // Used to implement MakeBindStateType.
@@ -1313,9 +1382,16 @@ decltype(auto) BindImpl(Functor&& functor, Args&&... args) {
   }
 
   using InvokeFuncStorage = BindStateBase::InvokeFuncStorage;
-  return CallbackType(BindState::Create(
-      reinterpret_cast<InvokeFuncStorage>(invoke_func),
-      std::forward<Functor>(functor), std::forward<Args>(args)...));
+  if constexpr (kIsOnce) {
+    return CallbackType(std::in_place_type<BindState>,
+                        reinterpret_cast<InvokeFuncStorage>(invoke_func),
+                        std::forward<Functor>(functor),
+                        std::forward<Args>(args)...);
+  } else {
+    return CallbackType(BindState::Create(
+        nullptr, reinterpret_cast<InvokeFuncStorage>(invoke_func),
+        std::forward<Functor>(functor), std::forward<Args>(args)...));
+  }
 }
 
 // Special cases for binding to a base::{Once, Repeating}Callback without extra
@@ -84,7 +84,7 @@ ToDoNothingCallback(DoNothingCallbackTag::WithBoundArguments<BoundArgs...> t) {
 }  // namespace internal
 
 template <typename R, typename... Args>
-class OnceCallback<R(Args...)> : public internal::CallbackBase {
+class OnceCallback<R(Args...)> : public internal::OnceCallbackBase {
  public:
   using ResultType = R;
   using RunType = R(Args...);
@@ -137,7 +137,15 @@ class OnceCallback<R(Args...)> : public internal::CallbackBase {
   }
 
   explicit OnceCallback(internal::BindStateBase* bind_state)
-      : internal::CallbackBase(bind_state) {}
+      : internal::OnceCallbackBase(bind_state) {}
+
+  // Creates a BindStateType with |args| in the callback, if it fits. Used by
+  // BindOnce().
+  template <typename BindStateType, typename... BindStateArgs>
+  explicit OnceCallback(std::in_place_type_t<BindStateType> type,
+                        BindStateArgs&&... args)
+      : internal::OnceCallbackBase(type,
+                                   std::forward<BindStateArgs>(args)...) {}
 
   OnceCallback(const OnceCallback&) = delete;
   OnceCallback& operator=(const OnceCallback&) = delete;
@@ -146,7 +154,7 @@ class OnceCallback<R(Args...)> : public internal::CallbackBase {
   OnceCallback& operator=(OnceCallback&&) noexcept = default;
 
   OnceCallback(RepeatingCallback<RunType> other)
-      : internal::CallbackBase(std::move(other)) {}
+      : internal::OnceCallbackBase(std::move(other)) {}
 
   OnceCallback& operator=(RepeatingCallback<RunType> other) {
     static_cast<internal::CallbackBase&>(*this) = std::move(other);
@@ -371,6 +379,11 @@ class RepeatingCallback<R(Args...)> : public internal::CallbackBaseCopyable {
   }
 };
 
+// Only OnceCallbacks have inline storage; copies of RepeatingCallbacks are
+// passed around by value.
+static_assert(sizeof(RepeatingClosure) == sizeof(void*),
+              "RepeatingCallback must stay pointer-sized.");
+
 }  // namespace kiwi::base
 
 #endif  // BASE_FUNCTIONAL_CALLBACK_H_
@@ -31,21 +31,26 @@ void BindStateBaseRefCountTraits::Destruct(const BindStateBase* bind_state) {
 }
 
 BindStateBase::BindStateBase(InvokeFuncStorage polymorphic_invoke,
-                             void (*destructor)(const BindStateBase*))
+                             void (*destructor)(const BindStateBase*),
+                             RelocateFunc relocate)
     : BindStateBase(polymorphic_invoke,
                     destructor,
-                    &QueryCancellationTraitsForNonCancellables) {}
+                    &QueryCancellationTraitsForNonCancellables,
+                    relocate) {}
 
 BindStateBase::BindStateBase(
     InvokeFuncStorage polymorphic_invoke,
     void (*destructor)(const BindStateBase*),
     bool (*query_cancellation_traits)(const BindStateBase*,
-                                      CancellationQueryMode))
+                                      CancellationQueryMode),
+    RelocateFunc relocate)
     : polymorphic_invoke_(polymorphic_invoke),
       destructor_(destructor),
-      query_cancellation_traits_(query_cancellation_traits) {}
+      query_cancellation_traits_(query_cancellation_traits),
+      relocate_(relocate) {}
 
 CallbackBase& CallbackBase::operator=(CallbackBase&& c) noexcept = default;
+
 CallbackBase::CallbackBase(const CallbackBaseCopyable& c)
     : bind_state_(c.bind_state_) {}
 
@@ -97,5 +102,24 @@ CallbackBaseCopyable& CallbackBaseCopyable::operator=(
 CallbackBaseCopyable& CallbackBaseCopyable::operator=(
     CallbackBaseCopyable&& c) noexcept = default;
 
+OnceCallbackBase& OnceCallbackBase::operator=(OnceCallbackBase&& c) noexcept {
+  if (this != &c) {
+    // The old state is destroyed last, as it may own |c|.
+    OnceCallbackBase old(std::move(*this));
+    if (c.bind_state_ && c.bind_state_->is_inline())
+      RelocateFrom(c);
+    else
+      bind_state_ = std::move(c.bind_state_);
+  }
+  return *this;
+}
+
+void OnceCallbackBase::RelocateFrom(OnceCallbackBase& c) noexcept {
+  assert(!bind_state_);
+  // |c| gives its reference up, and the moved state is adopted.
+  BindStateBase* state = c.bind_state_.release();
+  bind_state_ = AdoptRef(state->relocate_(state, inline_storage_));
+}
+
 }  // namespace internal
 }  // namespace kiwi::base
@@ -5,6 +5,9 @@
 #ifndef BASE_FUNCTIONAL_CALLBACK_INTERNAL_H_
 #define BASE_FUNCTIONAL_CALLBACK_INTERNAL_H_
 
+#include <cstddef>
+#include <utility>
+
 #include "base/base_export.h"
 #include "base/compiler_specific.h"
 #include "base/memory/ref_counted.h"
@@ -17,6 +20,7 @@ class BindStateBase;
 
 class CallbackBase;
 class CallbackBaseCopyable;
+class OnceCallbackBase;
 
 template <typename Functor, typename... BoundArgs>
 struct BindState;
@@ -49,17 +53,20 @@ class BASE_EXPORT BindStateBase
   };
 
   using InvokeFuncStorage = void (*)();
+  using RelocateFunc = BindStateBase* (*)(BindStateBase* from, void* to);
 
   BindStateBase(const BindStateBase&) = delete;
   BindStateBase& operator=(const BindStateBase&) = delete;
 
  private:
   BindStateBase(InvokeFuncStorage polymorphic_invoke,
-                void (*destructor)(const BindStateBase*));
+                void (*destructor)(const BindStateBase*),
+                RelocateFunc relocate);
   BindStateBase(InvokeFuncStorage polymorphic_invoke,
                 void (*destructor)(const BindStateBase*),
                 bool (*query_cancellation_traits)(const BindStateBase*,
-                                                  CancellationQueryMode mode));
+                                                  CancellationQueryMode mode),
+                RelocateFunc relocate);
 
   ~BindStateBase() = default;
 
@@ -68,6 +75,7 @@ class BASE_EXPORT BindStateBase
 
   friend class CallbackBase;
   friend class CallbackBaseCopyable;
+  friend class OnceCallbackBase;
 
   // Allowlist subclasses that access the destructor of BindStateBase.
   template <typename Functor, typename... BoundArgs>
@@ -81,6 +89,8 @@ class BASE_EXPORT BindStateBase
     return query_cancellation_traits_(this, MAYBE_VALID);
   }
 
+  bool is_inline() const { return !!relocate_; }
+
   // In C++, it is safe to cast function pointers to function pointers of
   // another type. It is not okay to use void*. We create a InvokeFuncStorage
   // that that can store our function pointer, and then cast it back to
@@ -91,6 +101,11 @@ class BASE_EXPORT BindStateBase
   void (*destructor_)(const BindStateBase*);
   bool (*query_cancellation_traits_)(const BindStateBase*,
                                      CancellationQueryMode mode);
+
+  // Set for states which are stored in a callback's inline storage. It moves
+  // the state at |from| to |to|, destroys it at |from|, and returns the moved
+  // one.
+  RelocateFunc relocate_;
 };
 
 // Holds the Callback methods that don't require specialization to reduce
@@ -162,6 +177,53 @@ CallbackBase::CallbackBase(CallbackBase&&) noexcept = default;
 CallbackBase::CallbackBase(BindStateBase* bind_state)
     : bind_state_(AdoptRef(bind_state)) {}
 
+// OnceCallbackBase is a direct base class of OnceCallbacks. It keeps the
+// BindState in |inline_storage_|, instead of on the heap, if it fits and can be
+// moved without throwing, so that binding small arguments doesn't allocate.
+// Such a state is moved with the callback. RepeatingCallbacks share their
+// states on the heap, and stay pointer-sized.
+class BASE_EXPORT OnceCallbackBase : public CallbackBase {
+ public:
+  // Large enough for a method, its receiver and a pointer-sized argument.
+  static constexpr size_t kInlineStorageSize = 72;
+  static constexpr size_t kInlineStorageAlignment = alignof(void*);
+
+  inline OnceCallbackBase(OnceCallbackBase&& c) noexcept;
+  OnceCallbackBase& operator=(OnceCallbackBase&& c) noexcept;
+
+  explicit OnceCallbackBase(CallbackBaseCopyable&& c) noexcept
+      : CallbackBase(std::move(c)) {}
+
+ protected:
+  constexpr OnceCallbackBase() = default;
+  explicit OnceCallbackBase(BindStateBase* bind_state)
+      : CallbackBase(bind_state) {}
+
+  // Creates a BindStateType with |args|, in |inline_storage_| if it fits.
+  template <typename BindStateType, typename... Args>
+  explicit OnceCallbackBase(std::in_place_type_t<BindStateType>,
+                            Args&&... args) {
+    bind_state_ = AdoptRef(static_cast<BindStateBase*>(
+        BindStateType::Create(inline_storage_, std::forward<Args>(args)...)));
+  }
+
+  ~OnceCallbackBase() = default;
+
+ private:
+  // Moves |c|'s inline state into |inline_storage_|. This has no state.
+  void RelocateFrom(OnceCallbackBase& c) noexcept;
+
+  alignas(kInlineStorageAlignment) unsigned char
+      inline_storage_[kInlineStorageSize];
+};
+
+OnceCallbackBase::OnceCallbackBase(OnceCallbackBase&& c) noexcept {
+  if (c.bind_state_ && c.bind_state_->is_inline())
+    RelocateFrom(c);
+  else
+    bind_state_ = std::move(c.bind_state_);
+}
+
 // CallbackBase<Copyable> is a direct base class of Copyable Callbacks.
 class BASE_EXPORT CallbackBaseCopyable : public CallbackBase {
  public:
@@ -0,0 +1,153 @@
+// Copyright (C) 2026 Yisi Yu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#include "base/functional/callback.h"
+
+#include <array>
+#include <memory>
+#include <vector>
+
+#include "base/functional/bind.h"
+#include "base/memory/ref_counted.h"
+#include "kiwi/testing/allocation_counter.h"
+#include "third_party/googletest-release-1.12.1/googletest/include/gtest/gtest.h"
+
+namespace kiwi::base {
+namespace testing {
+
+namespace {
+using AllocationCounter = kiwi::testing::AllocationCounter;
+
+int Add(int a, int b) {
+  return a + b;
+}
+
+class Counter : public RefCountedThreadSafe<Counter> {
+ public:
+  void Increase(int step) { count_ += step; }
+  int count() const { return count_; }
+
+ private:
+  friend class RefCountedThreadSafe<Counter>;
+  ~Counter() = default;
+
+  int count_ = 0;
+};
+
+// Counts how many times it's destroyed, not counting the moved-from ones.
+class DestructionCounter {
+ public:
+  explicit DestructionCounter(int* destroyed) : destroyed_(destroyed) {}
+  DestructionCounter(DestructionCounter&& other) noexcept
+      : destroyed_(other.destroyed_) {
+    other.destroyed_ = nullptr;
+  }
+  ~DestructionCounter() {
+    if (destroyed_)
+      ++*destroyed_;
+  }
+
+ private:
+  int* destroyed_;
+};
+}  // namespace
+
+TEST(CallbackTest, SmallOnceCallbacksDontAllocate) {
+  scoped_refptr<Counter> counter = MakeRefCounted<Counter>();
+
+  AllocationCounter allocations;
+  OnceCallback<int(int)> add = BindOnce(&Add, 1);
+  OnceClosure increase =
+      BindOnce(&Counter::Increase, RetainedRef(counter), 2);
+  OnceClosure moved = std::move(increase);
+  int sum = std::move(add).Run(2);
+  std::move(moved).Run();
+  size_t count = allocations.count();
+
+  EXPECT_EQ(count, 0u);
+  EXPECT_EQ(sum, 3);
+  EXPECT_EQ(counter->count(), 2);
+  EXPECT_TRUE(counter->HasOneRef());
+}
+
+TEST(CallbackTest, LargeOnceCallbacksAllocate) {
+  std::array<int, 32> large = {1, 2, 3};
+
+  AllocationCounter allocations;
+  OnceCallback<int()> sum = BindOnce(
+      [](const std::array<int, 32>& values) { return values[0] + values[2]; },
+      large);
+  OnceCallback<int()> moved = std::move(sum);
+  size_t count = allocations.count();
+
+  EXPECT_EQ(count, 1u);
+  EXPECT_EQ(std::move(moved).Run(), 4);
+}
+
+TEST(CallbackTest, RepeatingCallbacksShareStates) {
+  AllocationCounter allocations;
+  RepeatingCallback<int(int)> add = BindRepeating(&Add, 1);
+  RepeatingCallback<int(int)> copy = add;
+  OnceCallback<int(int)> once = copy;
+  size_t count = allocations.count();
+
+  EXPECT_EQ(count, 1u);
+  EXPECT_EQ(add.Run(1), 2);
+  EXPECT_EQ(copy.Run(2), 3);
+  EXPECT_EQ(std::move(once).Run(3), 4);
+}
+
+// An inline state is moved with its callback, and destroyed once.
+TEST(CallbackTest, MovesInlineStates) {
+  int destroyed = 0;
+  {
+    OnceClosure task = BindOnce([](const DestructionCounter&) {},
+                                DestructionCounter(&destroyed));
+    std::vector<OnceClosure> tasks;
+    for (int i = 0; i < 16; ++i)
+      tasks.push_back(BindOnce([] {}));
+    tasks.insert(tasks.begin(), std::move(task));
+    EXPECT_TRUE(task.is_null());
+    EXPECT_EQ(destroyed, 0);
+
+    // Assigning destroys the old state.
+    tasks.back() = std::move(tasks.front());
+    EXPECT_EQ(destroyed, 0);
+    tasks.back() = BindOnce([] {});
+    EXPECT_EQ(destroyed, 1);
+  }
+  EXPECT_EQ(destroyed, 1);
+
+  OnceClosure task =
+      BindOnce([](DestructionCounter) {}, DestructionCounter(&destroyed));
+  std::move(task).Run();
+  EXPECT_EQ(destroyed, 2);
+}
+
+// Large arguments bound by std::move() aren't copied.
+TEST(CallbackTest, MovesBoundArguments) {
+  std::vector<int> data(1024, 1);
+  const int* buffer = data.data();
+  OnceCallback<const int*()> task =
+      BindOnce([](std::vector<int> data) -> const int* { return data.data(); },
+               std::move(data));
+  OnceCallback<const int*()> moved = std::move(task);
+  EXPECT_EQ(std::move(moved).Run(), buffer);
+
+  auto unique = std::make_unique<int>(42);
+  OnceCallback<int()> take = BindOnce(
+      [](std::unique_ptr<int> value) { return *value; }, std::move(unique));
+  EXPECT_EQ(std::move(take).Run(), 42);
+}
+
+}  // namespace testing
+}  // namespace kiwi::base
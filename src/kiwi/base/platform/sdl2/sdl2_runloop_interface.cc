@@ -12,6 +12,7 @@
 
 #include "base/platform/sdl2/sdl2_runloop_interface.h"
 
+#include <algorithm>
 #include <stack>
 
 #include "base/check.h"
@@ -115,7 +116,11 @@ void SDL2RunLoopInterface::HandleEvents() {
     }
   }
 
-  TryRender();
+  TimeDelta next_task_delay = TimeDelta::Max();
+  if (auto* executor = SDL2SingleThreadTaskExecutorInterface::GetCurrent())
+    next_task_delay = executor->RunDueDelayedTasks();
+
+  TryRender(next_task_delay);
 }
 
 void SDL2RunLoopInterface::Quit() {
@@ -124,7 +129,7 @@ void SDL2RunLoopInterface::Quit() {
   SDL_PushEvent(&event);
 }
 
-void SDL2RunLoopInterface::TryRender() {
+void SDL2RunLoopInterface::TryRender(TimeDelta next_task_delay) {
 #if __EMSCRIPTEN__
   if (GetRenderHandlerForSDL2()) {
     GetRenderHandlerForSDL2().Run();
@@ -137,7 +142,12 @@ void SDL2RunLoopInterface::TryRender() {
   } else {
     // When condition variable is signaled. It means a PostTask is called in
     // another thread. When condition variable is timeout, no task is post
-    // duration this 'delay'.
+    // duration this 'delay'. Delayed tasks are run by the next HandleEvents(),
+    // so it wakes up for them as well.
+    if (!next_task_delay.is_max()) {
+      delay = std::min(delay, static_cast<float>(
+                                  next_task_delay.InMillisecondsRoundedUp()));
+    }
     int result = SDL_CondWaitTimeout(cond_, frame_sync_mutex_, delay);
     if (result < 0)
       LOG(ERROR) << " Condition wait timeout failed:" << SDL_GetError();
@@ -147,12 +157,21 @@ void SDL2RunLoopInterface::TryRender() {
 
 // Gets the recommended delay duration. Window should render if duration <= 0.
 float SDL2RunLoopInterface::GetNextRenderDelay() {
-  constexpr auto kRenderDuration = std::chrono::milliseconds(1000 / kFPS);
+  constexpr auto kRenderDuration =
+      std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+          std::chrono::duration<double>(1.0 / kFPS));
+  const auto now = std::chrono::steady_clock::now();
   const std::chrono::duration<float, std::milli> frame_elapsed =
-      std::chrono::steady_clock::now() - render_timestamp_;
+      now - render_timestamp_;
   bool need_render = frame_elapsed >= kRenderDuration;
-  if (need_render)
-    render_timestamp_ = std::chrono::steady_clock::now();
+  if (need_render) {
+    // Renders are scheduled by a fixed period, rather than from when the last
+    // one happened, so that waking up late doesn't slow the frame rate down.
+    // If it falls more than a frame behind, it starts over from now.
+    render_timestamp_ += kRenderDuration;
+    if (now - render_timestamp_ >= kRenderDuration)
+      render_timestamp_ = now;
+  }
   return (kRenderDuration - frame_elapsed).count();
 }
 
@@ -18,6 +18,7 @@
 #include <memory>
 
 #include "base/platform/platform_factory.h"
+#include "base/time/time.h"
 #include "third_party/SDL2/include/SDL_events.h"
 
 namespace kiwi::base {
@@ -41,7 +42,9 @@ class SDL2RunLoopInterface : public RunLoopInterface {
 
  private:
   void Quit();
-  void TryRender();
+  // Renders if it's time to, or waits for a post no longer than until it is,
+  // or until |next_task_delay|, when the next delayed task is due.
+  void TryRender(TimeDelta next_task_delay);
   float GetNextRenderDelay();
 
  private:
@@ -15,6 +15,7 @@
 #include <atomic>
 
 #include "base/check.h"
+#include "base/compiler_specific.h"
 #include "base/platform/sdl2/sdl2_runloop_interface.h"
 #include "third_party/SDL2/include/SDL.h"
 
@@ -22,22 +23,8 @@ namespace kiwi::base {
 namespace platform {
 
 namespace {
-
-struct TimerContext {
-  SDL2SingleThreadTaskExecutorInterface* t;
-  base::OnceClosure task;
-};
-
-Uint32 OnShouldPostTask(Uint32 interval, void* param) {
-  TimerContext* context = reinterpret_cast<TimerContext*>(param);
-  SDL_assert(context);
-  context->t->PostTask(std::move(context->task), base::TimeDelta());
-  delete context;
-
-  // Do not run this timer again. Returns zero.
-  return 0;
-}
-
+THREAD_LOCAL SDL2SingleThreadTaskExecutorInterface* g_current_executor =
+    nullptr;
 }  // namespace
 
 SDL2SingleThreadTaskExecutorInterface::SDL2SingleThreadTaskExecutorInterface(
@@ -54,47 +41,58 @@ SDL2SingleThreadTaskExecutorInterface::SDL2SingleThreadTaskExecutorInterface(
       }
     }
   }
-  mutex_ = SDL_CreateMutex();
-
   scoped_refptr<SDL2SingleThreadTaskRunner> task_runner =
       base::MakeRefCounted<SDL2SingleThreadTaskRunner>(this);
   SingleThreadTaskRunner::SetCurrentDefault(task_runner);
   SequencedTaskRunner::SetCurrentDefault(task_runner);
   task_runner_ = task_runner;
+  g_current_executor = this;
 }
 
 SDL2SingleThreadTaskExecutorInterface::
     ~SDL2SingleThreadTaskExecutorInterface() {
-  if (timer_)
-    SDL_RemoveTimer(timer_);
+  g_current_executor = nullptr;
   SingleThreadTaskRunner::SetCurrentDefault(nullptr);
   SequencedTaskRunner::SetCurrentDefault(nullptr);
-  SDL_DestroyMutex(mutex_);
 }
 
 bool SDL2SingleThreadTaskExecutorInterface::PostTask(base::OnceClosure task,
                                                      base::TimeDelta delay) {
-  if (delay == base::TimeDelta()) {
-    SDL_Event event = SDL2RunLoopInterface::CreatePostTaskEvent();
-    // Push the task into the queue, waiting for poll.
-    SDL_LockMutex(mutex_);
-    tasks_.push(std::move(task));
-    SDL_UnlockMutex(mutex_);
-    event.user.data1 = this;
-    SDL_PushEvent(&event);
-  } else {
-    TimerContext* ctx = new TimerContext{this, std::move(task)};
-    timer_ = SDL_AddTimer(delay.InMilliseconds(), OnShouldPostTask, ctx);
-  }
+  // Push the task into the queue, waiting for poll. Delayed tasks are posted
+  // as well, so that the run loop wakes up and waits for them.
+  if (delay == base::TimeDelta())
+    tasks_.Push(std::make_unique<PendingTask>(std::move(task)));
+  else
+    tasks_.Push(std::make_unique<PendingTask>(std::move(task), delay));
+
+  SDL_Event event = SDL2RunLoopInterface::CreatePostTaskEvent();
+  event.user.data1 = this;
+  SDL_PushEvent(&event);
   return true;
 }
 
 void SDL2SingleThreadTaskExecutorInterface::RunTask() {
-  SDL_LockMutex(mutex_);
-  base::OnceClosure task = std::move(tasks_.front());
-  tasks_.pop();
-  SDL_UnlockMutex(mutex_);
-  std::move(task).Run();
+  tasks_.Drain([this](std::unique_ptr<PendingTask> task) {
+    if (task->is_delayed())
+      delayed_tasks_.Push(std::move(task));
+    else
+      std::move(task->task).Run();
+  });
+}
+
+TimeDelta SDL2SingleThreadTaskExecutorInterface::RunDueDelayedTasks() {
+  // Delayed tasks which become due while these run are left for the next
+  // turn, after the events which come meanwhile.
+  PendingTask::Clock::time_point now = PendingTask::Clock::now();
+  while (std::unique_ptr<PendingTask> task = delayed_tasks_.PopDue(now))
+    std::move(task->task).Run();
+  return delayed_tasks_.GetDelayUntilNext(PendingTask::Clock::now());
+}
+
+// static
+SDL2SingleThreadTaskExecutorInterface*
+SDL2SingleThreadTaskExecutorInterface::GetCurrent() {
+  return g_current_executor;
 }
 
 }  // namespace platform
@@ -14,12 +14,13 @@
 #define BASE_PLATFORM_SDL2_SDL2_SINGLE_THREAD_TASK_EXECUTOR_INTERFACE_H_
 
 #include <SDL.h>
-#include <queue>
 #include <set>
 
 #include "base/message_loop/message_pump_type.h"
 #include "base/platform/platform_factory.h"
 #include "base/platform/sdl2/sdl2_single_thread_task_runner.h"
+#include "base/task/delayed_task_queue.h"
+#include "base/task/pending_task.h"
 #include "base/time/time.h"
 
 namespace kiwi::base {
@@ -36,16 +37,27 @@ class SDL2SingleThreadTaskExecutorInterface
   bool PostTask(base::OnceClosure task, base::TimeDelta delay) override;
 
  public:
-  // Run the front task of the task queue, and remove it from the task queue.
+  // Runs the tasks which have been posted. A task's event may find it has run
+  // already, with the tasks before it.
   void RunTask();
 
+  // Runs the delayed tasks which are due, and returns how long until the next
+  // one is, or TimeDelta::Max() if there is none. The run loop waits for
+  // events no longer than it.
+  TimeDelta RunDueDelayedTasks();
+
+  // The executor of the current thread, or null.
+  static SDL2SingleThreadTaskExecutorInterface* GetCurrent();
+
  private:
   scoped_refptr<base::SequencedTaskRunner> task_runner_;
-  SDL_TimerID timer_ = 0;
 
-  // Tasks implementation.
-  std::queue<base::OnceClosure> tasks_;
-  SDL_mutex* mutex_ = nullptr;
+  // Tasks implementation. A PostTask event is pushed after each task, delayed
+  // or not.
+  PendingTaskQueue tasks_;
+
+  // Delayed tasks which have been taken from |tasks_|.
+  DelayedTaskQueue delayed_tasks_;
 };
 }  // namespace platform
 }  // namespace kiwi::base
@@ -17,25 +17,6 @@
 namespace kiwi::base {
 namespace platform {
 
-namespace {
-
-struct TimerContext {
-  SDL2ThreadInterface* t;
-  base::OnceClosure task;
-};
-
-Uint32 OnShouldPostTask(Uint32 interval, void* param) {
-  TimerContext* context = reinterpret_cast<TimerContext*>(param);
-  SDL_assert(context);
-  context->t->PostTask(std::move(context->task), base::TimeDelta());
-  delete context;
-
-  // Do not run this timer again. Returns zero.
-  return 0;
-}
-
-}  // namespace
-
 int ThreadEventFunc(void* data) {
   SDL2ThreadInterface* t = reinterpret_cast<SDL2ThreadInterface*>(data);
 
@@ -44,17 +25,19 @@ int ThreadEventFunc(void* data) {
   SequencedTaskRunner::SetCurrentDefault(t->task_runner_);
 
   while (t->is_running_) {
-    SDL_SemWait(t->sem_);
+    // Waits for a task, or until the first delayed task is due.
+    TimeDelta delay =
+        t->delayed_tasks_.GetDelayUntilNext(PendingTask::Clock::now());
+    if (delay.is_max())
+      SDL_SemWait(t->sem_);
+    else if (delay != TimeDelta())
+      SDL_SemWaitTimeout(t->sem_, delay.InMillisecondsRoundedUp());
 
     // When is_running_ is set to false, wake sem_.
     if (!t->is_running_)
       break;
 
-    SDL_LockMutex(t->mutex_);
-    base::OnceClosure task = std::move(t->tasks_.front());
-    t->tasks_.pop();
-    SDL_UnlockMutex(t->mutex_);
-    std::move(task).Run();
+    t->RunTasks();
   }
 
   // Cleanup task runner for current thread.
@@ -64,14 +47,10 @@ int ThreadEventFunc(void* data) {
 }
 
 SDL2ThreadInterface::SDL2ThreadInterface() {
-  mutex_ = SDL_CreateMutex();
   sem_ = SDL_CreateSemaphore(0);
 }
 
 SDL2ThreadInterface::~SDL2ThreadInterface() {
-  if (timer_)
-    SDL_RemoveTimer(timer_);
-
   if (thread_) {
     ExitThread(0);
 
@@ -79,7 +58,6 @@ SDL2ThreadInterface::~SDL2ThreadInterface() {
     SDL_WaitThread(thread_, &status);
     thread_ = nullptr;
   }
-  SDL_DestroyMutex(mutex_);
   SDL_DestroySemaphore(sem_);
 }
 
@@ -123,17 +101,32 @@ void SDL2ThreadInterface::ExitThread(int exit_code) {
 
 bool SDL2ThreadInterface::PostTask(base::OnceClosure task,
                                    base::TimeDelta delay) {
-  if (delay == base::TimeDelta()) {
-    SDL_LockMutex(mutex_);
-    tasks_.push(std::move(task));
-    SDL_UnlockMutex(mutex_);
-    SDL_SemPost(sem_);
-  } else {
-    TimerContext* ctx = new TimerContext{this, std::move(task)};
-    timer_ = SDL_AddTimer(delay.InMilliseconds(), OnShouldPostTask, ctx);
-  }
+  if (delay == base::TimeDelta())
+    tasks_.Push(std::make_unique<PendingTask>(std::move(task)));
+  else
+    tasks_.Push(std::make_unique<PendingTask>(std::move(task), delay));
+
+  // Delayed tasks wake the thread up as well, so that it waits for them.
+  SDL_SemPost(sem_);
   return true;
 }
 
+void SDL2ThreadInterface::RunTasks() {
+  // A wake up runs all tasks which can be popped, so that the ones whose
+  // wake ups come later may have run already.
+  tasks_.Drain([this](std::unique_ptr<PendingTask> task) {
+    if (task->is_delayed())
+      delayed_tasks_.Push(std::move(task));
+    else
+      std::move(task->task).Run();
+  });
+
+  // Delayed tasks which become due while these run are left for the next
+  // turn, after the tasks posted meanwhile.
+  PendingTask::Clock::time_point now = PendingTask::Clock::now();
+  while (std::unique_ptr<PendingTask> task = delayed_tasks_.PopDue(now))
+    std::move(task->task).Run();
+}
+
 }  // namespace platform
 }  // namespace kiwi::base
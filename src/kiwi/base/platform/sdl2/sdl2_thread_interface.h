@@ -15,10 +15,11 @@
 
 #include <SDL.h>
 #include <atomic>
-#include <queue>
 
 #include "base/platform/platform_factory.h"
 #include "base/platform/sdl2/sdl2_single_thread_task_runner.h"
+#include "base/task/delayed_task_queue.h"
+#include "base/task/pending_task.h"
 #include "third_party/SDL2/include/SDL_mutex.h"
 #include "third_party/SDL2/include/SDL_thread.h"
 
@@ -45,17 +46,25 @@ class SDL2ThreadInterface
  private:
   void ExitThread(int exit_code);
 
+  // Runs the tasks which have been posted, and the delayed tasks which are
+  // due. Thread only.
+  void RunTasks();
+
  private:
   friend int ThreadEventFunc(void*);
   friend class SDL2SingleThreadTaskRunner;
 
-  SDL_TimerID timer_ = 0;
   std::atomic_bool is_running_;
   std::atomic_int exit_code_;
-  std::queue<base::OnceClosure> tasks_;
-  SDL_mutex* mutex_ = nullptr;
+  // Tasks are posted without locking. |sem_| is posted after each of them,
+  // delayed or not.
+  PendingTaskQueue tasks_;
   SDL_sem* sem_ = nullptr;
 
+  // Delayed tasks which have been taken from |tasks_|. The thread waits on
+  // |sem_| until the first of them is due.
+  DelayedTaskQueue delayed_tasks_;
+
   SDL_Thread* thread_ = nullptr;
   std::string thread_name_;
   scoped_refptr<SingleThreadTaskRunner> task_runner_;
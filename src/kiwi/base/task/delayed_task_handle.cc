@@ -0,0 +1,72 @@
+// Copyright (C) 2026 Yisi Yu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#include "base/task/delayed_task_handle.h"
+
+#include "base/functional/bind.h"
+#include "base/memory/ref_counted.h"
+
+namespace kiwi::base {
+
+// Shared by the handle and the posted closure. Both are used on the same
+// sequence, so that |task| needs no lock.
+class DelayedTaskHandle::State : public RefCountedThreadSafe<State> {
+ public:
+  explicit State(OnceClosure task) : task_(std::move(task)) {}
+
+  bool has_task() const { return !!task_; }
+
+  void Run() {
+    if (task_)
+      std::move(task_).Run();
+  }
+
+  void Cancel() { task_.Reset(); }
+
+ private:
+  friend class RefCountedThreadSafe<State>;
+  ~State() = default;
+
+  OnceClosure task_;
+};
+
+DelayedTaskHandle::DelayedTaskHandle() = default;
+
+DelayedTaskHandle::DelayedTaskHandle(scoped_refptr<State> state)
+    : state_(std::move(state)) {}
+
+DelayedTaskHandle::~DelayedTaskHandle() = default;
+
+DelayedTaskHandle::DelayedTaskHandle(DelayedTaskHandle&& other) = default;
+
+DelayedTaskHandle& DelayedTaskHandle::operator=(DelayedTaskHandle&& other) =
+    default;
+
+bool DelayedTaskHandle::IsValid() const {
+  return state_ && state_->has_task();
+}
+
+void DelayedTaskHandle::CancelTask() {
+  if (state_) {
+    state_->Cancel();
+    state_ = nullptr;
+  }
+}
+
+// static
+DelayedTaskHandle DelayedTaskHandle::Wrap(OnceClosure* task) {
+  scoped_refptr<State> state = MakeRefCounted<State>(std::move(*task));
+  *task = BindOnce(&State::Run, state);
+  return DelayedTaskHandle(std::move(state));
+}
+
+}  // namespace kiwi::base
@@ -0,0 +1,56 @@
+// Copyright (C) 2026 Yisi Yu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#ifndef BASE_TASK_DELAYED_TASK_HANDLE_H_
+#define BASE_TASK_DELAYED_TASK_HANDLE_H_
+
+#include "base/base_export.h"
+#include "base/functional/callback.h"
+#include "base/memory/scoped_refptr.h"
+
+namespace kiwi::base {
+
+// A handle to a task posted by SequencedTaskRunner::PostCancelableDelayedTask(),
+// which can cancel it before it runs. It must be used, and destroyed, on the
+// sequence which runs the task. Destroying it doesn't cancel the task.
+class BASE_EXPORT DelayedTaskHandle {
+ public:
+  DelayedTaskHandle();
+  ~DelayedTaskHandle();
+
+  DelayedTaskHandle(DelayedTaskHandle&& other);
+  DelayedTaskHandle& operator=(DelayedTaskHandle&& other);
+
+  // Whether the task is waiting to run, which is false once it has run or
+  // been canceled.
+  bool IsValid() const;
+
+  // Cancels the task, and destroys it right away, together with what is bound
+  // to it. Does nothing if the handle isn't valid.
+  void CancelTask();
+
+ private:
+  friend class SequencedTaskRunner;
+  class State;
+
+  explicit DelayedTaskHandle(scoped_refptr<State> state);
+
+  // Moves |*task| into a new handle, and replaces it with a closure which runs
+  // it unless it's been canceled.
+  static DelayedTaskHandle Wrap(OnceClosure* task);
+
+  scoped_refptr<State> state_;
+};
+
+}  // namespace kiwi::base
+
+#endif  // BASE_TASK_DELAYED_TASK_HANDLE_H_
@@ -0,0 +1,62 @@
+// Copyright (C) 2026 Yisi Yu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#include "base/task/delayed_task_queue.h"
+
+#include <algorithm>
+
+#include "base/check.h"
+
+namespace kiwi::base {
+namespace {
+// Orders the heap, which std::push_heap() makes a max-heap, into a min-heap.
+bool RunsLater(const std::unique_ptr<PendingTask>& lhs,
+               const std::unique_ptr<PendingTask>& rhs) {
+  if (lhs->delayed_run_time != rhs->delayed_run_time)
+    return lhs->delayed_run_time > rhs->delayed_run_time;
+  return lhs->sequence_num > rhs->sequence_num;
+}
+}  // namespace
+
+DelayedTaskQueue::DelayedTaskQueue() = default;
+
+DelayedTaskQueue::~DelayedTaskQueue() = default;
+
+void DelayedTaskQueue::Push(std::unique_ptr<PendingTask> task) {
+  DCHECK(task->is_delayed());
+  task->sequence_num = next_sequence_num_++;
+  tasks_.push_back(std::move(task));
+  std::push_heap(tasks_.begin(), tasks_.end(), &RunsLater);
+}
+
+std::unique_ptr<PendingTask> DelayedTaskQueue::PopDue(Clock::time_point now) {
+  if (tasks_.empty() || tasks_.front()->delayed_run_time > now)
+    return nullptr;
+
+  std::pop_heap(tasks_.begin(), tasks_.end(), &RunsLater);
+  std::unique_ptr<PendingTask> task = std::move(tasks_.back());
+  tasks_.pop_back();
+  return task;
+}
+
+TimeDelta DelayedTaskQueue::GetDelayUntilNext(Clock::time_point now) const {
+  if (tasks_.empty())
+    return TimeDelta::Max();
+
+  Clock::duration delay = tasks_.front()->delayed_run_time - now;
+  if (delay <= Clock::duration::zero())
+    return TimeDelta();
+  return Microseconds(
+      std::chrono::ceil<std::chrono::microseconds>(delay).count());
+}
+
+}  // namespace kiwi::base
@@ -0,0 +1,60 @@
+// Copyright (C) 2026 Yisi Yu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#ifndef BASE_TASK_DELAYED_TASK_QUEUE_H_
+#define BASE_TASK_DELAYED_TASK_QUEUE_H_
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "base/base_export.h"
+#include "base/task/pending_task.h"
+
+namespace kiwi::base {
+
+// DelayedTaskQueue keeps delayed tasks of a thread in a min-heap by when they
+// are due, so that the thread's run loop can wait exactly until the first one,
+// instead of having a timer for each. It's used by the thread which runs the
+// tasks only. Tasks posted from other threads go through their task runners'
+// queues first.
+class BASE_EXPORT DelayedTaskQueue {
+ public:
+  using Clock = PendingTask::Clock;
+
+  DelayedTaskQueue();
+  ~DelayedTaskQueue();
+
+  DelayedTaskQueue(const DelayedTaskQueue&) = delete;
+  DelayedTaskQueue& operator=(const DelayedTaskQueue&) = delete;
+
+  bool empty() const { return tasks_.empty(); }
+  size_t size() const { return tasks_.size(); }
+
+  // |task| must be delayed.
+  void Push(std::unique_ptr<PendingTask> task);
+
+  // Pops the first task if it is due at |now|, or returns null.
+  std::unique_ptr<PendingTask> PopDue(Clock::time_point now);
+
+  // How long from |now| until the first task is due, which is 0 if it's due,
+  // or TimeDelta::Max() if there are no tasks.
+  TimeDelta GetDelayUntilNext(Clock::time_point now) const;
+
+ private:
+  std::vector<std::unique_ptr<PendingTask>> tasks_;
+  uint64_t next_sequence_num_ = 0;
+};
+
+}  // namespace kiwi::base
+
+#endif  // BASE_TASK_DELAYED_TASK_QUEUE_H_
@@ -0,0 +1,190 @@
+// Copyright (C) 2026 Yisi Yu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#include "base/task/delayed_task_queue.h"
+
+#include <atomic>
+#include <chrono>
+#include <latch>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "base/functional/bind.h"
+#include "base/task/delayed_task_handle.h"
+#include "base/task/single_thread_task_runner.h"
+#include "base/threading/thread.h"
+#include "third_party/googletest-release-1.12.1/googletest/include/gtest/gtest.h"
+
+namespace kiwi::base {
+namespace testing {
+
+namespace {
+// BindOnce() doesn't take capturing lambdas, which tests use for brevity.
+template <typename Lambda>
+OnceClosure BindLambdaForTesting(Lambda lambda) {
+  return BindOnce([](Lambda lambda) { lambda(); }, std::move(lambda));
+}
+
+std::unique_ptr<PendingTask> CreateTask(std::vector<int>* order,
+                                        int id,
+                                        PendingTask::Clock::time_point due) {
+  auto task = std::make_unique<PendingTask>(
+      BindOnce([](std::vector<int>* order, int id) { order->push_back(id); },
+               order, id),
+      Milliseconds(1));
+  task->delayed_run_time = due;
+  return task;
+}
+
+// Sets |*destroyed| when it's destroyed, together with the task it's bound to.
+class DestructionObserver {
+ public:
+  explicit DestructionObserver(bool* destroyed) : destroyed_(destroyed) {}
+  ~DestructionObserver() { *destroyed_ = true; }
+
+ private:
+  bool* destroyed_;
+};
+}  // namespace
+
+TEST(DelayedTaskQueueTest, PopsDueTasksInOrder) {
+  const PendingTask::Clock::time_point now = PendingTask::Clock::now();
+  std::vector<int> order;
+  DelayedTaskQueue queue;
+  queue.Push(CreateTask(&order, 0, now + std::chrono::milliseconds(30)));
+  queue.Push(CreateTask(&order, 1, now + std::chrono::milliseconds(10)));
+  queue.Push(CreateTask(&order, 2, now + std::chrono::milliseconds(20)));
+  // Tasks which are due at the same time run in the order they are posted.
+  queue.Push(CreateTask(&order, 3, now + std::chrono::milliseconds(10)));
+  EXPECT_EQ(queue.size(), 4u);
+
+  EXPECT_EQ(queue.PopDue(now), nullptr);
+  while (std::unique_ptr<PendingTask> task =
+             queue.PopDue(now + std::chrono::milliseconds(20))) {
+    std::move(task->task).Run();
+  }
+  EXPECT_EQ(order, (std::vector<int>{1, 3, 2}));
+  EXPECT_EQ(queue.size(), 1u);
+
+  std::move(queue.PopDue(now + std::chrono::milliseconds(30))->task).Run();
+  EXPECT_EQ(order, (std::vector<int>{1, 3, 2, 0}));
+  EXPECT_TRUE(queue.empty());
+}
+
+TEST(DelayedTaskQueueTest, GetDelayUntilNext) {
+  const PendingTask::Clock::time_point now = PendingTask::Clock::now();
+  std::vector<int> order;
+  DelayedTaskQueue queue;
+  EXPECT_TRUE(queue.GetDelayUntilNext(now).is_max());
+
+  queue.Push(CreateTask(&order, 0, now + std::chrono::milliseconds(5)));
+  EXPECT_EQ(queue.GetDelayUntilNext(now), Milliseconds(5));
+  EXPECT_EQ(queue.GetDelayUntilNext(now + std::chrono::milliseconds(5)),
+            TimeDelta());
+  EXPECT_EQ(queue.GetDelayUntilNext(now + std::chrono::milliseconds(6)),
+            TimeDelta());
+
+  // Rounds up, so that a wait for it doesn't wake up early.
+  queue.Push(CreateTask(&order, 1, now + std::chrono::nanoseconds(1500)));
+  EXPECT_EQ(queue.GetDelayUntilNext(now), Microseconds(2));
+}
+
+TEST(DelayedTaskQueueTest, ThreadRunsDelayedTasksInOrder) {
+  constexpr int kDelays[] = {60, 20, 40, 0};
+  std::mutex lock;
+  std::vector<int> order;
+  std::atomic<int> early_count{0};
+  std::latch done(std::size(kDelays));
+
+  Thread thread("DelayedTaskQueueTest");
+  thread.StartWithOptions(Thread::Options());
+  const auto start = std::chrono::steady_clock::now();
+  for (int delay : kDelays) {
+    thread.task_runner()->PostDelayedTask(
+        FROM_HERE, BindLambdaForTesting([&, delay] {
+          if (std::chrono::steady_clock::now() - start <
+              std::chrono::milliseconds(delay)) {
+            ++early_count;
+          }
+          {
+            std::lock_guard<std::mutex> guard(lock);
+            order.push_back(delay);
+          }
+          done.count_down();
+        }),
+        Milliseconds(delay));
+  }
+  done.wait();
+
+  EXPECT_EQ(order, (std::vector<int>{0, 20, 40, 60}));
+  EXPECT_EQ(early_count, 0);
+}
+
+// Delayed tasks which overlap each other are all kept, rather than replacing
+// one another.
+TEST(DelayedTaskQueueTest, ThreadRunsOverlappingDelayedTasks) {
+  constexpr int kTaskCount = 1000;
+  std::atomic<int> count{0};
+  std::latch done(kTaskCount);
+
+  Thread thread("DelayedTaskQueueTest");
+  thread.StartWithOptions(Thread::Options());
+  for (int i = 0; i < kTaskCount; ++i) {
+    thread.task_runner()->PostDelayedTask(FROM_HERE,
+                                          BindLambdaForTesting([&] {
+                                            ++count;
+                                            done.count_down();
+                                          }),
+                                          Milliseconds(i % 10 + 1));
+  }
+  done.wait();
+  EXPECT_EQ(count, kTaskCount);
+}
+
+TEST(DelayedTaskQueueTest, CancelDelayedTask) {
+  bool canceled_task_ran = false;
+  bool destroyed_on_cancel = false;
+  std::latch done(1);
+
+  Thread thread("DelayedTaskQueueTest");
+  thread.StartWithOptions(Thread::Options());
+  thread.task_runner()->PostTask(FROM_HERE, BindLambdaForTesting([&] {
+    bool destroyed = false;
+    DelayedTaskHandle handle =
+        SingleThreadTaskRunner::GetCurrentDefault()->PostCancelableDelayedTask(
+            FROM_HERE,
+            BindOnce(
+                [](bool* ran, std::unique_ptr<DestructionObserver>) {
+                  *ran = true;
+                },
+                &canceled_task_ran,
+                std::make_unique<DestructionObserver>(&destroyed)),
+            Milliseconds(20));
+    EXPECT_TRUE(handle.IsValid());
+    handle.CancelTask();
+    EXPECT_FALSE(handle.IsValid());
+    destroyed_on_cancel = destroyed;
+
+    // Runs after the canceled task would have.
+    SingleThreadTaskRunner::GetCurrentDefault()->PostDelayedTask(
+        FROM_HERE, BindLambdaForTesting([&] { done.count_down(); }),
+        Milliseconds(40));
+  }));
+  done.wait();
+
+  EXPECT_TRUE(destroyed_on_cancel);
+  EXPECT_FALSE(canceled_task_ran);
+}
+
+}  // namespace testing
+}  // namespace kiwi::base
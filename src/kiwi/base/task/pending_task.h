@@ -0,0 +1,54 @@
+// Copyright (C) 2026 Yisi Yu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#ifndef BASE_TASK_PENDING_TASK_H_
+#define BASE_TASK_PENDING_TASK_H_
+
+#include <chrono>
+#include <cstdint>
+
+#include "base/containers/mpsc_queue.h"
+#include "base/functional/callback.h"
+#include "base/time/time.h"
+
+namespace kiwi::base {
+
+// A task which has been posted to a task runner, and hasn't run yet.
+struct PendingTask : public MPSCQueueNode {
+  using Clock = std::chrono::steady_clock;
+
+  explicit PendingTask(OnceClosure task) : task(std::move(task)) {}
+
+  // A task posted with |delay|, which is due |delay| from now.
+  PendingTask(OnceClosure task, TimeDelta delay)
+      : task(std::move(task)),
+        delayed_run_time(
+            Clock::now() + std::chrono::microseconds(delay.InMicroseconds())) {}
+
+  bool is_delayed() const { return delayed_run_time != Clock::time_point(); }
+
+  OnceClosure task;
+
+  // When a delayed task is due, on the monotonic clock. It's the epoch for
+  // tasks which aren't delayed.
+  Clock::time_point delayed_run_time;
+
+  // Set by DelayedTaskQueue, so that tasks which are due at the same time run
+  // in the order they are posted.
+  uint64_t sequence_num = 0;
+};
+
+using PendingTaskQueue = MPSCQueue<PendingTask>;
+
+}  // namespace kiwi::base
+
+#endif  // BASE_TASK_PENDING_TASK_H_
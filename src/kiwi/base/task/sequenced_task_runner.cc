@@ -30,6 +30,16 @@ bool SequencedTaskRunner::PostTask(const Location& from_here,
   return PostDelayedTask(from_here, std::move(task), base::TimeDelta());
 }
 
+DelayedTaskHandle SequencedTaskRunner::PostCancelableDelayedTask(
+    const Location& from_here,
+    OnceClosure task,
+    base::TimeDelta delay) {
+  DelayedTaskHandle handle = DelayedTaskHandle::Wrap(&task);
+  if (!PostDelayedTask(from_here, std::move(task), delay))
+    return DelayedTaskHandle();
+  return handle;
+}
+
 const scoped_refptr<SequencedTaskRunner>&
 SequencedTaskRunner::GetCurrentDefault() {
   CHECK(HasCurrentDefault());
@@ -18,6 +18,7 @@
 #include "base/functional/callback_helpers.h"
 #include "base/location.h"
 #include "base/memory/ref_counted.h"
+#include "base/task/delayed_task_handle.h"
 #include "base/task/post_task_and_reply_with_result_internal.h"
 #include "base/time/time.h"
 
@@ -42,6 +43,14 @@ class BASE_EXPORT SequencedTaskRunner
                                OnceClosure task,
                                base::TimeDelta delay) = 0;
 
+  // Like PostDelayedTask(), but returns a handle which can cancel |task|
+  // before it runs. The handle must be used on this sequence. If the post
+  // fails, the handle is not valid.
+  [[nodiscard]] DelayedTaskHandle PostCancelableDelayedTask(
+      const Location& from_here,
+      OnceClosure task,
+      base::TimeDelta delay);
+
   // Posts |task| on the current TaskRunner.  On completion, |reply| is posted
   // to the sequence that called PostTaskAndReply().  On the success case,
   // |task| is destroyed on the target sequence and |reply| is destroyed on the
@@ -0,0 +1,358 @@
+// Copyright (C) 2026 Yisi Yu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#include "base/task/thread_pool.h"
+
+#include <algorithm>
+#include <deque>
+#include <queue>
+#include <thread>
+
+#include "base/check.h"
+#include "base/compiler_specific.h"
+
+namespace kiwi::base {
+namespace {
+constexpr int kPriorityCount = static_cast<int>(TaskPriority::kUserBlocking) + 1;
+
+// Wraps |task|, so that |reply| is posted back to the current sequence after
+// it runs.
+OnceClosure BindReply(const Location& from_here,
+                      OnceClosure task,
+                      OnceClosure reply) {
+  return std::move(task).Then(BindOnce(
+      [](const Location& from_here,
+         scoped_refptr<SequencedTaskRunner> reply_task_runner,
+         OnceClosure reply) {
+        reply_task_runner->PostTask(from_here, std::move(reply));
+      },
+      from_here, SequencedTaskRunner::GetCurrentDefault(), std::move(reply)));
+}
+}  // namespace
+
+namespace internal {
+struct ThreadPoolWorker {
+  ThreadPool* pool = nullptr;
+  size_t index = 0;
+  std::thread thread;
+
+  // Guards |tasks|. |task_counts| can be read without it, so that empty deques
+  // are skipped without being locked.
+  std::mutex lock;
+  std::deque<OnceClosure> tasks[kPriorityCount];
+  std::atomic<int> task_counts[kPriorityCount] = {};
+};
+
+struct ThreadPoolDelayedTask {
+  std::chrono::steady_clock::time_point run_time;
+  // Tasks of the same run time run in the order they are posted.
+  uint64_t sequence_num = 0;
+  TaskPriority priority = TaskPriority::kUserVisible;
+  OnceClosure task;
+};
+}  // namespace internal
+
+namespace {
+THREAD_LOCAL internal::ThreadPoolWorker* g_current_worker = nullptr;
+
+// Orders a max-heap of delayed tasks into a min-heap by run times.
+bool RunsLater(const internal::ThreadPoolDelayedTask& lhs,
+               const internal::ThreadPoolDelayedTask& rhs) {
+  if (lhs.run_time != rhs.run_time)
+    return lhs.run_time > rhs.run_time;
+  return lhs.sequence_num > rhs.sequence_num;
+}
+}  // namespace
+
+class ThreadPool::PooledSequencedTaskRunner : public SequencedTaskRunner {
+ public:
+  PooledSequencedTaskRunner(ThreadPool* pool, TaskPriority priority)
+      : pool_(pool), priority_(priority) {}
+
+  // SequencedTaskRunner:
+  bool PostDelayedTask(const Location& from_here,
+                       OnceClosure task,
+                       TimeDelta delay) override {
+    if (delay != TimeDelta()) {
+      // The task joins the sequence when it's due.
+      return pool_->PostDelayedTask(
+          from_here, priority_,
+          BindOnce(IgnoreResult(&PooledSequencedTaskRunner::Push),
+                   scoped_refptr<PooledSequencedTaskRunner>(this),
+                   std::move(task)),
+          delay);
+    }
+    return Push(std::move(task));
+  }
+
+  bool PostTaskAndReply(const Location& from_here,
+                        OnceClosure task,
+                        OnceClosure reply) override {
+    return PostTask(from_here,
+                    BindReply(from_here, std::move(task), std::move(reply)));
+  }
+
+ private:
+  ~PooledSequencedTaskRunner() override = default;
+
+  // Queues |task|, and schedules the sequence if it isn't.
+  bool Push(OnceClosure task) {
+    {
+      std::lock_guard<std::mutex> lock(lock_);
+      tasks_.push(std::move(task));
+      if (scheduled_)
+        return true;
+      scheduled_ = true;
+    }
+
+    if (!pool_->PostTask(
+            FROM_HERE, priority_,
+            BindOnce(&PooledSequencedTaskRunner::RunNextTask,
+                     scoped_refptr<PooledSequencedTaskRunner>(this)))) {
+      std::lock_guard<std::mutex> lock(lock_);
+      scheduled_ = false;
+      return false;
+    }
+    return true;
+  }
+
+  // Runs one task at a time, and schedules the sequence again if there are
+  // more, so that other tasks of the pool get their turns.
+  void RunNextTask() {
+    OnceClosure task;
+    {
+      std::lock_guard<std::mutex> lock(lock_);
+      DCHECK(scheduled_ && !tasks_.empty());
+      task = std::move(tasks_.front());
+      tasks_.pop();
+    }
+
+    SequencedTaskRunner::SetCurrentDefault(this);
+    std::move(task).Run();
+    SequencedTaskRunner::SetCurrentDefault(nullptr);
+
+    {
+      std::lock_guard<std::mutex> lock(lock_);
+      scheduled_ = !tasks_.empty();
+      if (!scheduled_)
+        return;
+    }
+    // Runs on a worker, which can still post while the pool is shutting down.
+    pool_->Enqueue(priority_,
+                   BindOnce(&PooledSequencedTaskRunner::RunNextTask,
+                            scoped_refptr<PooledSequencedTaskRunner>(this)));
+  }
+
+ private:
+  ThreadPool* pool_ = nullptr;
+  const TaskPriority priority_;
+
+  std::mutex lock_;
+  std::queue<OnceClosure> tasks_;
+  // Whether RunNextTask() has been posted to the pool and hasn't finished.
+  bool scheduled_ = false;
+};
+
+ThreadPool::ThreadPool(int thread_count) {
+  if (thread_count <= 0) {
+    thread_count =
+        std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+  }
+
+  // All workers are created before any starts, since they steal from each
+  // other.
+  for (int i = 0; i < thread_count; ++i) {
+    std::unique_ptr<Worker> worker = std::make_unique<Worker>();
+    worker->pool = this;
+    worker->index = i;
+    workers_.push_back(std::move(worker));
+  }
+  for (std::unique_ptr<Worker>& worker : workers_) {
+    worker->thread =
+        std::thread(&ThreadPool::RunWorker, this, worker.get());
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(sleep_lock_);
+    shutting_down_ = true;
+  }
+  wake_up_.notify_all();
+  for (std::unique_ptr<Worker>& worker : workers_)
+    worker->thread.join();
+}
+
+bool ThreadPool::PostTask(const Location& from_here,
+                          TaskPriority priority,
+                          OnceClosure task) {
+  // Tasks which run while shutting down can still post, so that what they
+  // have started, such as sequences, can finish.
+  bool on_worker = g_current_worker && g_current_worker->pool == this;
+  if (shutting_down_ && !on_worker)
+    return false;
+
+  Enqueue(priority, std::move(task));
+  return true;
+}
+
+bool ThreadPool::PostDelayedTask(const Location& from_here,
+                                 TaskPriority priority,
+                                 OnceClosure task,
+                                 TimeDelta delay) {
+  if (delay == TimeDelta())
+    return PostTask(from_here, priority, std::move(task));
+
+  if (shutting_down_)
+    return false;
+
+  Clock::time_point run_time =
+      Clock::now() + std::chrono::microseconds(delay.InMicroseconds());
+  {
+    std::lock_guard<std::mutex> lock(sleep_lock_);
+    delayed_tasks_.push_back(DelayedTask{run_time, delayed_task_count_++,
+                                         priority, std::move(task)});
+    std::push_heap(delayed_tasks_.begin(), delayed_tasks_.end(), &RunsLater);
+    next_delayed_run_time_.store(
+        delayed_tasks_.front().run_time.time_since_epoch().count(),
+        std::memory_order_relaxed);
+  }
+  // A sleeping worker should wait for the first delayed task now.
+  wake_up_.notify_one();
+  return true;
+}
+
+bool ThreadPool::PostTaskAndReply(const Location& from_here,
+                                  TaskPriority priority,
+                                  OnceClosure task,
+                                  OnceClosure reply) {
+  return PostTask(from_here, priority,
+                  BindReply(from_here, std::move(task), std::move(reply)));
+}
+
+scoped_refptr<SequencedTaskRunner> ThreadPool::CreateSequencedTaskRunner(
+    TaskPriority priority) {
+  return MakeRefCounted<PooledSequencedTaskRunner>(this, priority);
+}
+
+void ThreadPool::RunWorker(Worker* worker) {
+  g_current_worker = worker;
+  for (;;) {
+    if (Clock::now().time_since_epoch().count() >=
+        next_delayed_run_time_.load(std::memory_order_relaxed)) {
+      std::lock_guard<std::mutex> lock(sleep_lock_);
+      EnqueueDueDelayedTasks(Clock::now());
+    }
+
+    OnceClosure task;
+    if (TakeTask(worker, &task)) {
+      std::move(task).Run();
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(sleep_lock_);
+    EnqueueDueDelayedTasks(Clock::now());
+
+    // A poster adds to |pending_tasks_| before it reads |sleeping_workers_|,
+    // and this is the other way around, so that either the task is seen here,
+    // or the poster sees this worker sleeping, and wakes it up.
+    sleeping_workers_.fetch_add(1);
+    if (pending_tasks_.load() == 0) {
+      if (shutting_down_) {
+        sleeping_workers_.fetch_sub(1);
+        break;
+      }
+      if (delayed_tasks_.empty())
+        wake_up_.wait(lock);
+      else
+        wake_up_.wait_until(lock, delayed_tasks_.front().run_time);
+    }
+    sleeping_workers_.fetch_sub(1);
+  }
+  g_current_worker = nullptr;
+}
+
+void ThreadPool::PushTask(TaskPriority priority, OnceClosure task) {
+  Worker* worker = g_current_worker;
+  if (!worker || worker->pool != this) {
+    worker = workers_[next_worker_.fetch_add(1, std::memory_order_relaxed) %
+                      workers_.size()]
+                 .get();
+  }
+
+  int index = static_cast<int>(priority);
+  std::lock_guard<std::mutex> lock(worker->lock);
+  worker->tasks[index].push_back(std::move(task));
+  worker->task_counts[index].fetch_add(1, std::memory_order_relaxed);
+  pending_tasks_.fetch_add(1);
+}
+
+void ThreadPool::Enqueue(TaskPriority priority, OnceClosure task) {
+  PushTask(priority, std::move(task));
+  if (sleeping_workers_.load() > 0) {
+    std::lock_guard<std::mutex> lock(sleep_lock_);
+    wake_up_.notify_one();
+  }
+}
+
+bool ThreadPool::TakeTask(Worker* worker, OnceClosure* task) {
+  if (pending_tasks_.load() == 0)
+    return false;
+
+  size_t worker_count = workers_.size();
+  for (int index = kPriorityCount - 1; index >= 0; --index) {
+    for (size_t i = 0; i < worker_count; ++i) {
+      Worker* victim = workers_[(worker->index + i) % worker_count].get();
+      if (!victim->task_counts[index].load(std::memory_order_relaxed))
+        continue;
+
+      std::lock_guard<std::mutex> lock(victim->lock);
+      std::deque<OnceClosure>& tasks = victim->tasks[index];
+      if (tasks.empty())
+        continue;
+
+      if (victim == worker) {
+        *task = std::move(tasks.back());
+        tasks.pop_back();
+      } else {
+        *task = std::move(tasks.front());
+        tasks.pop_front();
+      }
+      victim->task_counts[index].fetch_sub(1, std::memory_order_relaxed);
+      pending_tasks_.fetch_sub(1);
+      return true;
+    }
+  }
+  return false;
+}
+
+void ThreadPool::EnqueueDueDelayedTasks(Clock::time_point now) {
+  bool enqueued = false;
+  while (!delayed_tasks_.empty() && delayed_tasks_.front().run_time <= now) {
+    std::pop_heap(delayed_tasks_.begin(), delayed_tasks_.end(), &RunsLater);
+    DelayedTask& delayed_task = delayed_tasks_.back();
+    PushTask(delayed_task.priority, std::move(delayed_task.task));
+    delayed_tasks_.pop_back();
+    enqueued = true;
+  }
+  next_delayed_run_time_.store(
+      delayed_tasks_.empty()
+          ? Clock::duration::max().count()
+          : delayed_tasks_.front().run_time.time_since_epoch().count(),
+      std::memory_order_relaxed);
+
+  // |sleep_lock_| is held, so sleeping workers can be woken up directly.
+  if (enqueued)
+    wake_up_.notify_all();
+}
+
+}  // namespace kiwi::base
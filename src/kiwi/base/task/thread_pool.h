@@ -0,0 +1,165 @@
+// Copyright (C) 2026 Yisi Yu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#ifndef BASE_TASK_THREAD_POOL_H_
+#define BASE_TASK_THREAD_POOL_H_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "base/base_export.h"
+#include "base/functional/bind.h"
+#include "base/functional/callback.h"
+#include "base/location.h"
+#include "base/task/post_task_and_reply_with_result_internal.h"
+#include "base/task/sequenced_task_runner.h"
+#include "base/time/time.h"
+
+namespace kiwi::base {
+namespace internal {
+struct ThreadPoolWorker;
+struct ThreadPoolDelayedTask;
+}  // namespace internal
+
+// Tasks of higher priorities are always taken first.
+enum class TaskPriority {
+  // Tasks which the user won't notice, such as cleaning up caches.
+  kBestEffort,
+  // Tasks whose results the user will see, such as decoding box arts.
+  kUserVisible,
+  // Tasks which the user is waiting for, such as loading a game.
+  kUserBlocking,
+};
+
+// ThreadPool runs tasks in parallel on a fixed number of worker threads.
+//
+// Each worker has a deque of tasks for each priority. Tasks posted by a
+// worker go to its own deques, and tasks posted by other threads are spread
+// over the workers. A worker takes the newest task of its own, which is the
+// most likely to be in its cache, and when it has none, steals the oldest task
+// of another worker, so that no worker idles while there are tasks.
+//
+// Tasks posted to the pool run in no particular order. Tasks posted to a
+// sequenced task runner from CreateSequencedTaskRunner() run one at a time, in
+// the order they are posted, on any of the workers.
+class BASE_EXPORT ThreadPool {
+ public:
+  // Starts |thread_count| workers. If |thread_count| is 0, hardware
+  // concurrency is used.
+  explicit ThreadPool(int thread_count = 0);
+
+  // Runs the tasks which have been posted, drops the delayed tasks which
+  // aren't due, and joins the workers. Sequenced task runners created by the
+  // pool can't be posted to afterwards.
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  int thread_count() const { return static_cast<int>(workers_.size()); }
+
+  // Posts |task| to run on any worker. Returns false if the pool is shutting
+  // down, and |task| will never run.
+  bool PostTask(const Location& from_here,
+                TaskPriority priority,
+                OnceClosure task);
+  bool PostDelayedTask(const Location& from_here,
+                       TaskPriority priority,
+                       OnceClosure task,
+                       TimeDelta delay);
+
+  // Posts |task| to run on any worker, and then |reply| back to the sequence
+  // which calls this, which must have a current default task runner.
+  bool PostTaskAndReply(const Location& from_here,
+                        TaskPriority priority,
+                        OnceClosure task,
+                        OnceClosure reply);
+
+  // Like PostTaskAndReply(), but passes the result of |task| to |reply|. See
+  // SequencedTaskRunner::PostTaskAndReplyWithResult().
+  template <typename TaskReturnType,
+            typename ReplyArgType,
+            template <typename>
+            class TaskCallbackType,
+            template <typename>
+            class ReplyCallbackType,
+            typename = EnableIfIsBaseCallback<TaskCallbackType>,
+            typename = EnableIfIsBaseCallback<ReplyCallbackType>>
+  bool PostTaskAndReplyWithResult(const Location& from_here,
+                                  TaskPriority priority,
+                                  TaskCallbackType<TaskReturnType()> task,
+                                  ReplyCallbackType<void(ReplyArgType)> reply) {
+    auto* result = new std::unique_ptr<TaskReturnType>();
+    return PostTaskAndReply(
+        from_here, priority,
+        BindOnce(&internal::ReturnAsParamAdapter<TaskReturnType>,
+                 std::move(task), result),
+        BindOnce(&internal::ReplyAdapter<TaskReturnType, ReplyArgType>,
+                 std::move(reply), Owned(result)));
+  }
+
+  // Creates a task runner whose tasks run in sequence, at |priority|.
+  scoped_refptr<SequencedTaskRunner> CreateSequencedTaskRunner(
+      TaskPriority priority);
+
+ private:
+  class PooledSequencedTaskRunner;
+  using Worker = internal::ThreadPoolWorker;
+  using DelayedTask = internal::ThreadPoolDelayedTask;
+  using Clock = std::chrono::steady_clock;
+
+  void RunWorker(Worker* worker);
+
+  // Pushes |task| to the deque of the current worker, or to the next worker's
+  // if it is not on a worker.
+  void PushTask(TaskPriority priority, OnceClosure task);
+
+  // Pushes |task|, and wakes a worker up if any is sleeping.
+  void Enqueue(TaskPriority priority, OnceClosure task);
+
+  // Takes the task of the highest priority, from |worker| itself first.
+  bool TakeTask(Worker* worker, OnceClosure* task);
+
+  // Enqueues the delayed tasks which are due. |sleep_lock_| must be held.
+  void EnqueueDueDelayedTasks(Clock::time_point now);
+
+ private:
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::atomic<unsigned> next_worker_{0};
+
+  // Tasks in workers' deques, and workers waiting for them.
+  std::atomic<int> pending_tasks_{0};
+  std::atomic<int> sleeping_workers_{0};
+  std::atomic_bool shutting_down_{false};
+
+  // Guards |delayed_tasks_|, and is what sleeping workers wait on.
+  std::mutex sleep_lock_;
+  std::condition_variable wake_up_;
+
+  // A min-heap of delayed tasks by their run times.
+  std::vector<DelayedTask> delayed_tasks_;
+  uint64_t delayed_task_count_ = 0;
+
+  // The run time of the first delayed task, so that busy workers can tell
+  // whether any is due without taking |sleep_lock_|.
+  std::atomic<Clock::rep> next_delayed_run_time_{
+      Clock::duration::max().count()};
+};
+
+}  // namespace kiwi::base
+
+#endif  // BASE_TASK_THREAD_POOL_H_
@@ -0,0 +1,263 @@
+// Copyright (C) 2026 Yisi Yu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#include "base/task/thread_pool.h"
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <latch>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "third_party/googletest-release-1.12.1/googletest/include/gtest/gtest.h"
+
+namespace kiwi::base {
+namespace testing {
+
+namespace {
+// BindOnce() doesn't take capturing lambdas, which tests use for brevity.
+template <typename Lambda>
+OnceClosure BindLambdaForTesting(Lambda lambda) {
+  return BindOnce([](Lambda lambda) { lambda(); }, std::move(lambda));
+}
+}  // namespace
+
+TEST(ThreadPoolTest, RunsAllTasks) {
+  constexpr int kTaskCount = 10000;
+  std::atomic<int> count{0};
+  std::latch done(kTaskCount);
+  ThreadPool pool(4);
+  for (int i = 0; i < kTaskCount; ++i) {
+    pool.PostTask(FROM_HERE, static_cast<TaskPriority>(i % 3),
+                  BindOnce(
+                      [](std::atomic<int>* count, std::latch* done) {
+                        ++*count;
+                        done->count_down();
+                      },
+                      &count, &done));
+  }
+  done.wait();
+  EXPECT_EQ(count, kTaskCount);
+}
+
+// Tasks posted by a worker go to its own deque, and idle workers steal them.
+TEST(ThreadPoolTest, StealsTasks) {
+  constexpr int kTaskCount = 16;
+  std::mutex lock;
+  std::set<std::thread::id> thread_ids;
+  std::latch done(kTaskCount);
+  ThreadPool pool(4);
+  pool.PostTask(
+      FROM_HERE, TaskPriority::kUserVisible,
+      BindLambdaForTesting([&] {
+        for (int i = 0; i < kTaskCount; ++i) {
+          pool.PostTask(FROM_HERE, TaskPriority::kUserVisible,
+                        BindLambdaForTesting([&] {
+                          std::this_thread::sleep_for(
+                              std::chrono::milliseconds(5));
+                          {
+                            std::lock_guard<std::mutex> guard(lock);
+                            thread_ids.insert(std::this_thread::get_id());
+                          }
+                          done.count_down();
+                        }));
+        }
+      }));
+  done.wait();
+  EXPECT_GT(thread_ids.size(), 1u);
+}
+
+TEST(ThreadPoolTest, HigherPrioritiesGoFirst) {
+  ThreadPool pool(1);
+  std::promise<void> started;
+  std::promise<void> unblock;
+  std::shared_future<void> unblocked = unblock.get_future().share();
+  pool.PostTask(FROM_HERE, TaskPriority::kBestEffort,
+                BindLambdaForTesting([&] {
+                  started.set_value();
+                  unblocked.wait();
+                }));
+  started.get_future().wait();
+
+  // The only worker is busy, so that these are queued.
+  std::vector<TaskPriority> order;
+  std::latch done(3);
+  for (TaskPriority priority :
+       {TaskPriority::kBestEffort, TaskPriority::kUserVisible,
+        TaskPriority::kUserBlocking}) {
+    pool.PostTask(FROM_HERE, priority, BindLambdaForTesting([&, priority] {
+                    order.push_back(priority);
+                    done.count_down();
+                  }));
+  }
+  unblock.set_value();
+  done.wait();
+  EXPECT_EQ(order,
+            std::vector<TaskPriority>({TaskPriority::kUserBlocking,
+                                       TaskPriority::kUserVisible,
+                                       TaskPriority::kBestEffort}));
+}
+
+TEST(ThreadPoolTest, SequencesKeepOrder) {
+  constexpr int kSequenceCount = 8;
+  constexpr int kTaskCount = 1000;
+  ThreadPool pool(4);
+  std::latch done(kSequenceCount);
+  std::vector<scoped_refptr<SequencedTaskRunner>> task_runners;
+  std::vector<std::vector<int>> results(kSequenceCount);
+  std::atomic<int> overlaps{0};
+  std::vector<std::atomic_bool> running(kSequenceCount);
+  for (int i = 0; i < kSequenceCount; ++i) {
+    task_runners.push_back(
+        pool.CreateSequencedTaskRunner(TaskPriority::kUserVisible));
+  }
+
+  for (int j = 0; j < kTaskCount; ++j) {
+    for (int i = 0; i < kSequenceCount; ++i) {
+      task_runners[i]->PostTask(FROM_HERE, BindLambdaForTesting([&, i, j] {
+                                  if (running[i].exchange(true))
+                                    ++overlaps;
+                                  EXPECT_TRUE(task_runners[i]
+                                                  ->RunsTasksInCurrentSequence());
+                                  results[i].push_back(j);
+                                  running[i] = false;
+                                  if (j == kTaskCount - 1)
+                                    done.count_down();
+                                }));
+    }
+  }
+  done.wait();
+
+  EXPECT_EQ(overlaps, 0);
+  for (const std::vector<int>& result : results) {
+    ASSERT_EQ(result.size(), static_cast<size_t>(kTaskCount));
+    for (int j = 0; j < kTaskCount; ++j)
+      ASSERT_EQ(result[j], j);
+  }
+}
+
+TEST(ThreadPoolTest, RepliesToOriginSequence) {
+  ThreadPool pool(4);
+  scoped_refptr<SequencedTaskRunner> origin =
+      pool.CreateSequencedTaskRunner(TaskPriority::kUserBlocking);
+  std::promise<bool> replied;
+  std::promise<int> result;
+  origin->PostTask(FROM_HERE, BindLambdaForTesting([&] {
+                     pool.PostTaskAndReply(
+                         FROM_HERE, TaskPriority::kUserBlocking, DoNothing(),
+                         BindLambdaForTesting([&] {
+                           replied.set_value(
+                               origin->RunsTasksInCurrentSequence());
+                         }));
+                     pool.PostTaskAndReplyWithResult(
+                         FROM_HERE, TaskPriority::kUserBlocking,
+                         BindOnce([] { return 42; }),
+                         BindOnce(
+                             [](scoped_refptr<SequencedTaskRunner> origin,
+                                std::promise<int>* result, int value) {
+                               EXPECT_TRUE(
+                                   origin->RunsTasksInCurrentSequence());
+                               result->set_value(value);
+                             },
+                             origin, &result));
+                   }));
+  EXPECT_TRUE(replied.get_future().get());
+  EXPECT_EQ(result.get_future().get(), 42);
+}
+
+TEST(ThreadPoolTest, DelayedTasks) {
+  ThreadPool pool(2);
+  scoped_refptr<SequencedTaskRunner> task_runner =
+      pool.CreateSequencedTaskRunner(TaskPriority::kUserVisible);
+  std::mutex lock;
+  std::vector<int> order;
+  std::latch done(3);
+  auto record = [&](int value) {
+    std::lock_guard<std::mutex> guard(lock);
+    order.push_back(value);
+    done.count_down();
+  };
+
+  // Delays are far apart, so that posting them doesn't take long enough to
+  // change their order.
+  auto start = std::chrono::steady_clock::now();
+  pool.PostDelayedTask(FROM_HERE, TaskPriority::kUserVisible,
+                       BindLambdaForTesting([&] { record(3); }),
+                       Milliseconds(150));
+  task_runner->PostDelayedTask(FROM_HERE,
+                               BindLambdaForTesting([&] { record(2); }),
+                               Milliseconds(100));
+  pool.PostDelayedTask(FROM_HERE, TaskPriority::kUserVisible,
+                       BindLambdaForTesting([&] { record(1); }),
+                       Milliseconds(50));
+  done.wait();
+  EXPECT_GE(std::chrono::steady_clock::now() - start,
+            std::chrono::milliseconds(150));
+  EXPECT_EQ(order, std::vector<int>({1, 2, 3}));
+}
+
+TEST(ThreadPoolTest, ShutdownRunsPostedTasks) {
+  constexpr int kTaskCount = 1000;
+  std::atomic<int> count{0};
+  std::vector<int> sequence;
+  {
+    ThreadPool pool(2);
+    scoped_refptr<SequencedTaskRunner> task_runner =
+        pool.CreateSequencedTaskRunner(TaskPriority::kBestEffort);
+    for (int i = 0; i < kTaskCount; ++i) {
+      pool.PostTask(FROM_HERE, TaskPriority::kBestEffort,
+                    BindLambdaForTesting([&] { ++count; }));
+      task_runner->PostTask(FROM_HERE,
+                            BindLambdaForTesting([&, i] {
+                              sequence.push_back(i);
+                            }));
+    }
+    // Delayed tasks which aren't due are dropped.
+    pool.PostDelayedTask(FROM_HERE, TaskPriority::kUserBlocking,
+                         BindLambdaForTesting([&] { ++count; }),
+                         Milliseconds(60 * 1000));
+  }
+  EXPECT_EQ(count, kTaskCount);
+  EXPECT_EQ(sequence.size(), static_cast<size_t>(kTaskCount));
+}
+
+// Every task runs while several threads post at once.
+TEST(ThreadPoolTest, Contention) {
+  constexpr int kProducerCount = 4;
+  constexpr int kTaskCount = 10000;
+  ThreadPool pool(4);
+  std::atomic<int> count{0};
+  std::latch done(kProducerCount * kTaskCount);
+
+  std::vector<std::thread> producers;
+  for (int i = 0; i < kProducerCount; ++i) {
+    producers.emplace_back([&] {
+      for (int j = 0; j < kTaskCount; ++j) {
+        pool.PostTask(FROM_HERE, TaskPriority::kUserVisible,
+                      BindLambdaForTesting([&] {
+                        ++count;
+                        done.count_down();
+                      }));
+      }
+    });
+  }
+  for (std::thread& producer : producers)
+    producer.join();
+  done.wait();
+  EXPECT_EQ(count, kProducerCount * kTaskCount);
+}
+
+}  // namespace testing
+}  // namespace kiwi::base
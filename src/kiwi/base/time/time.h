@@ -34,8 +34,15 @@ class BASE_EXPORT TimeDelta {
     return TimeDelta(delta);
   }
 
+  // The largest delta, which stands for forever.
+  static constexpr TimeDelta Max() {
+    return TimeDelta(std::chrono::microseconds::max().count());
+  }
+  constexpr bool is_max() const { return *this == Max(); }
+
   constexpr int64_t InSeconds() const;
   constexpr int64_t InMilliseconds() const;
+  constexpr int64_t InMillisecondsRoundedUp() const;
   constexpr int64_t InMicroseconds() const { return delta_.count(); }
   constexpr int64_t InNanoseconds() const;
 
@@ -46,6 +53,9 @@ class BASE_EXPORT TimeDelta {
   constexpr bool operator!=(TimeDelta other) const {
     return delta_ != other.delta_;
   }
+  constexpr bool operator<(TimeDelta other) const {
+    return delta_ < other.delta_;
+  }
 
  private:
   // Constructs a delta given the duration in microseconds. This is private
@@ -90,6 +100,10 @@ constexpr int64_t TimeDelta::InMilliseconds() const {
   return std::chrono::duration_cast<std::chrono::milliseconds>(delta_).count();
 }
 
+constexpr int64_t TimeDelta::InMillisecondsRoundedUp() const {
+  return std::chrono::ceil<std::chrono::milliseconds>(delta_).count();
+}
+
 constexpr int64_t TimeDelta::InNanoseconds() const {
   return std::chrono::duration_cast<std::chrono::nanoseconds>(delta_).count();
 }
@@ -12,6 +12,9 @@
 
 #include "nes/apu.h"
 
+#include <algorithm>
+#include <cmath>
+
 #include "base/logging.h"
 #include "nes/cpu_bus.h"
 #include "nes/emulator_impl.h"
@@ -26,29 +29,47 @@ constexpr long kNTSCClockRate = 1789773;
 constexpr int kAPUNTSCFrequency = 60;  // NTSC 60Hz
 constexpr auto kAPUFrameDuration =
     std::chrono::milliseconds(1000 / kAPUNTSCFrequency);
+// Samples are read out of the output buffer at the end of each frame, so it
+// holds two frames of them. Audio devices buffer them as they need.
+constexpr int kOutputBufferMS = 2 * 1000 / kAPUNTSCFrequency + 1;
+
+size_t GetBufferBytes(const Blip_Buffer& buffer) {
+  if (!buffer.buffer_)
+    return 0;
+  return (buffer.buffer_size_ + Blip_Buffer::widest_impulse_) *
+         sizeof(Blip_Buffer::buf_t_);
+}
 
-int ReadDMC(void* user_data, cpu_addr_t address) {
-  CPUBus* cpu_bus = reinterpret_cast<CPUBus*>(user_data);
-  return cpu_bus->Read(address);
+int DMCReader(void* user_data, cpu_addr_t address) {
+  APU* apu = reinterpret_cast<APU*>(user_data);
+  CHECK(apu);
+  return apu->ReadDMC(address);
 }
 
 void IRQNotifier(void* user_data) {
   APU* apu = reinterpret_cast<APU*>(user_data);
   CHECK(apu);
-  apu->RunIRQCallback();
+  apu->OnIRQChanged();
 }
 }  // namespace
 
-APU::APU(EmulatorImpl* emulator, CPUBus* cpu_bus)
-    : emulator_(emulator), cpu_bus_(cpu_bus) {
+APU::APU(EmulatorImpl* emulator, CPUBus* cpu_bus, Output output)
+    : output_(output), emulator_(emulator), cpu_bus_(cpu_bus) {
   CHECK(emulator_);
   CHECK(cpu_bus_);
+  apu_impl_.dmc_reader(&DMCReader, this);
+  apu_impl_.irq_notifier(&IRQNotifier, this);
   apu_impl_.reset(false);
-  buffer_.sample_rate(IODevices::AudioDevice::kFrequency,
-                      IODevices::AudioDevice::kBufferMS);
+  ScheduleEvents();
+  if (output_ == Output::kNone)
+    return;
+
+  buffer_.sample_rate(IODevices::AudioDevice::kFrequency, kOutputBufferMS);
   buffer_.clock_rate(kNTSCClockRate);
-  apu_impl_.output(&buffer_);
-  apu_impl_.dmc_reader(&ReadDMC, cpu_bus_);
+  // Synthesizes the first frame, until it's known whether there's an audio
+  // device.
+  has_audio_device_ = true;
+  UpdateSynthesizing();
 }
 
 APU::~APU() = default;
@@ -58,34 +79,71 @@ void APU::Reset() {
   // so clear_cycles() should be called as well.
   cycles_ = 0;
   apu_impl_.reset();
-  buffer_.clear();
+  ScheduleEvents();
+  if (output_ != Output::kNone)
+    buffer_.clear();
 }
 
 void APU::StepFrame() {
-  // APU runs at kNTSCFrequency. If frame rendered to fast, just return and do
-  // nothing.
   apu_impl_.end_frame(cycles_);
-  buffer_.end_frame(cycles_);
-  cycles_ = 0;
+  IODevices::AudioDevice* audio_device =
+      emulator_->GetIODevices() ? emulator_->GetIODevices()->audio_device()
+                                : nullptr;
+  if (synthesizing_) {
+    buffer_.end_frame(cycles_);
+
+    // All samples of the frame are sent, none is held back to the next frame.
+    while (buffer_.samples_avail() > 0) {
+      size_t count = buffer_.read_samples(out_buffer_, kOutBufferConstantSize);
+      if (!audio_device)
+        continue;
+      if (time_stretch_.ratio() > 1)
+        time_stretch_.Process(out_buffer_, count, &stretched_samples_);
+      else
+        audio_device->OnSampleArrived(out_buffer_, count);
+    }
+
+    if (!stretched_samples_.empty()) {
+      audio_device->OnSampleArrived(stretched_samples_.data(),
+                                    stretched_samples_.size());
+      stretched_samples_.clear();
+    }
 
-  while (buffer_.samples_avail() >= kOutBufferConstantSize) {
-    size_t count = buffer_.read_samples(out_buffer_, kOutBufferConstantSize);
-    if (emulator_->GetIODevices() &&
-        emulator_->GetIODevices()->audio_device()) {
-      emulator_->GetIODevices()->audio_device()->OnSampleArrived(out_buffer_,
-                                                                 count);
+    // Samples are resampled by the device's ratio, by telling the buffer that
+    // the APU runs slower or faster. It only changes between frames.
+    if (audio_device) {
+      double ratio = audio_device->GetSampleRateRatio();
+      DCHECK(ratio > 0);
+      long clock_rate = std::lround(kNTSCClockRate / ratio);
+      if (clock_rate != buffer_.clock_rate())
+        buffer_.clock_rate(clock_rate);
     }
   }
+  cycles_ = 0;
+  ScheduleEvents();
+
+  // Without an audio device, nothing is synthesized in the next frame.
+  has_audio_device_ = !!audio_device;
+  UpdateSynthesizing();
 }
 
 void APU::SetIRQCallback(IRQCallback irq_callback) {
   irq_callback_ = irq_callback;
-  apu_impl_.irq_notifier(IRQNotifier, this);
+  ScheduleEvents();
 }
 
-void APU::RunIRQCallback() {
-  if (irq_callback_)
-    irq_callback_.Run();
+void APU::SetDMCDMACallback(DMCDMACallback dmc_dma_callback) {
+  dmc_dma_callback_ = dmc_dma_callback;
+}
+
+void APU::OnIRQChanged() {
+  ScheduleEvents();
+}
+
+int APU::ReadDMC(Address address) {
+  if (!loading_snapshot_ && dmc_dma_callback_)
+    dmc_dma_callback_.Run();
+  return cpu_bus_->Read(address);
 }
 
 void APU::SetVolume(float volume) {
@@ -97,6 +155,21 @@ float APU::GetVolume() {
   return volume_;
 }
 
+void APU::SetOutputSuspended(bool suspended) {
+  output_suspended_ = suspended;
+  UpdateSynthesizing();
+}
+
+void APU::SetTimeStretch(double ratio) {
+  if (time_stretch_.ratio() == ratio)
+    return;
+
+  // Samples which are being stretched are dropped, they are a few
+  // milliseconds at most.
+  time_stretch_.Reset();
+  time_stretch_.SetRatio(ratio);
+}
+
 void APU::SetAudioChannels(int audio_channels) {
   apu_impl_.set_audio_channels(audio_channels);
 }
@@ -108,7 +181,9 @@ int APU::GetAudioChannels() {
 // Device:
 Byte APU::Read(Address address) {
   if (address == 0x4015) {
-    return apu_impl_.read_status(cycles_);
+    Byte status = apu_impl_.read_status(cycles_);
+    ScheduleEvents();
+    return status;
   }
 
   LOG(WARNING) << "Address $" << Hex<16>{address}
@@ -118,10 +193,76 @@ Byte APU::Read(Address address) {
 
 void APU::Write(Address address, Byte value) {
   apu_impl_.write_register(cycles_, address, value);
+  ScheduleEvents();
+}
+
+void APU::CopyStatesFrom(APU& other) {
+  // A snapshot is taken at the time the APU has run to, which may be behind
+  // |other|'s cycles. The copy starts its frame from there.
+  other.apu_impl_.run_until(other.cycles_);
+  apu_snapshot_t state = {};
+  other.apu_impl_.save_snapshot(&state);
+  // Only the samples waiting are cleared, the output buffer is large.
+  cycles_ = 0;
+  if (output_ != Output::kNone)
+    buffer_.clear(false);
+  loading_snapshot_ = true;
+  apu_impl_.load_snapshot(state);
+  loading_snapshot_ = false;
+  ScheduleEvents();
+  SetVolume(other.volume_);
+  SetAudioChannels(other.GetAudioChannels());
+}
+
+size_t APU::GetAllocatedBytes() {
+  return GetBufferBytes(buffer_);
+}
+
+void APU::UpdateSynthesizing() {
+  bool synthesizing =
+      output_ != Output::kNone && !output_suspended_ && has_audio_device_;
+  if (synthesizing_ == synthesizing)
+    return;
+
+  synthesizing_ = synthesizing;
+  if (!synthesizing) {
+    for (int i = 0; i < Nes_Apu::osc_count; ++i)
+      last_amps_[i] = apu_impl_.osc_last_amp(i);
+    apu_impl_.output(nullptr);
+  } else {
+    // Continues from the amplitudes which were output to |buffer_|, whatever
+    // they have become meanwhile.
+    apu_impl_.output(&buffer_);
+    for (int i = 0; i < Nes_Apu::osc_count; ++i)
+      apu_impl_.set_osc_last_amp(i, last_amps_[i]);
+  }
+}
+
+void APU::ScheduleEvents() {
+  irq_cycles_ = apu_impl_.earliest_irq();
+  dmc_read_cycles_ = apu_impl_.next_dmc_read_time();
+  // An IRQ which has come is no more an event, the line stays asserted.
+  next_event_cycles_ = irq_cycles_ > cycles_
+                           ? std::min(irq_cycles_, dmc_read_cycles_)
+                           : dmc_read_cycles_;
+  if (irq_callback_)
+    irq_callback_.Run(cycles_ >= irq_cycles_);
+}
+
+void APU::RunScheduledEvents() {
+  // Fetches the sample byte, which may raise DMC's IRQ.
+  if (cycles_ >= dmc_read_cycles_)
+    apu_impl_.run_until(cycles_);
+  ScheduleEvents();
 }
 
 void APU::Serialize(EmulatorStates::SerializableStateData& data) {
-  apu_snapshot_t state;
+  // Runs up to current cycle, so that states are loaded where they are saved.
+  apu_impl_.run_until(cycles_);
+
+  // Clears padding and unused fields, so that same states are always
+  // serialized into same bytes.
+  apu_snapshot_t state = {};
   apu_impl_.save_snapshot(&state);
   data.WriteData(state);
 }
@@ -129,10 +270,20 @@ void APU::Serialize(EmulatorStates::SerializableStateData& data) {
 bool APU::Deserialize(const EmulatorStates::Header& header,
                       EmulatorStates::DeserializableStateData& data) {
   if (header.version == 1) {
-    Reset();
+    // While the output is suspended, frames run ahead are being rolled back,
+    // and samples in |buffer_| which haven't been played are kept.
+    if (output_suspended_) {
+      cycles_ = 0;
+      apu_impl_.reset();
+    } else {
+      Reset();
+    }
     apu_snapshot_t state;
     data.ReadData(&state);
+    loading_snapshot_ = true;
     apu_impl_.load_snapshot(state);
+    loading_snapshot_ = false;
+    ScheduleEvents();
     return true;
   }
   return false;
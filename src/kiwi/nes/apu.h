@@ -14,9 +14,11 @@
 #define NES_APU_H_
 
 #include <chrono>
+#include <vector>
 
 #include "base/functional/callback.h"
 #include "nes/emulator_states.h"
+#include "nes/time_stretch.h"
 #include "nes/types.h"
 #include "third_party/nes_apu/Blip_Buffer.h"
 #include "third_party/nes_apu/Nes_Apu.h"
@@ -38,9 +40,25 @@ class APU : public Device, public EmulatorStates::SerializableState {
     kAll = kSquare_1 | kSquare_2 | kTriangle | kNoise | kDMC,
   };
 
-  using IRQCallback = base::RepeatingClosure;
+  // How samples are buffered before they are sent to the audio device.
+  enum class Output {
+    // The output buffer holds two frames of samples, which is enough, since
+    // samples are sent to the audio device every frame.
+    kDefault,
+    // There is no output buffer, and nothing is synthesized, like the output
+    // is always suspended.
+    kNone,
+  };
+
+  // Runs with whether the IRQ line is asserted, whenever it may have changed.
+  // Frame counter and DMC IRQs hold the line until they are acknowledged.
+  using IRQCallback = base::RepeatingCallback<void(bool)>;
+  // Runs when DMC fetches a sample byte, which halts the CPU.
+  using DMCDMACallback = base::RepeatingClosure;
 
-  explicit APU(EmulatorImpl* emulator, CPUBus* cpu_bus);
+  explicit APU(EmulatorImpl* emulator,
+               CPUBus* cpu_bus,
+               Output output = Output::kDefault);
   ~APU() override;
 
   enum {
@@ -48,12 +66,22 @@ class APU : public Device, public EmulatorStates::SerializableState {
   };
 
  public:
-  void increase_cycles() { ++cycles_; }
+  // IRQs and DMC fetches are scheduled at the cycles Nes_Apu predicts, so
+  // that it is only run when they come, or when its registers are accessed.
+  void increase_cycles() {
+    if (++cycles_ == next_event_cycles_)
+      RunScheduledEvents();
+  }
 
   void Reset();
   void StepFrame();
   void SetIRQCallback(IRQCallback irq_callback);
-  void RunIRQCallback();
+  void SetDMCDMACallback(DMCDMACallback dmc_dma_callback);
+
+  // Called by Nes_Apu when the time of the next IRQ may have changed.
+  void OnIRQChanged();
+  // Called by Nes_Apu when DMC fetches a sample byte.
+  int ReadDMC(Address address);
 
   void SetAudioChannels(int audio_channels);
   int GetAudioChannels();
@@ -61,25 +89,67 @@ class APU : public Device, public EmulatorStates::SerializableState {
   void SetVolume(float volume);
   float GetVolume();
 
+  // While the output is suspended, nothing is synthesized, and the output
+  // buffer is left untouched. Frames run ahead use it, so that rolling them
+  // back doesn't break the audio. Channels keep running as usual, because
+  // games can see their status, DMC fetches and IRQs. The output is suspended
+  // as well while there is no audio device.
+  void SetOutputSuspended(bool suspended);
+
+  // Shortens the output by |ratio| without changing its pitch, see
+  // TimeStretch. It is set while fast-forwarding, and 1 turns it off.
+  void SetTimeStretch(double ratio);
 
   // Device:
   Byte Read(Address address) override;
   void Write(Address address, Byte value) override;
 
+  // Copies the APU's states from |other|, which is brought up to current cycle
+  // first. Samples which haven't been played are not copied.
+  void CopyStatesFrom(APU& other);
+
+  // Bytes allocated for the output buffers, apart from the APU itself.
+  size_t GetAllocatedBytes();
+
   // EmulatorStates::SerializableState:
   void Serialize(EmulatorStates::SerializableStateData& data) override;
   bool Deserialize(const EmulatorStates::Header& header,
                    EmulatorStates::DeserializableStateData& data) override;
 
+ private:
+  // Starts or stops synthesis, by the output, whether it's suspended, and
+  // whether there's an audio device.
+  void UpdateSynthesizing();
+  // Finds when the next IRQ or DMC fetch comes, and updates the IRQ line.
+  void ScheduleEvents();
+  void RunScheduledEvents();
+
  private:
   int64_t cycles_ = 0;
+  // Cycles of the next IRQ, DMC fetch, and whichever comes first. They are
+  // Nes_Apu::no_irq if none is coming.
+  int64_t irq_cycles_ = Nes_Apu::no_irq;
+  int64_t dmc_read_cycles_ = Nes_Apu::no_irq;
+  int64_t next_event_cycles_ = Nes_Apu::no_irq;
+  // Whether a snapshot is being loaded, whose DMC fetches are not real.
+  bool loading_snapshot_ = false;
   Nes_Apu apu_impl_;
   Blip_Buffer buffer_;
+  Output output_ = Output::kDefault;
+  bool output_suspended_ = false;
+  // Whether there was an audio device at the end of last frame.
+  bool has_audio_device_ = false;
+  // Whether samples are synthesized into |buffer_| in this frame.
+  bool synthesizing_ = false;
+  int last_amps_[Nes_Apu::osc_count] = {0};
   EmulatorImpl* emulator_ = nullptr;
   CPUBus* cpu_bus_ = nullptr;
   IRQCallback irq_callback_;
+  DMCDMACallback dmc_dma_callback_;
   float volume_ = 1.f;
   blip_sample_t out_buffer_[kOutBufferConstantSize] = {0};
+  TimeStretch time_stretch_;
+  std::vector<Sample> stretched_samples_;
 };
 }  // namespace nes
 }  // namespace kiwi
@@ -0,0 +1,240 @@
+// Copyright (C) 2026 Yisi Yu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#include "kiwi/nes/apu.h"
+
+#include "kiwi/base/files/file_path.h"
+#include "kiwi/base/files/file_util.h"
+#include "kiwi/testing/rom_test.h"
+
+namespace kiwi {
+namespace nes {
+namespace testing {
+
+namespace {
+// Programs below count CPU cycles with X and Y in the main loop, from the last
+// APU register write until an IRQ comes. The IRQ handler keeps X at $10, Y at
+// $11, and the status read from $4015 at $12, and then halts.
+constexpr Address kNMIVector = 0xc031;
+constexpr Address kResetVector = 0xc000;
+constexpr Address kIRQVector = 0xc025;
+
+// The frame counter is restarted in 4-step mode, which raises IRQs. DMC loops
+// a byte at the highest rate, if it is enabled at kDMCEnableOffset.
+constexpr Byte kFrameIRQProgram[] = {
+    // Reset, at $C000
+    0x78,              // SEI
+    0xd8,              // CLD
+    0xa2, 0xff,        // LDX #$FF
+    0x9a,              // TXS
+    0xa9, 0x4f,        // LDA #$4F
+    0x8d, 0x10, 0x40,  // STA $4010
+    0xa9, 0x00,        // LDA #$00
+    0x8d, 0x13, 0x40,  // STA $4013
+    0xa9, 0x00,        // LDA #$00, DMC is enabled by $10
+    0x8d, 0x15, 0x40,  // STA $4015
+    0xa9, 0x00,        // LDA #$00
+    0x8d, 0x17, 0x40,  // STA $4017
+    0x58,              // CLI
+    0xa2, 0x00,        // LDX #$00
+    0xa0, 0x00,        // LDY #$00
+    // Main loop, at $C01E
+    0xe8,              // INX
+    0xd0, 0xfd,        // BNE $C01E
+    0xc8,              // INY
+    0x4c, 0x1e, 0xc0,  // JMP $C01E
+    // IRQ, at $C025
+    0x86, 0x10,        // STX $10
+    0x84, 0x11,        // STY $11
+    0xad, 0x15, 0x40,  // LDA $4015
+    0x85, 0x12,        // STA $12
+    0x4c, 0x2e, 0xc0,  // JMP $C02E
+    // NMI, at $C031
+    0x40,  // RTI
+};
+constexpr size_t kDMCEnableOffset = 0x10;
+// The value which is written to $4017.
+constexpr size_t kFrameCounterOffset = 0x15;
+
+// DMC plays 17 bytes at the highest rate, or at the rate in the low bits of
+// the byte at kDMCRateOffset, and raises IRQ when it has fetched the last one.
+// Frame IRQs are inhibited.
+constexpr Byte kDMCIRQProgram[] = {
+    // Reset, at $C000
+    0x78,              // SEI
+    0xd8,              // CLD
+    0xa2, 0xff,        // LDX #$FF
+    0x9a,              // TXS
+    0xa9, 0x8f,        // LDA #$8F
+    0x8d, 0x10, 0x40,  // STA $4010
+    0xa9, 0x01,        // LDA #$01
+    0x8d, 0x13, 0x40,  // STA $4013
+    0xa9, 0x40,        // LDA #$40
+    0x8d, 0x17, 0x40,  // STA $4017
+    0xa9, 0x10,        // LDA #$10
+    0x8d, 0x15, 0x40,  // STA $4015
+    0x58,              // CLI
+    0xa2, 0x00,        // LDX #$00
+    0xa0, 0x00,        // LDY #$00
+    // Main loop, at $C01E
+    0xe8,              // INX
+    0xd0, 0xfd,        // BNE $C01E
+    0xc8,              // INY
+    0x4c, 0x1e, 0xc0,  // JMP $C01E
+    // IRQ, at $C025
+    0x86, 0x10,        // STX $10
+    0x84, 0x11,        // STY $11
+    0xad, 0x15, 0x40,  // LDA $4015
+    0x85, 0x12,        // STA $12
+    0x4c, 0x2e, 0xc0,  // JMP $C02E
+    // NMI, at $C031
+    0x40,  // RTI
+};
+constexpr size_t kDMCRateOffset = 0x06;
+
+// Cycles of STA, CLI, LDX and LDY, from the last write until the main loop.
+constexpr int kSetupCycles = 4 + 2 + 2 + 2;
+// INX and BNE taken, and every 256 of them, BNE not taken, INY and JMP.
+constexpr int kLoopCycles = 2 + 3;
+constexpr int kYCycles = 255 * kLoopCycles + 2 + 2 + 2 + 3;
+
+// https://www.nesdev.org/wiki/APU_Frame_Counter
+constexpr int kFrameIRQCycles = 29830;
+// https://www.nesdev.org/wiki/APU_DMC, NTSC cycles of a bit at each rate.
+constexpr int kDMCRateBitCycles[] = {428, 380, 340, 320, 286, 254, 226, 214,
+                                     190, 160, 142, 128, 106, 84, 72, 54};
+// Rate $F, and rate $0 which DMC is at after power-up.
+constexpr int kDMCBitCycles = kDMCRateBitCycles[0xf];
+constexpr int kDMCByteCycles = kDMCBitCycles * 8;
+constexpr int kDMCPowerUpBitCycles = kDMCRateBitCycles[0];
+constexpr int kDMCDMACycles = 4;
+
+// blargg's apu_test ROMs, which are expected at testing/roms/apu_test/. They
+// report on $6000 like all_instrs.nes. A ROM which isn't there is skipped.
+constexpr const char* kAPUTestRoms[] = {
+    "1-len_ctr.nes",       "2-len_table.nes",       "3-irq_flag.nes",
+    "4-jitter.nes",        "5-len_timing.nes",      "6-irq_flag_timing.nes",
+    "7-dmc_basics.nes",    "8-dmc_rates.nes",
+};
+constexpr int kAPUTestRomFrames = 600;
+}  // namespace
+
+class APUTest : public RomTest {
+ protected:
+  // Runs |program| for a few frames, and returns the CPU cycles the main loop
+  // counted until the IRQ.
+  int RunUntilIRQ(const Byte* program, size_t size) {
+    Bytes rom =
+        CreateNROMForTesting(program, size, kNMIVector, kResetVector,
+                             kIRQVector);
+    emulator_->LoadFromBinary(rom, base::BindOnce([](bool success) {
+                                EXPECT_TRUE(success) << "Failed to load ROM";
+                              }));
+    emulator_->Run();
+    for (int i = 0; i < 3; ++i)
+      emulator_->RunOneFrame();
+    return kSetupCycles + debug_port_->CPUReadByte(0x11) * kYCycles +
+           debug_port_->CPUReadByte(0x10) * kLoopCycles;
+  }
+
+  Byte status() { return debug_port_->CPUReadByte(0x12); }
+};
+
+// The frame IRQ comes at the cycle the frame counter sets its flag, and the
+// CPU takes it at the next instruction.
+TEST_F(APUTest, FrameIRQTiming) {
+  int cycles = RunUntilIRQ(kFrameIRQProgram, sizeof(kFrameIRQProgram));
+  EXPECT_GE(cycles, kFrameIRQCycles);
+  EXPECT_LT(cycles, kFrameIRQCycles + kLoopCycles + 2);
+  EXPECT_EQ(status() & 0xc0, 0x40);
+}
+
+// DMC's IRQ comes when the last byte is fetched. The first byte is fetched
+// when DMC is enabled, and the next one when its output unit is free, which
+// is up to a byte later. The rate which is written only takes effect when the
+// timer reloads, which is up to a bit of the power-up rate later.
+TEST_F(APUTest, DMCIRQTiming) {
+  int cycles = RunUntilIRQ(kDMCIRQProgram, sizeof(kDMCIRQProgram));
+  // The main loop doesn't count cycles taken by DMA.
+  int dma_cycles = 17 * kDMCDMACycles;
+  EXPECT_GE(cycles, 15 * kDMCByteCycles - dma_cycles);
+  EXPECT_LT(cycles, 16 * kDMCByteCycles + kDMCPowerUpBitCycles - dma_cycles +
+                        kLoopCycles);
+  // The IRQ flag is set, and DMC is done.
+  EXPECT_EQ(status() & 0xd0, 0x80);
+}
+
+// Every rate delays DMC's IRQ by its own number of cycles a byte.
+TEST_F(APUTest, DMCRates) {
+  Bytes program(kDMCIRQProgram, kDMCIRQProgram + sizeof(kDMCIRQProgram));
+  for (int rate = 0; rate < 16; ++rate) {
+    program[kDMCRateOffset] = 0x80 | rate;
+    int cycles = RunUntilIRQ(program.data(), program.size());
+    int byte_cycles = kDMCRateBitCycles[rate] * 8;
+    int dma_cycles = 17 * kDMCDMACycles;
+    EXPECT_GE(cycles, 15 * byte_cycles - dma_cycles) << "rate " << rate;
+    EXPECT_LT(cycles, 16 * byte_cycles + kDMCPowerUpBitCycles - dma_cycles +
+                          kLoopCycles)
+        << "rate " << rate;
+    EXPECT_EQ(status() & 0xd0, 0x80) << "rate " << rate;
+  }
+}
+
+// The frame counter raises no IRQ in 5-step mode, nor when IRQs are inhibited,
+// so the IRQ handler never stores anything in the frames which are run.
+TEST_F(APUTest, NoFrameIRQ) {
+  Bytes program(kFrameIRQProgram, kFrameIRQProgram + sizeof(kFrameIRQProgram));
+  for (Byte frame_counter : {0x80, 0x40, 0xc0}) {
+    program[kFrameCounterOffset] = frame_counter;
+    EXPECT_EQ(RunUntilIRQ(program.data(), program.size()), kSetupCycles)
+        << "$4017=" << static_cast<int>(frame_counter);
+    EXPECT_EQ(status(), 0) << "$4017=" << static_cast<int>(frame_counter);
+  }
+}
+
+// Each byte DMC fetches halts the CPU, so the main loop counts fewer cycles
+// until the frame IRQ.
+TEST_F(APUTest, DMCDMAStealsCycles) {
+  int cycles = RunUntilIRQ(kFrameIRQProgram, sizeof(kFrameIRQProgram));
+
+  Bytes program(kFrameIRQProgram, kFrameIRQProgram + sizeof(kFrameIRQProgram));
+  program[kDMCEnableOffset] = 0x10;
+  int dmc_cycles = RunUntilIRQ(program.data(), program.size());
+  int fetches = kFrameIRQCycles / kDMCByteCycles;
+  EXPECT_NEAR(cycles - dmc_cycles, fetches * kDMCDMACycles,
+              kDMCDMACycles + kLoopCycles);
+  EXPECT_EQ(status() & 0x50, 0x50);
+}
+
+TEST_F(APUTest, APUTestRoms) {
+  base::FilePath rom_dir = base::FilePath(__FILE__)
+                               .DirName()
+                               .Append("../")
+                               .Append("testing")
+                               .Append("roms")
+                               .Append("apu_test");
+  int run_count = 0;
+  for (const char* name : kAPUTestRoms) {
+    base::FilePath rom_path = rom_dir.Append(name);
+    if (!base::PathExists(rom_path))
+      continue;
+    RomTestResult result = RunRom(rom_path, kAPUTestRomFrames);
+    EXPECT_EQ(result.status, 0x00) << name << ":\n" << result.output;
+    ++run_count;
+  }
+  if (!run_count)
+    GTEST_SKIP() << "No apu_test ROMs in " << rom_dir;
+}
+
+}  // namespace testing
+}  // namespace nes
+}  // namespace kiwi
@@ -65,6 +65,24 @@ void Cartridge::Reset() {
   }
 }
 
+scoped_refptr<Cartridge> Cartridge::Clone(EmulatorImpl* emulator) {
+  DCHECK(is_loaded_ && mapper_);
+  scoped_refptr<Cartridge> cartridge =
+      base::MakeRefCounted<Cartridge>(emulator);
+  cartridge->rom_path_ = rom_path_;
+  cartridge->rom_data_ = rom_data_;
+  cartridge->mapper_ = mapper_->Clone();
+  cartridge->crc_ = crc_;
+  cartridge->is_loaded_ = true;
+  return cartridge;
+}
+
+void Cartridge::CopyStatesFrom(const Cartridge& other) {
+  DCHECK(is_loaded_ && mapper_);
+  DCHECK(rom_data_ == other.rom_data_);
+  mapper_->CopyStatesFrom(*other.mapper_);
+}
+
 void Cartridge::Serialize(EmulatorStates::SerializableStateData& data) {
   data.WriteData(crc_);
   mapper()->Serialize(data);
@@ -89,7 +107,7 @@ Cartridge::LoadResult Cartridge::LoadFromFileOnIOThread(
   DCHECK(emulator_->is_power_on());
 
   DCHECK(!rom_data_);
-  rom_data_ = std::make_unique<RomData>();
+  rom_data_ = std::make_shared<RomData>();
 
   base::File rom_file(rom_path, base::File::FLAG_OPEN | base::File::FLAG_READ);
   if (!rom_file.IsValid()) {
@@ -159,7 +177,7 @@ Cartridge::LoadResult Cartridge::LoadFromDataOnIOThread(const Bytes& data) {
   DCHECK(emulator_->is_power_on());
 
   DCHECK(!rom_data_);
-  rom_data_ = std::make_unique<RomData>();
+  rom_data_ = std::make_shared<RomData>();
 
   const Byte* data_ptr = data.data();
   ProcessHeaders(data_ptr);
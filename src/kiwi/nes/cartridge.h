@@ -21,6 +21,7 @@
 #include "nes/types.h"
 
 #include <atomic>
+#include <memory>
 
 namespace kiwi {
 namespace nes {
@@ -70,6 +71,15 @@ class Cartridge : public base::RefCountedThreadSafe<Cartridge>,
 
   void Reset();
 
+  // Creates a cartridge for |emulator| with a copy of the mapper's states. ROM
+  // data is immutable once loaded, so it is shared instead of copied. The
+  // mapper's callbacks are not copied, and must be set by |emulator|.
+  scoped_refptr<Cartridge> Clone(EmulatorImpl* emulator);
+
+  // Copies the mapper's states of |other|, which is a clone of this cartridge
+  // or the cartridge cloned from, see Mapper::CopyStatesFrom().
+  void CopyStatesFrom(const Cartridge& other);
+
   // EmulatorStates::SerializableState:
   void Serialize(EmulatorStates::SerializableStateData& data) override;
   bool Deserialize(const EmulatorStates::Header& header,
@@ -92,7 +102,7 @@ class Cartridge : public base::RefCountedThreadSafe<Cartridge>,
   EmulatorImpl* emulator_ = nullptr;
   base::FilePath rom_path_;
   std::atomic_bool is_loaded_ = false;
-  std::unique_ptr<RomData> rom_data_;
+  std::shared_ptr<RomData> rom_data_;
   std::unique_ptr<Mapper> mapper_;
   uint32_t crc_ = 0;  // crc_ is the combination CRC32 of PRG and CHR
 };
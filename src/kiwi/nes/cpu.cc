@@ -54,6 +54,64 @@ constexpr Byte kOperationShift = 5;
   (((opcode)&kAddressModeMask) >> kAddressModeShift)
 
 #define IS_CROSSING_PAGE(a, b) ((a & 0xff00) != (b & 0xff00))
+
+// How an instruction in an idle loop reads memory. Only official instructions
+// which change nothing but registers are allowed.
+enum class IdleLoopRead {
+  kNotAllowed,
+  kNone,
+  kZeroPage,
+  kZeroPageX,
+  kZeroPageY,
+  kAbsolute,
+};
+
+IdleLoopRead GetIdleLoopRead(Byte opcode) {
+  switch (opcode) {
+    // LDA, LDX, LDY, CMP, CPX, CPY, AND, ORA, EOR, ADC, SBC #imm
+    case 0xa9: case 0xa2: case 0xa0: case 0xc9: case 0xe0: case 0xc0:
+    case 0x29: case 0x09: case 0x49: case 0x69: case 0xe9:
+    // TAX, TAY, TXA, TYA, TSX, CLC, SEC, CLV, NOP
+    case 0xaa: case 0xa8: case 0x8a: case 0x98: case 0xba: case 0x18:
+    case 0x38: case 0xb8: case 0xea:
+    // INX, DEX, INY, DEY, ASL A, LSR A, ROL A, ROR A
+    case 0xe8: case 0xca: case 0xc8: case 0x88: case 0x0a: case 0x4a:
+    case 0x2a: case 0x6a:
+    // BPL, BMI, BVC, BVS, BCC, BCS, BNE, BEQ, JMP abs
+    case 0x10: case 0x30: case 0x50: case 0x70: case 0x90: case 0xb0:
+    case 0xd0: case 0xf0: case 0x4c:
+      return IdleLoopRead::kNone;
+    // LDA, LDX, LDY, BIT, CMP, CPX, CPY, AND, ORA, EOR, ADC, SBC zp
+    case 0xa5: case 0xa6: case 0xa4: case 0x24: case 0xc5: case 0xe4:
+    case 0xc4: case 0x25: case 0x05: case 0x45: case 0x65: case 0xe5:
+      return IdleLoopRead::kZeroPage;
+    // LDA, LDY, CMP, AND, ORA, EOR, ADC, SBC zp,X
+    case 0xb5: case 0xb4: case 0xd5: case 0x35: case 0x15: case 0x55:
+    case 0x75: case 0xf5:
+      return IdleLoopRead::kZeroPageX;
+    // LDX zp,Y
+    case 0xb6:
+      return IdleLoopRead::kZeroPageY;
+    // LDA, LDX, LDY, BIT, CMP, CPX, CPY, AND, ORA, EOR, ADC, SBC abs
+    case 0xad: case 0xae: case 0xac: case 0x2c: case 0xcd: case 0xec:
+    case 0xcc: case 0x2d: case 0x0d: case 0x4d: case 0x6d: case 0xed:
+      return IdleLoopRead::kAbsolute;
+    default:
+      return IdleLoopRead::kNotAllowed;
+  }
+}
+
+// Idle loops run from the internal RAM or PRG ROM, which don't change while
+// the loop is replayed.
+bool IsIdleLoopCode(Address address) {
+  return address < 0x2000 || address >= 0x8000;
+}
+
+bool IsSameRegisters(const CPURegisters& a, const CPURegisters& b) {
+  // Registers are not compared by memcmp() because of their paddings.
+  return a.A == b.A && a.X == b.X && a.Y == b.Y && a.PC == b.PC &&
+         a.S == b.S && a.P.value == b.P.value;
+}
 }  // namespace
 
 // Define ENABLE_DCHECK_OPCODE to enable debugging opcode checking runtime. It
@@ -75,6 +133,7 @@ CPU::CPU(CPUBus* cpu_bus) : cpu_bus_(cpu_bus) {
 CPU::~CPU() = default;
 
 void CPU::PowerUp() {
+  ResetIdleLoop();
   registers_.P.value = 0x34;
   registers_.A = registers_.X = registers_.Y = 0;
   registers_.S = 0xfd;
@@ -82,6 +141,7 @@ void CPU::PowerUp() {
 
 void CPU::Reset() {
   PowerUp();
+  ResetIdleLoop();
   registers_.PC = cpu_bus_->ReadWord(kResetVector);
   has_break_ = false;
 }
@@ -105,12 +165,6 @@ void CPU::Interrupt(InterruptType type) {
 }
 
 void CPU::Step() {
-  struct M2CylceIRQNotifier {
-    M2CylceIRQNotifier(CPUBus* cpu_bus) : cpu_bus_(cpu_bus) {}
-    ~M2CylceIRQNotifier() { cpu_bus_->GetMapper()->M2CycleIRQ(); }
-    CPUBus* cpu_bus_;
-  } notifier(cpu_bus_);
-
   if (--cycles_to_skip_ >= 0) {
     if (observer_)
       observer_->OnCPUStepped();
@@ -120,12 +174,14 @@ void CPU::Step() {
 
   // Handle NMI first because it has higher priority.
   if (pending_NMI_) {
+    ResetIdleLoop();
     InterruptSequence(InterruptType::NMI);
     pending_NMI_ = pending_IRQ_ = false;
     if (observer_)
       observer_->OnCPUStepped();
     return;
-  } else if (pending_IRQ_) {
+  } else if (pending_IRQ_ || (irq_line_ && !registers_.P.I)) {
+    ResetIdleLoop();
     InterruptSequence(InterruptType::IRQ);
     pending_NMI_ = pending_IRQ_ = false;
     if (observer_)
@@ -148,12 +204,31 @@ void CPU::Step() {
     }
   }
 
-  Opcode opcode = static_cast<Opcode>(cpu_bus_->Read(registers_.PC));
+  if (idle_loop_.state == IdleLoop::State::kReplaying && ReplayIdleLoop()) {
+    if (observer_)
+      observer_->OnCPUStepped();
+    return;
+  }
+
+  Address address = registers_.PC;
+  instruction_ = Decode(address);
+  instruction_address_ = address;
+  Opcode opcode = static_cast<Opcode>(Read(registers_.PC));
+
+  // Reads are peeked before the instruction is executed, for reading may
+  // change them.
+  IdleLoopStep idle_loop_step;
+  if (idle_loop_.state != IdleLoop::State::kNone &&
+      !PeekIdleLoopStep(opcode, &idle_loop_step)) {
+    ResetIdleLoop();
+  }
 
   // opcode has been fetched. Now PC goes to the next address.
   ++registers_.PC;
 
-  int64_t cycle_length = GetOpcodeCycle(static_cast<uint8_t>(opcode));
+  int64_t cycle_length = instruction_
+                             ? instruction_->cycles
+                             : GetOpcodeCycle(static_cast<uint8_t>(opcode));
   DCHECK(cycle_length > 0);
   if (cycle_length && Execute(opcode)) {
     cycles_to_skip_ += (cycle_length - 1);  // One cycle has been spent on this
@@ -162,6 +237,14 @@ void CPU::Step() {
                << GetOpcodeName(static_cast<uint8_t>(opcode)) << " ($"
                << Hex<8>{static_cast<uint8_t>(opcode)} << ")";
   }
+  instruction_ = nullptr;
+
+  if (idle_loop_.state != IdleLoop::State::kNone) {
+    idle_loop_step.cycles = cycles_to_skip_ + 1;
+    RecordIdleLoopStep(idle_loop_step);
+  } else if (idle_loop_enabled_) {
+    DetectIdleLoop(opcode, address);
+  }
 
   if (observer_)
     observer_->OnCPUStepped();
@@ -179,6 +262,32 @@ void CPU::SkipDMACycles() {
   cycles_to_skip_ += (cycles_to_skip_ & 1);
 }
 
+void CPU::SkipDMCDMACycles() {
+  // https://www.nesdev.org/wiki/APU_DMC#Memory_reader
+  // It takes 4 cycles mostly, and 3 if the CPU is writing. Instructions are
+  // executed in their first cycle here, so it's always 4.
+  cycles_to_skip_ += 4;
+}
+
+void CPU::SetDecodedInstructionCacheEnabled(bool enabled) {
+  if (!enabled)
+    decoded_instructions_.reset();
+  else if (!decoded_instructions_)
+    decoded_instructions_ =
+        std::make_unique<DecodedInstruction[]>(kDecodedInstructionCount);
+}
+
+size_t CPU::GetAllocatedBytes() {
+  return decoded_instructions_
+             ? kDecodedInstructionCount * sizeof(DecodedInstruction)
+             : 0;
+}
+
+void CPU::set_idle_loop_enabled(bool enabled) {
+  idle_loop_enabled_ = enabled;
+  ResetIdleLoop();
+}
+
 void CPU::SetObserver(CPUObserver* observer) {
   observer_ = observer;
 }
@@ -187,6 +296,15 @@ void CPU::RemoveObserver() {
   observer_ = nullptr;
 }
 
+void CPU::CopyStatesFrom(const CPU& other) {
+  registers_ = other.registers_;
+  pending_NMI_ = other.pending_NMI_;
+  pending_IRQ_ = other.pending_IRQ_;
+  cycles_to_skip_ = other.cycles_to_skip_;
+  last_address_ = other.last_address_;
+  ResetIdleLoop();
+}
+
 void CPU::Serialize(EmulatorStates::SerializableStateData& data) {
   data.WriteData(registers_)
       .WriteData(pending_NMI_)
@@ -203,6 +321,7 @@ bool CPU::Deserialize(const EmulatorStates::Header& header,
         .ReadData(&pending_IRQ_)
         .ReadData(&cycles_to_skip_)
         .ReadData(&last_address_);
+    ResetIdleLoop();
     return true;
   }
 
@@ -246,17 +365,63 @@ void CPU::PopPC() {
   registers_.PC |= Pop() << 8;
 }
 
+Byte CPU::Read(Address address) {
+  if (instruction_) {
+    Address offset = static_cast<Address>(address - instruction_address_);
+    if (offset < kMaxInstructionLength)
+      return instruction_->bytes[offset];
+  }
+  return cpu_bus_->Read(address);
+}
+
+Word CPU::ReadWord(Address address) {
+  return Read(address) | Read(address + 1) << 8;
+}
+
 void CPU::SetZN(Byte value) {
   registers_.P.Z = !value;
   registers_.P.N = (value & 0x80) ? 1 : 0;
 }
 
 bool CPU::Execute(Opcode opcode) {
-  return ExecuteMove(opcode) || ExecuteArithmetic(opcode) ||
-         ExecuteJumpFlags(opcode) || ExecuteBlock0(static_cast<Byte>(opcode)) ||
-         ExecuteBlock1(static_cast<Byte>(opcode)) ||
-         ExecuteBlock2(static_cast<Byte>(opcode)) ||
-         ExecuteBlock3(static_cast<Byte>(opcode));
+  Executor& executor = executors_[static_cast<Byte>(opcode)];
+  switch (executor) {
+    case Executor::kMove:
+      return ExecuteMove(opcode);
+    case Executor::kArithmetic:
+      return ExecuteArithmetic(opcode);
+    case Executor::kJumpFlags:
+      return ExecuteJumpFlags(opcode);
+    case Executor::kBlock0:
+      return ExecuteBlock0(static_cast<Byte>(opcode));
+    case Executor::kBlock1:
+      return ExecuteBlock1(static_cast<Byte>(opcode));
+    case Executor::kBlock2:
+      return ExecuteBlock2(static_cast<Byte>(opcode));
+    case Executor::kBlock3:
+      return ExecuteBlock3(static_cast<Byte>(opcode));
+    case Executor::kUnknown:
+      break;
+  }
+
+  // The first time an opcode is executed, tries each part in order.
+  if (ExecuteMove(opcode))
+    executor = Executor::kMove;
+  else if (ExecuteArithmetic(opcode))
+    executor = Executor::kArithmetic;
+  else if (ExecuteJumpFlags(opcode))
+    executor = Executor::kJumpFlags;
+  else if (ExecuteBlock0(static_cast<Byte>(opcode)))
+    executor = Executor::kBlock0;
+  else if (ExecuteBlock1(static_cast<Byte>(opcode)))
+    executor = Executor::kBlock1;
+  else if (ExecuteBlock2(static_cast<Byte>(opcode)))
+    executor = Executor::kBlock2;
+  else if (ExecuteBlock3(static_cast<Byte>(opcode)))
+    executor = Executor::kBlock3;
+  else
+    return false;
+  return true;
 }
 
 bool CPU::ExecuteJumpFlags(Opcode opcode) {
@@ -302,7 +467,7 @@ bool CPU::ExecuteJumpFlags(Opcode opcode) {
       break;
     case Opcode::JSR:
       PushNextPC();
-      registers_.PC = cpu_bus_->ReadWord(registers_.PC);
+      registers_.PC = ReadWord(registers_.PC);
       break;
     case Opcode::RTS:
       PopPC();
@@ -313,13 +478,13 @@ bool CPU::ExecuteJumpFlags(Opcode opcode) {
       PopPC();
       break;
     case Opcode::JMP:
-      registers_.PC = cpu_bus_->ReadWord(registers_.PC);
+      registers_.PC = ReadWord(registers_.PC);
       break;
     case Opcode::JMPI: {
-      Address location = cpu_bus_->ReadWord(registers_.PC);
+      Address location = ReadWord(registers_.PC);
       Address page = location & 0xff00;
-      registers_.PC = cpu_bus_->Read(location) |
-                      cpu_bus_->Read(page | ((location + 1) & 0xff)) << 8;
+      registers_.PC = Read(location) |
+                      Read(page | ((location + 1) & 0xff)) << 8;
     } break;
     case Opcode::BPL:
     case Opcode::BMI:
@@ -349,7 +514,7 @@ bool CPU::ExecuteJumpFlags(Opcode opcode) {
 
       if (branch) {
         // The branch is met.
-        int8_t offset = cpu_bus_->Read(registers_.PC++);
+        int8_t offset = Read(registers_.PC++);
         // add 1 cycle on branches if taken.
         ++cycles_to_skip_;
         auto new_pc = static_cast<Address>(registers_.PC + offset);
@@ -539,7 +704,7 @@ bool CPU::ExecuteBlock0(Byte opcode) {
     switch (static_cast<Operation0>(OPCODE_ROW_IN_BLOCK(opcode))) {
       case Operation0::BIT:
         DCHECK_OPCODE_BY_NAME(opcode, BIT);
-        operand = cpu_bus_->Read(location);
+        operand = Read(location);
         registers_.P.Z = !(registers_.A & operand);
         registers_.P.V = (operand & 0x40) ? 1 : 0;
         registers_.P.N = (operand & 0x80) ? 1 : 0;
@@ -550,18 +715,18 @@ bool CPU::ExecuteBlock0(Byte opcode) {
         break;
       case Operation0::LDY:
         DCHECK_OPCODE_BY_NAME(opcode, LDY);
-        registers_.Y = cpu_bus_->Read(location);
+        registers_.Y = Read(location);
         SetZN(registers_.Y);
         break;
       case Operation0::CPY: {
         DCHECK_OPCODE_BY_NAME(opcode, CPY);
-        uint16_t diff = registers_.Y - cpu_bus_->Read(location);
+        uint16_t diff = registers_.Y - Read(location);
         registers_.P.C = !(diff & 0x100);
         SetZN(static_cast<Byte>(diff));
       } break;
       case Operation0::CPX: {
         DCHECK_OPCODE_BY_NAME(opcode, CPX);
-        uint16_t diff = registers_.X - cpu_bus_->Read(location);
+        uint16_t diff = registers_.X - Read(location);
         registers_.P.C = !(diff & 0x100);
         SetZN(static_cast<Byte>(diff));
       } break;
@@ -644,22 +809,22 @@ bool CPU::ExecuteBlock1(Byte opcode) {
     switch (op) {
       case Operation1::ORA:
         DCHECK_OPCODE_BY_NAME(opcode, ORA);
-        registers_.A |= cpu_bus_->Read(location);
+        registers_.A |= Read(location);
         SetZN(registers_.A);
         break;
       case Operation1::AND:
         DCHECK_OPCODE_BY_NAME(opcode, AND);
-        registers_.A &= cpu_bus_->Read(location);
+        registers_.A &= Read(location);
         SetZN(registers_.A);
         break;
       case Operation1::EOR:
         DCHECK_OPCODE_BY_NAME(opcode, EOR);
-        registers_.A ^= cpu_bus_->Read(location);
+        registers_.A ^= Read(location);
         SetZN(registers_.A);
         break;
       case Operation1::ADC: {
         DCHECK_OPCODE_BY_NAME(opcode, ADC);
-        uint16_t operand = cpu_bus_->Read(location);
+        uint16_t operand = Read(location);
         uint16_t sum = registers_.A + operand + registers_.P.C;
         // Carry forward or UNSIGNED overflow
         registers_.P.C = (sum > 0xff) ? 1 : 0;
@@ -674,12 +839,12 @@ bool CPU::ExecuteBlock1(Byte opcode) {
         break;
       case Operation1::LDA:
         DCHECK_OPCODE_BY_NAME(opcode, LDA);
-        registers_.A = cpu_bus_->Read(location);
+        registers_.A = Read(location);
         SetZN(registers_.A);
         break;
       case Operation1::SBC: {
         DCHECK_OPCODE_BY_NAME(opcode, SBC);
-        uint16_t operand = cpu_bus_->Read(location);
+        uint16_t operand = Read(location);
         uint16_t diff = registers_.A - operand - (1 - registers_.P.C);
         registers_.P.C = diff < 0x100;
         registers_.P.V =
@@ -689,7 +854,7 @@ bool CPU::ExecuteBlock1(Byte opcode) {
       } break;
       case Operation1::CMP: {
         DCHECK_OPCODE_BY_NAME(opcode, CMP);
-        uint16_t diff = registers_.A - cpu_bus_->Read(location);
+        uint16_t diff = registers_.A - Read(location);
         registers_.P.C = !(diff & 0x100);
         SetZN(static_cast<Byte>(diff));
       } break;
@@ -783,7 +948,7 @@ bool CPU::ExecuteBlock2(Byte opcode) {
           SetZN(registers_.A);
         } else {
           auto prev_C = registers_.P.C;
-          uint16_t operand = cpu_bus_->Read(location);
+          uint16_t operand = Read(location);
           registers_.P.C = (operand & 0x80) ? 1 : 0;
           operand = operand << 1 | (prev_C && (op == Operation2::ROL));
           SetZN(static_cast<Byte>(operand));
@@ -806,7 +971,7 @@ bool CPU::ExecuteBlock2(Byte opcode) {
           SetZN(registers_.A);
         } else {
           auto prev_C = registers_.P.C;
-          uint16_t operand = cpu_bus_->Read(location);
+          uint16_t operand = Read(location);
           registers_.P.C = operand & 1;
           operand = operand >> 1 | (prev_C && (op == Operation2::ROR)) << 7;
           SetZN(static_cast<Byte>(operand));
@@ -819,18 +984,18 @@ bool CPU::ExecuteBlock2(Byte opcode) {
         break;
       case Operation2::LDX:
         DCHECK_OPCODE_BY_NAME(opcode, LDX);
-        registers_.X = cpu_bus_->Read(location);
+        registers_.X = Read(location);
         SetZN(registers_.X);
         break;
       case Operation2::DEC: {
         DCHECK_OPCODE_BY_NAME(opcode, DEC);
-        auto operand = cpu_bus_->Read(location) - 1;
+        auto operand = Read(location) - 1;
         SetZN(operand);
         cpu_bus_->Write(location, operand);
       } break;
       case Operation2::INC: {
         DCHECK_OPCODE_BY_NAME(opcode, INC);
-        auto operand = cpu_bus_->Read(location) + 1;
+        auto operand = Read(location) + 1;
         SetZN(operand);
         cpu_bus_->Write(location, operand);
       } break;
@@ -853,7 +1018,7 @@ bool CPU::ExecuteBlock3(Byte opcode) {
     case Opcode::ANC_1: {
       DCHECK_OPCODE_ADDRESSING_MODE(opcode, AddressingMode::kIMM);
       Address location = Addressing(AddressingMode::kIMM, is_page_crossed);
-      registers_.A &= cpu_bus_->Read(location);
+      registers_.A &= Read(location);
       SetZN(registers_.A);
       registers_.P.C = registers_.P.N;
       return true;
@@ -861,7 +1026,7 @@ bool CPU::ExecuteBlock3(Byte opcode) {
     case Opcode::LAS: {
       DCHECK_OPCODE_ADDRESSING_MODE(opcode, AddressingMode::kABY);
       Address location = Addressing(AddressingMode::kABY, is_page_crossed);
-      Byte operand = cpu_bus_->Read(location);
+      Byte operand = Read(location);
       registers_.A = registers_.X = registers_.S = (registers_.S & operand);
       SetZN(registers_.A);
       return true;
@@ -869,7 +1034,7 @@ bool CPU::ExecuteBlock3(Byte opcode) {
     case Opcode::ALR: {
       DCHECK_OPCODE_ADDRESSING_MODE(opcode, AddressingMode::kIMM);
       Address location = Addressing(AddressingMode::kIMM, is_page_crossed);
-      Byte operand = cpu_bus_->Read(location);
+      Byte operand = Read(location);
       operand &= registers_.A;
       registers_.P.C = operand & 0x01;
       registers_.A = operand >> 1;
@@ -879,7 +1044,7 @@ bool CPU::ExecuteBlock3(Byte opcode) {
     case Opcode::ARR: {
       DCHECK_OPCODE_ADDRESSING_MODE(opcode, AddressingMode::kIMM);
       Address location = Addressing(AddressingMode::kIMM, is_page_crossed);
-      Byte operand = cpu_bus_->Read(location);
+      Byte operand = Read(location);
       operand &= registers_.A;
       registers_.A = (operand >> 1) | (registers_.P.C << 7);
       SetZN(registers_.A);
@@ -891,7 +1056,7 @@ bool CPU::ExecuteBlock3(Byte opcode) {
       DCHECK_OPCODE_ADDRESSING_MODE(opcode, AddressingMode::kIMM);
       Address location = Addressing(AddressingMode::kIMM, is_page_crossed);
       uint16_t result =
-          (registers_.A & registers_.X) - cpu_bus_->Read(location);
+          (registers_.A & registers_.X) - Read(location);
       registers_.P.C = (result < 0x100) ? 1 : 0;
       registers_.X = result & 0xff;
       SetZN(registers_.X);
@@ -981,7 +1146,7 @@ bool CPU::ExecuteBlock3(Byte opcode) {
     switch (op) {
       case Operation3::SLO: {
         DCHECK_OPCODE_BY_NAME(opcode, SLO);
-        Byte operand = cpu_bus_->Read(location);
+        Byte operand = Read(location);
         registers_.P.C = (operand & 0x80) ? 1 : 0;
         operand <<= 1;
         registers_.A |= operand;
@@ -990,7 +1155,7 @@ bool CPU::ExecuteBlock3(Byte opcode) {
       } break;
       case Operation3::RLA: {
         DCHECK_OPCODE_BY_NAME(opcode, RLA);
-        Byte operand = cpu_bus_->Read(location);
+        Byte operand = Read(location);
         if (registers_.P.C) {
           registers_.P.C = (operand & 0x80) ? 1 : 0;
           operand = (operand << 1) | 1;
@@ -1004,7 +1169,7 @@ bool CPU::ExecuteBlock3(Byte opcode) {
       } break;
       case Operation3::SRE: {
         DCHECK_OPCODE_BY_NAME(opcode, SRE);
-        Byte operand = cpu_bus_->Read(location);
+        Byte operand = Read(location);
         registers_.P.C = (operand & 0x01) ? 1 : 0;
         operand >>= 1;
         registers_.A ^= operand;
@@ -1013,7 +1178,7 @@ bool CPU::ExecuteBlock3(Byte opcode) {
       } break;
       case Operation3::RRA: {
         DCHECK_OPCODE_BY_NAME(opcode, RRA);
-        Byte operand = cpu_bus_->Read(location);
+        Byte operand = Read(location);
         if (registers_.P.C) {
           registers_.P.C = (operand & 0x01) ? 1 : 0;
           operand = (operand >> 1) | 0x80;
@@ -1037,13 +1202,13 @@ bool CPU::ExecuteBlock3(Byte opcode) {
       } break;
       case Operation3::LAX: {
         DCHECK_OPCODE_BY_NAME(opcode, LAX);
-        registers_.A = cpu_bus_->Read(location);
+        registers_.A = Read(location);
         registers_.X = registers_.A;
         SetZN(registers_.A);
       } break;
       case Operation3::DCP: {
         DCHECK_OPCODE_BY_NAME(opcode, DCP);
-        Byte operand = cpu_bus_->Read(location) - 1;
+        Byte operand = Read(location) - 1;
         uint16_t diff = registers_.A - operand;
         registers_.P.C = ((diff & 0x8000) == 0) ? 1 : 0;
         SetZN(static_cast<Byte>(diff));
@@ -1052,7 +1217,7 @@ bool CPU::ExecuteBlock3(Byte opcode) {
       case Operation3::ISC: {
         DCHECK_OPCODE_BY_NAME(opcode, ISC);
         // INC
-        Byte operand = cpu_bus_->Read(location) + 1;
+        Byte operand = Read(location) + 1;
         cpu_bus_->Write(location, operand);
         // SBC
         uint16_t diff = registers_.A - operand - (1 - registers_.P.C);
@@ -1112,25 +1277,25 @@ Address CPU::Addressing(AddressingMode mode, bool& is_page_crossed) {
       return registers_.PC++;
     }
     case AddressingMode::kZP: {
-      return cpu_bus_->Read(registers_.PC++);
+      return Read(registers_.PC++);
     }
     case AddressingMode::kZPX: {
-      Address location = cpu_bus_->Read(registers_.PC++);
+      Address location = Read(registers_.PC++);
       location = (location + registers_.X) & 0xff;
       return location;
     }
     case AddressingMode::kZPY: {
-      Address location = cpu_bus_->Read(registers_.PC++);
+      Address location = Read(registers_.PC++);
       location = (location + registers_.Y) & 0xff;
       return location;
     }
     case AddressingMode::kABS: {
-      Address location = cpu_bus_->ReadWord(registers_.PC);
+      Address location = ReadWord(registers_.PC);
       registers_.PC += 2;
       return location;
     }
     case AddressingMode::kABX: {
-      Address location = cpu_bus_->ReadWord(registers_.PC);
+      Address location = ReadWord(registers_.PC);
       registers_.PC += 2;
       Byte index = registers_.X;
       is_page_crossed = IS_CROSSING_PAGE(location, location + index);
@@ -1138,7 +1303,7 @@ Address CPU::Addressing(AddressingMode mode, bool& is_page_crossed) {
       return location;
     }
     case AddressingMode::kABY: {
-      Address location = cpu_bus_->ReadWord(registers_.PC);
+      Address location = ReadWord(registers_.PC);
       registers_.PC += 2;
       Byte index = registers_.Y;
       is_page_crossed = IS_CROSSING_PAGE(location, location + index);
@@ -1146,12 +1311,12 @@ Address CPU::Addressing(AddressingMode mode, bool& is_page_crossed) {
       return location;
     }
     case AddressingMode::kIZX: {
-      Byte zero_addr = registers_.X + cpu_bus_->Read(registers_.PC++);
+      Byte zero_addr = registers_.X + Read(registers_.PC++);
       return cpu_bus_->Read(zero_addr & 0xff) |
              cpu_bus_->Read((zero_addr + 1) & 0xff) << 8;
     }
     case AddressingMode::kIZY: {
-      Byte zero_addr = cpu_bus_->Read(registers_.PC++);
+      Byte zero_addr = Read(registers_.PC++);
       Address location = cpu_bus_->Read(zero_addr & 0xff) |
                          cpu_bus_->Read((zero_addr + 1) & 0xff) << 8;
       is_page_crossed = IS_CROSSING_PAGE(location, location + registers_.Y);
@@ -1169,5 +1334,129 @@ Address CPU::Addressing(AddressingMode mode, bool& is_page_crossed) {
   }
 }
 
+const CPU::DecodedInstruction* CPU::Decode(Address address) {
+  // Only PRG-ROM is cached. Instructions at its last bytes are not, for they
+  // may wrap around to RAM.
+  if (!decoded_instructions_ || address < kDecodedInstructionBase ||
+      address > 0x10000 - kMaxInstructionLength) {
+    return nullptr;
+  }
+
+  uint32_t generation = cpu_bus_->prg_generation();
+  if (!generation)
+    return nullptr;
+
+  DecodedInstruction& instruction =
+      decoded_instructions_[address - kDecodedInstructionBase];
+  if (instruction.generation != generation) {
+    for (int i = 0; i < kMaxInstructionLength; ++i)
+      instruction.bytes[i] = cpu_bus_->Read(address + i);
+    instruction.cycles = GetOpcodeCycle(instruction.bytes[0]);
+    instruction.generation = generation;
+  }
+  return &instruction;
+}
+
+bool CPU::PeekIdleLoopStep(Opcode opcode, IdleLoopStep* step) {
+  step->registers = registers_;
+  step->has_read = false;
+  // The operand follows the opcode, at PC + 1.
+  Address operand = registers_.PC + 1;
+  switch (GetIdleLoopRead(static_cast<Byte>(opcode))) {
+    case IdleLoopRead::kNotAllowed:
+      return false;
+    case IdleLoopRead::kNone:
+      return true;
+    case IdleLoopRead::kZeroPage:
+      step->read_address = Read(operand);
+      break;
+    case IdleLoopRead::kZeroPageX:
+      step->read_address = (Read(operand) + registers_.X) & 0xff;
+      break;
+    case IdleLoopRead::kZeroPageY:
+      step->read_address = (Read(operand) + registers_.Y) & 0xff;
+      break;
+    case IdleLoopRead::kAbsolute:
+      step->read_address = ReadWord(operand);
+      break;
+  }
+  step->has_read = true;
+  return cpu_bus_->Peek(step->read_address, &step->read_value);
+}
+
+void CPU::RecordIdleLoopStep(const IdleLoopStep& step) {
+  DCHECK(idle_loop_.state == IdleLoop::State::kRecording);
+  Address address = step.registers.PC;
+  if (address < idle_loop_.start || address > idle_loop_.end ||
+      idle_loop_.count == kMaxIdleLoopSteps) {
+    ResetIdleLoop();
+    return;
+  }
+
+  idle_loop_.steps[idle_loop_.count++] = step;
+  if (registers_.PC == idle_loop_.start) {
+    if (IsSameRegisters(registers_, idle_loop_.steps[0].registers)) {
+      idle_loop_.state = IdleLoop::State::kReplaying;
+      idle_loop_.index = 0;
+    } else {
+      // Registers are changed by the loop, such as a counter. Records again
+      // from here, until they are stable.
+      idle_loop_.count = 0;
+    }
+  }
+}
+
+void CPU::DetectIdleLoop(Opcode opcode, Address address) {
+  switch (opcode) {
+    case Opcode::BPL:
+    case Opcode::BMI:
+    case Opcode::BVC:
+    case Opcode::BVS:
+    case Opcode::BCC:
+    case Opcode::BCS:
+    case Opcode::BNE:
+    case Opcode::BEQ:
+    case Opcode::JMP:
+      break;
+    default:
+      return;
+  }
+
+  Address target = registers_.PC;
+  if (target > address || address - target >= kMaxIdleLoopBytes ||
+      !IsIdleLoopCode(target) || !IsIdleLoopCode(address)) {
+    return;
+  }
+
+  // Fetching instructions from MMC5 may switch banks, which can't be skipped.
+  if (cpu_bus_->GetMapper()->HasPRGReadSideEffects())
+    return;
+
+  idle_loop_.state = IdleLoop::State::kRecording;
+  idle_loop_.start = target;
+  idle_loop_.end = address;
+  idle_loop_.count = 0;
+}
+
+bool CPU::ReplayIdleLoop() {
+  const IdleLoopStep& step = idle_loop_.steps[idle_loop_.index];
+  DCHECK(IsSameRegisters(registers_, step.registers));
+  if (step.has_read) {
+    Byte value;
+    if (!cpu_bus_->Peek(step.read_address, &value) ||
+        value != step.read_value) {
+      ResetIdleLoop();
+      return false;
+    }
+  }
+
+  // The next registers are what the instruction would produce, for they
+  // follow the same registers and the same read.
+  idle_loop_.index = (idle_loop_.index + 1) % idle_loop_.count;
+  registers_ = idle_loop_.steps[idle_loop_.index].registers;
+  cycles_to_skip_ += step.cycles - 1;
+  return true;
+}
+
 }  // namespace nes
 }  // namespace kiwi
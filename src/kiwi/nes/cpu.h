@@ -15,6 +15,8 @@
 
 #include <stdint.h>
 
+#include <memory>
+
 #include "base/compiler_specific.h"
 #include "nes/cpu_observer.h"
 #include "nes/emulator_states.h"
@@ -52,10 +54,15 @@ class CPU : public EmulatorStates::SerializableState {
   void PowerUp();
   void Reset();
   void Interrupt(InterruptType type);
-  // Step() should be called every cycle.
+  // The APU holds its IRQ line until the IRQ is acknowledged, so it is taken
+  // whenever interrupts are enabled, rather than once like Interrupt().
+  void SetIRQLine(bool asserted) { irq_line_ = asserted; }
+  // Step() should be called every cycle. The mapper's M2CycleIRQ() is called
+  // by the emulator after each step, in its mapper's step loop.
   void Step();
   void Step(int64_t cycles);
   void SkipDMACycles();
+  void SkipDMCDMACycles();
 
   CPURegisters registers() { return registers_; }
   LastAction get_last_action() {
@@ -64,9 +71,28 @@ class CPU : public EmulatorStates::SerializableState {
 
   void increase_skip_cycle() { ++cycles_to_skip_; }
 
+  // Idle loops, such as polling PPUSTATUS or RAM until NMI, are recorded once
+  // and then replayed without fetching and executing their instructions. It
+  // is enabled by default.
+  void set_idle_loop_enabled(bool enabled);
+  bool idle_loop_enabled() const { return idle_loop_enabled_; }
+  bool is_replaying_idle_loop() const {
+    return idle_loop_.state == IdleLoop::State::kReplaying;
+  }
+
+  // Instructions in PRG-ROM can be decoded once into a cache, which keeps
+  // their bytes and cycles, so that executing them again doesn't read through
+  // the mapper. The cache takes 256KB, and is disabled by default.
+  void SetDecodedInstructionCacheEnabled(bool enabled);
+  size_t GetAllocatedBytes();
+
   void SetObserver(CPUObserver* observer);
   void RemoveObserver();
 
+  // Copies registers and pending interrupts from |other|. It is used to clone
+  // an emulator, the bus and the observer are kept.
+  void CopyStatesFrom(const CPU& other);
+
   // EmulatorStates::SerializableState:
   void Serialize(EmulatorStates::SerializableStateData& data) override;
   bool Deserialize(const EmulatorStates::Header& header,
@@ -85,6 +111,11 @@ class CPU : public EmulatorStates::SerializableState {
   // PC.
   ALWAYS_INLINE void PopPC();
 
+  // Reads for the instruction being executed. Its own bytes are taken from
+  // its decoded instruction, if any, and others are read from the bus.
+  ALWAYS_INLINE Byte Read(Address address);
+  ALWAYS_INLINE Word ReadWord(Address address);
+
   // Set Z flag and N flag indicated by |value|. |opcode| just check whether ZN
   // flags should be set.
   ALWAYS_INLINE void SetZN(Byte value);
@@ -96,6 +127,18 @@ class CPU : public EmulatorStates::SerializableState {
   ALWAYS_INLINE bool Execute(Opcode opcode);
 
   // Devides opcodes into move, arithmetic, jump flag, and 4-blocks parts.
+  // Which part handles an opcode is remembered in |executors_|.
+  enum class Executor : Byte {
+    kUnknown,
+    kMove,
+    kArithmetic,
+    kJumpFlags,
+    kBlock0,
+    kBlock1,
+    kBlock2,
+    kBlock3,
+  };
+
   ALWAYS_INLINE bool ExecuteMove(Opcode opcode);
   ALWAYS_INLINE bool ExecuteArithmetic(Opcode opcode);
   ALWAYS_INLINE bool ExecuteJumpFlags(Opcode opcode);
@@ -113,12 +156,82 @@ class CPU : public EmulatorStates::SerializableState {
   // Gets the target address by |mode|, in current context.
   ALWAYS_INLINE Address Addressing(AddressingMode mode, bool& is_page_crossed);
 
+  // Decoded instructions of $8000-$FFFF. An instruction is valid if its
+  // generation is CPUBus::prg_generation().
+  static constexpr Address kDecodedInstructionBase = 0x8000;
+  static constexpr size_t kDecodedInstructionCount = 0x8000;
+  static constexpr int kMaxInstructionLength = 3;
+
+  struct DecodedInstruction {
+    uint32_t generation;
+    Byte bytes[kMaxInstructionLength];
+    Byte cycles;
+  };
+
+  // Returns the decoded instruction at |address|, decoding it if it is not
+  // valid, or nullptr if it can't be cached.
+  ALWAYS_INLINE const DecodedInstruction* Decode(Address address);
+
+  // Idle loops.
+  // A short backward branch or jump starts recording. Each instruction in the
+  // loop is recorded with the registers before it and the value it reads,
+  // until the loop returns to its start with the same registers. From then
+  // on, an instruction is replayed if it reads the same value again, which is
+  // only peeked from RAM or PPUSTATUS, so that replaying has no side effects
+  // and the result is the same as executing it.
+  static constexpr int kMaxIdleLoopSteps = 8;
+  static constexpr Address kMaxIdleLoopBytes = 16;
+
+  struct IdleLoopStep {
+    CPURegisters registers;
+    int64_t cycles;
+    bool has_read;
+    Address read_address;
+    Byte read_value;
+  };
+
+  struct IdleLoop {
+    enum class State {
+      kNone,
+      kRecording,
+      kReplaying,
+    };
+
+    State state = State::kNone;
+    Address start = 0;
+    Address end = 0;
+    IdleLoopStep steps[kMaxIdleLoopSteps];
+    int count = 0;
+    int index = 0;
+  };
+
+  // Fills registers and the read of |opcode| into |step|. Returns false if
+  // the instruction can't be in an idle loop.
+  bool PeekIdleLoopStep(Opcode opcode, IdleLoopStep* step);
+  // Records |step|, which has just been executed.
+  void RecordIdleLoopStep(const IdleLoopStep& step);
+  // Starts recording if |opcode| at |address| just jumped back a little.
+  void DetectIdleLoop(Opcode opcode, Address address);
+  // Replays the current step. Returns false if it must be executed, and the
+  // loop is abandoned.
+  bool ReplayIdleLoop();
+  void ResetIdleLoop() { idle_loop_.state = IdleLoop::State::kNone; }
+
  private:
   CPUBus* cpu_bus_ = nullptr;
   CPURegisters registers_{};
   bool pending_NMI_ = false;
   bool pending_IRQ_ = false;
+  bool irq_line_ = false;
   int64_t cycles_to_skip_ = 0;
+  bool idle_loop_enabled_ = true;
+  IdleLoop idle_loop_;
+
+  Executor executors_[0x100] = {};
+  std::unique_ptr<DecodedInstruction[]> decoded_instructions_;
+  // The decoded instruction being executed, and its address.
+  const DecodedInstruction* instruction_ = nullptr;
+  Address instruction_address_ = 0;
 
   // For debugging
   Address last_address_ = 0;
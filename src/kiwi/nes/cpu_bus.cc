@@ -14,6 +14,7 @@
 
 #include "base/logging.h"
 #include "nes/mapper.h"
+#include "nes/ppu.h"
 #include "nes/registers.h"
 #include "nes/types.h"
 
@@ -25,6 +26,7 @@ CPUBus::~CPUBus() = default;
 void CPUBus::SetMapper(Mapper* mapper) {
   DCHECK(mapper);
   mapper_ = mapper;
+  IncreasePRGGeneration();
 }
 
 Mapper* CPUBus::GetMapper() {
@@ -61,11 +63,29 @@ void CPUBus::Write(Address address, Byte value) {
     emulator_->Write(address, value);
   } else if (address < 0x8000) {  // $4020-$7FFF, battery backed save / work RAM
     mapper_->WriteExtendedRAM(address, value);
+    // Without work RAM, or for MMC5, it writes mapper's registers.
+    if (!mapper_->HasExtendedRAM() || mapper_->IsMMC5())
+      IncreasePRGGeneration();
   } else {  // $8000-$FFFF, Usual ROM, commonly with Mapper Registers
     mapper_->WritePRG(address, value);
+    IncreasePRGGeneration();
   }
 }
 
+bool CPUBus::Peek(Address address, Byte* value) {
+  if (address < 0x2000) {
+    *value = ram_[address & 0x7ff];
+    return true;
+  }
+
+  if (address < 0x4000 && (address & 0xe007) == 0x2002) {
+    DCHECK(ppu_) << "PPU must be set.";
+    return ppu_->PeekStatus(value);
+  }
+
+  return false;
+}
+
 Byte* CPUBus::GetPagePointer(Byte page) {
   // The start of a page is $XX00.
   Address address = page << 8;
@@ -84,6 +104,11 @@ Byte* CPUBus::GetPagePointer(Byte page) {
   return nullptr;
 }
 
+void CPUBus::CopyStatesFrom(const CPUBus& other) {
+  memcpy(ram_, other.ram_, sizeof(ram_));
+  IncreasePRGGeneration();
+}
+
 void CPUBus::Serialize(EmulatorStates::SerializableStateData& data) {
   data.WriteData(ram_);
 }
@@ -92,6 +117,7 @@ bool CPUBus::Deserialize(const EmulatorStates::Header& header,
                          EmulatorStates::DeserializableStateData& data) {
   if (header.version == 1) {
     data.ReadData(&ram_);
+    IncreasePRGGeneration();
     return true;
   }
   return false;
@@ -101,6 +127,13 @@ Word CPUBus::ReadWord(Address address) {
   return Read(address) | Read(address + 1) << 8;
 }
 
+void CPUBus::IncreasePRGGeneration() {
+  if (mapper_ && mapper_->HasPRGReadSideEffects())
+    prg_generation_ = 0;
+  else if (++prg_generation_ == 0)
+    prg_generation_ = 1;
+}
+
 
 }  // namespace nes
 }  // namespace kiwi
@@ -24,6 +24,7 @@ namespace kiwi {
 namespace nes {
 class Mapper;
 class Device;
+class PPU;
 
 // CPU Bus is connected to the CPU.
 // See https://www.nesdev.org/wiki/CPU_memory_map for more addressing details.
@@ -40,19 +41,37 @@ class CPUBus : public EmulatorStates::SerializableState {
   Byte* GetPagePointer(Byte page);
   Word ReadWord(Address address);
 
-  void set_ppu(Device* ppu) { ppu_ = ppu; }
+  // Gets the value reading |address| would return, if the read has no side
+  // effects. Only the internal RAM and PPUSTATUS can be peeked, others return
+  // false. It is used to skip idle loops, see CPU.
+  bool Peek(Address address, Byte* value);
+
+  // Increases whenever PRG-ROM may be mapped differently: the mapper is
+  // written, replaced, or its states are restored. The CPU drops its decoded
+  // instructions when it changes. It is 0 if reading PRG-ROM has side
+  // effects, so that instructions can't be cached.
+  uint32_t prg_generation() const { return prg_generation_; }
+
+  void set_ppu(PPU* ppu) { ppu_ = ppu; }
   void set_emulator(Device* emulator) { emulator_ = emulator; }
 
+  // Copies the internal RAM from |other|.
+  void CopyStatesFrom(const CPUBus& other);
+
   // EmulatorStates::SerializableState:
   void Serialize(EmulatorStates::SerializableStateData& data) override;
   bool Deserialize(const EmulatorStates::Header& header,
                    EmulatorStates::DeserializableStateData& data) override;
 
+ private:
+  void IncreasePRGGeneration();
+
  private:
   Mapper* mapper_ = nullptr;
-  Device* ppu_ = nullptr;
+  PPU* ppu_ = nullptr;
   Device* emulator_ = nullptr;
   Byte ram_[0x800] = {0};
+  uint32_t prg_generation_ = 1;
 };
 
 }  // namespace nes
@@ -10,6 +10,12 @@
 // MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
 // GNU General Public License for more details.
 
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+#include "kiwi/nes/emulator_impl.h"
+#include "kiwi/nes/emulator_states.h"
 #include "kiwi/testing/rom_test.h"
 
 namespace kiwi {
@@ -34,6 +40,32 @@ class CpuInstructionsTest : public RomTest {
         .Append("cpu")
         .Append("all_instrs.nes");
   }
+
+  // Runs all_instrs.nes for |frame_count| frames, with or without the decoded
+  // instruction cache. Returns the host time of a frame, and sets |states| to
+  // the states it ends in.
+  std::chrono::duration<double, std::milli> RunFrames(int frame_count,
+                                                      bool cache,
+                                                      Bytes* states) {
+    scoped_refptr<Emulator> emulator = CreateEmulatorForTesting();
+    emulator->PowerOn();
+    static_cast<EmulatorImpl*>(emulator.get())
+        ->SetDecodedInstructionCache(cache);
+    emulator->LoadAndRun(GetRomPath(), base::BindOnce([](bool success) {
+                           EXPECT_TRUE(success) << "Failed to load ROM";
+                         }));
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < frame_count; ++i)
+      emulator->RunOneFrame();
+    std::chrono::duration<double, std::milli> frame =
+        (std::chrono::steady_clock::now() - start) / frame_count;
+    *states = EmulatorStates::CreateStateForVersion(
+                  static_cast<EmulatorImpl*>(emulator.get()),
+                  EmulatorStates::kLatestVersion)
+                  .Build(EmulatorStates::Compression::kNone);
+    emulator->PowerOff();
+    return frame;
+  }
 };
 
 TEST_F(CpuInstructionsTest, RunAllInstructions) {
@@ -47,6 +79,37 @@ TEST_F(CpuInstructionsTest, RunAllInstructions) {
   EXPECT_EQ(result.status, 0x00);
 }
 
+// all_instrs.nes switches PRG banks of MMC1, which must drop decoded
+// instructions.
+TEST_F(CpuInstructionsTest, DecodedInstructionCache) {
+  Bytes uncached_states;
+  Bytes cached_states;
+  RunFrames(120, false, &uncached_states);
+  RunFrames(120, true, &cached_states);
+  EXPECT_EQ(cached_states, uncached_states);
+}
+
+// Measures the host time of a frame with and without the decoded instruction
+// cache, the fastest of several rounds. The cache must make it less.
+TEST_F(CpuInstructionsTest, DISABLED_DecodedInstructionCacheCost) {
+  constexpr int kRoundCount = 5;
+  constexpr int kFrameCount = 120;
+  auto uncached = std::chrono::duration<double, std::milli>::max();
+  auto cached = std::chrono::duration<double, std::milli>::max();
+  Bytes states;
+  for (int round = 0; round < kRoundCount; ++round) {
+    uncached = std::min(uncached, RunFrames(kFrameCount, false, &states));
+    cached = std::min(cached, RunFrames(kFrameCount, true, &states));
+  }
+
+  RecordProperty("uncached_us", static_cast<int>(uncached.count() * 1000));
+  RecordProperty("cached_us", static_cast<int>(cached.count() * 1000));
+  std::cout << "Frame: " << uncached.count() << " ms (uncached), "
+            << cached.count() << " ms (decoded instruction cache)"
+            << std::endl;
+  EXPECT_LT(cached, uncached);
+}
+
 }  // namespace testing
 }  // namespace nes
 }  // namespace kiwi
@@ -82,6 +82,15 @@ void PerformanceCounter::CPUEnd() {
   }
 }
 
+void PerformanceCounter::RunAheadStart() {
+  run_ahead_timestamp_ = std::chrono::high_resolution_clock::now();
+}
+
+void PerformanceCounter::RunAheadEnd() {
+  run_ahead_ms_per_frame_ =
+      std::chrono::high_resolution_clock::now() - run_ahead_timestamp_;
+}
+
 int PerformanceCounter::PPUDurationPerFrameInMilliseconds() {
   return static_cast<float>(ppu_ms_per_frame_.count());
 }
@@ -90,6 +99,10 @@ int PerformanceCounter::CPUDurationPerFrameInMilliseconds() {
   return static_cast<float>(cpu_ms_per_frame_.count());
 }
 
+int PerformanceCounter::RunAheadDurationPerFrameInMilliseconds() {
+  return static_cast<float>(run_ahead_ms_per_frame_.count());
+}
+
 DebugPort::DebugPort(Emulator* emulator) : emulator_(emulator) {
   DCHECK(emulator_);
   main_task_runner_ = base::SingleThreadTaskRunner::GetCurrentDefault();
@@ -108,8 +108,14 @@ class PerformanceCounter {
   void CPUStart();
   void CPUEnd();
 
+  // Measures frames run ahead, including saving and restoring states. The
+  // duration is kept until the next frame runs ahead.
+  void RunAheadStart();
+  void RunAheadEnd();
+
   int PPUDurationPerFrameInMilliseconds();
   int CPUDurationPerFrameInMilliseconds();
+  int RunAheadDurationPerFrameInMilliseconds();
 
  private:
   bool started_ = false;
@@ -117,6 +123,9 @@ class PerformanceCounter {
   std::chrono::high_resolution_clock::time_point ppu_timestamp_;
   std::chrono::duration<float, std::milli> cpu_ms_per_frame_;
   std::chrono::high_resolution_clock::time_point cpu_timestamp_;
+  std::chrono::duration<float, std::milli> run_ahead_ms_per_frame_ =
+      std::chrono::milliseconds(0);
+  std::chrono::high_resolution_clock::time_point run_ahead_timestamp_;
 };
 
 class NES_EXPORT DebugPort {
@@ -47,6 +47,36 @@ class NES_EXPORT Emulator : public base::RefCountedThreadSafe<Emulator>,
     kRunning,
   };
 
+  enum class RunAheadMode {
+    kSingleInstance,
+    kSecondInstance,
+  };
+
+  enum class MemoryMode {
+    // Components are allocated separately, and frames are kept in colors.
+    kDefault,
+    // CPU, PPU, APU, their buses and screen buffers are in one allocation.
+    // Frames are kept as palette indices, and converted to colors only when
+    // they are presented or asked for.
+    kCompact,
+    // The same as kCompact, but no audio is output, and the APU has no output
+    // buffer at all.
+    kCompactWithoutAudio,
+  };
+
+  // Identifies the frame last presented to render devices, see
+  // GetPresentedFrameChanges().
+  struct FrameChanges {
+    // Frames with the same sequence have the same pixels. Sequences are
+    // unique in the process.
+    uint64_t sequence = 0;
+    // Rows [first_row, end_row) are the only ones which differ from the frame
+    // of |base_sequence|, the frame presented before.
+    uint64_t base_sequence = 0;
+    int first_row = 0;
+    int end_row = 0;
+  };
+
   Emulator();
 
  protected:
@@ -63,10 +93,11 @@ class NES_EXPORT Emulator : public base::RefCountedThreadSafe<Emulator>,
   virtual void PowerOff() = 0;
 
   // Loads a ROM. When loads finish, you can call Run() to run the
-  // emulator.
+  // emulator. |data| is moved to the emulator's thread, so that pass it by
+  // std::move() if you don't need it any longer, rather than copying it.
   virtual void LoadFromFile(const base::FilePath& rom_path,
                             LoadCallback callback) = 0;
-  virtual void LoadFromBinary(const Bytes& data, LoadCallback callback) = 0;
+  virtual void LoadFromBinary(Bytes data, LoadCallback callback) = 0;
 
   // Gets currently loaded ROM's data. Returns nullptr if no ROM has been
   // loaded.
@@ -90,8 +121,7 @@ class NES_EXPORT Emulator : public base::RefCountedThreadSafe<Emulator>,
   // An utility method to call Load() and Run() in proper thread.
   virtual void LoadAndRun(const base::FilePath& rom_path,
                           LoadCallback = base::DoNothing()) = 0;
-  virtual void LoadAndRun(const Bytes& data,
-                          LoadCallback = base::DoNothing()) = 0;
+  virtual void LoadAndRun(Bytes data, LoadCallback = base::DoNothing()) = 0;
 
   // Steps one CPU cycle. Because Run() will start a working task runner to run
   // cycles, Step() should be called only when the emulator is not running.
@@ -107,7 +137,15 @@ class NES_EXPORT Emulator : public base::RefCountedThreadSafe<Emulator>,
   // Saves or loads current states, such as CPU, PPU, APU, cartridge, etc.
   // If save state failed, an empty data will be returned in |callback|.
   virtual void SaveState(SaveStateCallback callback) = 0;
-  virtual void LoadState(const Bytes& data, LoadCallback callback) = 0;
+  virtual void LoadState(Bytes data, LoadCallback callback) = 0;
+
+  // Creates an independent emulator in current states, without serializing
+  // them. The clone shares the loaded ROM, and copies RAM, VRAM, OAM,
+  // registers, mapper's and APU's states. It must be called on the emulator's
+  // thread when no frame is running, and a ROM must have been loaded. Like a
+  // testing emulator, the clone runs synchronously on the calling thread. It
+  // has no IO devices or debug port, and is in the same running state.
+  virtual scoped_refptr<Emulator> Clone() = 0;
 
   // Sets or gets emulator's volume. The valid volume is from 0 to 1.
   virtual void SetVolume(float volume) = 0;
@@ -117,6 +155,40 @@ class NES_EXPORT Emulator : public base::RefCountedThreadSafe<Emulator>,
   virtual const Colors& GetLastFrame() = 0;
   virtual const Colors& GetCurrentFrame() = 0;
 
+  // Gets the sequence of the frame last presented to render devices, and
+  // which of its rows changed, so that a render device can skip a frame it
+  // already has, or update only the changed rows of the frame before. Frames
+  // are compared only when they are presented. It must be called on the
+  // emulator's thread.
+  virtual FrameChanges GetPresentedFrameChanges() = 0;
+
+  // Run-ahead hides the lag of games which respond to input some frames later.
+  // After each frame, |frames| more frames are run with current input, the
+  // last of them is presented, and their states and audio are discarded.
+  // kSingleInstance mode saves states and restores them afterwards, while
+  // kSecondInstance mode runs the frames on a second emulator which is synced
+  // to this one, so that this one is never rolled back. 0 disables run-ahead.
+  virtual void SetRunAhead(int frames, RunAheadMode mode) = 0;
+
+  // Fast-forward runs |speed| frames for each RunOneFrame(), and presents the
+  // last of them. Audio keeps its pace and pitch: only the last two frames
+  // are synthesized, and they are time-stretched into a frame's length. Run-
+  // ahead is skipped meanwhile. |speed| is from 1, which disables
+  // fast-forward, to kMaxFastForwardSpeed.
+  static constexpr int kMaxFastForwardSpeed = 8;
+  virtual void SetFastForward(int speed) = 0;
+
+  // Sets how the emulator lays out its memory. It must be called before
+  // PowerOn(), and clones are in the same mode. Compact modes suit headless
+  // emulators run in large numbers.
+  virtual void SetMemoryMode(MemoryMode mode) = 0;
+  virtual MemoryMode GetMemoryMode() = 0;
+
+  // Returns bytes allocated for the emulator and its components, including
+  // screen and audio buffers. The ROM, which may be shared with clones, and
+  // the mapper are not counted.
+  virtual size_t GetMemoryFootprint() = 0;
+
  public:
   virtual void SetDebugPort(DebugPort* debug_port) = 0;
 
@@ -0,0 +1,229 @@
+// Copyright (C) 2026 Yisi Yu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#include "nes/emulator_batch.h"
+
+#include <algorithm>
+#include <latch>
+#include <string>
+#include <thread>
+
+#include "base/check.h"
+#include "base/functional/bind.h"
+#include "base/logging.h"
+#include "base/threading/thread.h"
+#include "nes/emulator_impl.h"
+
+namespace kiwi {
+namespace nes {
+// An instance is its emulator's input and audio device as well.
+class EmulatorBatch::Instance : public IODevices::InputDevice,
+                                public IODevices::AudioDevice {
+ public:
+  Instance() = default;
+  ~Instance() override = default;
+
+  // IODevices::InputDevice:
+  bool IsKeyDown(int controller_id, ControllerButton button) override {
+    return input.controllers[controller_id] & (1 << static_cast<int>(button));
+  }
+  int GetZapperState() override { return kNone; }
+
+  // IODevices::AudioDevice:
+  void OnSampleArrived(Sample* samples_arrived, size_t count) override {
+    samples.insert(samples.end(), samples_arrived, samples_arrived + count);
+  }
+
+  scoped_refptr<Emulator> emulator;
+  // The last frame in the default mode, taken on the worker's thread after
+  // each run.
+  const Colors* frame = nullptr;
+  Input input;
+  std::vector<Sample> samples;
+};
+
+struct EmulatorBatch::Worker {
+  std::unique_ptr<base::Thread> thread;
+  std::vector<Instance*> instances;
+  bool loaded = false;
+};
+
+EmulatorBatch::EmulatorBatch(int instance_count,
+                             int thread_count,
+                             Emulator::MemoryMode memory_mode)
+    : memory_mode_(memory_mode) {
+  DCHECK(instance_count > 0);
+  if (thread_count <= 0) {
+    thread_count =
+        std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+  }
+  thread_count = std::min(thread_count, instance_count);
+
+  for (int i = 0; i < instance_count; ++i)
+    instances_.push_back(std::make_unique<Instance>());
+
+  // Each worker steps a contiguous range of instances.
+  for (int i = 0; i < thread_count; ++i) {
+    std::unique_ptr<Worker> worker = std::make_unique<Worker>();
+    worker->thread = std::make_unique<base::Thread>(
+        "Kiwi Emulator Batch Worker " + std::to_string(i));
+    worker->thread->StartWithOptions(base::Thread::Options());
+    for (int j = i * instance_count / thread_count;
+         j < (i + 1) * instance_count / thread_count; ++j) {
+      worker->instances.push_back(instances_[j].get());
+    }
+    workers_.push_back(std::move(worker));
+  }
+}
+
+EmulatorBatch::~EmulatorBatch() {
+  // Emulators are powered off on their own threads, before the threads stop.
+  RunOnWorkers(base::BindRepeating([](Worker* worker) {
+    for (Instance* instance : worker->instances) {
+      if (instance->emulator) {
+        instance->emulator->PowerOff();
+        instance->emulator.reset();
+      }
+    }
+  }));
+}
+
+bool EmulatorBatch::LoadFromFile(const base::FilePath& rom_path) {
+  return Load(rom_path, Bytes());
+}
+
+bool EmulatorBatch::LoadFromBinary(const Bytes& data) {
+  return Load(base::FilePath(), data);
+}
+
+void EmulatorBatch::RunOneFrame(const std::vector<Input>& inputs) {
+  DCHECK_EQ(inputs.size(), instances_.size());
+  // Inputs are set before the tasks are posted, so that workers see them.
+  for (size_t i = 0; i < instances_.size(); ++i)
+    instances_[i]->input = inputs[i];
+
+  RunOnWorkers(base::BindRepeating(
+      [](bool convert_frames, Worker* worker) {
+        for (Instance* instance : worker->instances) {
+          instance->samples.clear();
+          if (instance->emulator) {
+            instance->emulator->RunOneFrame();
+            if (convert_frames)
+              instance->frame = &instance->emulator->GetLastFrame();
+          }
+        }
+      },
+      memory_mode_ == Emulator::MemoryMode::kDefault));
+}
+
+const Colors& EmulatorBatch::GetFrame(int index) {
+  DCHECK(memory_mode_ == Emulator::MemoryMode::kDefault);
+  DCHECK(instances_[index]->frame);
+  return *instances_[index]->frame;
+}
+
+const Byte* EmulatorBatch::GetIndexedFrame(int index) {
+  DCHECK(memory_mode_ != Emulator::MemoryMode::kDefault);
+  DCHECK(instances_[index]->emulator);
+  return static_cast<EmulatorImpl*>(instances_[index]->emulator.get())
+      ->GetLastIndexedFrame();
+}
+
+const std::vector<Sample>& EmulatorBatch::GetAudio(int index) {
+  return instances_[index]->samples;
+}
+
+const Byte* EmulatorBatch::GetRAM(int index) {
+  DCHECK(instances_[index]->emulator);
+  return static_cast<EmulatorImpl*>(instances_[index]->emulator.get())
+      ->GetRAM();
+}
+
+size_t EmulatorBatch::GetMemoryFootprint(int index) {
+  DCHECK(instances_[index]->emulator);
+  return instances_[index]->emulator->GetMemoryFootprint();
+}
+
+bool EmulatorBatch::Load(const base::FilePath& rom_path, const Bytes& data) {
+  RunOnWorkers(base::BindRepeating(
+      [](const base::FilePath* rom_path, const Bytes* data,
+         Emulator::MemoryMode memory_mode, Worker* worker) {
+        worker->loaded = false;
+        for (Instance* instance : worker->instances) {
+          if (instance->emulator) {
+            instance->emulator->PowerOff();
+            instance->emulator.reset();
+          }
+          instance->frame = nullptr;
+          instance->samples.clear();
+        }
+
+        // Like testing emulators, instances run synchronously on their
+        // worker's thread.
+        scoped_refptr<Emulator> emulator = CreateEmulatorForTesting();
+        emulator->SetMemoryMode(memory_mode);
+        emulator->PowerOn();
+        bool success = false;
+        Emulator::LoadCallback callback = base::BindOnce(
+            [](bool* result, bool success) { *result = success; },
+            base::Unretained(&success));
+        if (data->empty())
+          emulator->LoadAndRun(*rom_path, std::move(callback));
+        else
+          emulator->LoadAndRun(*data, std::move(callback));
+
+        if (!success) {
+          LOG(ERROR) << "Failed to load ROM for the emulator batch.";
+          emulator->PowerOff();
+          return;
+        }
+
+        for (Instance* instance : worker->instances) {
+          instance->emulator = instance == worker->instances.front()
+                                   ? emulator
+                                   : emulator->Clone();
+          std::unique_ptr<IODevices> io_devices = std::make_unique<IODevices>();
+          io_devices->set_input_device(instance);
+          io_devices->set_audio_device(instance);
+          instance->emulator->SetIODevices(std::move(io_devices));
+          if (memory_mode == Emulator::MemoryMode::kDefault)
+            instance->frame = &instance->emulator->GetLastFrame();
+        }
+        worker->loaded = true;
+      },
+      base::Unretained(&rom_path), base::Unretained(&data), memory_mode_));
+
+  return std::all_of(workers_.begin(), workers_.end(),
+                     [](const std::unique_ptr<Worker>& worker) {
+                       return worker->loaded;
+                     });
+}
+
+void EmulatorBatch::RunOnWorkers(
+    base::RepeatingCallback<void(Worker*)> callback) {
+  std::latch done(workers_.size());
+  for (std::unique_ptr<Worker>& worker : workers_) {
+    worker->thread->task_runner()->PostTask(
+        FROM_HERE, base::BindOnce(
+                       [](base::RepeatingCallback<void(Worker*)> callback,
+                          Worker* worker, std::latch* done) {
+                         callback.Run(worker);
+                         done->count_down();
+                       },
+                       callback, base::Unretained(worker.get()),
+                       base::Unretained(&done)));
+  }
+  done.wait();
+}
+
+}  // namespace nes
+}  // namespace kiwi
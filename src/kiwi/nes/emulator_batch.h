@@ -0,0 +1,108 @@
+// Copyright (C) 2026 Yisi Yu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#ifndef NES_EMULATOR_BATCH_H_
+#define NES_EMULATOR_BATCH_H_
+
+#include <memory>
+#include <vector>
+
+#include "base/files/file_path.h"
+#include "base/functional/callback.h"
+#include "nes/emulator.h"
+#include "nes/nes_export.h"
+#include "nes/types.h"
+
+namespace kiwi {
+namespace base {
+class Thread;
+}
+
+namespace nes {
+// EmulatorBatch owns a number of headless emulators running the same ROM, and
+// steps all of them a frame in a single call. Instances are spread across
+// worker threads, each of which steps its instances in turn, so that a frame
+// costs one task per thread rather than one per instance.
+// All methods must be called on the same thread, and they block until the
+// workers finish.
+class NES_EXPORT EmulatorBatch {
+ public:
+  // Buttons held by an instance in a frame. Bit n of a controller is set if
+  // ControllerButton n is pressed.
+  struct Input {
+    Byte controllers[2] = {0};
+  };
+
+  // Size of the CPU's internal RAM returned by GetRAM().
+  static constexpr size_t kRAMSize = 0x800;
+
+  // Creates |instance_count| instances, which run on |thread_count| worker
+  // threads. If |thread_count| is 0, hardware concurrency is used. Instances
+  // lay out their memory in |memory_mode|, see Emulator::MemoryMode.
+  explicit EmulatorBatch(
+      int instance_count,
+      int thread_count = 0,
+      Emulator::MemoryMode memory_mode = Emulator::MemoryMode::kDefault);
+  ~EmulatorBatch();
+
+  EmulatorBatch(const EmulatorBatch&) = delete;
+  EmulatorBatch& operator=(const EmulatorBatch&) = delete;
+
+  // Loads a ROM into all instances and runs them. Each worker loads the ROM
+  // once, and clones its other instances from the first one. Returns whether
+  // all instances are loaded.
+  bool LoadFromFile(const base::FilePath& rom_path);
+  bool LoadFromBinary(const Bytes& data);
+
+  // Runs all instances a frame, with inputs[i] for instance i. |inputs| must
+  // have an entry for each instance.
+  void RunOneFrame(const std::vector<Input>& inputs);
+
+  int size() const { return static_cast<int>(instances_.size()); }
+  int thread_count() const { return static_cast<int>(workers_.size()); }
+
+  // Views of an instance's outputs. They are not copied, so they are only
+  // valid until the next RunOneFrame() or load.
+  // GetFrame() returns the last frame rendered, GetAudio() returns samples of
+  // the last RunOneFrame(), and GetRAM() returns |kRAMSize| bytes of the CPU's
+  // internal RAM.
+  // In compact modes, frames are not converted to colors, and
+  // GetIndexedFrame() returns PPU::kFrameSize palette indices instead of
+  // GetFrame().
+  const Colors& GetFrame(int index);
+  const Byte* GetIndexedFrame(int index);
+  const std::vector<Sample>& GetAudio(int index);
+  const Byte* GetRAM(int index);
+
+  // Returns bytes allocated for an instance, see
+  // Emulator::GetMemoryFootprint().
+  size_t GetMemoryFootprint(int index);
+
+ private:
+  class Instance;
+  struct Worker;
+
+  bool Load(const base::FilePath& rom_path, const Bytes& data);
+
+  // Runs |callback| with each worker on its thread, and waits for all of them.
+  void RunOnWorkers(base::RepeatingCallback<void(Worker*)> callback);
+
+ private:
+  Emulator::MemoryMode memory_mode_;
+  std::vector<std::unique_ptr<Instance>> instances_;
+  std::vector<std::unique_ptr<Worker>> workers_;
+};
+
+}  // namespace nes
+}  // namespace kiwi
+
+#endif  // NES_EMULATOR_BATCH_H_
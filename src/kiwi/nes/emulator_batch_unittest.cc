@@ -0,0 +1,252 @@
+// Copyright (C) 2026 Yisi Yu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#include "kiwi/nes/emulator_batch.h"
+
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+#include "kiwi/nes/emulator_impl.h"
+#include "kiwi/nes/ppu.h"
+#include "kiwi/testing/rom_test.h"
+
+namespace kiwi {
+namespace nes {
+namespace testing {
+
+namespace {
+constexpr int kFrameCount = 30;
+
+// An NROM program which reads controller 1 into $01 every frame, and sets the
+// backdrop color and the pitch of pulse 1 by it.
+constexpr Byte kProgram[] = {
+    // Reset, at $C000
+    0x78,              // SEI
+    0xd8,              // CLD
+    0xa2, 0xff,        // LDX #$FF
+    0x9a,              // TXS
+    0x2c, 0x02, 0x20,  // BIT $2002
+    0x10, 0xfb,        // BPL $C005
+    0x2c, 0x02, 0x20,  // BIT $2002
+    0x10, 0xfb,        // BPL $C00A
+    0xa9, 0x01,        // LDA #$01
+    0x8d, 0x15, 0x40,  // STA $4015
+    0xa9, 0xbf,        // LDA #$BF
+    0x8d, 0x00, 0x40,  // STA $4000
+    0xa9, 0x00,        // LDA #$00
+    0x8d, 0x03, 0x40,  // STA $4003
+    0xa9, 0x80,        // LDA #$80
+    0x8d, 0x00, 0x20,  // STA $2000
+    0xa9, 0x08,        // LDA #$08
+    0x8d, 0x01, 0x20,  // STA $2001
+    0x4c, 0x28, 0xc0,  // JMP $C028
+    // NMI, at $C02B
+    0xa9, 0x01,        // LDA #$01
+    0x8d, 0x16, 0x40,  // STA $4016
+    0xa9, 0x00,        // LDA #$00
+    0x8d, 0x16, 0x40,  // STA $4016
+    0xa2, 0x08,        // LDX #$08
+    0xad, 0x16, 0x40,  // LDA $4016
+    0x4a,              // LSR A
+    0x66, 0x01,        // ROR $01
+    0xca,              // DEX
+    0xd0, 0xf7,        // BNE $C037
+    0xa5, 0x01,        // LDA $01
+    0x8d, 0x02, 0x40,  // STA $4002
+    0xa9, 0x3f,        // LDA #$3F
+    0x8d, 0x06, 0x20,  // STA $2006
+    0xa9, 0x00,        // LDA #$00
+    0x8d, 0x06, 0x20,  // STA $2006
+    0xa5, 0x01,        // LDA $01
+    0x29, 0x3f,        // AND #$3F
+    0x8d, 0x07, 0x20,  // STA $2007
+    0xa9, 0x00,        // LDA #$00
+    0x8d, 0x06, 0x20,  // STA $2006
+    0x8d, 0x06, 0x20,  // STA $2006
+    0x40,              // RTI
+    // IRQ, at $C05F
+    0x40,  // RTI
+};
+constexpr Address kNMIVector = 0xc02b;
+constexpr Address kResetVector = 0xc000;
+constexpr Address kIRQVector = 0xc05f;
+
+Bytes CreateTestROM() {
+  return CreateNROMForTesting(kProgram, sizeof(kProgram), kNMIVector,
+                              kResetVector, kIRQVector);
+}
+
+// Inputs and records outputs of a standalone emulator.
+class Device : public IODevices::InputDevice, public IODevices::AudioDevice {
+ public:
+  // IODevices::InputDevice:
+  bool IsKeyDown(int controller_id, ControllerButton button) override {
+    return controller_id == 0 && (buttons & (1 << static_cast<int>(button)));
+  }
+  int GetZapperState() override { return kNone; }
+
+  // IODevices::AudioDevice:
+  void OnSampleArrived(Sample* samples_arrived, size_t count) override {
+    samples.insert(samples.end(), samples_arrived, samples_arrived + count);
+  }
+
+  Byte buttons = 0;
+  std::vector<Sample> samples;
+};
+
+// Up and Left are never pressed, for controllers ignore opposite directions
+// pressed together.
+std::vector<EmulatorBatch::Input> CreateInputs(int count, int frame) {
+  std::vector<EmulatorBatch::Input> inputs(count);
+  for (int i = 0; i < count; ++i)
+    inputs[i].controllers[0] = static_cast<Byte>((i * 37 + frame + 1) & 0xaf);
+  return inputs;
+}
+}  // namespace
+
+using EmulatorBatchTest = RomTest;
+
+TEST_F(EmulatorBatchTest, RunsInstancesWithTheirInputs) {
+  constexpr int kInstanceCount = 6;
+  EmulatorBatch batch(kInstanceCount, 4);
+  EXPECT_EQ(batch.size(), kInstanceCount);
+  EXPECT_EQ(batch.thread_count(), 4);
+  ASSERT_TRUE(batch.LoadFromBinary(CreateTestROM()));
+
+  std::vector<EmulatorBatch::Input> inputs;
+  for (int frame = 0; frame < kFrameCount; ++frame) {
+    inputs = CreateInputs(kInstanceCount, frame);
+    // The first and the last instance run on different threads, with the
+    // same inputs.
+    inputs.back() = inputs.front();
+    batch.RunOneFrame(inputs);
+  }
+
+  for (int i = 0; i < kInstanceCount; ++i) {
+    EXPECT_EQ(batch.GetRAM(i)[1], inputs[i].controllers[0]) << "Instance " << i;
+    EXPECT_FALSE(batch.GetAudio(i).empty()) << "Instance " << i;
+  }
+  EXPECT_NE(batch.GetFrame(0), batch.GetFrame(1));
+  EXPECT_EQ(batch.GetFrame(0), batch.GetFrame(kInstanceCount - 1));
+  EXPECT_EQ(batch.GetAudio(0), batch.GetAudio(kInstanceCount - 1));
+  EXPECT_EQ(0, memcmp(batch.GetRAM(0), batch.GetRAM(kInstanceCount - 1),
+                      EmulatorBatch::kRAMSize));
+}
+
+TEST_F(EmulatorBatchTest, MatchesStandaloneEmulator) {
+  constexpr int kInstanceCount = 4;
+  EmulatorBatch batch(kInstanceCount, 2);
+  ASSERT_TRUE(batch.LoadFromBinary(CreateTestROM()));
+
+  // Instance 3 is cloned from the instance which loads the ROM, and should
+  // run the same as an emulator which loads the ROM itself.
+  constexpr int kIndex = 3;
+  Device device;
+  std::unique_ptr<IODevices> io_devices = std::make_unique<IODevices>();
+  io_devices->set_input_device(&device);
+  io_devices->set_audio_device(&device);
+  emulator_->SetIODevices(std::move(io_devices));
+  emulator_->LoadAndRun(CreateTestROM(), base::BindOnce([](bool success) {
+                          EXPECT_TRUE(success) << "Failed to load ROM";
+                        }));
+
+  std::vector<Sample> samples;
+  for (int frame = 0; frame < kFrameCount; ++frame) {
+    std::vector<EmulatorBatch::Input> inputs =
+        CreateInputs(kInstanceCount, frame);
+    batch.RunOneFrame(inputs);
+    samples.insert(samples.end(), batch.GetAudio(kIndex).begin(),
+                   batch.GetAudio(kIndex).end());
+
+    device.buttons = inputs[kIndex].controllers[0];
+    emulator_->RunOneFrame();
+    ASSERT_EQ(batch.GetFrame(kIndex), emulator_->GetLastFrame())
+        << "Frame " << frame;
+  }
+  EXPECT_EQ(samples, device.samples);
+  EXPECT_EQ(0, memcmp(batch.GetRAM(kIndex),
+                      static_cast<EmulatorImpl*>(emulator_.get())->GetRAM(),
+                      EmulatorBatch::kRAMSize));
+}
+
+TEST_F(EmulatorBatchTest, CompactInstances) {
+  constexpr int kInstanceCount = 4;
+  EmulatorBatch batch(kInstanceCount, 2,
+                      Emulator::MemoryMode::kCompactWithoutAudio);
+  EmulatorBatch reference(kInstanceCount, 2);
+  ASSERT_TRUE(batch.LoadFromBinary(CreateTestROM()));
+  ASSERT_TRUE(reference.LoadFromBinary(CreateTestROM()));
+
+  std::vector<EmulatorBatch::Input> inputs;
+  for (int frame = 0; frame < kFrameCount; ++frame) {
+    inputs = CreateInputs(kInstanceCount, frame);
+    inputs.back() = inputs.front();
+    batch.RunOneFrame(inputs);
+    reference.RunOneFrame(inputs);
+  }
+
+  for (int i = 0; i < kInstanceCount; ++i) {
+    EXPECT_EQ(0, memcmp(batch.GetRAM(i), reference.GetRAM(i),
+                        EmulatorBatch::kRAMSize))
+        << "Instance " << i;
+    EXPECT_TRUE(batch.GetAudio(i).empty()) << "Instance " << i;
+    EXPECT_LT(batch.GetMemoryFootprint(i), reference.GetMemoryFootprint(i));
+  }
+  EXPECT_NE(0, memcmp(batch.GetIndexedFrame(0), batch.GetIndexedFrame(1),
+                      PPU::kFrameSize));
+  EXPECT_EQ(0, memcmp(batch.GetIndexedFrame(0),
+                      batch.GetIndexedFrame(kInstanceCount - 1),
+                      PPU::kFrameSize));
+}
+
+TEST_F(EmulatorBatchTest, RejectsUnsupportedROM) {
+  EmulatorBatch batch(2, 2);
+  Bytes unsupported = CreateTestROM();
+  // Mapper 255
+  unsupported[6] = 0xf0;
+  unsupported[7] = 0xf0;
+  EXPECT_FALSE(batch.LoadFromBinary(unsupported));
+  EXPECT_TRUE(batch.LoadFromBinary(CreateTestROM()));
+}
+
+// Measures frames run per second with one thread and all threads. All threads
+// must run more, if there's more than one.
+TEST_F(EmulatorBatchTest, DISABLED_Throughput) {
+  constexpr int kInstanceCount = 64;
+  constexpr int kFrames = 5;
+  auto measure = [](int thread_count) {
+    EmulatorBatch batch(kInstanceCount, thread_count);
+    EXPECT_TRUE(batch.LoadFromBinary(CreateTestROM()));
+    auto start = std::chrono::steady_clock::now();
+    for (int frame = 0; frame < kFrames; ++frame)
+      batch.RunOneFrame(CreateInputs(kInstanceCount, frame));
+    std::chrono::duration<double> duration =
+        std::chrono::steady_clock::now() - start;
+    return kInstanceCount * kFrames / duration.count();
+  };
+
+  double single_thread = measure(1);
+  double all_threads = measure(0);
+  RecordProperty("single_thread_fps", static_cast<int>(single_thread));
+  RecordProperty("all_threads_fps", static_cast<int>(all_threads));
+  std::cout << "Frames per second of " << kInstanceCount
+            << " instances: " << single_thread << " (1 thread), "
+            << all_threads << " (" << std::thread::hardware_concurrency()
+            << " threads)" << std::endl;
+  if (std::thread::hardware_concurrency() > 1)
+    EXPECT_GT(all_threads, single_thread);
+}
+
+}  // namespace testing
+}  // namespace nes
+}  // namespace kiwi
@@ -12,19 +12,24 @@
 
 #include "nes/emulator_impl.h"
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <cstring>
 #include <memory>
-#include <mutex>
-#include <queue>
 
 #include "base/logging.h"
 #include "base/memory/scoped_refptr.h"
 #include "base/task/bind_post_task.h"
+#include "base/task/delayed_task_queue.h"
+#include "base/task/pending_task.h"
 #include "base/task/sequenced_task_runner.h"
 #include "nes/cpu.h"
 #include "nes/cpu_bus.h"
 #include "nes/emulator.h"
 #include "nes/emulator_states.h"
+#include "nes/mapper.h"
+#include "nes/mappers/mappers.h"
 #include "nes/ppu.h"
 #include "nes/ppu_bus.h"
 #include "nes/registers.h"
@@ -33,8 +38,42 @@ namespace kiwi {
 namespace nes {
 constexpr std::chrono::nanoseconds kNanoPerCycle =
     std::chrono::nanoseconds(559);
+// A frame has about 29781 CPU loops.
+constexpr int kLoopsPerFrame = 29781;
+// Frames synthesized while fast-forwarding, which are time-stretched into a
+// frame's length.
+constexpr int kFastForwardAudioFrames = 2;
+constexpr int kFrameWidth = 256;
+constexpr int kFrameHeight = 240;
+
+// Components of an emulator in compact modes, which are allocated at once.
+// The screen buffers are the largest, so they are placed at the end, after all
+// the small states which are touched every cycle.
+struct EmulatorImpl::CompactComponents {
+  CompactComponents(EmulatorImpl* emulator, APU::Output output)
+      : ppu(&ppu_bus, screenbuffers),
+        cpu(&cpu_bus),
+        apu(emulator, &cpu_bus, output) {}
+
+  PPUBus ppu_bus;
+  PPU ppu;
+  CPUBus cpu_bus;
+  CPU cpu;
+  APU apu;
+  Byte screenbuffers[2 * PPU::kFrameSize];
+};
 
 namespace {
+uint64_t NextFrameSequence() {
+  static std::atomic<uint64_t> g_frame_sequence{0};
+  return ++g_frame_sequence;
+}
+
+template <typename T, typename Deleter>
+size_t GetOwnedBytes(const std::unique_ptr<T, Deleter>& component) {
+  return component && component.get_deleter().owned ? sizeof(T) : 0;
+}
+
 class EmulatorRenderTaskRunner : public base::SequencedTaskRunner {
  public:
   friend class base::RefCountedThreadSafe<EmulatorRenderTaskRunner>;
@@ -57,26 +96,29 @@ class EmulatorRenderTaskRunner : public base::SequencedTaskRunner {
   ~EmulatorRenderTaskRunner() = default;
 
  public:
+  // Runs tasks which have been posted, and delayed tasks which are due. Tasks
+  // which they post run next time. As it runs once a frame, delayed tasks run
+  // at the first frame after they are due.
   void RunAllTasks();
-  base::OnceClosure PopTask();
-  bool HasTask();
 
  private:
-  std::queue<base::OnceClosure> tasks_while_rendering_unsafe_;
-  std::mutex mutex_for_tasks_while_rendering_;
+  // Other threads post while a frame is running, without waiting for it.
+  base::PendingTaskQueue tasks_while_rendering_;
+
+  // Delayed tasks which have been taken from |tasks_while_rendering_|.
+  base::DelayedTaskQueue delayed_tasks_;
 };
 
 bool EmulatorRenderTaskRunner::PostDelayedTask(const base::Location& from_here,
                                                base::OnceClosure task,
                                                base::TimeDelta delay) {
-  if (delay != base::TimeDelta()) {
-    LOG(ERROR) << "Post with delay is not supported.";
-    return false;
+  if (delay == base::TimeDelta()) {
+    tasks_while_rendering_.Push(
+        std::make_unique<base::PendingTask>(std::move(task)));
+  } else {
+    tasks_while_rendering_.Push(
+        std::make_unique<base::PendingTask>(std::move(task), delay));
   }
-
-  std::lock_guard<std::mutex> guard(mutex_for_tasks_while_rendering_);
-  tasks_while_rendering_unsafe_.push(std::move(task));
-
   return true;
 }
 
@@ -96,23 +138,17 @@ bool EmulatorRenderTaskRunner::PostTaskAndReply(const base::Location& from_here,
 }
 
 void EmulatorRenderTaskRunner::RunAllTasks() {
-  // Checks if any task to be run
-  while (HasTask()) {
-    base::OnceClosure task = PopTask();
-    std::move(task).Run();
-  }
-}
+  tasks_while_rendering_.Drain(
+      [this](std::unique_ptr<base::PendingTask> task) {
+        if (task->is_delayed())
+          delayed_tasks_.Push(std::move(task));
+        else
+          std::move(task->task).Run();
+      });
 
-bool EmulatorRenderTaskRunner::HasTask() {
-  std::lock_guard<std::mutex> guard(mutex_for_tasks_while_rendering_);
-  return !tasks_while_rendering_unsafe_.empty();
-}
-
-base::OnceClosure EmulatorRenderTaskRunner::PopTask() {
-  std::lock_guard<std::mutex> guard(mutex_for_tasks_while_rendering_);
-  base::OnceClosure task = std::move(tasks_while_rendering_unsafe_.front());
-  tasks_while_rendering_unsafe_.pop();
-  return task;
+  base::PendingTask::Clock::time_point now = base::PendingTask::Clock::now();
+  while (std::unique_ptr<base::PendingTask> task = delayed_tasks_.PopDue(now))
+    std::move(task->task).Run();
 }
 
 }  // namespace
@@ -132,16 +168,43 @@ void EmulatorImpl::PowerOn() {
     render_coroutine_ = emulator_task_runner_;
   }
 
-  ppu_bus_ = std::make_unique<PPUBus>();
-  ppu_ = std::make_unique<PPU>(ppu_bus_.get());
-  ppu_->SetObserver(this);
+  CreateComponents();
+  is_power_on_ = true;
+
+  if (debug_port_) {
+    debug_port_->OnCPUPowerOn(GetCPUContext());
+    debug_port_->OnPPUPowerOn(GetPPUContext());
+  }
+}
+
+void EmulatorImpl::CreateComponents() {
+  if (memory_mode_ == MemoryMode::kDefault) {
+    ppu_bus_ = ComponentPtr<PPUBus>(new PPUBus());
+    ppu_ = ComponentPtr<PPU>(new PPU(ppu_bus_.get()));
+    cpu_bus_ = ComponentPtr<CPUBus>(new CPUBus());
+    cpu_ = ComponentPtr<CPU>(new CPU(cpu_bus_.get()));
+    apu_ = ComponentPtr<APU>(new APU(this, cpu_bus_.get()));
+  } else {
+    constexpr EmulatorComponentDeleter kUnowned{false};
+    auto components = std::make_unique<CompactComponents>(
+        this, memory_mode_ == MemoryMode::kCompact ? APU::Output::kDefault
+                                                   : APU::Output::kNone);
+    ppu_bus_ = ComponentPtr<PPUBus>(&components->ppu_bus, kUnowned);
+    ppu_ = ComponentPtr<PPU>(&components->ppu, kUnowned);
+    cpu_bus_ = ComponentPtr<CPUBus>(&components->cpu_bus, kUnowned);
+    cpu_ = ComponentPtr<CPU>(&components->cpu, kUnowned);
+    apu_ = ComponentPtr<APU>(&components->apu, kUnowned);
+    // Old components, if any, are destroyed after nothing points to them.
+    compact_components_ = std::move(components);
+  }
 
-  cpu_bus_ = std::make_unique<CPUBus>();
+  ppu_->SetObserver(this);
   cpu_bus_->set_ppu(ppu_.get());
   cpu_bus_->set_emulator(this);
-
-  cpu_ = std::make_unique<CPU>(cpu_bus_.get());
   cpu_->SetObserver(this);
+  cpu_->set_idle_loop_enabled(idle_loop_skipping_);
+  cpu_->SetDecodedInstructionCacheEnabled(
+      decoded_instruction_cache_ && memory_mode_ == MemoryMode::kDefault);
 
   // Set callback for NMI interrupt
   ppu_->set_cpu_nmi_callback(base::BindRepeating(
@@ -150,15 +213,11 @@ void EmulatorImpl::PowerOn() {
   // Power up CPU, initialize memory and registers.
   cpu_->PowerUp();
 
-  apu_ = std::make_unique<APU>(this, cpu_bus_.get());
+  // Set callbacks for APU's IRQ and DMC DMA
   apu_->SetIRQCallback(
-      base::BindRepeating(&EmulatorImpl::OnIRQFromAPU, base::Unretained(this)));
-  is_power_on_ = true;
-
-  if (debug_port_) {
-    debug_port_->OnCPUPowerOn(GetCPUContext());
-    debug_port_->OnPPUPowerOn(GetPPUContext());
-  }
+      base::BindRepeating(&CPU::SetIRQLine, base::Unretained(cpu_.get())));
+  apu_->SetDMCDMACallback(base::BindRepeating(&CPU::SkipDMCDMACycles,
+                                              base::Unretained(cpu_.get())));
 }
 
 void EmulatorImpl::PowerOff() {
@@ -193,12 +252,12 @@ void EmulatorImpl::LoadFromFile(const base::FilePath& rom_path,
   }
 }
 
-void EmulatorImpl::LoadFromBinary(const Bytes& data, LoadCallback callback) {
+void EmulatorImpl::LoadFromBinary(Bytes data, LoadCallback callback) {
   if (render_coroutine_ != emulator_task_runner_) {
     render_coroutine_->PostTaskAndReplyWithResult(
         FROM_HERE,
         base::BindOnce(&EmulatorImpl::LoadFromBinaryOnProperThread,
-                       base::RetainedRef(this), data),
+                       base::RetainedRef(this), std::move(data)),
         base::BindOnce(std::move(callback)));
   } else {
     std::move(callback).Run(LoadFromBinaryOnProperThread(data));
@@ -258,7 +317,7 @@ void EmulatorImpl::LoadAndRun(const base::FilePath& rom_path,
   LoadFromFile(rom_path, std::move(load_callback));
 }
 
-void EmulatorImpl::LoadAndRun(const Bytes& data, LoadCallback callback) {
+void EmulatorImpl::LoadAndRun(Bytes data, LoadCallback callback) {
   LoadCallback load_callback = base::BindOnce(
       [](scoped_refptr<EmulatorImpl> emulator, LoadCallback callback,
          bool success) {
@@ -270,7 +329,7 @@ void EmulatorImpl::LoadAndRun(const Bytes& data, LoadCallback callback) {
         std::move(callback).Run(success);
       },
       base::RetainedRef(this), std::move(callback));
-  LoadFromBinary(data, std::move(load_callback));
+  LoadFromBinary(std::move(data), std::move(load_callback));
 }
 
 void EmulatorImpl::Unload(UnloadCallback callback) {
@@ -321,12 +380,20 @@ void EmulatorImpl::RunOneFrameOnProperThread() {
   if (debug_port_)
     debug_port_->performance_counter().Start();
 
-  // A frame has about 29781 CPU loops.
-  constexpr int kLoopsPerFrame = 29781;
-  for (int loop = 0; loop < kLoopsPerFrame; ++loop) {
-    if (running_state_ != RunningState::kRunning)
-      break;
-    StepInternal();
+  int fast_forward_speed = fast_forward_speed_;
+  apu_->SetTimeStretch(fast_forward_speed > 1 ? kFastForwardAudioFrames : 1);
+
+  int run_ahead_frames = run_ahead_frames_;
+  if (fast_forward_speed > 1) {
+    RunOneFrameWithFastForward(fast_forward_speed);
+  } else if (run_ahead_frames > 0) {
+    RunOneFrameWithRunAhead(run_ahead_frames, run_ahead_mode_);
+  } else {
+    for (int loop = 0; loop < kLoopsPerFrame; ++loop) {
+      if (running_state_ != RunningState::kRunning)
+        break;
+      StepInternal();
+    }
   }
   if (debug_port_)
     debug_port_->performance_counter().End();
@@ -337,9 +404,170 @@ void EmulatorImpl::RunOneFrameOnProperThread() {
   }
 }
 
+bool EmulatorImpl::RunUntilFrameReady() {
+  // A frame is treated as lost if the PPU doesn't finish it in 2 frames' time.
+  frame_ready_ = false;
+  for (int loop = 0; loop < kLoopsPerFrame * 2 && !frame_ready_; ++loop) {
+    if (running_state_ != RunningState::kRunning)
+      return false;
+    StepInternal();
+  }
+  return frame_ready_;
+}
+
+void EmulatorImpl::RunOneFrameWithRunAhead(int frames, RunAheadMode mode) {
+  DCHECK(emulator_task_runner_->RunsTasksInCurrentSequence());
+  // Runs the frame to be kept. Its audio is played, but its video is replaced
+  // by the frame run ahead.
+  present_frames_ = false;
+  bool frame_ready = RunUntilFrameReady();
+  present_frames_ = true;
+  if (!frame_ready)
+    return;
+
+  // Frames run ahead are hidden from the debug port.
+  DebugPort* debug_port = debug_port_;
+  debug_port_ = nullptr;
+  if (debug_port)
+    debug_port->performance_counter().RunAheadStart();
+
+  EmulatorImpl* emulator = this;
+  if (mode == RunAheadMode::kSecondInstance) {
+    emulator = GetRunAheadInstance();
+  } else {
+    EmulatorStates::CreateStateForVersion(this, EmulatorStates::kLatestVersion)
+        .BuildUncompressed(run_ahead_states_);
+    apu_->SetOutputSuspended(true);
+  }
+
+  emulator->present_frames_ = false;
+  for (int i = 0; i < frames; ++i) {
+    if (!emulator->RunUntilFrameReady())
+      break;
+  }
+  emulator->present_frames_ = true;
+
+  debug_port_ = debug_port;
+  PresentFrame(emulator);
+
+  if (emulator == this) {
+    EmulatorStates::CreateStateForVersion(this, EmulatorStates::kLatestVersion)
+        .RestoreOwnStates(run_ahead_states_);
+    apu_->SetOutputSuspended(false);
+  }
+
+  if (debug_port_)
+    debug_port_->performance_counter().RunAheadEnd();
+}
+
+void EmulatorImpl::RunOneFrameWithFastForward(int speed) {
+  DCHECK(emulator_task_runner_->RunsTasksInCurrentSequence());
+  // Frames before the last ones skip audio synthesis, and only the last frame
+  // is presented.
+  present_frames_ = false;
+  for (int i = 0; i < speed; ++i) {
+    apu_->SetOutputSuspended(i < speed - kFastForwardAudioFrames);
+    present_frames_ = i == speed - 1;
+    if (!RunUntilFrameReady())
+      break;
+  }
+  present_frames_ = true;
+  apu_->SetOutputSuspended(false);
+}
+
+EmulatorImpl* EmulatorImpl::GetRunAheadInstance() {
+  DCHECK(emulator_task_runner_->RunsTasksInCurrentSequence());
+  if (!run_ahead_instance_) {
+    // The instance never plays audio, and its frames are presented by this
+    // one.
+    run_ahead_instance_ = CreateClone();
+    run_ahead_instance_->apu_->SetOutputSuspended(true);
+    run_ahead_instance_->SetIODevices(std::make_unique<IODevices>());
+  } else {
+    run_ahead_instance_->CopyStatesFrom(this);
+  }
+
+  // Controllers are not a part of the states, sync them as well.
+  run_ahead_instance_->io_devices_->set_input_device(
+      io_devices_ ? io_devices_->input_device() : nullptr);
+  if (run_ahead_instance_->controller1_.type() != controller1_.type()) {
+    run_ahead_instance_->controller1_.SetType(run_ahead_instance_.get(),
+                                              controller1_.type());
+  }
+  if (run_ahead_instance_->controller2_.type() != controller2_.type()) {
+    run_ahead_instance_->controller2_.SetType(run_ahead_instance_.get(),
+                                              controller2_.type());
+  }
+  return run_ahead_instance_.get();
+}
+
+void EmulatorImpl::ResetRunAheadInstance() {
+  if (run_ahead_instance_) {
+    run_ahead_instance_->PowerOff();
+    run_ahead_instance_.reset();
+  }
+}
+
+void EmulatorImpl::PresentFrame(EmulatorImpl* source) {
+  if (debug_port_) {
+    if (debug_port_->render_paused())
+      return;
+
+    debug_port_->OnNametableRenderReady();
+  }
+
+  if (io_devices_) {
+    const Colors* frame = nullptr;
+    for (IODevices::RenderDevice* render_device :
+         io_devices_->render_devices()) {
+      CHECK(render_device);
+      if (render_device->NeedRender()) {
+        if (!frame) {
+          frame = &source->ppu_->last_frame();
+          UpdatePresentedFrame(*frame);
+        }
+        render_device->Render(kFrameWidth, kFrameHeight, *frame);
+      }
+    }
+  }
+}
+
+void EmulatorImpl::UpdatePresentedFrame(const Colors& frame) {
+  DCHECK_EQ(frame.size(), static_cast<size_t>(kFrameWidth * kFrameHeight));
+  FrameChanges& changes = presented_frame_changes_;
+  if (presented_frame_.empty()) {
+    presented_frame_ = frame;
+    changes.base_sequence = 0;
+    changes.sequence = NextFrameSequence();
+    changes.first_row = 0;
+    changes.end_row = kFrameHeight;
+    return;
+  }
+
+  // Rows which differ are copied, so that the copy is the new frame.
+  int first_row = kFrameHeight;
+  int end_row = 0;
+  for (int row = 0; row < kFrameHeight; ++row) {
+    const Color* pixels = frame.data() + row * kFrameWidth;
+    Color* presented_pixels = presented_frame_.data() + row * kFrameWidth;
+    if (std::memcmp(pixels, presented_pixels, kFrameWidth * sizeof(Color))) {
+      std::memcpy(presented_pixels, pixels, kFrameWidth * sizeof(Color));
+      first_row = std::min(first_row, row);
+      end_row = row + 1;
+    }
+  }
+  if (first_row < end_row) {
+    changes.base_sequence = changes.sequence;
+    changes.sequence = NextFrameSequence();
+    changes.first_row = first_row;
+    changes.end_row = end_row;
+  }
+}
+
 void EmulatorImpl::PowerOffOnProperThread() {
   DCHECK(emulator_task_runner_->RunsTasksInCurrentSequence());
   SetDebugPort(nullptr);
+  ResetRunAheadInstance();
   cpu_.reset();
   ppu_.reset();
   ppu_bus_.reset();
@@ -354,7 +582,9 @@ Bytes EmulatorImpl::SaveStateOnProperThread() {
   DCHECK(emulator_task_runner_->RunsTasksInCurrentSequence());
 
   if (running_state_ != Emulator::RunningState::kStopped) {
-    return EmulatorStates::CreateStateForVersion(this, 1).Build();
+    return EmulatorStates::CreateStateForVersion(
+               this, EmulatorStates::kLatestVersion)
+        .Build(EmulatorStates::Compression::kZlib);
   } else {
     return Bytes();
   }
@@ -365,7 +595,9 @@ bool EmulatorImpl::LoadStateOnProperThread(const Bytes& data) {
 
   bool success;
   if (running_state_ != Emulator::RunningState::kStopped) {
-    success = EmulatorStates::CreateStateForVersion(this, 1).Restore(data);
+    success = EmulatorStates::CreateStateForVersion(
+                  this, EmulatorStates::kLatestVersion)
+                  .Restore(data);
   } else {
     success = false;
   }
@@ -390,6 +622,7 @@ void EmulatorImpl::UnloadOnProperThread() {
   DCHECK(emulator_task_runner_->RunsTasksInCurrentSequence());
   CHECK(is_power_on()) << "Make sure Emulator is power on.";
   running_state_ = RunningState::kStopped;
+  ResetRunAheadInstance();
   ResetOnProperThread();
 }
 
@@ -403,11 +636,6 @@ void EmulatorImpl::PostReset(RunningState last_state) {
   }
 }
 
-void EmulatorImpl::OnIRQFromAPU() {
-  // TODO Handle APU IRQ
-  DLOG(INFO) << "OnIRQFromAPU() is unhandled yet.";
-}
-
 void EmulatorImpl::SetControllerTypes(uint32_t crc32) {
   switch (crc32) {
     case 0x24598791:  // Duck Hunt
@@ -466,16 +694,24 @@ bool EmulatorImpl::HandleLoadedResult(Cartridge::LoadResult load_result,
     return false;
 
   UnloadOnProperThread();
-  cartridge_ = cartridge;
+  AttachCartridge(cartridge);
   if (debug_port_) {
     debug_port_->OnRomLoaded(load_result.success, cartridge->GetRomData());
   }
 
+  SetControllerTypes(cartridge->crc32());
+
+  // Reset CPU and PPU.
+  ResetOnProperThread();
+  return true;
+}
+
+void EmulatorImpl::AttachCartridge(scoped_refptr<Cartridge> cartridge) {
+  cartridge_ = cartridge;
+
   // Set patch config for PPU
   ppu_->SetPatch(cartridge->crc32());
 
-  SetControllerTypes(cartridge->crc32());
-
   // Set mapper for buses.
   cpu_bus_->SetMapper(cartridge->mapper());
   ppu_bus_->SetMapper(cartridge->mapper());
@@ -483,12 +719,42 @@ bool EmulatorImpl::HandleLoadedResult(Cartridge::LoadResult load_result,
       &PPUBus::UpdateMirroring, base::Unretained(ppu_bus_.get())));
   cartridge->mapper()->set_irq_callback(base::BindRepeating(
       &CPU::Interrupt, base::Unretained(cpu_.get()), CPU::InterruptType::IRQ));
+  SelectStepLoop(cartridge->GetRomData()->mapper);
+}
 
-  // Reset CPU and PPU.
-  ResetOnProperThread();
-  return true;
+void EmulatorImpl::SelectStepLoop(Byte mapper) {
+  step_internal_ = &EmulatorImpl::StepInternal<Mapper>;
+  if (!mapper_step_loops_)
+    return;
+
+  switch (mapper) {
+#define SELECT_STEP_LOOP(number, type)                  \
+  case number:                                          \
+    step_internal_ = &EmulatorImpl::StepInternal<type>; \
+    break;
+    KIWI_NES_FOR_EACH_MAPPER(SELECT_STEP_LOOP)
+#undef SELECT_STEP_LOOP
+    default:
+      break;
+  }
+}
+
+void EmulatorImpl::CopyStatesFrom(EmulatorImpl* other) {
+  DCHECK(other->cartridge_ && other->cartridge_->is_loaded());
+  // The cartridge is cloned only once for each game. Later copies keep the
+  // cartridge and its callbacks, and only copy the mapper's states.
+  if (cartridge_ && cartridge_->GetRomData() == other->cartridge_->GetRomData())
+    cartridge_->CopyStatesFrom(*other->cartridge_);
+  else
+    AttachCartridge(other->cartridge_->Clone(this));
+  cpu_->CopyStatesFrom(*other->cpu_);
+  cpu_bus_->CopyStatesFrom(*other->cpu_bus_);
+  ppu_->CopyStatesFrom(*other->ppu_);
+  ppu_bus_->CopyStatesFrom(*other->ppu_bus_);
+  apu_->CopyStatesFrom(*other->apu_);
 }
 
+template <typename MapperType>
 void EmulatorImpl::StepInternal() {
   apu_->increase_cycles();
 
@@ -496,9 +762,9 @@ void EmulatorImpl::StepInternal() {
   // PPU
   if (debug_port_)
     debug_port_->performance_counter().PPUStart();
-  ppu_->Step();
-  ppu_->Step();
-  ppu_->Step();
+  ppu_->Step<MapperType>();
+  ppu_->Step<MapperType>();
+  ppu_->Step<MapperType>();
   if (debug_port_)
     debug_port_->performance_counter().PPUEnd();
 
@@ -506,6 +772,8 @@ void EmulatorImpl::StepInternal() {
   if (debug_port_)
     debug_port_->performance_counter().CPUStart();
   cpu_->Step();
+  // Mappers, such as mapper 40, count M2 cycles of the CPU.
+  MapperDispatch<MapperType>::M2CycleIRQ(cpu_bus_->GetMapper());
   if (debug_port_)
     debug_port_->performance_counter().CPUEnd();
 
@@ -537,14 +805,73 @@ void EmulatorImpl::SaveState(SaveStateCallback callback) {
       std::move(callback));
 }
 
-void EmulatorImpl::LoadState(const Bytes& data, LoadCallback callback) {
+void EmulatorImpl::LoadState(Bytes data, LoadCallback callback) {
   render_coroutine_->PostTaskAndReplyWithResult(
       FROM_HERE,
       base::BindOnce(&EmulatorImpl::LoadStateOnProperThread,
-                     base::RetainedRef(this), data),
+                     base::RetainedRef(this), std::move(data)),
       std::move(callback));
 }
 
+const Byte* EmulatorImpl::GetRAM() {
+  DCHECK(cpu_bus_);
+  return cpu_bus_->GetPagePointer(0);
+}
+
+const Byte* EmulatorImpl::GetLastIndexedFrame() {
+  DCHECK(ppu_);
+  return ppu_->last_indexed_frame();
+}
+
+void EmulatorImpl::SetIdleLoopSkipping(bool enabled) {
+  idle_loop_skipping_ = enabled;
+  if (cpu_)
+    cpu_->set_idle_loop_enabled(enabled);
+}
+
+void EmulatorImpl::SetDecodedInstructionCache(bool enabled) {
+  decoded_instruction_cache_ = enabled;
+  if (cpu_) {
+    cpu_->SetDecodedInstructionCacheEnabled(
+        enabled && memory_mode_ == MemoryMode::kDefault);
+  }
+}
+
+void EmulatorImpl::SetMapperStepLoops(bool enabled) {
+  mapper_step_loops_ = enabled;
+  if (cartridge_)
+    SelectStepLoop(cartridge_->GetRomData()->mapper);
+}
+
+bool EmulatorImpl::IsReplayingIdleLoop() {
+  DCHECK(cpu_);
+  return cpu_->is_replaying_idle_loop();
+}
+
+scoped_refptr<Emulator> EmulatorImpl::Clone() {
+  return CreateClone();
+}
+
+scoped_refptr<EmulatorImpl> EmulatorImpl::CreateClone() {
+  DCHECK(emulator_task_runner_->RunsTasksInCurrentSequence());
+  DCHECK(is_power_on() && cartridge_);
+  scoped_refptr<EmulatorImpl> clone = base::MakeRefCounted<EmulatorImpl>();
+  clone->SetForTesting();
+  clone->emulator_task_runner_ = emulator_task_runner_;
+  clone->render_coroutine_ = emulator_task_runner_;
+  clone->memory_mode_ = memory_mode_;
+  clone->idle_loop_skipping_ = idle_loop_skipping_;
+  clone->decoded_instruction_cache_ = decoded_instruction_cache_;
+  clone->mapper_step_loops_ = mapper_step_loops_;
+  clone->CreateComponents();
+  clone->is_power_on_ = true;
+  clone->CopyStatesFrom(this);
+  clone->controller1_.SetType(clone.get(), controller1_.type());
+  clone->controller2_.SetType(clone.get(), controller2_.type());
+  clone->running_state_ = running_state_.load();
+  return clone;
+}
+
 void EmulatorImpl::SetVolume(float volume) {
   apu_->SetVolume(volume);
 }
@@ -553,11 +880,53 @@ float EmulatorImpl::GetVolume() {
   return apu_->GetVolume();
 }
 
+void EmulatorImpl::SetRunAhead(int frames, RunAheadMode mode) {
+  DCHECK(frames >= 0);
+  run_ahead_frames_ = frames;
+  run_ahead_mode_ = mode;
+}
+
+void EmulatorImpl::SetFastForward(int speed) {
+  DCHECK(speed >= 1 && speed <= kMaxFastForwardSpeed);
+  fast_forward_speed_ = speed;
+}
+
+void EmulatorImpl::SetMemoryMode(MemoryMode mode) {
+  DCHECK(!is_power_on()) << "Memory mode must be set before powering on.";
+  memory_mode_ = mode;
+}
+
+Emulator::MemoryMode EmulatorImpl::GetMemoryMode() {
+  return memory_mode_;
+}
+
+size_t EmulatorImpl::GetMemoryFootprint() {
+  size_t bytes = sizeof(*this) + GetOwnedBytes(cpu_) +
+                 GetOwnedBytes(cpu_bus_) + GetOwnedBytes(ppu_) +
+                 GetOwnedBytes(ppu_bus_) + GetOwnedBytes(apu_);
+  if (compact_components_)
+    bytes += sizeof(CompactComponents);
+  if (cpu_)
+    bytes += cpu_->GetAllocatedBytes();
+  if (ppu_)
+    bytes += ppu_->GetAllocatedBytes();
+  if (apu_)
+    bytes += apu_->GetAllocatedBytes();
+  if (run_ahead_instance_)
+    bytes += run_ahead_instance_->GetMemoryFootprint();
+  return bytes;
+}
+
 const Colors& EmulatorImpl::GetLastFrame() {
   DCHECK(emulator_task_runner_->RunsTasksInCurrentSequence());
   return ppu_->last_frame();
 }
 
+Emulator::FrameChanges EmulatorImpl::GetPresentedFrameChanges() {
+  DCHECK(emulator_task_runner_->RunsTasksInCurrentSequence());
+  return presented_frame_changes_;
+}
+
 Byte EmulatorImpl::Read(Address address) {
   DCHECK(emulator_task_runner_->RunsTasksInCurrentSequence());
   switch (static_cast<IORegister>(address)) {
@@ -639,28 +1008,15 @@ void EmulatorImpl::OnPPUFrameEnd() {
   }
 }
 
-void EmulatorImpl::OnRenderReady(const Colors& swapbuffer) {
+void EmulatorImpl::OnRenderReady() {
   DCHECK(emulator_task_runner_->RunsTasksInCurrentSequence());
   // Render is ready, update APU state here.
 
   apu_->StepFrame();
+  frame_ready_ = true;
 
-  if (debug_port_) {
-    if (debug_port_->render_paused())
-      return;
-
-    debug_port_->OnNametableRenderReady();
-  }
-
-  if (io_devices_) {
-    for (IODevices::RenderDevice* render_device :
-         io_devices_->render_devices()) {
-      CHECK(render_device);
-      if (render_device->NeedRender()) {
-        render_device->Render(256, 240, swapbuffer);
-      }
-    }
-  }
+  if (present_frames_)
+    PresentFrame(this);
 }
 
 void EmulatorImpl::OnCPUNMI() {
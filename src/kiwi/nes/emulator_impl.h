@@ -36,6 +36,18 @@ class CPUBus;
 class PPU;
 class EmulatorStates;
 
+// Components of an emulator are deleted by their pointers, unless they are a
+// part of the emulator's compact allocation.
+struct EmulatorComponentDeleter {
+  bool owned = true;
+
+  template <typename T>
+  void operator()(T* component) const {
+    if (owned)
+      delete component;
+  }
+};
+
 // Emulator stands for the virtual machine of NES.
 class EmulatorImpl : public Emulator, public PPUObserver, public CPUObserver {
  public:
@@ -49,14 +61,14 @@ class EmulatorImpl : public Emulator, public PPUObserver, public CPUObserver {
   void PowerOff() override;
   void LoadFromFile(const base::FilePath& rom_path,
                     LoadCallback callback) override;
-  void LoadFromBinary(const Bytes& data, LoadCallback callback) override;
+  void LoadFromBinary(Bytes data, LoadCallback callback) override;
   const RomData* GetRomData() override;
   void Run() override;
   void RunOneFrame() override;
   void Pause() override;
   void LoadAndRun(const base::FilePath& rom_path,
                   LoadCallback callback) override;
-  void LoadAndRun(const Bytes& data, LoadCallback callback) override;
+  void LoadAndRun(Bytes data, LoadCallback callback) override;
   void Unload(UnloadCallback callback) override;
   void Reset(ResetCallback reset_callback) override;
   void Step() override;
@@ -65,10 +77,17 @@ class EmulatorImpl : public Emulator, public PPUObserver, public CPUObserver {
   void SetIODevices(std::unique_ptr<IODevices> io_devices) override;
   IODevices* GetIODevices() override;
   void SaveState(SaveStateCallback callback) override;
-  void LoadState(const Bytes& data, LoadCallback callback) override;
+  void LoadState(Bytes data, LoadCallback callback) override;
+  scoped_refptr<Emulator> Clone() override;
   void SetVolume(float volume) override;
   float GetVolume() override;
   const Colors& GetLastFrame() override;
+  FrameChanges GetPresentedFrameChanges() override;
+  void SetRunAhead(int frames, RunAheadMode mode) override;
+  void SetFastForward(int speed) override;
+  void SetMemoryMode(MemoryMode mode) override;
+  MemoryMode GetMemoryMode() override;
+  size_t GetMemoryFootprint() override;
 
   // Device:
   Byte Read(Address address) override;
@@ -81,7 +100,7 @@ class EmulatorImpl : public Emulator, public PPUObserver, public CPUObserver {
   void OnPPUScanlineEnd(int scanline) override;
   void OnPPUFrameStart() override;
   void OnPPUFrameEnd() override;
-  void OnRenderReady(const Colors& swapbuffer) override;
+  void OnRenderReady() override;
 
   // CPUObserver:
   void OnCPUNMI() override;
@@ -110,44 +129,120 @@ class EmulatorImpl : public Emulator, public PPUObserver, public CPUObserver {
  public:
   bool is_power_on() { return is_power_on_; }
 
+  // Returns the CPU's internal RAM, which is 2KB.
+  const Byte* GetRAM();
+
+  // Returns the last frame as palette indices in compact modes, or nullptr.
+  const Byte* GetLastIndexedFrame();
+
+  // Sets whether the CPU replays idle loops instead of executing them, see
+  // CPU::set_idle_loop_enabled(). The result is the same either way, it is
+  // enabled by default.
+  void SetIdleLoopSkipping(bool enabled);
+  bool IsReplayingIdleLoop();
+
+  // Sets whether the CPU caches decoded instructions, see
+  // CPU::SetDecodedInstructionCacheEnabled(). It is enabled by default, but
+  // never in compact modes.
+  void SetDecodedInstructionCache(bool enabled);
+
+  // Sets whether the emulator steps in a loop specialized for the cartridge's
+  // mapper, which calls the mapper without virtual dispatch. The result is the
+  // same either way, it is enabled by default.
+  void SetMapperStepLoops(bool enabled);
+
  private:
   // Set emulator for testing. All async methods will run on the same thread.
   void SetForTesting();
   friend scoped_refptr<Emulator> CreateEmulatorForTesting();
 
  private:
+  // Creates and connects CPU, PPU, APU and their buses.
+  void CreateComponents();
+  // Connects |cartridge|'s mapper to the buses.
+  void AttachCartridge(scoped_refptr<Cartridge> cartridge);
+  // Copies states of all components from |other|, which runs the same ROM.
+  void CopyStatesFrom(EmulatorImpl* other);
+  scoped_refptr<EmulatorImpl> CreateClone();
   bool LoadFromFileOnProperThread(const base::FilePath& rom_path);
   bool LoadFromBinaryOnProperThread(const Bytes& data);
   bool HandleLoadedResult(Cartridge::LoadResult load_result,
                           scoped_refptr<Cartridge> cartridge);
+  // Steps a CPU cycle through |step_internal_|.
+  void StepInternal() { (this->*step_internal_)(); }
+  template <typename MapperType>
   void StepInternal();
+  // Selects the step loop of |mapper|, see SetMapperStepLoops().
+  void SelectStepLoop(Byte mapper);
   void RunOneFrameOnProperThread();
+  // Steps until the PPU finishes a frame. Returns false if the emulator isn't
+  // running, or no frame has been finished.
+  bool RunUntilFrameReady();
+  void RunOneFrameWithRunAhead(int frames, RunAheadMode mode);
+  void RunOneFrameWithFastForward(int speed);
+  EmulatorImpl* GetRunAheadInstance();
+  void ResetRunAheadInstance();
+  // Presents the last frame of |source|, which is this emulator or its
+  // run-ahead instance. Frames are converted to colors only if they are
+  // rendered.
+  void PresentFrame(EmulatorImpl* source);
+  // Compares |frame|, which is being presented, with the frame presented
+  // before, and updates |presented_frame_changes_|.
+  void UpdatePresentedFrame(const Colors& frame);
   void PowerOffOnProperThread();
   Bytes SaveStateOnProperThread();
   bool LoadStateOnProperThread(const Bytes& data);
   void ResetOnProperThread();
   void UnloadOnProperThread();
   void PostReset(RunningState last_state);
-  void OnIRQFromAPU();
   void SetControllerTypes(uint32_t crc32);
   // EmulatorStates will dump states from emulator, it can access all members.
   friend class EmulatorStates;
 
+  template <typename T>
+  using ComponentPtr = std::unique_ptr<T, EmulatorComponentDeleter>;
+  struct CompactComponents;
+
  private:
   bool is_power_on_ = false;
   bool set_for_testing_ = false;
+  MemoryMode memory_mode_ = MemoryMode::kDefault;
+  bool idle_loop_skipping_ = true;
+  bool decoded_instruction_cache_ = true;
+  bool mapper_step_loops_ = true;
+  void (EmulatorImpl::*step_internal_)() = &EmulatorImpl::StepInternal<Mapper>;
+  // Holds all components in compact modes. It is declared before them, so
+  // that it outlives the pointers.
+  std::unique_ptr<CompactComponents> compact_components_;
   // NTSC NES: 1.789773 MHz (~559 ns per cycle)
-  std::unique_ptr<CPU> cpu_;
-  std::unique_ptr<CPUBus> cpu_bus_;
-  std::unique_ptr<PPU> ppu_;
-  std::unique_ptr<PPUBus> ppu_bus_;
-  std::unique_ptr<APU> apu_;
+  ComponentPtr<CPU> cpu_;
+  ComponentPtr<CPUBus> cpu_bus_;
+  ComponentPtr<PPU> ppu_;
+  ComponentPtr<PPUBus> ppu_bus_;
+  ComponentPtr<APU> apu_;
   scoped_refptr<Cartridge> cartridge_;
   Controller controller1_;
   Controller controller2_;
   std::atomic<RunningState> running_state_ = RunningState::kStopped;
   std::unique_ptr<IODevices> io_devices_;
 
+  // Run-ahead.
+  std::atomic<int> run_ahead_frames_ = 0;
+  std::atomic<RunAheadMode> run_ahead_mode_ = RunAheadMode::kSingleInstance;
+  // Frames are presented only when this is set.
+  bool present_frames_ = true;
+  // A copy of the frame last presented, which the next one is compared with
+  // row by row, and how it changed.
+  Colors presented_frame_;
+  FrameChanges presented_frame_changes_;
+  bool frame_ready_ = false;
+  scoped_refptr<EmulatorImpl> run_ahead_instance_;
+  // States which single-instance run-ahead rolls back to. The buffer is kept,
+  // so that it isn't allocated every frame.
+  Bytes run_ahead_states_;
+
+  std::atomic<int> fast_forward_speed_ = 1;
+
   DebugPort* debug_port_ = nullptr;
   scoped_refptr<base::SequencedTaskRunner> emulator_task_runner_;
   scoped_refptr<base::SequencedTaskRunner> render_coroutine_;
@@ -0,0 +1,1080 @@
+// Copyright (C) 2026 Yisi Yu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#include "kiwi/nes/emulator_impl.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+#include "kiwi/base/files/file_util.h"
+#include "kiwi/nes/ppu.h"
+#include "kiwi/nes/time_stretch.h"
+#include "kiwi/testing/allocation_counter.h"
+#include "kiwi/testing/rom_test.h"
+
+namespace kiwi {
+namespace nes {
+namespace testing {
+
+namespace {
+constexpr int kFrameCount = 60;
+
+// An NROM program which changes the backdrop color and the pitch of pulse 1
+// every frame, so that each frame can be told from others.
+constexpr Byte kProgram[] = {
+    // Reset, at $C000
+    0x78,              // SEI
+    0xd8,              // CLD
+    0xa2, 0xff,        // LDX #$FF
+    0x9a,              // TXS
+    0x2c, 0x02, 0x20,  // BIT $2002
+    0x10, 0xfb,        // BPL $C005
+    0x2c, 0x02, 0x20,  // BIT $2002
+    0x10, 0xfb,        // BPL $C00A
+    0xa9, 0x01,        // LDA #$01
+    0x8d, 0x15, 0x40,  // STA $4015
+    0xa9, 0xbf,        // LDA #$BF
+    0x8d, 0x00, 0x40,  // STA $4000
+    0xa9, 0x00,        // LDA #$00
+    0x8d, 0x03, 0x40,  // STA $4003
+    0xa9, 0x80,        // LDA #$80
+    0x8d, 0x00, 0x20,  // STA $2000
+    0xa9, 0x08,        // LDA #$08
+    0x8d, 0x01, 0x20,  // STA $2001
+    0x4c, 0x28, 0xc0,  // JMP $C028
+    // NMI, at $C02B
+    0xe6, 0x00,        // INC $00
+    0xa5, 0x00,        // LDA $00
+    0x8d, 0x02, 0x40,  // STA $4002
+    0xa9, 0x3f,        // LDA #$3F
+    0x8d, 0x06, 0x20,  // STA $2006
+    0xa9, 0x00,        // LDA #$00
+    0x8d, 0x06, 0x20,  // STA $2006
+    0xa5, 0x00,        // LDA $00
+    0x29, 0x3f,        // AND #$3F
+    0x8d, 0x07, 0x20,  // STA $2007
+    0xa9, 0x00,        // LDA #$00
+    0x8d, 0x06, 0x20,  // STA $2006
+    0x8d, 0x06, 0x20,  // STA $2006
+    0x40,              // RTI
+    // IRQ, at $C04C
+    0x40,  // RTI
+};
+constexpr Address kNMIVector = 0xc02b;
+constexpr Address kResetVector = 0xc000;
+constexpr Address kIRQVector = 0xc04c;
+
+Bytes CreateTestROM() {
+  return CreateNROMForTesting(kProgram, sizeof(kProgram), kNMIVector,
+                              kResetVector, kIRQVector);
+}
+
+// Like CreateTestROM(), but the NMI masks the backdrop with #$00 instead of
+// #$3F, so that every frame is the same.
+Bytes CreateStillTestROM() {
+  Bytes program(std::begin(kProgram), std::end(kProgram));
+  // The operand of AND #$3F in the NMI.
+  constexpr size_t kBackdropMaskOffset = kNMIVector - kResetVector + 20;
+  EXPECT_EQ(program[kBackdropMaskOffset], 0x3f);
+  program[kBackdropMaskOffset] = 0;
+  return CreateNROMForTesting(program.data(), program.size(), kNMIVector,
+                              kResetVector, kIRQVector);
+}
+
+// Like kProgram, but the main loop waits for NMI by polling RAM, and then
+// counts down X before waiting again.
+constexpr Byte kPollingProgram[] = {
+    // Reset, at $C000
+    0x78,              // SEI
+    0xd8,              // CLD
+    0xa2, 0xff,        // LDX #$FF
+    0x9a,              // TXS
+    0x2c, 0x02, 0x20,  // BIT $2002
+    0x10, 0xfb,        // BPL $C005
+    0x2c, 0x02, 0x20,  // BIT $2002
+    0x10, 0xfb,        // BPL $C00A
+    0xa9, 0x01,        // LDA #$01
+    0x8d, 0x15, 0x40,  // STA $4015
+    0xa9, 0xbf,        // LDA #$BF
+    0x8d, 0x00, 0x40,  // STA $4000
+    0xa9, 0x00,        // LDA #$00
+    0x8d, 0x03, 0x40,  // STA $4003
+    0xa9, 0x80,        // LDA #$80
+    0x8d, 0x00, 0x20,  // STA $2000
+    0xa9, 0x08,        // LDA #$08
+    0x8d, 0x01, 0x20,  // STA $2001
+    // Main loop, at $C028
+    0xa5, 0x00,        // LDA $00
+    0xc5, 0x01,        // CMP $01
+    0xf0, 0xfa,        // BEQ $C028
+    0x85, 0x01,        // STA $01
+    0x8d, 0x02, 0x40,  // STA $4002
+    0xa2, 0x40,        // LDX #$40
+    0xca,              // DEX
+    0xd0, 0xfd,        // BNE $C035
+    0x4c, 0x28, 0xc0,  // JMP $C028
+    // NMI, at $C03B
+    0xe6, 0x00,        // INC $00
+    0xa9, 0x3f,        // LDA #$3F
+    0x8d, 0x06, 0x20,  // STA $2006
+    0xa9, 0x00,        // LDA #$00
+    0x8d, 0x06, 0x20,  // STA $2006
+    0xa5, 0x00,        // LDA $00
+    0x29, 0x3f,        // AND #$3F
+    0x8d, 0x07, 0x20,  // STA $2007
+    0xa9, 0x00,        // LDA #$00
+    0x8d, 0x06, 0x20,  // STA $2006
+    0x8d, 0x06, 0x20,  // STA $2006
+    0x40,              // RTI
+    // IRQ, at $C05A
+    0x40,  // RTI
+};
+
+Bytes CreatePollingTestROM() {
+  return CreateNROMForTesting(kPollingProgram, sizeof(kPollingProgram), 0xc03b,
+                              kResetVector, 0xc05a);
+}
+
+// An NROM program which plays all channels, and counts IRQs of DMC and the
+// frame counter at $02. Their status, read from $4015, is kept at $01 every
+// frame, and at $03 in every IRQ.
+constexpr Byte kAPUProgram[] = {
+    // Reset, at $C000
+    0x78,              // SEI
+    0xd8,              // CLD
+    0xa2, 0xff,        // LDX #$FF
+    0x9a,              // TXS
+    0x2c, 0x02, 0x20,  // BIT $2002
+    0x10, 0xfb,        // BPL $C005
+    0x2c, 0x02, 0x20,  // BIT $2002
+    0x10, 0xfb,        // BPL $C00A
+    0xa9, 0x0f,        // LDA #$0F
+    0x8d, 0x15, 0x40,  // STA $4015
+    0xa9, 0xbf,        // LDA #$BF
+    0x8d, 0x00, 0x40,  // STA $4000
+    0x8d, 0x0c, 0x40,  // STA $400C
+    0xa9, 0xff,        // LDA #$FF
+    0x8d, 0x08, 0x40,  // STA $4008
+    0xa9, 0x00,        // LDA #$00
+    0x8d, 0x03, 0x40,  // STA $4003
+    0x8d, 0x0b, 0x40,  // STA $400B
+    0x8d, 0x0f, 0x40,  // STA $400F
+    0x8d, 0x12, 0x40,  // STA $4012
+    0x8d, 0x17, 0x40,  // STA $4017
+    0xa9, 0x01,        // LDA #$01
+    0x8d, 0x13, 0x40,  // STA $4013
+    0xa9, 0x8f,        // LDA #$8F
+    0x8d, 0x10, 0x40,  // STA $4010
+    0xa9, 0x1f,        // LDA #$1F
+    0x8d, 0x15, 0x40,  // STA $4015
+    0xa9, 0x80,        // LDA #$80
+    0x8d, 0x00, 0x20,  // STA $2000
+    0xa9, 0x08,        // LDA #$08
+    0x8d, 0x01, 0x20,  // STA $2001
+    0x58,              // CLI
+    // Main loop, at $C04C
+    0x4c, 0x4c, 0xc0,  // JMP $C04C
+    // NMI, at $C04F
+    0xe6, 0x00,        // INC $00
+    0xa5, 0x00,        // LDA $00
+    0x8d, 0x02, 0x40,  // STA $4002
+    0x8d, 0x0a, 0x40,  // STA $400A
+    0x8d, 0x0e, 0x40,  // STA $400E
+    0xad, 0x15, 0x40,  // LDA $4015
+    0x85, 0x01,        // STA $01
+    0xa9, 0x3f,        // LDA #$3F
+    0x8d, 0x06, 0x20,  // STA $2006
+    0xa9, 0x00,        // LDA #$00
+    0x8d, 0x06, 0x20,  // STA $2006
+    0xa5, 0x00,        // LDA $00
+    0x29, 0x3f,        // AND #$3F
+    0x8d, 0x07, 0x20,  // STA $2007
+    0xa9, 0x00,        // LDA #$00
+    0x8d, 0x06, 0x20,  // STA $2006
+    0x8d, 0x06, 0x20,  // STA $2006
+    0x40,              // RTI
+    // IRQ, at $C07B
+    0xe6, 0x02,        // INC $02
+    0xad, 0x15, 0x40,  // LDA $4015
+    0x85, 0x03,        // STA $03
+    0xa9, 0x1f,        // LDA #$1F
+    0x8d, 0x15, 0x40,  // STA $4015
+    0x40,  // RTI
+};
+
+Bytes CreateAPUTestROM() {
+  return CreateNROMForTesting(kAPUProgram, sizeof(kAPUProgram), 0xc04f,
+                              kResetVector, 0xc07b);
+}
+
+// An MMC3 program which takes a scanline IRQ 20 scanlines into each frame,
+// counted at $02, with APU frame IRQs inhibited. The IRQ turns rendering off
+// and changes the backdrop, so that it shows in frames, and NMI turns them
+// back. NMI reloads the counter after its palette writes, which clock it
+// through A12, and switches CHR banks every frame.
+constexpr Byte kMMC3Program[] = {
+    // Reset, at $C000
+    0x78,              // SEI
+    0xd8,              // CLD
+    0xa2, 0xff,        // LDX #$FF
+    0x9a,              // TXS
+    0x2c, 0x02, 0x20,  // BIT $2002
+    0x10, 0xfb,        // BPL $C005
+    0x2c, 0x02, 0x20,  // BIT $2002
+    0x10, 0xfb,        // BPL $C00A
+    0xa9, 0x40,        // LDA #$40
+    0x8d, 0x17, 0x40,  // STA $4017
+    0xa9, 0x14,        // LDA #$14
+    0x8d, 0x00, 0xc0,  // STA $C000
+    0x8d, 0x01, 0xc0,  // STA $C001
+    0x8d, 0x01, 0xe0,  // STA $E001
+    0xa9, 0x88,        // LDA #$88
+    0x8d, 0x00, 0x20,  // STA $2000
+    0xa9, 0x18,        // LDA #$18
+    0x8d, 0x01, 0x20,  // STA $2001
+    0x58,              // CLI
+    0x4c, 0x2a, 0xc0,  // JMP $C02A
+    // NMI, at $C02D
+    0xe6, 0x00,        // INC $00
+    0xa9, 0x00,        // LDA #$00
+    0x8d, 0x00, 0x80,  // STA $8000
+    0xa5, 0x00,        // LDA $00
+    0x29, 0x06,        // AND #$06
+    0x8d, 0x01, 0x80,  // STA $8001
+    0xa9, 0x3f,        // LDA #$3F
+    0x8d, 0x06, 0x20,  // STA $2006
+    0xa9, 0x00,        // LDA #$00
+    0x8d, 0x06, 0x20,  // STA $2006
+    0xa9, 0x10,        // LDA #$10
+    0x8d, 0x07, 0x20,  // STA $2007
+    0xa9, 0x00,        // LDA #$00
+    0x8d, 0x06, 0x20,  // STA $2006
+    0x8d, 0x06, 0x20,  // STA $2006
+    0x8d, 0x01, 0xc0,  // STA $C001
+    0x8d, 0x01, 0xe0,  // STA $E001
+    0xa9, 0x18,        // LDA #$18
+    0x8d, 0x01, 0x20,  // STA $2001
+    0x40,              // RTI
+    // IRQ, at $C05E
+    0x48,              // PHA
+    0x8d, 0x00, 0xe0,  // STA $E000
+    0xe6, 0x02,        // INC $02
+    0xa9, 0x00,        // LDA #$00
+    0x8d, 0x01, 0x20,  // STA $2001
+    0xa9, 0x3f,        // LDA #$3F
+    0x8d, 0x06, 0x20,  // STA $2006
+    0xa9, 0x00,        // LDA #$00
+    0x8d, 0x06, 0x20,  // STA $2006
+    0xa9, 0x16,        // LDA #$16
+    0x8d, 0x07, 0x20,  // STA $2007
+    0x68,              // PLA
+    0x40,              // RTI
+};
+
+Bytes CreateMMC3TestROM() {
+  Bytes rom = CreateNROMForTesting(kMMC3Program, sizeof(kMMC3Program), 0xc02d,
+                                   kResetVector, 0xc05e);
+  // Mapper 4. The 16KB PRG-ROM is two 8KB banks, which MMC3 maps at $C000 and
+  // $E000, where NROM maps it.
+  rom[6] = 0x40;
+  return rom;
+}
+
+// Records everything the emulator outputs.
+class Recorder : public IODevices::RenderDevice,
+                 public IODevices::AudioDevice {
+ public:
+  // IODevices::RenderDevice:
+  void Render(int width, int height, const Colors& buffer) override {
+    frames.push_back(buffer);
+    if (emulator)
+      frame_changes.push_back(emulator->GetPresentedFrameChanges());
+  }
+  bool NeedRender() override { return true; }
+
+  // IODevices::AudioDevice:
+  void OnSampleArrived(Sample* samples_arrived, size_t count) override {
+    samples.insert(samples.end(), samples_arrived, samples_arrived + count);
+  }
+  double GetSampleRateRatio() override { return sample_rate_ratio; }
+
+  std::vector<Colors> frames;
+  std::vector<Sample> samples;
+  double sample_rate_ratio = 1.0;
+  // If it's set, the changes of each frame are recorded as well.
+  Emulator* emulator = nullptr;
+  std::vector<Emulator::FrameChanges> frame_changes;
+};
+
+// Counts the outputs, without keeping them.
+class OutputCounter : public IODevices::RenderDevice,
+                      public IODevices::AudioDevice {
+ public:
+  // IODevices::RenderDevice:
+  void Render(int width, int height, const Colors& buffer) override {
+    ++frame_count;
+  }
+  bool NeedRender() override { return true; }
+
+  // IODevices::AudioDevice:
+  void OnSampleArrived(Sample* samples_arrived, size_t count) override {
+    sample_count += count;
+  }
+  double GetSampleRateRatio() override { return 1.0; }
+
+  int frame_count = 0;
+  size_t sample_count = 0;
+};
+}  // namespace
+
+class EmulatorImplTest : public RomTest {
+ protected:
+  void TearDown() override {
+    for (scoped_refptr<Emulator>& emulator : emulators_)
+      emulator->PowerOff();
+    RomTest::TearDown();
+  }
+
+  // Creates an emulator running the test ROM, whose outputs are recorded in
+  // |recorder| if it is set.
+  scoped_refptr<Emulator> CreateEmulator(
+      Recorder* recorder,
+      int run_ahead_frames,
+      Emulator::RunAheadMode mode,
+      Emulator::MemoryMode memory_mode = Emulator::MemoryMode::kDefault) {
+    scoped_refptr<Emulator> emulator = CreateEmulatorForTesting();
+    emulator->SetMemoryMode(memory_mode);
+    emulator->PowerOn();
+    std::unique_ptr<IODevices> io_devices = std::make_unique<IODevices>();
+    if (recorder) {
+      io_devices->add_render_device(recorder);
+      io_devices->set_audio_device(recorder);
+    }
+    emulator->SetIODevices(std::move(io_devices));
+    emulator->SetRunAhead(run_ahead_frames, mode);
+
+    emulator->LoadFromBinary(rom_,
+                             base::BindOnce([](bool success) {
+                               EXPECT_TRUE(success) << "Failed to load ROM";
+                             }));
+    emulator->Run();
+    emulators_.push_back(emulator);
+    return emulator;
+  }
+
+  // Returns the average host time of a frame.
+  std::chrono::duration<double, std::milli> RunFrames(Emulator* emulator,
+                                                      int count) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < count; ++i)
+      emulator->RunOneFrame();
+    return (std::chrono::steady_clock::now() - start) / count;
+  }
+
+  // Runs |count| frames in |first| and in |second| by turns, several rounds.
+  // Returns the host time of a frame of each, the fastest of the rounds, so
+  // that the noise is kept out of comparisons.
+  std::pair<std::chrono::duration<double, std::milli>,
+            std::chrono::duration<double, std::milli>>
+  RunFramesFastest(Emulator* first, Emulator* second, int count) {
+    constexpr int kRoundCount = 5;
+    auto first_fastest = std::chrono::duration<double, std::milli>::max();
+    auto second_fastest = std::chrono::duration<double, std::milli>::max();
+    for (int round = 0; round < kRoundCount; ++round) {
+      first_fastest = std::min(first_fastest, RunFrames(first, count));
+      second_fastest = std::min(second_fastest, RunFrames(second, count));
+    }
+    return {first_fastest, second_fastest};
+  }
+
+  Bytes BuildStates(Emulator* emulator) {
+    return EmulatorStates::CreateStateForVersion(
+               static_cast<EmulatorImpl*>(emulator),
+               EmulatorStates::kLatestVersion)
+        .Build(EmulatorStates::Compression::kNone);
+  }
+
+  // The ROM emulators created by CreateEmulator() run.
+  Bytes rom_ = CreateTestROM();
+  std::vector<scoped_refptr<Emulator>> emulators_;
+};
+
+using RunAheadTest = EmulatorImplTest;
+using CloneTest = EmulatorImplTest;
+using MemoryModeTest = EmulatorImplTest;
+using IdleLoopTest = EmulatorImplTest;
+using MapperStepLoopTest = EmulatorImplTest;
+using AudioRateTest = EmulatorImplTest;
+using FastForwardTest = EmulatorImplTest;
+using HeadlessAudioTest = EmulatorImplTest;
+using FrameSequenceTest = EmulatorImplTest;
+using AllocationTest = EmulatorImplTest;
+
+TEST_F(RunAheadTest, PresentsFramesAhead) {
+  constexpr int kRunAheadFrames = 2;
+  Recorder reference;
+  Recorder single_instance;
+  Recorder second_instance;
+  RunFrames(CreateEmulator(&reference, 0,
+                           Emulator::RunAheadMode::kSingleInstance)
+                .get(),
+            kFrameCount + kRunAheadFrames);
+  RunFrames(CreateEmulator(&single_instance, kRunAheadFrames,
+                           Emulator::RunAheadMode::kSingleInstance)
+                .get(),
+            kFrameCount);
+  RunFrames(CreateEmulator(&second_instance, kRunAheadFrames,
+                           Emulator::RunAheadMode::kSecondInstance)
+                .get(),
+            kFrameCount);
+
+  ASSERT_GE(reference.frames.size(), kFrameCount + kRunAheadFrames);
+  EXPECT_NE(reference.frames[kFrameCount - 1], reference.frames[kFrameCount]);
+
+  // Each frame presented is the one which would be presented
+  // |kRunAheadFrames| frames later.
+  ASSERT_EQ(single_instance.frames.size(), kFrameCount);
+  ASSERT_EQ(second_instance.frames.size(), kFrameCount);
+  for (int i = 0; i < kFrameCount; ++i) {
+    EXPECT_EQ(single_instance.frames[i], reference.frames[i + kRunAheadFrames])
+        << "Frame " << i;
+    EXPECT_EQ(second_instance.frames[i], reference.frames[i + kRunAheadFrames])
+        << "Frame " << i;
+  }
+}
+
+TEST_F(RunAheadTest, KeepsStatesAndAudio) {
+  Recorder reference;
+  Recorder single_instance;
+  Recorder second_instance;
+  scoped_refptr<Emulator> reference_emulator =
+      CreateEmulator(&reference, 0, Emulator::RunAheadMode::kSingleInstance);
+  scoped_refptr<Emulator> single_instance_emulator = CreateEmulator(
+      &single_instance, 3, Emulator::RunAheadMode::kSingleInstance);
+  scoped_refptr<Emulator> second_instance_emulator = CreateEmulator(
+      &second_instance, 3, Emulator::RunAheadMode::kSecondInstance);
+  RunFrames(reference_emulator.get(), kFrameCount);
+  RunFrames(single_instance_emulator.get(), kFrameCount);
+  RunFrames(second_instance_emulator.get(), kFrameCount);
+
+  // Frames run ahead are rolled back, so that both modes end up in the same
+  // states.
+  EXPECT_EQ(BuildStates(single_instance_emulator.get()),
+            BuildStates(second_instance_emulator.get()));
+
+  // Audio of the frames run ahead is dropped, and rolling back doesn't break
+  // the audio which is played.
+  size_t sample_count = std::min(
+      {reference.samples.size(), single_instance.samples.size(),
+       second_instance.samples.size()});
+  ASSERT_GT(sample_count, 0u);
+  EXPECT_NE(std::count(reference.samples.begin(), reference.samples.end(), 0),
+            reference.samples.size());
+  reference.samples.resize(sample_count);
+  single_instance.samples.resize(sample_count);
+  second_instance.samples.resize(sample_count);
+  EXPECT_EQ(single_instance.samples, reference.samples);
+  EXPECT_EQ(second_instance.samples, reference.samples);
+}
+
+// APU's IRQs and DMC fetches are predicted again from the states which frames
+// run ahead roll back to, so that both modes take the same IRQs.
+TEST_F(RunAheadTest, KeepsAPUIRQs) {
+  rom_ = CreateAPUTestROM();
+  scoped_refptr<Emulator> single_instance_emulator =
+      CreateEmulator(nullptr, 3, Emulator::RunAheadMode::kSingleInstance);
+  scoped_refptr<Emulator> second_instance_emulator =
+      CreateEmulator(nullptr, 3, Emulator::RunAheadMode::kSecondInstance);
+  RunFrames(single_instance_emulator.get(), kFrameCount);
+  RunFrames(second_instance_emulator.get(), kFrameCount);
+  EXPECT_EQ(BuildStates(single_instance_emulator.get()),
+            BuildStates(second_instance_emulator.get()));
+  EXPECT_GT(static_cast<EmulatorImpl*>(single_instance_emulator.get())
+                ->GetCPUMemory(0x02),
+            0);
+}
+
+// Measures the host time run-ahead costs. At 2 frames, it must be less than a
+// frame at 60 Hz.
+TEST_F(RunAheadTest, DISABLED_Overhead) {
+  constexpr int kRunAheadFrames = 2;
+  constexpr std::chrono::duration<double, std::milli> kHostFrame(1000. / 60);
+  Recorder reference;
+  Recorder single_instance;
+  Recorder second_instance;
+  scoped_refptr<Emulator> reference_emulator =
+      CreateEmulator(&reference, 0, Emulator::RunAheadMode::kSingleInstance);
+  scoped_refptr<Emulator> single_instance_emulator =
+      CreateEmulator(&single_instance, kRunAheadFrames,
+                     Emulator::RunAheadMode::kSingleInstance);
+  scoped_refptr<Emulator> second_instance_emulator =
+      CreateEmulator(&second_instance, kRunAheadFrames,
+                     Emulator::RunAheadMode::kSecondInstance);
+
+  // Warms up, so that the second instance has been created.
+  RunFrames(second_instance_emulator.get(), 1);
+
+  std::chrono::duration<double, std::milli> frame =
+      RunFrames(reference_emulator.get(), kFrameCount);
+  std::chrono::duration<double, std::milli> single_instance_overhead =
+      RunFrames(single_instance_emulator.get(), kFrameCount) - frame;
+  std::chrono::duration<double, std::milli> second_instance_overhead =
+      RunFrames(second_instance_emulator.get(), kFrameCount) - frame;
+
+  RecordProperty("frame_us", static_cast<int>(frame.count() * 1000));
+  RecordProperty("single_instance_overhead_us",
+                 static_cast<int>(single_instance_overhead.count() * 1000));
+  RecordProperty("second_instance_overhead_us",
+                 static_cast<int>(second_instance_overhead.count() * 1000));
+  std::cout << "Frame: " << frame.count() << " ms, run-ahead overhead: "
+            << single_instance_overhead.count() << " ms (single instance), "
+            << second_instance_overhead.count() << " ms (second instance)"
+            << std::endl;
+
+  // Apart from the frames run ahead, syncing states costs less than a frame.
+  EXPECT_LT(single_instance_overhead, frame * (kRunAheadFrames + 1));
+  EXPECT_LT(second_instance_overhead, frame * (kRunAheadFrames + 1));
+#if defined(NDEBUG)
+  // Unoptimized builds are too slow to be held to host's frame time.
+  EXPECT_LT(single_instance_overhead, kHostFrame);
+  EXPECT_LT(second_instance_overhead, kHostFrame);
+#endif
+}
+
+TEST_F(CloneTest, CopiesStates) {
+  Recorder recorder;
+  scoped_refptr<Emulator> emulator =
+      CreateEmulator(&recorder, 0, Emulator::RunAheadMode::kSingleInstance);
+  // A frame doesn't end at vertical blank, so the emulator is cloned in the
+  // middle of rendering.
+  RunFrames(emulator.get(), kFrameCount / 2);
+
+  scoped_refptr<Emulator> clone = emulator->Clone();
+  emulators_.push_back(clone);
+  EXPECT_EQ(clone->GetRunningState(), Emulator::RunningState::kRunning);
+  EXPECT_EQ(clone->GetRomData(), emulator->GetRomData());
+  EXPECT_EQ(BuildStates(clone.get()), BuildStates(emulator.get()));
+  EXPECT_EQ(clone->GetCurrentFrame(), emulator->GetCurrentFrame());
+  EXPECT_EQ(clone->GetLastFrame(), emulator->GetLastFrame());
+}
+
+TEST_F(CloneTest, RunsIndependently) {
+  Recorder recorder;
+  Recorder clone_recorder;
+  scoped_refptr<Emulator> emulator =
+      CreateEmulator(&recorder, 0, Emulator::RunAheadMode::kSingleInstance);
+  RunFrames(emulator.get(), kFrameCount / 2);
+
+  scoped_refptr<Emulator> clone = emulator->Clone();
+  emulators_.push_back(clone);
+  std::unique_ptr<IODevices> io_devices = std::make_unique<IODevices>();
+  io_devices->add_render_device(&clone_recorder);
+  clone->SetIODevices(std::move(io_devices));
+
+  // The clone renders the same frames as the emulator does.
+  size_t frames_before_clone = recorder.frames.size();
+  RunFrames(emulator.get(), kFrameCount);
+  RunFrames(clone.get(), kFrameCount);
+  ASSERT_EQ(recorder.frames.size() - frames_before_clone,
+            clone_recorder.frames.size());
+  ASSERT_FALSE(clone_recorder.frames.empty());
+  EXPECT_TRUE(std::equal(clone_recorder.frames.begin(),
+                         clone_recorder.frames.end(),
+                         recorder.frames.begin() + frames_before_clone));
+  EXPECT_EQ(BuildStates(clone.get()), BuildStates(emulator.get()));
+
+  // Running the clone doesn't touch the emulator.
+  Bytes states = BuildStates(emulator.get());
+  RunFrames(clone.get(), 10);
+  EXPECT_NE(BuildStates(clone.get()), states);
+  EXPECT_EQ(BuildStates(emulator.get()), states);
+}
+
+// Compares the host time of Clone() with forking by states, which loads the
+// ROM into a new emulator and restores the states in it. Both allocate all
+// components, so that each is the fastest of several rounds, which keeps the
+// noise out of the comparison.
+TEST_F(CloneTest, DISABLED_Cost) {
+  constexpr int kRoundCount = 5;
+  constexpr int kForkCount = 100;
+  Recorder recorder;
+  scoped_refptr<Emulator> emulator =
+      CreateEmulator(&recorder, 0, Emulator::RunAheadMode::kSingleInstance);
+  RunFrames(emulator.get(), kFrameCount / 2);
+  Bytes rom = CreateTestROM();
+  Bytes states = BuildStates(emulator.get());
+
+  using Microseconds = std::chrono::duration<double, std::micro>;
+  Microseconds fork_by_states = Microseconds::max();
+  Microseconds clone = Microseconds::max();
+  for (int round = 0; round < kRoundCount; ++round) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kForkCount; ++i) {
+      scoped_refptr<Emulator> fork = CreateEmulatorForTesting();
+      fork->PowerOn();
+      fork->LoadFromBinary(rom, base::DoNothing());
+      EXPECT_TRUE(EmulatorStates::CreateStateForVersion(
+                      static_cast<EmulatorImpl*>(fork.get()),
+                      EmulatorStates::kLatestVersion)
+                      .Restore(states));
+    }
+    fork_by_states =
+        std::min<Microseconds>(fork_by_states,
+                               (std::chrono::steady_clock::now() - start) /
+                                   kForkCount);
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kForkCount; ++i)
+      scoped_refptr<Emulator> fork = emulator->Clone();
+    clone = std::min<Microseconds>(
+        clone, (std::chrono::steady_clock::now() - start) / kForkCount);
+  }
+
+  RecordProperty("fork_by_states_us", static_cast<int>(fork_by_states.count()));
+  RecordProperty("clone_us", static_cast<int>(clone.count()));
+  std::cout << "Fork by states: " << fork_by_states.count()
+            << " us, clone: " << clone.count() << " us" << std::endl;
+  EXPECT_LT(clone, fork_by_states);
+}
+
+TEST_F(MemoryModeTest, CompactModesMatchDefault) {
+  Recorder reference;
+  Recorder compact;
+  Recorder compact_without_audio;
+  scoped_refptr<Emulator> reference_emulator =
+      CreateEmulator(&reference, 0, Emulator::RunAheadMode::kSingleInstance);
+  scoped_refptr<Emulator> compact_emulator =
+      CreateEmulator(&compact, 0, Emulator::RunAheadMode::kSingleInstance,
+                     Emulator::MemoryMode::kCompact);
+  scoped_refptr<Emulator> compact_without_audio_emulator = CreateEmulator(
+      &compact_without_audio, 0, Emulator::RunAheadMode::kSingleInstance,
+      Emulator::MemoryMode::kCompactWithoutAudio);
+  RunFrames(reference_emulator.get(), kFrameCount);
+  RunFrames(compact_emulator.get(), kFrameCount);
+  RunFrames(compact_without_audio_emulator.get(), kFrameCount);
+
+  ASSERT_FALSE(reference.frames.empty());
+  EXPECT_EQ(compact.frames, reference.frames);
+  EXPECT_EQ(compact_without_audio.frames, reference.frames);
+  ASSERT_FALSE(reference.samples.empty());
+  EXPECT_EQ(compact.samples, reference.samples);
+  EXPECT_TRUE(compact_without_audio.samples.empty());
+  EXPECT_EQ(BuildStates(compact_emulator.get()),
+            BuildStates(reference_emulator.get()));
+  EXPECT_EQ(BuildStates(compact_without_audio_emulator.get()),
+            BuildStates(reference_emulator.get()));
+
+  // Frames are kept as indices, and converted when asked for.
+  EXPECT_FALSE(static_cast<EmulatorImpl*>(reference_emulator.get())
+                   ->GetLastIndexedFrame());
+  EXPECT_TRUE(static_cast<EmulatorImpl*>(compact_emulator.get())
+                  ->GetLastIndexedFrame());
+  EXPECT_EQ(compact_emulator->GetLastFrame(),
+            reference_emulator->GetLastFrame());
+
+  // Clones are in the same mode.
+  scoped_refptr<Emulator> clone = compact_emulator->Clone();
+  emulators_.push_back(clone);
+  EXPECT_EQ(clone->GetMemoryMode(), Emulator::MemoryMode::kCompact);
+  RunFrames(clone.get(), 10);
+  RunFrames(compact_emulator.get(), 10);
+  EXPECT_EQ(BuildStates(clone.get()), BuildStates(compact_emulator.get()));
+  EXPECT_EQ(clone->GetLastFrame(), compact_emulator->GetLastFrame());
+}
+
+// Measures bytes of an emulator in each memory mode. The numbers are printed,
+// and recorded as properties in the XML output.
+TEST_F(MemoryModeTest, Footprint) {
+  // Without render devices, frames are never converted to colors.
+  scoped_refptr<Emulator> reference_emulator =
+      CreateEmulator(nullptr, 0, Emulator::RunAheadMode::kSingleInstance);
+  scoped_refptr<Emulator> compact_emulator =
+      CreateEmulator(nullptr, 0, Emulator::RunAheadMode::kSingleInstance,
+                     Emulator::MemoryMode::kCompact);
+  scoped_refptr<Emulator> compact_without_audio_emulator =
+      CreateEmulator(nullptr, 0, Emulator::RunAheadMode::kSingleInstance,
+                     Emulator::MemoryMode::kCompactWithoutAudio);
+  RunFrames(reference_emulator.get(), kFrameCount);
+  RunFrames(compact_emulator.get(), kFrameCount);
+  RunFrames(compact_without_audio_emulator.get(), kFrameCount);
+
+  size_t reference_bytes = reference_emulator->GetMemoryFootprint();
+  size_t compact_bytes = compact_emulator->GetMemoryFootprint();
+  size_t compact_without_audio_bytes =
+      compact_without_audio_emulator->GetMemoryFootprint();
+  RecordProperty("default_bytes", static_cast<int>(reference_bytes));
+  RecordProperty("compact_bytes", static_cast<int>(compact_bytes));
+  RecordProperty("compact_without_audio_bytes",
+                 static_cast<int>(compact_without_audio_bytes));
+  std::cout << "Bytes per emulator: " << reference_bytes << " (default), "
+            << compact_bytes << " (compact), " << compact_without_audio_bytes
+            << " (compact without audio)" << std::endl;
+
+  // Screen buffers of indices are a quarter of colors' size.
+  EXPECT_LT(compact_bytes, reference_bytes / 2);
+  EXPECT_LT(compact_without_audio_bytes, compact_bytes);
+  EXPECT_LT(compact_without_audio_bytes, 2 * PPU::kFrameSize + 32 * 1024);
+
+  scoped_refptr<Emulator> clone = compact_without_audio_emulator->Clone();
+  emulators_.push_back(clone);
+  EXPECT_LT(clone->GetMemoryFootprint(), 2 * PPU::kFrameSize + 32 * 1024);
+}
+
+TEST_F(IdleLoopTest, MatchesExecuting) {
+  for (const Bytes& rom : {CreateTestROM(), CreatePollingTestROM()}) {
+    rom_ = rom;
+    Recorder executing;
+    Recorder replaying;
+    scoped_refptr<Emulator> executing_emulator =
+        CreateEmulator(&executing, 0, Emulator::RunAheadMode::kSingleInstance);
+    static_cast<EmulatorImpl*>(executing_emulator.get())
+        ->SetIdleLoopSkipping(false);
+    scoped_refptr<Emulator> replaying_emulator =
+        CreateEmulator(&replaying, 0, Emulator::RunAheadMode::kSingleInstance);
+
+    for (int i = 0; i < kFrameCount; ++i) {
+      executing_emulator->RunOneFrame();
+      replaying_emulator->RunOneFrame();
+      ASSERT_EQ(BuildStates(replaying_emulator.get()),
+                BuildStates(executing_emulator.get()))
+          << "Frame " << i;
+    }
+    EXPECT_FALSE(static_cast<EmulatorImpl*>(executing_emulator.get())
+                     ->IsReplayingIdleLoop());
+    EXPECT_TRUE(static_cast<EmulatorImpl*>(replaying_emulator.get())
+                    ->IsReplayingIdleLoop());
+    ASSERT_FALSE(executing.frames.empty());
+    EXPECT_EQ(replaying.frames, executing.frames);
+    ASSERT_FALSE(executing.samples.empty());
+    EXPECT_EQ(replaying.samples, executing.samples);
+  }
+}
+
+TEST_F(IdleLoopTest, RecordsAgainAfterLoadingStates) {
+  scoped_refptr<Emulator> executing_emulator =
+      CreateEmulator(nullptr, 0, Emulator::RunAheadMode::kSingleInstance);
+  static_cast<EmulatorImpl*>(executing_emulator.get())
+      ->SetIdleLoopSkipping(false);
+  scoped_refptr<Emulator> replaying_emulator =
+      CreateEmulator(nullptr, 0, Emulator::RunAheadMode::kSingleInstance);
+  RunFrames(executing_emulator.get(), 10);
+  Bytes states = BuildStates(executing_emulator.get());
+
+  // Loading states stops replaying, until the loop is recorded again.
+  for (Emulator* emulator :
+       {executing_emulator.get(), replaying_emulator.get()}) {
+    RunFrames(emulator, 5);
+    EXPECT_TRUE(EmulatorStates::CreateStateForVersion(
+                    static_cast<EmulatorImpl*>(emulator),
+                    EmulatorStates::kLatestVersion)
+                    .Restore(states));
+    EXPECT_FALSE(static_cast<EmulatorImpl*>(emulator)->IsReplayingIdleLoop());
+    RunFrames(emulator, 5);
+  }
+  EXPECT_TRUE(static_cast<EmulatorImpl*>(replaying_emulator.get())
+                  ->IsReplayingIdleLoop());
+  EXPECT_EQ(BuildStates(replaying_emulator.get()),
+            BuildStates(executing_emulator.get()));
+}
+
+// Measures the host time of a frame with and without replaying idle loops.
+TEST_F(IdleLoopTest, DISABLED_Cost) {
+  scoped_refptr<Emulator> executing_emulator =
+      CreateEmulator(nullptr, 0, Emulator::RunAheadMode::kSingleInstance);
+  static_cast<EmulatorImpl*>(executing_emulator.get())
+      ->SetIdleLoopSkipping(false);
+  scoped_refptr<Emulator> replaying_emulator =
+      CreateEmulator(nullptr, 0, Emulator::RunAheadMode::kSingleInstance);
+
+  auto [executing, replaying] = RunFramesFastest(
+      executing_emulator.get(), replaying_emulator.get(), kFrameCount);
+  RecordProperty("executing_us", static_cast<int>(executing.count() * 1000));
+  RecordProperty("replaying_us", static_cast<int>(replaying.count() * 1000));
+  std::cout << "Frame: " << executing.count() << " ms (executing idle loops), "
+            << replaying.count() << " ms (replaying idle loops)" << std::endl;
+}
+
+// all_instrs.nes runs on MMC1, the polling test ROM on NROM, and the MMC3 one
+// takes scanline IRQs.
+TEST_F(MapperStepLoopTest, MatchesVirtualDispatch) {
+  std::optional<Bytes> all_instrs =
+      base::ReadFileToBytes(base::FilePath(__FILE__)
+                                .DirName()
+                                .DirName()
+                                .Append("testing")
+                                .Append("roms")
+                                .Append("cpu")
+                                .Append("all_instrs.nes"));
+  ASSERT_TRUE(all_instrs);
+  for (const Bytes& rom :
+       {*all_instrs, CreatePollingTestROM(), CreateMMC3TestROM()}) {
+    rom_ = rom;
+    Recorder virtual_dispatch;
+    Recorder step_loop;
+    scoped_refptr<Emulator> virtual_dispatch_emulator = CreateEmulator(
+        &virtual_dispatch, 0, Emulator::RunAheadMode::kSingleInstance);
+    static_cast<EmulatorImpl*>(virtual_dispatch_emulator.get())
+        ->SetMapperStepLoops(false);
+    scoped_refptr<Emulator> step_loop_emulator =
+        CreateEmulator(&step_loop, 0, Emulator::RunAheadMode::kSingleInstance);
+
+    RunFrames(virtual_dispatch_emulator.get(), kFrameCount);
+    RunFrames(step_loop_emulator.get(), kFrameCount);
+    EXPECT_EQ(BuildStates(step_loop_emulator.get()),
+              BuildStates(virtual_dispatch_emulator.get()));
+    ASSERT_FALSE(virtual_dispatch.frames.empty());
+    EXPECT_EQ(step_loop.frames, virtual_dispatch.frames);
+    EXPECT_EQ(step_loop.samples, virtual_dispatch.samples);
+  }
+}
+
+// Scanline IRQs of MMC3 are taken, and show in frames.
+TEST_F(MapperStepLoopTest, TakesMMC3ScanlineIRQs) {
+  rom_ = CreateMMC3TestROM();
+  Recorder recorder;
+  scoped_refptr<Emulator> emulator =
+      CreateEmulator(&recorder, 0, Emulator::RunAheadMode::kSingleInstance);
+  RunFrames(emulator.get(), kFrameCount);
+  // An IRQ a frame, but for the two frames which reset waits for.
+  EXPECT_EQ(static_cast<EmulatorImpl*>(emulator.get())->GetCPUMemory(0x02),
+            kFrameCount - 2);
+  ASSERT_FALSE(recorder.frames.empty());
+  const Colors& frame = recorder.frames.back();
+  // The backdrop changes at the IRQ.
+  EXPECT_NE(frame.front(), frame.back());
+}
+
+// The APU resamples its output by the ratio which the audio device asks for.
+TEST_F(AudioRateTest, ResamplesByDeviceRatio) {
+  Recorder reference;
+  Recorder faster;
+  Recorder slower;
+  faster.sample_rate_ratio = 1.005;
+  slower.sample_rate_ratio = 0.995;
+  for (Recorder* recorder : {&reference, &faster, &slower}) {
+    RunFrames(CreateEmulator(recorder, 0,
+                             Emulator::RunAheadMode::kSingleInstance)
+                  .get(),
+              kFrameCount);
+  }
+
+  ASSERT_FALSE(reference.samples.empty());
+  double reference_count = reference.samples.size();
+  EXPECT_NEAR(faster.samples.size() / reference_count, 1.005, 0.0005);
+  EXPECT_NEAR(slower.samples.size() / reference_count, 0.995, 0.0005);
+}
+
+// Fast-forward presents every |kSpeed|th frame, and its audio is as long as
+// at normal speed.
+TEST_F(FastForwardTest, PresentsLastFramesAndKeepsAudioPace) {
+  constexpr int kSpeed = 4;
+  Recorder reference;
+  Recorder fast_forward;
+  scoped_refptr<Emulator> reference_emulator =
+      CreateEmulator(&reference, 0, Emulator::RunAheadMode::kSingleInstance);
+  scoped_refptr<Emulator> fast_forward_emulator = CreateEmulator(
+      &fast_forward, 0, Emulator::RunAheadMode::kSingleInstance);
+  fast_forward_emulator->SetFastForward(kSpeed);
+
+  // Fast-forward runs until frames are finished, rather than by cycles, so
+  // the reference runs a frame more to finish as many.
+  RunFrames(reference_emulator.get(), kFrameCount * kSpeed + 1);
+  RunFrames(fast_forward_emulator.get(), kFrameCount);
+
+  ASSERT_EQ(fast_forward.frames.size(), kFrameCount);
+  ASSERT_GE(reference.frames.size(), kFrameCount * kSpeed);
+  for (int i = 0; i < kFrameCount; ++i) {
+    EXPECT_EQ(fast_forward.frames[i], reference.frames[i * kSpeed + kSpeed - 1])
+        << "Frame " << i;
+  }
+
+  // The time-stretch lags behind by up to a segment.
+  double samples_per_frame = static_cast<double>(reference.samples.size()) /
+                             reference.frames.size();
+  EXPECT_NEAR(fast_forward.samples.size(), samples_per_frame * kFrameCount,
+              TimeStretch::kSegment + TimeStretch::kSearch);
+  EXPECT_NE(std::count(fast_forward.samples.begin(),
+                       fast_forward.samples.end(), 0),
+            fast_forward.samples.size());
+}
+
+// Without an audio device, nothing is synthesized, but everything else runs
+// the same, including what the CPU can see of the APU.
+TEST_F(HeadlessAudioTest, MatchesWithAudioDevice) {
+  rom_ = CreateAPUTestROM();
+  Recorder recorder;
+  scoped_refptr<Emulator> audio_emulator =
+      CreateEmulator(&recorder, 0, Emulator::RunAheadMode::kSingleInstance);
+  scoped_refptr<Emulator> headless_emulator =
+      CreateEmulator(nullptr, 0, Emulator::RunAheadMode::kSingleInstance);
+
+  for (int i = 0; i < kFrameCount; ++i) {
+    audio_emulator->RunOneFrame();
+    headless_emulator->RunOneFrame();
+    ASSERT_EQ(BuildStates(headless_emulator.get()),
+              BuildStates(audio_emulator.get()))
+        << "Frame " << i;
+  }
+  EXPECT_EQ(headless_emulator->GetLastFrame(), audio_emulator->GetLastFrame());
+  EXPECT_FALSE(recorder.samples.empty());
+
+  // IRQs were taken.
+  EXPECT_GT(static_cast<EmulatorImpl*>(headless_emulator.get())
+                ->GetCPUMemory(0x02),
+            0);
+}
+
+// Measures the host time of a frame with and without an audio device, which
+// must be less without one.
+TEST_F(HeadlessAudioTest, DISABLED_Cost) {
+  rom_ = CreateAPUTestROM();
+  Recorder recorder;
+  scoped_refptr<Emulator> audio_emulator =
+      CreateEmulator(&recorder, 0, Emulator::RunAheadMode::kSingleInstance);
+  scoped_refptr<Emulator> headless_emulator =
+      CreateEmulator(nullptr, 0, Emulator::RunAheadMode::kSingleInstance);
+
+  auto [audio, headless] = RunFramesFastest(
+      audio_emulator.get(), headless_emulator.get(), kFrameCount);
+  RecordProperty("audio_us", static_cast<int>(audio.count() * 1000));
+  RecordProperty("headless_us", static_cast<int>(headless.count() * 1000));
+  std::cout << "Frame: " << audio.count() << " ms (audio device), "
+            << headless.count() << " ms (headless)" << std::endl;
+  EXPECT_LT(headless, audio);
+}
+
+// Frames with the same sequence have the same pixels, with or without
+// run-ahead, and in each memory mode. A still screen keeps its sequence, and
+// a new sequence tells which rows changed.
+TEST_F(FrameSequenceTest, ChangesWithPixels) {
+  struct Config {
+    int run_ahead_frames;
+    Emulator::RunAheadMode run_ahead_mode;
+    Emulator::MemoryMode memory_mode;
+  };
+  constexpr Config kConfigs[] = {
+      {0, Emulator::RunAheadMode::kSingleInstance,
+       Emulator::MemoryMode::kDefault},
+      {0, Emulator::RunAheadMode::kSingleInstance,
+       Emulator::MemoryMode::kCompact},
+      {2, Emulator::RunAheadMode::kSingleInstance,
+       Emulator::MemoryMode::kDefault},
+      {2, Emulator::RunAheadMode::kSecondInstance,
+       Emulator::MemoryMode::kDefault},
+  };
+  for (bool still : {false, true}) {
+    rom_ = still ? CreateStillTestROM() : CreateTestROM();
+    for (const Config& config : kConfigs) {
+      SCOPED_TRACE(::testing::Message()
+                   << "Run-ahead frames: " << config.run_ahead_frames
+                   << ", mode: " << static_cast<int>(config.run_ahead_mode)
+                   << ", memory mode: " << static_cast<int>(config.memory_mode));
+      Recorder recorder;
+      scoped_refptr<Emulator> emulator =
+          CreateEmulator(&recorder, config.run_ahead_frames,
+                         config.run_ahead_mode, config.memory_mode);
+      recorder.emulator = emulator.get();
+      RunFrames(emulator.get(), kFrameCount);
+
+      const std::vector<Emulator::FrameChanges>& changes =
+          recorder.frame_changes;
+      ASSERT_EQ(changes.size(), recorder.frames.size());
+      ASSERT_GT(recorder.frames.size(), 1u);
+      for (size_t i = 0; i < recorder.frames.size(); ++i) {
+        for (size_t j = 0; j < i; ++j) {
+          if (changes[i].sequence == changes[j].sequence)
+            ASSERT_EQ(recorder.frames[i], recorder.frames[j]);
+        }
+      }
+      // A new sequence's rows are the ones which differ from the frame before,
+      // from the first to the last.
+      for (size_t i = 1; i < recorder.frames.size(); ++i) {
+        if (changes[i].sequence == changes[i - 1].sequence)
+          continue;
+        ASSERT_EQ(changes[i].base_sequence, changes[i - 1].sequence);
+        ASSERT_LT(changes[i].first_row, changes[i].end_row);
+        for (int row = 0; row < 240; ++row) {
+          auto row_of = [row](const Colors& frame) {
+            return Colors(frame.begin() + row * 256,
+                          frame.begin() + (row + 1) * 256);
+          };
+          bool changed =
+              row_of(recorder.frames[i]) != row_of(recorder.frames[i - 1]);
+          if (row < changes[i].first_row || row >= changes[i].end_row)
+            ASSERT_FALSE(changed) << "Row " << row;
+          else if (row == changes[i].first_row ||
+                   row == changes[i].end_row - 1)
+            ASSERT_TRUE(changed) << "Row " << row;
+        }
+      }
+      // Frames before the backdrop is set up may differ.
+      uint64_t middle_sequence = changes[changes.size() / 2].sequence;
+      if (still)
+        EXPECT_EQ(middle_sequence, changes.back().sequence);
+      else
+        EXPECT_NE(middle_sequence, changes.back().sequence);
+    }
+  }
+}
+
+namespace {
+// Once a ROM is running, frames don't allocate. The emulator isn't a testing
+// one, so that it runs its render task runner's tasks every frame, as it does
+// in the client.
+void ExpectNoAllocationsPerFrame(int run_ahead_frames,
+                                 Emulator::RunAheadMode run_ahead_mode) {
+  constexpr int kWarmUpFrames = 10;
+  constexpr int kAllocationFrameCount = 1000;
+  OutputCounter output_counter;
+  scoped_refptr<Emulator> emulator = nes::CreateEmulator();
+  emulator->PowerOn();
+  emulator->SetRunAhead(run_ahead_frames, run_ahead_mode);
+  std::unique_ptr<IODevices> io_devices = std::make_unique<IODevices>();
+  io_devices->add_render_device(&output_counter);
+  io_devices->set_audio_device(&output_counter);
+  emulator->SetIODevices(std::move(io_devices));
+
+  // The ROM is loaded by the first frame's tasks.
+  emulator->LoadFromBinary(CreateAPUTestROM(), base::DoNothing());
+  emulator->RunOneFrame();
+  emulator->Run();
+  ASSERT_EQ(emulator->GetRunningState(), Emulator::RunningState::kRunning);
+
+  // Buffers are allocated as the first frames need them.
+  for (int i = 0; i < kWarmUpFrames; ++i)
+    emulator->RunOneFrame();
+
+  kiwi::testing::AllocationCounter allocations;
+  for (int i = 0; i < kAllocationFrameCount; ++i)
+    emulator->RunOneFrame();
+  size_t count = allocations.count();
+
+  EXPECT_EQ(count, 0u);
+  EXPECT_GE(output_counter.frame_count, kAllocationFrameCount);
+  EXPECT_GT(output_counter.sample_count, 0u);
+  emulator->PowerOff();
+}
+}  // namespace
+
+TEST_F(AllocationTest, NoAllocationsPerFrame) {
+  ExpectNoAllocationsPerFrame(0, Emulator::RunAheadMode::kSingleInstance);
+}
+
+// The second instance copies states every frame, without allocating.
+TEST_F(AllocationTest, NoAllocationsPerFrameRunningAhead) {
+  ExpectNoAllocationsPerFrame(2, Emulator::RunAheadMode::kSecondInstance);
+}
+
+}  // namespace testing
+}  // namespace nes
+}  // namespace kiwi
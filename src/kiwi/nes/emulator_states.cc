@@ -12,18 +12,45 @@
 
 #include "nes/emulator_states.h"
 
-#include "base/strings/string_piece.h"
+#include <algorithm>
+#include <cstddef>
+
 #include "nes/cpu.h"
 #include "nes/cpu_bus.h"
 #include "nes/emulator_impl.h"
 #include "nes/ppu.h"
 #include "nes/ppu_bus.h"
+#include "third_party/zlib-1.3.2/zlib.h"
 
 namespace kiwi {
 namespace nes {
 namespace {
 #define kStateHeaderSignature "KIWI_NES_STATES"
 
+constexpr uint32_t MakeTag(const char (&tag)[5]) {
+  return static_cast<uint32_t>(tag[0]) | (static_cast<uint32_t>(tag[1]) << 8) |
+         (static_cast<uint32_t>(tag[2]) << 16) |
+         (static_cast<uint32_t>(tag[3]) << 24);
+}
+
+struct ChunkHeader {
+  uint32_t tag;
+  uint32_t layout_version;
+  uint32_t size;
+};
+static_assert(sizeof(ChunkHeader) == 12);
+
+struct ContainerHeader {
+  EmulatorStates::Header header;
+  uint32_t flags;
+  uint32_t payload_size;
+};
+static_assert(sizeof(ContainerHeader) == 28);
+
+// States are much smaller than this. A larger payload size comes from a
+// corrupted file, and isn't allocated.
+constexpr uint32_t kMaxPayloadSize = 16 * 1024 * 1024;
+
 class SerializableStateDataImpl : public EmulatorStates::SerializableStateData {
  public:
   SerializableStateDataImpl(Bytes& data);
@@ -43,127 +70,317 @@ SerializableStateDataImpl::~SerializableStateDataImpl() = default;
 EmulatorStates::SerializableStateData& SerializableStateDataImpl::WriteData(
     const void* data,
     size_t size) {
-  for (size_t i = 0; i < size; ++i) {
-    data_ref_.push_back(static_cast<const Byte*>(data)[i]);
-  }
-
+  const Byte* bytes = static_cast<const Byte*>(data);
+  data_ref_.insert(data_ref_.end(), bytes, bytes + size);
   return *this;
 }
 
+// Reads from [begin, begin + size) of |data|. Reading beyond the range won't
+// touch other data, but returns zeros and marks the reader as overflowed.
 class DeserializableStateDataImpl
     : public EmulatorStates::DeserializableStateData {
  public:
-  DeserializableStateDataImpl(const Bytes& data);
+  DeserializableStateDataImpl(const Bytes& data, size_t begin, size_t size);
   ~DeserializableStateDataImpl();
 
+  bool overflowed() const { return overflowed_; }
+  size_t remaining() const { return end_ - index_; }
+
  public:
   Bytes ReadData(size_t size) override;
 
  private:
   const Bytes& data_ref_;
   size_t index_ = 0;
+  size_t end_ = 0;
+  bool overflowed_ = false;
 };
 
-DeserializableStateDataImpl::DeserializableStateDataImpl(const Bytes& data)
-    : data_ref_(data) {}
-
-DeserializableStateDataImpl::~DeserializableStateDataImpl() {
-  DCHECK(index_ == data_ref_.size() || index_ == 0)
-      << "Data reading is not matching writing. Please check your Read/Write "
-         "method in EmulatorStates::SerializableStateData";
+DeserializableStateDataImpl::DeserializableStateDataImpl(const Bytes& data,
+                                                         size_t begin,
+                                                         size_t size)
+    : data_ref_(data), index_(begin), end_(begin + size) {
+  DCHECK(end_ <= data_ref_.size());
 }
 
+DeserializableStateDataImpl::~DeserializableStateDataImpl() = default;
+
 Bytes DeserializableStateDataImpl::ReadData(size_t size) {
-  Bytes read;
   if (!size)
     return Bytes();
 
-  read.resize(size);
+  Bytes read(size);
+  if (size > remaining()) {
+    overflowed_ = true;
+    index_ = end_;
+    return read;
+  }
+
   memcpy(read.data(), data_ref_.data() + index_, size);
   index_ += size;
   return read;
 }
+
+bool IsValidSignature(const EmulatorStates::Header& header) {
+  return memcmp(header.header, kStateHeaderSignature,
+                sizeof(kStateHeaderSignature)) == 0;
+}
+
 }  // namespace
 
 EmulatorStates EmulatorStates::CreateStateForVersion(EmulatorImpl* impl,
                                                      uint32_t version) {
-  CHECK(version == 1);  // Only version 1 is supported yet.
+  CHECK(version == 1 || version == 2);
   EmulatorStates state(version);
-  state.AddComponent(impl->cartridge_.get())
-      .AddComponent(impl->cpu_.get())
-      .AddComponent(impl->cpu_bus_.get())
-      .AddComponent(impl->ppu_.get())
-      .AddComponent(impl->ppu_bus_.get())
-      .AddComponent(impl->apu_.get());
+  state.AddComponent(MakeTag("CART"), impl->cartridge_.get())
+      .AddComponent(MakeTag("CPU "), impl->cpu_.get())
+      .AddComponent(MakeTag("CBUS"), impl->cpu_bus_.get())
+      .AddComponent(MakeTag("PPU "), impl->ppu_.get())
+      .AddComponent(MakeTag("PBUS"), impl->ppu_bus_.get())
+      .AddComponent(MakeTag("APU "), impl->apu_.get());
   return state;
 }
 
 EmulatorStates::EmulatorStates(uint32_t version) : version_(version) {}
 EmulatorStates::~EmulatorStates() = default;
 
-EmulatorStates& EmulatorStates::AddComponent(SerializableState* component) {
-  components_.push_back(component);
+EmulatorStates& EmulatorStates::AddComponent(uint32_t tag,
+                                             SerializableState* component) {
+  components_.push_back(Component{tag, component});
   return *this;
 }
 
-Bytes EmulatorStates::Build() {
-  Header header = {kStateHeaderSignature, version_};
+Bytes EmulatorStates::Build(Compression compression) {
+  return version_ == 1 ? BuildLegacy() : BuildChunks(compression);
+}
+
+Bytes EmulatorStates::BuildLegacy() {
+  Header header = {kStateHeaderSignature, 1};
 
   Bytes data;
   SerializableStateDataImpl serializable(data);
   serializable.SerializableStateData::WriteData(header);
 
   for (const auto& component : components_) {
-    component->Serialize(serializable);
+    component.state->Serialize(serializable);
   }
 
   return data;
 }
 
+void EmulatorStates::AppendChunks(Bytes& data) {
+  SerializableStateDataImpl serializable(data);
+  for (const auto& component : components_) {
+    size_t chunk_offset = data.size();
+    serializable.SerializableStateData::WriteData(
+        ChunkHeader{component.tag, kComponentLayoutVersion, 0});
+    component.state->Serialize(serializable);
+
+    // Fills the size after the component is serialized.
+    uint32_t chunk_size = static_cast<uint32_t>(data.size() - chunk_offset -
+                                                sizeof(ChunkHeader));
+    memcpy(data.data() + chunk_offset + offsetof(ChunkHeader, size),
+           &chunk_size, sizeof(chunk_size));
+  }
+}
+
+Bytes EmulatorStates::BuildChunks(Compression compression) {
+  Bytes payload;
+  AppendChunks(payload);
+
+  ContainerHeader container = {{kStateHeaderSignature, version_},
+                               0,
+                               static_cast<uint32_t>(payload.size())};
+  Bytes data(sizeof(ContainerHeader));
+  if (compression == Compression::kZlib) {
+    uLongf compressed_size = compressBound(payload.size());
+    data.resize(sizeof(ContainerHeader) + compressed_size);
+    int result = compress2(data.data() + sizeof(ContainerHeader),
+                           &compressed_size, payload.data(), payload.size(),
+                           Z_BEST_SPEED);
+    // Stores the payload directly if it can't be compressed.
+    if (result != Z_OK) {
+      LOG(WARNING) << "Can't compress states, error: " << result;
+    } else if (compressed_size < payload.size()) {
+      container.flags |= kFlagCompressed;
+      data.resize(sizeof(ContainerHeader) + compressed_size);
+    }
+  }
+
+  if (!(container.flags & kFlagCompressed)) {
+    data.resize(sizeof(ContainerHeader));
+    data.insert(data.end(), payload.begin(), payload.end());
+  }
+
+  memcpy(data.data(), &container, sizeof(container));
+  return data;
+}
+
+void EmulatorStates::BuildUncompressed(Bytes& data) {
+  DCHECK_EQ(version_, 2u);
+  data.resize(sizeof(ContainerHeader));
+  AppendChunks(data);
+
+  ContainerHeader container = {
+      {kStateHeaderSignature, version_},
+      0,
+      static_cast<uint32_t>(data.size() - sizeof(ContainerHeader))};
+  memcpy(data.data(), &container, sizeof(container));
+}
+
+void EmulatorStates::RestoreOwnStates(const Bytes& data) {
+  CHECK(RestoreChunks(data));
+}
+
 bool EmulatorStates::Restore(const Bytes& data) {
-  Bytes backup = Build();  // Make a backup
-  if (data.size() != backup.size()) {
-    // Wrong size, perhaps state is not saved yet, or data are corrupted / not
-    // compatible.
+  if (data.size() < sizeof(Header))
+    return false;
+
+  Header header = {0};
+  memcpy(&header, data.data(), sizeof(header));
+  if (!IsValidSignature(header)) {
+    LOG(WARNING) << "Wrong state header signature.";
+    return false;
+  }
+
+  // Backup is uncompressed, so that it is fast to make and restore.
+  Bytes backup = BuildChunks(Compression::kNone);
+  bool success = false;
+  if (header.version == 1) {
+    // Version 1 doesn't store sizes, it must match current layout exactly.
+    // The backup's payload is the same as version 1's data except the chunk
+    // headers.
+    size_t expected_size = sizeof(Header) + backup.size() -
+                           sizeof(ContainerHeader) -
+                           components_.size() * sizeof(ChunkHeader);
+    success = RestoreLegacy(data, expected_size);
+  } else if (header.version == 2) {
+    success = RestoreChunks(data);
+  } else {
+    LOG(WARNING) << "Unsupported state version: " << header.version;
     return false;
   }
 
-  bool success = RestoreInternal(data);
   if (!success) {
     // Fallback if load state failed.
-    CHECK(RestoreInternal(backup));
+    CHECK(RestoreChunks(backup));
     return false;
   }
 
   return true;
 }
 
-bool EmulatorStates::RestoreInternal(const kiwi::nes::Bytes& data) {
-  bool success = true;
-  DeserializableStateDataImpl deserializable(data);
+bool EmulatorStates::RestoreLegacy(const Bytes& data, size_t expected_size) {
+  if (data.size() != expected_size) {
+    // Wrong size, perhaps state is not saved yet, or data are corrupted / not
+    // compatible.
+    return false;
+  }
 
-  // Restore header first
+  DeserializableStateDataImpl deserializable(data, 0, data.size());
   Header header = {0};
   deserializable.DeserializableStateData::ReadData<Header>(&header);
+  LOG(INFO) << "Load state header success, version: " << header.version;
 
-  if (base::StringPiece(header.header) != kStateHeaderSignature) {
-    LOG(WARNING) << "Wrong state header signature: " << header.header;
-    success = false;
-  } else {
-    LOG(INFO) << "Load state header success, version: " << header.version;
+  for (const auto& component : components_) {
+    if (!component.state->Deserialize(header, deserializable) ||
+        deserializable.overflowed()) {
+      LOG(WARNING) << "Load state failed.";
+      return false;
+    }
   }
 
-  if (success) {
-    for (const auto& component : components_) {
-      success = component->Deserialize(header, deserializable);
-      if (!success) {
-        LOG(WARNING) << "Load state failed.";
+  DCHECK(!deserializable.remaining())
+      << "Data reading is not matching writing. Please check your Read/Write "
+         "method in EmulatorStates::SerializableStateData";
+  return true;
+}
+
+bool EmulatorStates::RestoreChunks(const Bytes& data) {
+  if (data.size() < sizeof(ContainerHeader))
+    return false;
+
+  ContainerHeader container;
+  memcpy(&container, data.data(), sizeof(container));
+
+  Bytes decompressed;
+  const Bytes* payload = &data;
+  size_t payload_offset = sizeof(ContainerHeader);
+  if (container.payload_size > kMaxPayloadSize) {
+    LOG(WARNING) << "States are too large: " << container.payload_size;
+    return false;
+  }
+
+  if (container.flags & kFlagCompressed) {
+    decompressed.resize(container.payload_size);
+    uLongf decompressed_size = container.payload_size;
+    int result = uncompress(decompressed.data(), &decompressed_size,
+                            data.data() + sizeof(ContainerHeader),
+                            data.size() - sizeof(ContainerHeader));
+    if (result != Z_OK || decompressed_size != container.payload_size) {
+      LOG(WARNING) << "Can't decompress states, error: " << result;
+      return false;
+    }
+    payload = &decompressed;
+    payload_offset = 0;
+  } else if (data.size() - sizeof(ContainerHeader) != container.payload_size) {
+    LOG(WARNING) << "States are truncated.";
+    return false;
+  }
+
+  // Finds chunks of all components before touching any of them.
+  std::vector<ChunkHeader> chunks(components_.size(), ChunkHeader{0});
+  std::vector<size_t> chunk_offsets(components_.size(), 0);
+  std::vector<bool> chunk_found(components_.size(), false);
+  size_t offset = payload_offset;
+  while (offset < payload->size()) {
+    if (payload->size() - offset < sizeof(ChunkHeader)) {
+      LOG(WARNING) << "Chunk header is truncated.";
+      return false;
+    }
+
+    ChunkHeader chunk;
+    memcpy(&chunk, payload->data() + offset, sizeof(chunk));
+    offset += sizeof(ChunkHeader);
+    if (payload->size() - offset < chunk.size) {
+      LOG(WARNING) << "Chunk data is truncated.";
+      return false;
+    }
+
+    for (size_t i = 0; i < components_.size(); ++i) {
+      if (components_[i].tag == chunk.tag) {
+        chunks[i] = chunk;
+        chunk_offsets[i] = offset;
+        chunk_found[i] = true;
         break;
       }
     }
+    offset += chunk.size;
+  }
+
+  for (size_t i = 0; i < components_.size(); ++i) {
+    if (!chunk_found[i]) {
+      LOG(WARNING) << "Missing state chunk of component " << i;
+      return false;
+    }
   }
 
-  return success;
+  for (size_t i = 0; i < components_.size(); ++i) {
+    // A newer layout only appends data, so that its chunk is read as the
+    // current layout, and the data appended is ignored.
+    Header header = {kStateHeaderSignature,
+                     std::min<uint32_t>(chunks[i].layout_version,
+                                        kComponentLayoutVersion)};
+    DeserializableStateDataImpl deserializable(*payload, chunk_offsets[i],
+                                               chunks[i].size);
+    if (!components_[i].state->Deserialize(header, deserializable) ||
+        deserializable.overflowed()) {
+      LOG(WARNING) << "Load state failed.";
+      return false;
+    }
+  }
+
+  return true;
 }
 
 }  // namespace nes
@@ -23,8 +23,43 @@
 namespace kiwi {
 namespace nes {
 class EmulatorImpl;
+
+// EmulatorStates dumps and restores the states of all components.
+//
+// Version 1 concatenates components' data after the header, so the size must
+// exactly match the current layout.
+//
+// Version 2 stores each component in a tagged chunk, and the chunks can be
+// deflated by zlib:
+// | Header (20 bytes) | Flags (4 bytes) | Payload size (4 bytes) | Payload |
+// Payload is a sequence of chunks, which is compressed if |kFlagCompressed|
+// is set, and |Payload size| is its size before compressing:
+// | Tag (4 bytes) | Layout version (4 bytes) | Size (4 bytes) | Data |
+// Unknown chunks are skipped. A chunk of a newer layout is read as the
+// current layout, and its trailing data is ignored.
 class EmulatorStates {
  public:
+  enum : uint32_t {
+    kLatestVersion = 2,
+  };
+
+  enum : uint32_t {
+    kFlagCompressed = 1 << 0,
+  };
+
+  // Layout version of components' data. It is passed as Header::version to
+  // SerializableState::Deserialize(). Bump it when a component appends data
+  // to its layout, and keep Deserialize() accepting older ones. Newer layouts
+  // are passed as this one, so that older builds can read them.
+  enum : uint32_t {
+    kComponentLayoutVersion = 1,
+  };
+
+  enum class Compression {
+    kNone,
+    kZlib,
+  };
+
   struct Header {
     char header[16];
     uint32_t version;
@@ -95,11 +130,32 @@ class EmulatorStates {
   static EmulatorStates CreateStateForVersion(EmulatorImpl* impl,
                                               uint32_t version);
 
-  Bytes Build();
+  // |compression| only takes effect since version 2.
+  Bytes Build(Compression compression);
+
+  // Restores states of any supported version, no matter which version this
+  // object is created for. If it fails, all components are kept untouched.
   bool Restore(const Bytes& data);
 
+  // Builds uncompressed states of version 2 into |data|, whose capacity is
+  // reused, so that building them every frame doesn't allocate.
+  void BuildUncompressed(Bytes& data);
+
+  // Restores states which BuildUncompressed() built from the same emulator.
+  // They can't fail to restore, so that no backup is made, unlike Restore().
+  void RestoreOwnStates(const Bytes& data);
+
  private:
-  bool RestoreInternal(const Bytes& data);
+  struct Component {
+    uint32_t tag;
+    SerializableState* state;
+  };
+
+  Bytes BuildLegacy();
+  Bytes BuildChunks(Compression compression);
+  void AppendChunks(Bytes& data);
+  bool RestoreLegacy(const Bytes& data, size_t expected_size);
+  bool RestoreChunks(const Bytes& data);
 
  public:
   ~EmulatorStates();
@@ -107,11 +163,11 @@ class EmulatorStates {
  private:
   EmulatorStates(uint32_t version);
 
-  EmulatorStates& AddComponent(SerializableState* component);
+  EmulatorStates& AddComponent(uint32_t tag, SerializableState* component);
 
  private:
   uint32_t version_ = 0;
-  std::vector<SerializableState*> components_;
+  std::vector<Component> components_;
 };
 
 }  // namespace nes
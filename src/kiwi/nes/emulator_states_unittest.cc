@@ -0,0 +1,202 @@
+// Copyright (C) 2026 Yisi Yu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#include "kiwi/nes/emulator_states.h"
+
+#include "kiwi/nes/emulator_impl.h"
+#include "kiwi/testing/rom_test.h"
+
+namespace kiwi {
+namespace nes {
+namespace testing {
+
+namespace {
+// Offsets in a version 2 container, see EmulatorStates.
+constexpr size_t kVersionOffset = 16;
+constexpr size_t kFlagsOffset = 20;
+constexpr size_t kPayloadSizeOffset = 24;
+constexpr size_t kContainerHeaderSize = 28;
+// Offsets in a chunk.
+constexpr size_t kLayoutVersionOffset = 4;
+constexpr size_t kChunkSizeOffset = 8;
+constexpr size_t kChunkHeaderSize = 12;
+
+uint32_t ReadUint32(const Bytes& data, size_t offset) {
+  uint32_t value;
+  memcpy(&value, data.data() + offset, sizeof(value));
+  return value;
+}
+
+void AppendUint32(Bytes& data, uint32_t value) {
+  const Byte* bytes = reinterpret_cast<const Byte*>(&value);
+  data.insert(data.end(), bytes, bytes + sizeof(value));
+}
+}  // namespace
+
+class EmulatorStatesTest : public RomTest {
+ protected:
+  void SetUp() override {
+    RomTest::SetUp();
+
+    // Runs a while, so that states are not the power-up ones.
+    base::FilePath rom_path = base::FilePath(__FILE__)
+                                  .DirName()
+                                  .Append("../")
+                                  .Append("testing")
+                                  .Append("roms")
+                                  .Append("cpu")
+                                  .Append("all_instrs.nes");
+    RunRom(rom_path, 30);
+  }
+
+  EmulatorStates CreateStates(uint32_t version) {
+    return EmulatorStates::CreateStateForVersion(
+        static_cast<EmulatorImpl*>(emulator_.get()), version);
+  }
+
+  Bytes Snapshot() {
+    return CreateStates(EmulatorStates::kLatestVersion)
+        .Build(EmulatorStates::Compression::kNone);
+  }
+
+  void RunFrames(int count) {
+    for (int i = 0; i < count; ++i)
+      emulator_->RunOneFrame();
+  }
+};
+
+TEST_F(EmulatorStatesTest, CompressedRoundTrip) {
+  Bytes snapshot = Snapshot();
+  Bytes compressed = CreateStates(EmulatorStates::kLatestVersion)
+                         .Build(EmulatorStates::Compression::kZlib);
+  EXPECT_EQ(ReadUint32(compressed, kVersionOffset), 2u);
+  EXPECT_TRUE(ReadUint32(compressed, kFlagsOffset) &
+              EmulatorStates::kFlagCompressed);
+  EXPECT_EQ(ReadUint32(compressed, kPayloadSizeOffset),
+            snapshot.size() - kContainerHeaderSize);
+  EXPECT_LT(compressed.size(), snapshot.size());
+
+  RunFrames(10);
+  EXPECT_NE(Snapshot(), snapshot);
+  EXPECT_TRUE(
+      CreateStates(EmulatorStates::kLatestVersion).Restore(compressed));
+  EXPECT_EQ(Snapshot(), snapshot);
+}
+
+TEST_F(EmulatorStatesTest, RestoreOwnStates) {
+  Bytes states;
+  CreateStates(EmulatorStates::kLatestVersion).BuildUncompressed(states);
+  Bytes snapshot = Snapshot();
+  EXPECT_EQ(states, snapshot);
+
+  // The buffer is reused.
+  RunFrames(10);
+  const Byte* buffer = states.data();
+  CreateStates(EmulatorStates::kLatestVersion).BuildUncompressed(states);
+  EXPECT_EQ(states.data(), buffer);
+  EXPECT_NE(states, snapshot);
+
+  CreateStates(EmulatorStates::kLatestVersion).RestoreOwnStates(snapshot);
+  EXPECT_EQ(Snapshot(), snapshot);
+}
+
+TEST_F(EmulatorStatesTest, RestoreVersion1) {
+  Bytes snapshot = Snapshot();
+  Bytes legacy = CreateStates(1).Build(EmulatorStates::Compression::kZlib);
+
+  RunFrames(10);
+  EXPECT_TRUE(CreateStates(EmulatorStates::kLatestVersion).Restore(legacy));
+  EXPECT_EQ(Snapshot(), snapshot);
+
+  // Version 1 requires the exact size.
+  legacy.push_back(0);
+  EXPECT_FALSE(CreateStates(EmulatorStates::kLatestVersion).Restore(legacy));
+  EXPECT_EQ(Snapshot(), snapshot);
+}
+
+TEST_F(EmulatorStatesTest, SkipsUnknownChunks) {
+  Bytes snapshot = Snapshot();
+
+  // Appends a chunk which may be written by a newer version.
+  Bytes extended = snapshot;
+  AppendUint32(extended, 0x454d4954);  // Unknown tag
+  AppendUint32(extended, 1);           // Layout version
+  AppendUint32(extended, 3);           // Size
+  extended.insert(extended.end(), {1, 2, 3});
+  uint32_t payload_size = extended.size() - kContainerHeaderSize;
+  memcpy(extended.data() + kPayloadSizeOffset, &payload_size,
+         sizeof(payload_size));
+
+  RunFrames(10);
+  EXPECT_TRUE(CreateStates(EmulatorStates::kLatestVersion).Restore(extended));
+  EXPECT_EQ(Snapshot(), snapshot);
+}
+
+TEST_F(EmulatorStatesTest, ReadsNewerLayouts) {
+  Bytes snapshot = Snapshot();
+
+  // Makes the first chunk a newer layout, which appends data.
+  Bytes newer = snapshot;
+  Byte* chunk = newer.data() + kContainerHeaderSize;
+  uint32_t layout_version = 2;
+  uint32_t chunk_size;
+  memcpy(chunk + kLayoutVersionOffset, &layout_version,
+         sizeof(layout_version));
+  memcpy(&chunk_size, chunk + kChunkSizeOffset, sizeof(chunk_size));
+  size_t chunk_end = kContainerHeaderSize + kChunkHeaderSize + chunk_size;
+  chunk_size += 4;
+  memcpy(chunk + kChunkSizeOffset, &chunk_size, sizeof(chunk_size));
+  newer.insert(newer.begin() + chunk_end, {1, 2, 3, 4});
+  uint32_t payload_size = newer.size() - kContainerHeaderSize;
+  memcpy(newer.data() + kPayloadSizeOffset, &payload_size,
+         sizeof(payload_size));
+
+  RunFrames(10);
+  EXPECT_TRUE(CreateStates(EmulatorStates::kLatestVersion).Restore(newer));
+  EXPECT_EQ(Snapshot(), snapshot);
+}
+
+TEST_F(EmulatorStatesTest, RejectsCorruptedStates) {
+  Bytes compressed = CreateStates(EmulatorStates::kLatestVersion)
+                         .Build(EmulatorStates::Compression::kZlib);
+  RunFrames(10);
+  Bytes snapshot = Snapshot();
+
+  Bytes truncated(compressed.begin(), compressed.end() - 16);
+  EXPECT_FALSE(
+      CreateStates(EmulatorStates::kLatestVersion).Restore(truncated));
+  EXPECT_EQ(Snapshot(), snapshot);
+
+  Bytes uncompressed_truncated(snapshot.begin(), snapshot.end() - 1);
+  EXPECT_FALSE(CreateStates(EmulatorStates::kLatestVersion)
+                   .Restore(uncompressed_truncated));
+  EXPECT_EQ(Snapshot(), snapshot);
+
+  // A corrupted size isn't trusted to allocate the payload.
+  Bytes huge_payload = compressed;
+  uint32_t huge_payload_size = 0xffffffff;
+  memcpy(huge_payload.data() + kPayloadSizeOffset, &huge_payload_size,
+         sizeof(huge_payload_size));
+  EXPECT_FALSE(
+      CreateStates(EmulatorStates::kLatestVersion).Restore(huge_payload));
+  EXPECT_EQ(Snapshot(), snapshot);
+
+  Bytes wrong_signature = snapshot;
+  wrong_signature[0] = 'X';
+  EXPECT_FALSE(
+      CreateStates(EmulatorStates::kLatestVersion).Restore(wrong_signature));
+  EXPECT_EQ(Snapshot(), snapshot);
+}
+
+}  // namespace testing
+}  // namespace nes
+}  // namespace kiwi
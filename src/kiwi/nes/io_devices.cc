@@ -22,5 +22,9 @@ IODevices::RenderDevice::~RenderDevice() = default;
 IODevices::AudioDevice::AudioDevice() = default;
 IODevices::AudioDevice::~AudioDevice() = default;
 
+double IODevices::AudioDevice::GetSampleRateRatio() {
+  return 1.0;
+}
+
 }  // namespace nes
 }  // namespace kiwi
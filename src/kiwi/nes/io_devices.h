@@ -63,15 +63,6 @@ class NES_EXPORT IODevices {
    public:
     enum {
       kFrequency = 44100,
-#if BUILDFLAG(IS_WIN)
-      kBufferMS = 0,
-#elif BUILDFLAG(IS_WASM)
-      kBufferMS = 1250,
-#elif BUILDFLAG(IS_ANDROID)
-      kBufferMS = 1000,
-#else
-      kBufferMS = 65000,
-#endif
     };
 
     AudioDevice();
@@ -79,6 +70,13 @@ class NES_EXPORT IODevices {
 
    public:
     virtual void OnSampleArrived(Sample* samples, size_t count) = 0;
+
+    // Gets how many samples the device wants for each one at kFrequency. A
+    // device which plays samples by its own clock returns a little more than 1
+    // when it's running out of samples, and a little less when they pile up,
+    // so that emulation keeps pace with its clock. It is asked once a frame,
+    // after the frame's samples arrive.
+    virtual double GetSampleRateRatio();
   };
 
   // Sets/Gets the input delegate, to handle input state.
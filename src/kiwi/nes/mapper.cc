@@ -16,24 +16,7 @@
 
 #include "base/logging.h"
 #include "nes/cartridge.h"
-#include "nes/mappers/mapper000.h"
-#include "nes/mappers/mapper001.h"
-#include "nes/mappers/mapper002.h"
-#include "nes/mappers/mapper003.h"
-#include "nes/mappers/mapper004.h"
-#include "nes/mappers/mapper005.h"
-#include "nes/mappers/mapper007.h"
-#include "nes/mappers/mapper009.h"
-#include "nes/mappers/mapper010.h"
-#include "nes/mappers/mapper011.h"
-#include "nes/mappers/mapper033.h"
-#include "nes/mappers/mapper040.h"
-#include "nes/mappers/mapper048.h"
-#include "nes/mappers/mapper066.h"
-#include "nes/mappers/mapper074.h"
-#include "nes/mappers/mapper075.h"
-#include "nes/mappers/mapper087.h"
-#include "nes/mappers/mapper185.h"
+#include "nes/mappers/mappers.h"
 
 namespace kiwi {
 namespace nes {
@@ -54,17 +37,12 @@ struct MapperFactoryBuilder : MapperFactory {
 };
 
 #define MAPPER(mapper, type) \
-  { mapper, new MapperFactoryBuilder<type, mapper>() }
+  {mapper, new MapperFactoryBuilder<type, mapper>()},
 
 // Leaks mappers by purpose.
 std::map<Byte, MapperFactory*> mapper_factories = {
-    MAPPER(0, Mapper000),  MAPPER(1, Mapper001),  MAPPER(2, Mapper002),
-    MAPPER(3, Mapper003),  MAPPER(4, Mapper004),  MAPPER(5, Mapper005),
-    MAPPER(7, Mapper007),  MAPPER(9, Mapper009),  MAPPER(10, Mapper010),
-    MAPPER(11, Mapper011), MAPPER(33, Mapper033), MAPPER(40, Mapper040),
-    MAPPER(48, Mapper048), MAPPER(66, Mapper066), MAPPER(74, Mapper074),
-    MAPPER(75, Mapper075), MAPPER(87, Mapper087), MAPPER(185, Mapper185),
-};
+    KIWI_NES_FOR_EACH_MAPPER(MAPPER)};
+#undef MAPPER
 }  // namespace
 
 Mapper::Mapper(Cartridge* cartridge) {
@@ -80,17 +58,11 @@ NametableMirroring Mapper::GetNametableMirroring() {
 
 void Mapper::Reset() {}
 
-void Mapper::ScanlineIRQ(int scanline, bool render_enabled) {}
-
-void Mapper::M2CycleIRQ() {}
-
 bool Mapper::HasExtendedRAM() {
   DCHECK(rom_data_);
   return force_use_extended_ram_ || rom_data_->has_extended_ram;
 }
 
-void Mapper::PPUAddressChanged(Address address) {}
-
 std::unique_ptr<Mapper> Mapper::Create(Cartridge* cartridge, Byte mapper) {
   auto iter = mapper_factories.find(mapper);
   if (iter != mapper_factories.cend()) {
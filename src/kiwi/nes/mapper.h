@@ -13,6 +13,8 @@
 #ifndef NES_MAPPER_H_
 #define NES_MAPPER_H_
 
+#include <type_traits>
+
 #include "base/functional/callback.h"
 #include "nes/emulator_states.h"
 #include "nes/nes_export.h"
@@ -50,17 +52,22 @@ class NES_EXPORT Mapper : public EmulatorStates::SerializableState {
   // CPU: $8000-$FFFF
   virtual void WritePRG(Address addr, Byte value) = 0;
   virtual Byte ReadPRG(Address addr) = 0;
+  // Whether ReadPRG() changes the mapper's states, such as switching banks.
+  // If it does, the CPU never skips fetching instructions.
+  virtual bool HasPRGReadSideEffects() { return false; }
 
   // PPU: $0000-$1FFF
   virtual void WriteCHR(Address addr, Byte value) = 0;
   virtual Byte ReadCHR(Address addr) = 0;
 
   virtual NametableMirroring GetNametableMirroring();
-  virtual void ScanlineIRQ(int scanline, bool render_enabled);
-  virtual void M2CycleIRQ();
+  // Defaults are defined here, so that they are inlined into the step loops
+  // of mappers which don't override them, see MapperDispatch.
+  virtual void ScanlineIRQ(int scanline, bool render_enabled) {}
+  virtual void M2CycleIRQ() {}
 
   // MMC3 uses this.
-  virtual void PPUAddressChanged(Address address);
+  virtual void PPUAddressChanged(Address address) {}
 
   // CPU: $4020-$7FFF
   // If a ROM has extented RAM, when writing to $4010-$7FFF, WriteExtendedRAM()
@@ -74,6 +81,15 @@ class NES_EXPORT Mapper : public EmulatorStates::SerializableState {
   virtual Byte* GetExtendedRAMPointer();
   bool HasExtendedRAM();
 
+  // Copies the mapper with all its states, such as banks, registers and
+  // CHR-RAM. The copy shares the ROM data, and its callbacks must be set again.
+  virtual std::unique_ptr<Mapper> Clone() = 0;
+
+  // Copies the states of |other|, which is the same mapper of the same ROM,
+  // into this one. Unlike Clone(), it allocates nothing, and keeps the
+  // callbacks.
+  virtual void CopyStatesFrom(const Mapper& other) = 0;
+
   static std::unique_ptr<Mapper> Create(Cartridge* cartridge, Byte mapper);
   static bool IsMapperSupported(Byte mapper);
 
@@ -83,16 +99,29 @@ class NES_EXPORT Mapper : public EmulatorStates::SerializableState {
                    EmulatorStates::DeserializableStateData& data) override;
 
   // For MMC5 only
+  // Step loops of other mappers know they are not MMC5 at compile time, see
+  // MapperDispatch::IsMMC5().
+  static constexpr bool kIsMMC5 = false;
   virtual bool IsMMC5() { return false; }
   virtual Byte ReadNametableByte(Byte* ram, Address address) { return 0; }
   virtual void WriteNametableByte(Byte* ram, Address address, Byte value) {}
-  virtual void SetCurrentRenderState(bool is_background,
+
+  // MMC5 selects CHR banks by what the PPU is fetching, and substitutes its
+  // own nametable in the split region. The PPU calls these fetch hooks for
+  // MMC5 only.
+  // OnBackgroundTileFetch() is called once for each background tile of a
+  // scanline, at the first |dot| fetched in it. Returns true if the tile is in
+  // the split region, and sets |split_data_address| to the data address
+  // fetched instead of the PPU's.
+  virtual bool OnBackgroundTileFetch(int dot,
                                      bool is_8x16_sprite,
-                                     int current_dot_in_scanline) {}
-  virtual Byte GetFineXInSplitRegion(Byte ppu_x_fine) { return ppu_x_fine; }
-  virtual Address GetDataAddressInSplitRegion(Address ppu_data_address) {
-    return ppu_data_address;
+                                     Address* split_data_address) {
+    return false;
   }
+  // Sprite patterns of a dot are fetched between OnSpriteFetch() and
+  // OnSpriteFetchEnd().
+  virtual void OnSpriteFetch(int dot, bool is_8x16_sprite) {}
+  virtual void OnSpriteFetchEnd() {}
 
  protected:
   MirroringChangedCallback mirroring_changed_callback() {
@@ -102,6 +131,19 @@ class NES_EXPORT Mapper : public EmulatorStates::SerializableState {
   // A callback to set CPU's IRQ.
   IRQCallback irq_callback() { return irq_callback_; }
 
+  // Implements CopyStatesFrom() by assigning |other| to this mapper, which is
+  // also a |MapperType|. Buffers keep their capacity, so that they are not
+  // reallocated.
+  template <typename MapperType>
+  void CopyStates(const MapperType& other) {
+    MirroringChangedCallback mirroring_changed_callback =
+        std::move(mirroring_changed_callback_);
+    IRQCallback irq_callback = std::move(irq_callback_);
+    static_cast<MapperType&>(*this) = other;
+    mirroring_changed_callback_ = std::move(mirroring_changed_callback);
+    irq_callback_ = std::move(irq_callback);
+  }
+
  private:
   void CheckExtendedRAM();
 
@@ -116,6 +158,45 @@ class NES_EXPORT Mapper : public EmulatorStates::SerializableState {
   bool force_use_extended_ram_ = false;
 };
 
+// Calls a mapper's methods which are called by the PPU or the CPU in every
+// cycle. If |MapperType| is a concrete mapper, the calls are not virtual, and
+// the mapper must be exactly |MapperType|, not a subclass of it. Mapper itself
+// dispatches virtually, for mappers which have no step loop of their own.
+template <typename MapperType>
+struct MapperDispatch {
+  static Byte ReadCHR(Mapper* mapper, Address address) {
+    if constexpr (std::is_same_v<MapperType, Mapper>)
+      return mapper->ReadCHR(address);
+    else
+      return static_cast<MapperType*>(mapper)->MapperType::ReadCHR(address);
+  }
+
+  static void ScanlineIRQ(Mapper* mapper, int scanline, bool render_enabled) {
+    if constexpr (std::is_same_v<MapperType, Mapper>) {
+      mapper->ScanlineIRQ(scanline, render_enabled);
+    } else {
+      static_cast<MapperType*>(mapper)->MapperType::ScanlineIRQ(
+          scanline, render_enabled);
+    }
+  }
+
+  // Returns whether the mapper is MMC5. Only Mapper checks |is_mmc5| at
+  // runtime.
+  static bool IsMMC5(bool is_mmc5) {
+    if constexpr (std::is_same_v<MapperType, Mapper>)
+      return is_mmc5;
+    else
+      return MapperType::kIsMMC5;
+  }
+
+  static void M2CycleIRQ(Mapper* mapper) {
+    if constexpr (std::is_same_v<MapperType, Mapper>)
+      mapper->M2CycleIRQ();
+    else
+      static_cast<MapperType*>(mapper)->MapperType::M2CycleIRQ();
+  }
+};
+
 }  // namespace nes
 }  // namespace kiwi
 
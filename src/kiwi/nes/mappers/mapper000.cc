@@ -35,6 +35,14 @@ Mapper000::Mapper000(Cartridge* cartridge) : Mapper(cartridge) {
 
 Mapper000::~Mapper000() = default;
 
+std::unique_ptr<Mapper> Mapper000::Clone() {
+  return std::make_unique<Mapper000>(*this);
+}
+
+void Mapper000::CopyStatesFrom(const Mapper& other) {
+  CopyStates(static_cast<const Mapper000&>(other));
+}
+
 void Mapper000::WritePRG(Address address, Byte value) {
   LOG(ERROR) << "Can't write value $" << Hex<16>{value} << " to PRG address $"
              << Hex<16>{address} << ", because it is read only.";
@@ -29,6 +29,14 @@ Mapper001::Mapper001(Cartridge* cartridge) : Mapper(cartridge) {
 
 Mapper001::~Mapper001() = default;
 
+std::unique_ptr<Mapper> Mapper001::Clone() {
+  return std::make_unique<Mapper001>(*this);
+}
+
+void Mapper001::CopyStatesFrom(const Mapper& other) {
+  CopyStates(static_cast<const Mapper001&>(other));
+}
+
 void Mapper001::WritePRG(Address address, Byte value) {
   // Load Register: $8000-$FFFF
   if (address < 0x8000)
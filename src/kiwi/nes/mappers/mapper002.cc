@@ -31,6 +31,14 @@ Mapper002::Mapper002(Cartridge* cartridge) : Mapper(cartridge) {
 
 Mapper002::~Mapper002() = default;
 
+std::unique_ptr<Mapper> Mapper002::Clone() {
+  return std::make_unique<Mapper002>(*this);
+}
+
+void Mapper002::CopyStatesFrom(const Mapper& other) {
+  CopyStates(static_cast<const Mapper002&>(other));
+}
+
 // 7  bit  0
 // ---- ----
 // xxxx pPPP
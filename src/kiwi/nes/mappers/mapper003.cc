@@ -34,6 +34,14 @@ Mapper003::Mapper003(Cartridge* cartridge) : Mapper(cartridge) {
 
 Mapper003::~Mapper003() = default;
 
+std::unique_ptr<Mapper> Mapper003::Clone() {
+  return std::make_unique<Mapper003>(*this);
+}
+
+void Mapper003::CopyStatesFrom(const Mapper& other) {
+  CopyStates(static_cast<const Mapper003&>(other));
+}
+
 // D~[..DC ..BA] A~[1... .... .... ....]
 //      ||   ||
 //      ||   ++- CHR A14..A13 (8 KiB bank)
@@ -37,6 +37,14 @@ Mapper004::Mapper004(Cartridge* cartridge) : Mapper(cartridge) {
 
 Mapper004::~Mapper004() = default;
 
+std::unique_ptr<Mapper> Mapper004::Clone() {
+  return std::make_unique<Mapper004>(*this);
+}
+
+void Mapper004::CopyStatesFrom(const Mapper& other) {
+  CopyStates(static_cast<const Mapper004&>(other));
+}
+
 void Mapper004::WritePRG(Address address, Byte value) {
   if (address >= 0x6000 && address <= 0x7fff) {
     prg_ram_[address & 0x1fff] = value;
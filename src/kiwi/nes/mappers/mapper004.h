@@ -43,6 +43,9 @@ class Mapper004 : public Mapper {
   void ScanlineIRQ(int scanline, bool render_enabled) override;
   void PPUAddressChanged(Address address) override;
 
+  std::unique_ptr<Mapper> Clone() override;
+  void CopyStatesFrom(const Mapper& other) override;
+
   // EmulatorStates::SerializableState:
   void Serialize(EmulatorStates::SerializableStateData& data) override;
   bool Deserialize(const EmulatorStates::Header& header,
@@ -40,6 +40,14 @@ Mapper005::Mapper005(Cartridge* cartridge) : Mapper(cartridge) {
 
 Mapper005::~Mapper005() = default;
 
+std::unique_ptr<Mapper> Mapper005::Clone() {
+  return std::make_unique<Mapper005>(*this);
+}
+
+void Mapper005::CopyStatesFrom(const Mapper& other) {
+  CopyStates(static_cast<const Mapper005&>(other));
+}
+
 void Mapper005::Reset() {
   ResetRegisters();
 }
@@ -744,6 +752,11 @@ bool Mapper005::IsMMC5() {
   return true;
 }
 
+bool Mapper005::HasPRGReadSideEffects() {
+  // PRG banks are switched by reading.
+  return true;
+}
+
 Byte Mapper005::ReadNametableByte(Byte* ram, Address address) {
   bool is_fetching_attribute = (address & 0x3ff) >= 0x3c0;
   if (IsInExtendedGraphicMode()) {
@@ -834,18 +847,25 @@ void Mapper005::SetCurrentRenderState(bool is_background,
       (split_data_address_ & 0xffe0) | ((current_dot_in_scanline_ / 8) & 0x1f);
 }
 
-Byte Mapper005::GetFineXInSplitRegion(Byte ppu_x_fine) {
-  if (InSplitRegion())
-    return current_dot_in_scanline_ % 8;
+bool Mapper005::OnBackgroundTileFetch(int dot,
+                                      bool is_8x16_sprite,
+                                      Address* split_data_address) {
+  SetCurrentRenderState(true, is_8x16_sprite, dot);
+  if (!InSplitRegion())
+    return false;
 
-  return ppu_x_fine;
+  *split_data_address = (split_data_address_ & 0xfff) | (split_fine_y_ << 12);
+  return true;
 }
 
-Address Mapper005::GetDataAddressInSplitRegion(Address ppu_data_address) {
-  if (InSplitRegion())
-    return ((split_data_address_ & 0xfff) | (split_fine_y_ << 12));
+void Mapper005::OnSpriteFetch(int dot, bool is_8x16_sprite) {
+  SetCurrentRenderState(false, is_8x16_sprite, dot);
+}
 
-  return ppu_data_address;
+void Mapper005::OnSpriteFetchEnd() {
+  // Fetches out of sprites, such as Uchuu Keibitai SDF (Japan) reading
+  // nametables before rendering, are treated as background fetches.
+  current_pattern_is_background_ = true;
 }
 
 }  // namespace nes
@@ -42,23 +42,31 @@ class Mapper005 : public Mapper {
 
   void ScanlineIRQ(int scanline, bool render_enabled) override;
 
+  std::unique_ptr<Mapper> Clone() override;
+  void CopyStatesFrom(const Mapper& other) override;
+
   // EmulatorStates::SerializableState:
   void Serialize(EmulatorStates::SerializableStateData& data) override;
   bool Deserialize(const EmulatorStates::Header& header,
                    EmulatorStates::DeserializableStateData& data) override;
 
   // MMC5
+  static constexpr bool kIsMMC5 = true;
   bool IsMMC5() override;
+  bool HasPRGReadSideEffects() override;
   Byte ReadNametableByte(Byte* ram, Address address) override;
   void WriteNametableByte(Byte* ram, Address address, Byte value) override;
-  void SetCurrentRenderState(bool is_background,
+  bool OnBackgroundTileFetch(int dot,
                              bool is_8x16_sprite,
-                             int current_dot_in_scanline) override;
-  Byte GetFineXInSplitRegion(Byte ppu_x_fine) override;
-  Address GetDataAddressInSplitRegion(Address ppu_data_address) override;
+                             Address* split_data_address) override;
+  void OnSpriteFetch(int dot, bool is_8x16_sprite) override;
+  void OnSpriteFetchEnd() override;
 
  private:
   void ResetRegisters();
+  void SetCurrentRenderState(bool is_background,
+                             bool is_8x16_sprite,
+                             int current_dot_in_scanline);
   Byte SelectSRAM(Byte data);
   bool SplitIsOn();
   bool InSplitRegion();
@@ -31,6 +31,14 @@ Mapper007::Mapper007(Cartridge* cartridge) : Mapper(cartridge) {
 
 Mapper007::~Mapper007() = default;
 
+std::unique_ptr<Mapper> Mapper007::Clone() {
+  return std::make_unique<Mapper007>(*this);
+}
+
+void Mapper007::CopyStatesFrom(const Mapper& other) {
+  CopyStates(static_cast<const Mapper007&>(other));
+}
+
 // 7  bit  0
 // ---- ----
 // xxxM xPPP
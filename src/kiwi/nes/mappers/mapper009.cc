@@ -46,6 +46,14 @@ Mapper009::Mapper009(Cartridge* cartridge) : Mapper(cartridge) {
 
 Mapper009::~Mapper009() = default;
 
+std::unique_ptr<Mapper> Mapper009::Clone() {
+  return std::make_unique<Mapper009>(*this);
+}
+
+void Mapper009::CopyStatesFrom(const Mapper& other) {
+  CopyStates(static_cast<const Mapper009&>(other));
+}
+
 void Mapper009::WritePRG(Address address, Byte value) {
   switch (address & 0xf000) {
     case 0xa000:
@@ -33,6 +33,14 @@ Mapper010::Mapper010(Cartridge* cartridge) : Mapper(cartridge) {
 
 Mapper010::~Mapper010() = default;
 
+std::unique_ptr<Mapper> Mapper010::Clone() {
+  return std::make_unique<Mapper010>(*this);
+}
+
+void Mapper010::CopyStatesFrom(const Mapper& other) {
+  CopyStates(static_cast<const Mapper010&>(other));
+}
+
 void Mapper010::WritePRG(Address address, Byte value) {
   switch (address & 0xf000) {
     case 0xa000:
@@ -26,6 +26,14 @@ Mapper011::Mapper011(Cartridge* cartridge) : Mapper(cartridge) {}
 
 Mapper011::~Mapper011() = default;
 
+std::unique_ptr<Mapper> Mapper011::Clone() {
+  return std::make_unique<Mapper011>(*this);
+}
+
+void Mapper011::CopyStatesFrom(const Mapper& other) {
+  CopyStates(static_cast<const Mapper011&>(other));
+}
+
 void Mapper011::WritePRG(Address address, Byte value) {
   if (address >= 0x8000) {
     // 7  bit  0
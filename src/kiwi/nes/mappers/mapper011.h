@@ -34,6 +34,9 @@ class Mapper011 : public Mapper{
   void WriteCHR(Address address, Byte value) override;
   Byte ReadCHR(Address address) override;
 
+  std::unique_ptr<Mapper> Clone() override;
+  void CopyStatesFrom(const Mapper& other) override;
+
   // EmulatorStates::SerializableState:
   void Serialize(EmulatorStates::SerializableStateData& data) override;
   bool Deserialize(const EmulatorStates::Header& header,
@@ -25,5 +25,13 @@ Mapper033::Mapper033(Cartridge* cartridge) : Mapper048(cartridge) {
 
 Mapper033::~Mapper033() = default;
 
+std::unique_ptr<Mapper> Mapper033::Clone() {
+  return std::make_unique<Mapper033>(*this);
+}
+
+void Mapper033::CopyStatesFrom(const Mapper& other) {
+  CopyStates(static_cast<const Mapper033&>(other));
+}
+
 }  // namespace nes
 }  // namespace kiwi
@@ -24,6 +24,9 @@ class Mapper033 : public Mapper048 {
  public:
   explicit Mapper033(Cartridge* cartridge);
   ~Mapper033() override;
+
+  std::unique_ptr<Mapper> Clone() override;
+  void CopyStatesFrom(const Mapper& other) override;
 };
 
 }  // namespace nes
@@ -49,6 +49,14 @@ Mapper040::Mapper040(Cartridge* cartridge) : Mapper(cartridge) {
 
 Mapper040::~Mapper040() = default;
 
+std::unique_ptr<Mapper> Mapper040::Clone() {
+  return std::make_unique<Mapper040>(*this);
+}
+
+void Mapper040::CopyStatesFrom(const Mapper& other) {
+  CopyStates(static_cast<const Mapper040&>(other));
+}
+
 void Mapper040::WritePRG(Address address, Byte value) {
   if (0x8000 <= address && address <= 0x9fff) {
     // Disable and reset IRQ counter
@@ -31,6 +31,14 @@ Mapper048::Mapper048(Cartridge* cartridge) : Mapper(cartridge) {
 
 Mapper048::~Mapper048() = default;
 
+std::unique_ptr<Mapper> Mapper048::Clone() {
+  return std::make_unique<Mapper048>(*this);
+}
+
+void Mapper048::CopyStatesFrom(const Mapper& other) {
+  CopyStates(static_cast<const Mapper048&>(other));
+}
+
 void Mapper048::ResetRegisters() {
   memset(prg_regs_, 0, sizeof(prg_regs_));
   memset(chr_regs_, 0, sizeof(chr_regs_));
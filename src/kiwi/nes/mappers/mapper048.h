@@ -38,6 +38,9 @@ class Mapper048 : public Mapper {
   NametableMirroring GetNametableMirroring() override;
   void ScanlineIRQ(int scanline, bool render_enabled) override;
 
+  std::unique_ptr<Mapper> Clone() override;
+  void CopyStatesFrom(const Mapper& other) override;
+
   // EmulatorStates::SerializableState:
   void Serialize(EmulatorStates::SerializableStateData& data) override;
   bool Deserialize(const EmulatorStates::Header& header,
@@ -33,6 +33,14 @@ Mapper066::Mapper066(Cartridge* cartridge) : Mapper(cartridge) {}
 
 Mapper066::~Mapper066() = default;
 
+std::unique_ptr<Mapper> Mapper066::Clone() {
+  return std::make_unique<Mapper066>(*this);
+}
+
+void Mapper066::CopyStatesFrom(const Mapper& other) {
+  CopyStates(static_cast<const Mapper066&>(other));
+}
+
 void Mapper066::WritePRG(Address address, Byte value) {
   if (address >= 0x8000) {
     select_chr_prg_ = value;
@@ -28,6 +28,14 @@ Mapper074::Mapper074(Cartridge* cartridge) : Mapper004(cartridge) {
 
 Mapper074::~Mapper074() = default;
 
+std::unique_ptr<Mapper> Mapper074::Clone() {
+  return std::make_unique<Mapper074>(*this);
+}
+
+void Mapper074::CopyStatesFrom(const Mapper& other) {
+  CopyStates(static_cast<const Mapper074&>(other));
+}
+
 void Mapper074::WriteCHR(Address address, Byte value) {
   Mapper004::WriteCHR(address, value);
   prg_ram_[address % prg_ram_.size()] = value;
@@ -29,6 +29,9 @@ class Mapper074 : public Mapper004 {
  public:
   void WriteCHR(Address address, Byte value) override;
 
+  std::unique_ptr<Mapper> Clone() override;
+  void CopyStatesFrom(const Mapper& other) override;
+
   // EmulatorStates::SerializableState:
   void Serialize(EmulatorStates::SerializableStateData& data) override;
   bool Deserialize(const EmulatorStates::Header& header,
@@ -45,6 +45,14 @@ Mapper075::Mapper075(Cartridge* cartridge) : Mapper(cartridge) {
 
 Mapper075::~Mapper075() = default;
 
+std::unique_ptr<Mapper> Mapper075::Clone() {
+  return std::make_unique<Mapper075>(*this);
+}
+
+void Mapper075::CopyStatesFrom(const Mapper& other) {
+  CopyStates(static_cast<const Mapper075&>(other));
+}
+
 void Mapper075::WritePRG(Address address, Byte value) {
   switch (address & 0xf000) {
     case 0x8000:
@@ -24,6 +24,14 @@ Mapper087::Mapper087(Cartridge* cartridge) : Mapper(cartridge) {}
 
 Mapper087::~Mapper087() = default;
 
+std::unique_ptr<Mapper> Mapper087::Clone() {
+  return std::make_unique<Mapper087>(*this);
+}
+
+void Mapper087::CopyStatesFrom(const Mapper& other) {
+  CopyStates(static_cast<const Mapper087&>(other));
+}
+
 void Mapper087::WritePRG(Address address, Byte value) {
   if (address >= 0x6000) {
     select_chr_ = ((value >> 1) & 1) | ((value & 1) << 1);
@@ -20,5 +20,13 @@ namespace kiwi {
 namespace nes {
 Mapper185::Mapper185(Cartridge* cartridge) : Mapper003(cartridge) {}
 Mapper185::~Mapper185() = default;
+
+std::unique_ptr<Mapper> Mapper185::Clone() {
+  return std::make_unique<Mapper185>(*this);
+}
+
+void Mapper185::CopyStatesFrom(const Mapper& other) {
+  CopyStates(static_cast<const Mapper185&>(other));
+}
 }  // namespace nes
 }  // namespace kiwi
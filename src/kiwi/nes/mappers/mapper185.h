@@ -25,6 +25,9 @@ class Mapper185 : public Mapper003 {
  public:
   explicit Mapper185(Cartridge* cartridge);
   ~Mapper185() override;
+
+  std::unique_ptr<Mapper> Clone() override;
+  void CopyStatesFrom(const Mapper& other) override;
 };
 
 }  // namespace core
@@ -0,0 +1,57 @@
+// Copyright (C) 2026 Yisi Yu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#ifndef NES_MAPPERS_MAPPERS_H_
+#define NES_MAPPERS_MAPPERS_H_
+
+#include "nes/mappers/mapper000.h"
+#include "nes/mappers/mapper001.h"
+#include "nes/mappers/mapper002.h"
+#include "nes/mappers/mapper003.h"
+#include "nes/mappers/mapper004.h"
+#include "nes/mappers/mapper005.h"
+#include "nes/mappers/mapper007.h"
+#include "nes/mappers/mapper009.h"
+#include "nes/mappers/mapper010.h"
+#include "nes/mappers/mapper011.h"
+#include "nes/mappers/mapper033.h"
+#include "nes/mappers/mapper040.h"
+#include "nes/mappers/mapper048.h"
+#include "nes/mappers/mapper066.h"
+#include "nes/mappers/mapper074.h"
+#include "nes/mappers/mapper075.h"
+#include "nes/mappers/mapper087.h"
+#include "nes/mappers/mapper185.h"
+
+// Invokes V(number, type) for each supported mapper. A new mapper must be
+// added here, so that it can be created, and it gets its own step loop.
+#define KIWI_NES_FOR_EACH_MAPPER(V) \
+  V(0, Mapper000)                   \
+  V(1, Mapper001)                   \
+  V(2, Mapper002)                   \
+  V(3, Mapper003)                   \
+  V(4, Mapper004)                   \
+  V(5, Mapper005)                   \
+  V(7, Mapper007)                   \
+  V(9, Mapper009)                   \
+  V(10, Mapper010)                  \
+  V(11, Mapper011)                  \
+  V(33, Mapper033)                  \
+  V(40, Mapper040)                  \
+  V(48, Mapper048)                  \
+  V(66, Mapper066)                  \
+  V(74, Mapper074)                  \
+  V(75, Mapper075)                  \
+  V(87, Mapper087)                  \
+  V(185, Mapper185)
+
+#endif  // NES_MAPPERS_MAPPERS_H_
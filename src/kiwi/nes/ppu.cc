@@ -14,6 +14,7 @@
 
 #include "base/logging.h"
 #include "nes/mapper.h"
+#include "nes/mappers/mappers.h"
 #include "nes/palette.h"
 #include "nes/ppu_bus.h"
 #include "nes/registers.h"
@@ -25,11 +26,17 @@ constexpr int kScanlineVisibleDots = 256;
 // Visible scanlines are from 0 to 239.
 constexpr int kVisibleScanlines = 240;
 
-PPU::PPU(PPUBus* bus)
-    : ppu_bus_(bus), palette_(CreatePaletteFromPPUModel(PPUModel::k2C02)) {
+PPU::PPU(PPUBus* bus, Byte* indexed_screenbuffers)
+    : ppu_bus_(bus),
+      palette_(CreatePaletteFromPPUModel(PPUModel::k2C02)),
+      indexed_screenbuffers_(indexed_screenbuffers) {
   // Initialize buffers
-  for (size_t i = 0; i < kMaxBufferSize; ++i) {
-    screenbuffers_[i].resize(kVisibleScanlines * kScanlineVisibleDots);
+  if (indexed_screenbuffers_) {
+    memset(indexed_screenbuffers_, 0, kMaxBufferSize * kFrameSize);
+  } else {
+    for (size_t i = 0; i < kMaxBufferSize; ++i) {
+      screenbuffers_[i].resize(kVisibleScanlines * kScanlineVisibleDots);
+    }
   }
 }
 
@@ -54,8 +61,10 @@ void PPU::Reset() {
   pipeline_state_ = PipelineState::kPreRender;
   scanline_ = 0;
   nmi_delay_ = 0;
+  mmc5_tile_ = -1;
 }
 
+template <typename MapperType>
 void PPU::Step() {
   // The PPU renders 262 scanlines per frame. Each scanline lasts for 341 PPU
   // clock cycles (113.667 CPU clock cycles; 1 CPU cycle = 3 PPU cycles), with
@@ -82,6 +91,7 @@ void PPU::Step() {
       } else if (cycles_ == 1) {
         registers_.PPUSTATUS.V = registers_.PPUSTATUS.S =
             registers_.PPUSTATUS.O = 0;
+        mmc5_tile_ = -1;
       } else if (cycles_ == 257 && is_render_enabled()) {  // Dot 257
         data_address_ &= ~0x41f;
         data_address_ |= temp_address_ & 0x41f;
@@ -102,7 +112,8 @@ void PPU::Step() {
       } else if (cycles_ == patch_.scanline_irq_dot) {
         // add IRQ support for MMC
         // -1 means pre-render state
-        ppu_bus_->GetMapper()->ScanlineIRQ(-1, is_render_enabled());
+        MapperDispatch<MapperType>::ScanlineIRQ(ppu_bus_->GetMapper(), -1,
+                                                is_render_enabled());
       }
     } break;
     case PipelineState::kRender: {
@@ -122,6 +133,10 @@ void PPU::Step() {
         const int y = scanline_;
         bool is_background_opaque = false;
         bool is_sprite_opaque = false;
+        // MMC5 is told what is fetched, other mappers skip it at compile time.
+        const bool is_mmc5 =
+            MapperDispatch<MapperType>::IsMMC5(ppu_bus_->is_mmc5());
+        const bool is_8x16_sprite = registers_.PPUCTRL.H && is_render_enabled();
 
         if (is_render_background()) {
           // Data address decoding:
@@ -149,24 +164,38 @@ void PPU::Step() {
             if (patch_.data_address_patch)
               patch_.data_address_patch(&data_address_);
 
+            Address data_address = data_address_;
+            Byte temp_x_fine = x_fine;
+            if (is_mmc5) {
+              // MMC5 is told once per tile, and uses its own data address and
+              // fine X in the split region.
+              const int mmc5_tile = y * 32 + x / 8;
+              if (mmc5_tile != mmc5_tile_) {
+                mmc5_tile_ = mmc5_tile;
+                mmc5_in_split_region_ =
+                    ppu_bus_->GetMapper()->OnBackgroundTileFetch(
+                        x, is_8x16_sprite, &mmc5_split_data_address_);
+              }
+              if (mmc5_in_split_region_) {
+                data_address = mmc5_split_data_address_;
+                temp_x_fine = x % 8;
+              }
+            }
+
             // Fetch tile (nametable byte).
-            ppu_bus_->SetCurrentPatternState(
-                PPUBus::CurrentPatternType::kBackground,
-                registers_.PPUCTRL.H && is_render_enabled(), x);
-            const Address data_address =
-                ppu_bus_->GetAdjustedDataAddress(data_address_);
             Address pixel_address = 0x2000 | (data_address & 0x0fff);
-            Byte tile = ppu_bus_->Read(pixel_address);
+            Byte tile = ppu_bus_->Read<MapperType>(pixel_address);
             // Gets tile address with fine Y scroll
             pixel_address = (tile << 4) + ((data_address >> 12) & 0x7);
             pixel_address += background_pattern_table_base_address();
 
-            Byte pattern = ppu_bus_->Read(pixel_address);
+            Byte pattern = ppu_bus_->Read<MapperType>(pixel_address);
             // Combines the tile and get background color index.
-            const Byte temp_x_fine = ppu_bus_->GetAdjustedXFine(x_fine);
             background_color = (pattern >> (7 ^ temp_x_fine)) & 1;
             background_color |=
-                ((ppu_bus_->Read(pixel_address + 8) >> (7 ^ temp_x_fine)) & 1)
+                ((ppu_bus_->Read<MapperType>(pixel_address + 8) >>
+                  (7 ^ temp_x_fine)) &
+                 1)
                 << 1;
 
             // If |background_color| is not 0, it is opaque.
@@ -177,7 +206,7 @@ void PPU::Step() {
             Address attribute_address = 0x23c0 | (data_address & 0x0c00) |
                                         ((data_address >> 4) & 0x38) |
                                         ((data_address >> 2) & 0x07);
-            Byte attribute = ppu_bus_->Read(attribute_address);
+            Byte attribute = ppu_bus_->Read<MapperType>(attribute_address);
             int shift = ((data_address >> 4) & 4) | (data_address & 2);
             // Extract and set the upper two bits for the color
             background_color |= ((attribute >> shift) & 0x3) << 2;
@@ -198,6 +227,7 @@ void PPU::Step() {
 
         // For sprites rendering, see https://www.nesdev.org/wiki/PPU_OAM.
         bool is_sprite_foreground = true;
+        bool is_sprite_fetched = false;
         if (is_render_sprites() && (!is_hide_edge_sprites() || x >= 8)) {
           for (auto i : secondary_oam_) {
             Byte sprite_x = sprite_memory_[i * 4 + 3];
@@ -244,12 +274,15 @@ void PPU::Step() {
               pattern_address |= (tile & 1) << 12;
             }
 
-            ppu_bus_->SetCurrentPatternState(
-                PPUBus::CurrentPatternType::kSprite,
-                registers_.PPUCTRL.H && is_render_enabled(), x);
-            sprite_color = (ppu_bus_->Read(pattern_address) >> (x_shift)) & 1;
-            sprite_color |=
-                ((ppu_bus_->Read(pattern_address + 8) >> (x_shift)) & 1) << 1;
+            if (is_mmc5 && !is_sprite_fetched)
+              ppu_bus_->GetMapper()->OnSpriteFetch(x, is_8x16_sprite);
+            is_sprite_fetched = true;
+            sprite_color =
+                (ppu_bus_->Read<MapperType>(pattern_address) >> (x_shift)) & 1;
+            sprite_color |= ((ppu_bus_->Read<MapperType>(pattern_address + 8) >>
+                              (x_shift)) &
+                             1)
+                            << 1;
 
             // If |sprite_color| is 0, it means this pixel is transparent.
             is_sprite_opaque = (sprite_color != 0);
@@ -274,6 +307,8 @@ void PPU::Step() {
             break;
           }
         }
+        if (is_mmc5 && is_sprite_fetched)
+          ppu_bus_->GetMapper()->OnSpriteFetchEnd();
 
         Byte palette_index = background_color;
         if ((!is_background_opaque && is_sprite_opaque) ||
@@ -286,13 +321,18 @@ void PPU::Step() {
 
         DCHECK(palette_);
         // Map |palette_index| to PPU memory map's Palette RAM address.
-        Color bgra = (palette_->GetColorBGRA(
-            ppu_bus_->Read(static_cast<Address>(palette_index | 0x3f00))));
-        DCHECK(static_cast<size_t>(y) * kScanlineVisibleDots +
-                   static_cast<size_t>(x) <
-               screenbuffers_[current_buffer_index_].size());
-        screenbuffers_[current_buffer_index_][y * kScanlineVisibleDots + x] =
-            bgra;
+        Byte color_index = ppu_bus_->Read<MapperType>(
+            static_cast<Address>(palette_index | 0x3f00));
+        if (indexed_screenbuffers_) {
+          indexed_screenbuffers_[current_buffer_index_ * kFrameSize +
+                                 y * kScanlineVisibleDots + x] = color_index;
+        } else {
+          DCHECK(static_cast<size_t>(y) * kScanlineVisibleDots +
+                     static_cast<size_t>(x) <
+                 screenbuffers_[current_buffer_index_].size());
+          screenbuffers_[current_buffer_index_][y * kScanlineVisibleDots + x] =
+              palette_->GetColorBGRA(color_index);
+        }
 
         if (cycles_ == kScanlineVisibleDots &&
             is_render_background()) {  // Dot 256
@@ -315,18 +355,14 @@ void PPU::Step() {
             data_address_ = (data_address_ & ~0x03e0) | (new_y << 5);
           }
         }
-
-        // Rendering is done, restore the pattern state
-        ppu_bus_->SetCurrentPatternState(
-            PPUBus::CurrentPatternType::kNotRendering,
-            registers_.PPUCTRL.H && is_render_enabled(), x);
       } else if (cycles_ == 257 && is_render_background()) {  // Dot 257
         data_address_ &= ~0x41f;
         data_address_ |= temp_address_ & 0x41f;
       }
 
       if (cycles_ == patch_.scanline_irq_dot) {
-        ppu_bus_->GetMapper()->ScanlineIRQ(scanline_, is_render_enabled());
+        MapperDispatch<MapperType>::ScanlineIRQ(
+            ppu_bus_->GetMapper(), scanline_, is_render_enabled());
       }
 
       if (cycles_ >= kScanlineEndCycle) {
@@ -367,7 +403,8 @@ void PPU::Step() {
     case PipelineState::kPostRender: {
       if (cycles_ == patch_.scanline_irq_dot) {
         DCHECK(scanline_ >= 240);
-        ppu_bus_->GetMapper()->ScanlineIRQ(scanline_, is_render_enabled());
+        MapperDispatch<MapperType>::ScanlineIRQ(
+            ppu_bus_->GetMapper(), scanline_, is_render_enabled());
       }
 
       if (cycles_ >= kScanlineEndCycle) {
@@ -375,15 +412,16 @@ void PPU::Step() {
         pipeline_state_ = PipelineState::kVerticalBlank;
 
         if (observer_) {
-          observer_->OnRenderReady(screenbuffers_[current_buffer_index_]);
           current_buffer_index_ = (current_buffer_index_ + 1) % kMaxBufferSize;
+          observer_->OnRenderReady();
         }
       }
     } break;
     case PipelineState::kVerticalBlank: {
       if (cycles_ == patch_.scanline_irq_dot) {
         DCHECK(scanline_ >= 240);
-        ppu_bus_->GetMapper()->ScanlineIRQ(scanline_, is_render_enabled());
+        MapperDispatch<MapperType>::ScanlineIRQ(
+            ppu_bus_->GetMapper(), scanline_, is_render_enabled());
       }
 
       // The VBlank flag of the PPU is set at tick 1 (the second tick) of
@@ -422,6 +460,11 @@ void PPU::Step() {
   }
 }
 
+template void PPU::Step<Mapper>();
+#define INSTANTIATE_STEP(mapper, type) template void PPU::Step<type>();
+KIWI_NES_FOR_EACH_MAPPER(INSTANTIATE_STEP)
+#undef INSTANTIATE_STEP
+
 Byte PPU::Read(Address address) {
   switch (static_cast<PPURegister>(address)) {
     case PPURegister::PPUCTRL:
@@ -468,6 +511,52 @@ void PPU::Write(Address address, Byte value) {
   }
 }
 
+void PPU::CopyStatesFrom(const PPU& other) {
+  registers_ = other.registers_;
+  temp_address_ = other.temp_address_;
+  data_address_ = other.data_address_;
+  sprite_data_address_ = other.sprite_data_address_;
+  fine_scroll_pos_x_ = other.fine_scroll_pos_x_;
+  data_buffer_ = other.data_buffer_;
+  write_toggle_ = other.write_toggle_;
+  nmi_delay_ = other.nmi_delay_;
+  std::memcpy(sprite_memory_, other.sprite_memory_, sizeof(sprite_memory_));
+  secondary_oam_ = other.secondary_oam_;
+  pipeline_state_ = other.pipeline_state_;
+  cycles_ = other.cycles_;
+  scanline_ = other.scanline_;
+  is_even_frame_ = other.is_even_frame_;
+  mmc5_tile_ = -1;
+  current_buffer_index_ = other.current_buffer_index_;
+  DCHECK_EQ(!indexed_screenbuffers_, !other.indexed_screenbuffers_);
+  if (indexed_screenbuffers_) {
+    std::memcpy(indexed_screenbuffers_, other.indexed_screenbuffers_,
+                kMaxBufferSize * kFrameSize);
+  } else {
+    for (size_t i = 0; i < kMaxBufferSize; ++i)
+      screenbuffers_[i] = other.screenbuffers_[i];
+  }
+}
+
+size_t PPU::GetAllocatedBytes() {
+  size_t bytes =
+      secondary_oam_.capacity() + converted_frame_.capacity() * sizeof(Color);
+  for (size_t i = 0; i < kMaxBufferSize; ++i)
+    bytes += screenbuffers_[i].capacity() * sizeof(Color);
+  return bytes;
+}
+
+const Colors& PPU::GetFrame(size_t buffer_index) {
+  if (!indexed_screenbuffers_)
+    return screenbuffers_[buffer_index];
+
+  converted_frame_.resize(kFrameSize);
+  const Byte* indices = indexed_screenbuffers_ + buffer_index * kFrameSize;
+  for (size_t i = 0; i < kFrameSize; ++i)
+    converted_frame_[i] = palette_->GetColorBGRA(indices[i]);
+  return converted_frame_;
+}
+
 void PPU::Serialize(EmulatorStates::SerializableStateData& data) {
   data.WriteData(registers_)
       .WriteData(temp_address_)
@@ -500,6 +589,7 @@ bool PPU::Deserialize(const EmulatorStates::Header& header,
         .ReadData(&cycles_)
         .ReadData(&scanline_)
         .ReadData(&is_even_frame_);
+    mmc5_tile_ = -1;
     return true;
   }
   return false;
@@ -524,6 +614,15 @@ void PPU::RemoveObserver() {
   observer_ = nullptr;
 }
 
+bool PPU::PeekStatus(Byte* status) {
+  if (registers_.PPUSTATUS.V || write_toggle_)
+    return false;
+
+  // Do not copy open bus.
+  *status = registers_.PPUSTATUS.value & 0xe0;
+  return true;
+}
+
 Byte PPU::GetStatus() {
   PPURegisters::PPUSTATUS_t status = registers_.PPUSTATUS;
   // Do not copy open bus.
@@ -24,6 +24,7 @@
 namespace kiwi {
 namespace nes {
 class CPU;
+class Mapper;
 class Palette;
 class PPUBus;
 
@@ -36,7 +37,14 @@ class PPU : public Device, public EmulatorStates::SerializableState {
     kVerticalBlank,
   };
 
-  explicit PPU(PPUBus* ppu_bus);
+  // Size of a frame in pixels.
+  static constexpr size_t kFrameSize = 256 * 240;
+
+  // If |indexed_screenbuffers| is set, frames are rendered into it as palette
+  // indices rather than colors. It must hold 2 frames, which are kFrameSize
+  // bytes each, and outlive the PPU. Colors are converted from the indices
+  // only when a frame is asked for.
+  explicit PPU(PPUBus* ppu_bus, Byte* indexed_screenbuffers = nullptr);
   ~PPU() override;
 
  public:
@@ -45,6 +53,9 @@ class PPU : public Device, public EmulatorStates::SerializableState {
   // See https://www.nesdev.org/wiki/PPU_power_up_state for more details.
   void PowerUp();
   void Reset();
+  // Steps a PPU cycle. Mappers are called through MapperDispatch<MapperType>,
+  // and the PPU's bus must be attached to a |MapperType|.
+  template <typename MapperType = Mapper>
   void Step();
   void DMA(Byte* source);
   PPURegisters registers() { return registers_; }
@@ -53,11 +64,20 @@ class PPU : public Device, public EmulatorStates::SerializableState {
   Palette* palette() { return palette_.get(); }
   bool write_toggle() { return write_toggle_; }
   const Colors& last_frame() {
-    return screenbuffers_[(current_buffer_index_ - 1) % kMaxBufferSize];
+    return GetFrame((current_buffer_index_ - 1) % kMaxBufferSize);
   }
-  const Colors& current_frame() {
-    return screenbuffers_[current_buffer_index_];
+  const Colors& current_frame() { return GetFrame(current_buffer_index_); }
+  // Returns the last frame as palette indices, or nullptr if the PPU renders
+  // colors.
+  const Byte* last_indexed_frame() {
+    return indexed_screenbuffers_
+               ? indexed_screenbuffers_ +
+                     (current_buffer_index_ - 1) % kMaxBufferSize * kFrameSize
+               : nullptr;
   }
+  // Bytes allocated for screen buffers and OAM, apart from the PPU itself.
+  // Indexed screen buffers are owned by the caller, and not counted.
+  size_t GetAllocatedBytes();
   int pixel() { return cycles_; }
   int scanline() {
     return pipeline_state_ == PipelineState::kPreRender ? 261 : scanline_;
@@ -71,6 +91,15 @@ class PPU : public Device, public EmulatorStates::SerializableState {
   void RemoveObserver();
   Byte ReadOAMData(Byte address);
 
+  // Gets PPUSTATUS as it would be read, if reading it has no side effects,
+  // which is when neither vertical blank nor the write toggle is set.
+  bool PeekStatus(Byte* status);
+
+  // Copies registers, OAM, the pipeline and screen buffers from |other|, so
+  // that a frame being rendered can be continued. Patches are set by
+  // SetPatch().
+  void CopyStatesFrom(const PPU& other);
+
  public:
   // Device:
   Byte Read(Address address) override;
@@ -82,6 +111,8 @@ class PPU : public Device, public EmulatorStates::SerializableState {
                    EmulatorStates::DeserializableStateData& data) override;
 
  private:
+  const Colors& GetFrame(size_t buffer_index);
+
   ALWAYS_INLINE Byte GetStatus();
   ALWAYS_INLINE Byte GetData();
   ALWAYS_INLINE Byte GetOAMData();
@@ -145,6 +176,16 @@ class PPU : public Device, public EmulatorStates::SerializableState {
   enum { kMaxBufferSize = 2 };
   size_t current_buffer_index_ = 0;
   Colors screenbuffers_[kMaxBufferSize];
+  Byte* indexed_screenbuffers_ = nullptr;
+  // Colors converted from an indexed screen buffer.
+  Colors converted_frame_;
+
+  // MMC5's split region of the background tile last told to it, see
+  // Mapper::OnBackgroundTileFetch(). |mmc5_tile_| is the tile's index in the
+  // frame, or -1 if MMC5 must be told again.
+  int mmc5_tile_ = -1;
+  bool mmc5_in_split_region_ = false;
+  Address mmc5_split_data_address_ = 0;
 
   PPUPatch patch_;
   uint32_t crc_;
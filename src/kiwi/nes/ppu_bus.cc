@@ -14,6 +14,7 @@
 
 #include "base/check.h"
 #include "nes/mapper.h"
+#include "nes/mappers/mappers.h"
 #include "nes/registers.h"
 
 namespace kiwi {
@@ -31,35 +32,6 @@ void PPUBus::SetMapper(Mapper* mapper) {
   SetDefaultPalettes();
 }
 
-void PPUBus::SetCurrentPatternState(CurrentPatternType pattern_type,
-                                    bool is_8x16_sprite,
-                                    int current_dot_in_scanline) {
-  if (is_mmc5_) {
-    // MMC5 needs know whether is fetching background tile or sprite tile.
-    // Uchuu Keibitai SDF (Japan) will fetch nametable and write bytes before
-    // rendering, so the current pattern type will be kNotRendering, and it
-    // will be treated as kBackground.
-    mapper_->SetCurrentRenderState(
-        pattern_type == CurrentPatternType::kBackground ||
-            pattern_type == CurrentPatternType::kNotRendering,
-        is_8x16_sprite, current_dot_in_scanline);
-  }
-}
-
-Byte PPUBus::GetAdjustedXFine(Byte x_fine_in) {
-  if (is_mmc5_)
-    return mapper_->GetFineXInSplitRegion(x_fine_in);
-
-  return x_fine_in;
-}
-
-Address PPUBus::GetAdjustedDataAddress(Address data_address_in) {
-  if (is_mmc5_)
-    return mapper_->GetDataAddressInSplitRegion(data_address_in);
-
-  return data_address_in;
-}
-
 void PPUBus::SetDefaultPalettes() {
   // By default, the palettes are set to background=black (0x3f), other=white
   // (0x30).
@@ -73,6 +45,7 @@ Mapper* PPUBus::GetMapper() {
   return mapper_;
 }
 
+template <typename MapperType>
 Byte PPUBus::Read(Address address) {
   // The PPU addresses a 16kB space, $0000-3FFF, completely separate from the
   // CPU's address bus. It is either directly accessed by the PPU itself, or via
@@ -81,7 +54,7 @@ Byte PPUBus::Read(Address address) {
   // nametable address space from $2000-2FFF, but this can be rerouted through
   // custom cartridge wiring.
   if (address < 0x2000) {
-    return mapper_->ReadCHR(address);
+    return MapperDispatch<MapperType>::ReadCHR(mapper_, address);
   } else if (address < 0x3eff) {
     const auto index = address & 0x3ff;
     // Name tables upto 0x3000, then mirrored upto 3eff
@@ -91,9 +64,9 @@ Byte PPUBus::Read(Address address) {
     }
 
     if (nametable_[0] >= RAM_SIZE) {
-      return mapper_->ReadCHR(normalized_address);
+      return MapperDispatch<MapperType>::ReadCHR(mapper_, normalized_address);
     } else {
-      if (!is_mmc5_) {
+      if (!MapperDispatch<MapperType>::IsMMC5(is_mmc5_)) {
         if (normalized_address < 0x2400)  // NT0
           return ram_[nametable_[0] + index];
         else if (normalized_address < 0x2800)  // NT1
@@ -114,6 +87,12 @@ Byte PPUBus::Read(Address address) {
   return 0;
 }
 
+template Byte PPUBus::Read<Mapper>(Address address);
+#define INSTANTIATE_READ(mapper, type) \
+  template Byte PPUBus::Read<type>(Address address);
+KIWI_NES_FOR_EACH_MAPPER(INSTANTIATE_READ)
+#undef INSTANTIATE_READ
+
 void PPUBus::Write(Address address, Byte value) {
   if (address < 0x2000) {
     mapper_->WriteCHR(address, value);
@@ -153,6 +132,12 @@ void PPUBus::Write(Address address, Byte value) {
   }
 }
 
+void PPUBus::CopyStatesFrom(const PPUBus& other) {
+  nametable_ = other.nametable_;
+  ram_ = other.ram_;
+  palette_ = other.palette_;
+}
+
 void PPUBus::Serialize(EmulatorStates::SerializableStateData& data) {
   data.WriteData(nametable_).WriteData(ram_).WriteData(palette_);
 }
@@ -26,21 +26,22 @@ class Mapper;
 // See https://www.nesdev.org/wiki/PPU_memory_map for more addressing details.
 class PPUBus : public EmulatorStates::SerializableState {
  public:
-  enum class CurrentPatternType {
-    kBackground,
-    kSprite,
-    kNotRendering,  // Fetching nametable not during rendering
-  };
-
   PPUBus();
   ~PPUBus() override;
 
   // Bus:
   void SetMapper(Mapper* mapper);
   Mapper* GetMapper();
+  // Pattern tables are read by MapperDispatch<MapperType>. It is instantiated
+  // for Mapper and each mapper in KIWI_NES_FOR_EACH_MAPPER.
+  template <typename MapperType = Mapper>
   Byte Read(Address address);
   void Write(Address address, Byte value);
 
+  // Copies nametables, VRAM and palettes from |other|. It must be called after
+  // SetMapper(), which resets mirroring and palettes.
+  void CopyStatesFrom(const PPUBus& other);
+
   // EmulatorStates::SerializableState:
   void Serialize(EmulatorStates::SerializableStateData& data) override;
   bool Deserialize(const EmulatorStates::Header& header,
@@ -48,14 +49,8 @@ class PPUBus : public EmulatorStates::SerializableState {
 
   void UpdateMirroring();
 
-  // Providing extra information for MMC5
-  void SetCurrentPatternState(CurrentPatternType pattern_type,
-                              bool is_8x16_sprite,
-                              int current_dot_in_scanline);
-
-  // MMC5 will use its own x_fine and data address when rendering split region.
-  Byte GetAdjustedXFine(Byte x_fine_in);
-  Address GetAdjustedDataAddress(Address data_address_in);
+  // Whether the mapper is MMC5, whose fetch hooks are called by the PPU.
+  bool is_mmc5() { return is_mmc5_; }
 
  private:
   void SetDefaultPalettes();
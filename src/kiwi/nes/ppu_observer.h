@@ -28,8 +28,9 @@ class PPUObserver {
   virtual void OnPPUScanlineEnd(int scanline) {}
   virtual void OnPPUFrameStart() {}
   virtual void OnPPUFrameEnd() {}
-  // If all visible scanlines are rendered, this method will be called.
-  virtual void OnRenderReady(const Colors& swapbuffer) {}
+  // If all visible scanlines are rendered, this method will be called. The
+  // frame rendered is PPU::last_frame().
+  virtual void OnRenderReady() {}
 };
 
 }  // namespace core
@@ -0,0 +1,133 @@
+// Copyright (C) 2026 Yisi Yu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#include "nes/time_stretch.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <numbers>
+
+#include "base/check.h"
+
+namespace kiwi {
+namespace nes {
+namespace {
+// Raised cosine from 0 to 1. The previous segment fades out by 1 minus it, so
+// that the gains always sum to 1.
+const std::array<float, TimeStretch::kOverlap>& GetFadeIn() {
+  static const std::array<float, TimeStretch::kOverlap> fade_in = [] {
+    std::array<float, TimeStretch::kOverlap> fade_in;
+    for (int i = 0; i < TimeStretch::kOverlap; ++i) {
+      fade_in[i] = 0.5f - 0.5f * std::cos(std::numbers::pi_v<float> *
+                                          (i + 0.5f) / TimeStretch::kOverlap);
+    }
+    return fade_in;
+  }();
+  return fade_in;
+}
+
+// Every other sample is enough to tell how well waveforms match.
+constexpr int kCorrelationStride = 2;
+}  // namespace
+
+TimeStretch::TimeStretch() = default;
+
+TimeStretch::~TimeStretch() = default;
+
+void TimeStretch::SetRatio(double ratio) {
+  DCHECK(ratio >= 1);
+  ratio_ = ratio;
+}
+
+void TimeStretch::Process(const Sample* samples,
+                          size_t count,
+                          std::vector<Sample>* output) {
+  DCHECK(output);
+  input_.insert(input_.end(), samples, samples + count);
+
+  const std::array<float, kOverlap>& fade_in = GetFadeIn();
+  for (;;) {
+    size_t position = static_cast<size_t>(position_);
+    if (position + kSearch + kSegment > input_.size())
+      break;
+
+    size_t best_position;
+    if (tail_.empty()) {
+      // Nothing to cross-fade from, the first half is taken as it is.
+      best_position = position;
+      output->insert(output->end(), input_.begin() + position,
+                     input_.begin() + position + kOverlap);
+    } else {
+      best_position = FindBestPosition(position);
+      for (int i = 0; i < kOverlap; ++i) {
+        float sample = tail_[i] * (1 - fade_in[i]) +
+                       input_[best_position + i] * fade_in[i];
+        output->push_back(static_cast<Sample>(std::clamp(
+            std::lround(sample),
+            static_cast<long>(std::numeric_limits<Sample>::min()),
+            static_cast<long>(std::numeric_limits<Sample>::max()))));
+      }
+    }
+    tail_.assign(input_.begin() + best_position + kOverlap,
+                 input_.begin() + best_position + kSegment);
+    position_ += kOverlap * ratio_;
+  }
+
+  // Drops input which no segment can be taken from any more.
+  size_t position = static_cast<size_t>(position_);
+  if (position > kSearch) {
+    size_t dropped = std::min(position - kSearch, input_.size());
+    input_.erase(input_.begin(), input_.begin() + dropped);
+    position_ -= dropped;
+  }
+}
+
+void TimeStretch::Reset() {
+  input_.clear();
+  tail_.clear();
+  position_ = 0;
+}
+
+size_t TimeStretch::FindBestPosition(size_t position) const {
+  // The segment which naturally follows the last one starts with the tail, so
+  // the tail is what a segment should look like.
+  size_t begin = position > kSearch ? position - kSearch : 0;
+  size_t end = position + kSearch;
+  auto score = [this](size_t candidate) {
+    int64_t correlation = 0;
+    int64_t energy = 0;
+    for (int i = 0; i < kOverlap; i += kCorrelationStride) {
+      int64_t sample = input_[candidate + i];
+      correlation += sample * tail_[i];
+      energy += sample * sample;
+    }
+    return correlation / std::sqrt(static_cast<double>(energy) + 1);
+  };
+
+  // Where the segment is taken wins ties, such as in silence.
+  size_t best_position = position;
+  double best_score = score(position);
+  for (size_t candidate = begin; candidate <= end; ++candidate) {
+    double candidate_score = score(candidate);
+    if (candidate_score > best_score) {
+      best_score = candidate_score;
+      best_position = candidate;
+    }
+  }
+  return best_position;
+}
+
+}  // namespace nes
+}  // namespace kiwi
@@ -0,0 +1,75 @@
+// Copyright (C) 2026 Yisi Yu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#ifndef NES_TIME_STRETCH_H_
+#define NES_TIME_STRETCH_H_
+
+#include <vector>
+
+#include "nes/types.h"
+
+namespace kiwi {
+namespace nes {
+// TimeStretch shortens audio by a ratio, keeping its pitch, with WSOLA
+// (waveform similarity overlap-add). Output is made of segments of input,
+// taken every |ratio| times the output hop. Each segment is cross-faded into
+// the previous one, and is moved a little from where it is taken, to where its
+// waveform matches best, so that cross-fades don't cancel out.
+class TimeStretch {
+ public:
+  // Output hop, which is also the length of cross-fades. A segment is twice as
+  // long.
+  static constexpr int kOverlap = 256;
+  static constexpr int kSegment = kOverlap * 2;
+  // How far a segment can be moved, each way.
+  static constexpr int kSearch = 128;
+
+  TimeStretch();
+  ~TimeStretch();
+
+  TimeStretch(const TimeStretch&) = delete;
+  TimeStretch& operator=(const TimeStretch&) = delete;
+
+  // Sets how many input samples make an output sample. It should be at
+  // least 1.
+  void SetRatio(double ratio);
+  double ratio() const { return ratio_; }
+
+  // Appends |count| samples, and appends what can be stretched so far to
+  // |output|. Input is stretched by segments, so output lags behind by up to
+  // a segment.
+  void Process(const Sample* samples,
+               size_t count,
+               std::vector<Sample>* output);
+
+  // Drops input which hasn't been stretched yet, and starts over.
+  void Reset();
+
+ private:
+  // Finds where the segment taken at |position| matches the last segment's
+  // tail best.
+  size_t FindBestPosition(size_t position) const;
+
+ private:
+  double ratio_ = 1;
+  std::vector<Sample> input_;
+  // Where the next segment is taken in |input_|, before it's moved.
+  double position_ = 0;
+  // The second half of the last segment, which the next segment cross-fades
+  // from.
+  std::vector<Sample> tail_;
+};
+
+}  // namespace nes
+}  // namespace kiwi
+
+#endif  // NES_TIME_STRETCH_H_
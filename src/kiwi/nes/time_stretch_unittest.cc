@@ -0,0 +1,118 @@
+// Copyright (C) 2026 Yisi Yu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#include "kiwi/nes/time_stretch.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <numbers>
+#include <random>
+
+#include "kiwi/nes/io_devices.h"
+#include "third_party/googletest-release-1.12.1/googletest/include/gtest/gtest.h"
+
+namespace kiwi {
+namespace nes {
+namespace testing {
+
+namespace {
+constexpr int kFrequency = IODevices::AudioDevice::kFrequency;
+constexpr int kFrameSamples = kFrequency / 60;
+
+std::vector<Sample> CreateSine(double frequency, int count) {
+  std::vector<Sample> samples(count);
+  for (int i = 0; i < count; ++i) {
+    samples[i] = static_cast<Sample>(
+        8000 * std::sin(2 * std::numbers::pi * frequency * i / kFrequency));
+  }
+  return samples;
+}
+
+std::vector<Sample> Stretch(TimeStretch& time_stretch,
+                            const std::vector<Sample>& samples,
+                            size_t chunk) {
+  std::vector<Sample> output;
+  for (size_t i = 0; i < samples.size(); i += chunk) {
+    time_stretch.Process(samples.data() + i,
+                         std::min(chunk, samples.size() - i), &output);
+  }
+  return output;
+}
+
+// Counts rising zero crossings per second.
+double MeasureFrequency(const std::vector<Sample>& samples) {
+  int crossings = 0;
+  for (size_t i = 1; i < samples.size(); ++i) {
+    if (samples[i - 1] < 0 && samples[i] >= 0)
+      ++crossings;
+  }
+  return static_cast<double>(crossings) * kFrequency / samples.size();
+}
+}  // namespace
+
+TEST(TimeStretchTest, PassesThroughAtRatioOne) {
+  std::mt19937 random(42);
+  std::uniform_int_distribution<int> distribution(-8000, 8000);
+  std::vector<Sample> noise(kFrequency / 10);
+  for (Sample& sample : noise)
+    sample = static_cast<Sample>(distribution(random));
+
+  TimeStretch time_stretch;
+  std::vector<Sample> output = Stretch(time_stretch, noise, kFrameSamples);
+  ASSERT_GT(output.size(), noise.size() - TimeStretch::kSegment -
+                               TimeStretch::kSearch - TimeStretch::kOverlap);
+  for (size_t i = 0; i < output.size(); ++i)
+    ASSERT_NEAR(output[i], noise[i], 1) << "Sample " << i;
+}
+
+TEST(TimeStretchTest, KeepsPitch) {
+  std::vector<Sample> sine = CreateSine(440, kFrequency);
+  TimeStretch time_stretch;
+  time_stretch.SetRatio(2);
+  std::vector<Sample> output = Stretch(time_stretch, sine, kFrameSamples);
+
+  // Half as long, up to the latency of a segment.
+  EXPECT_LE(output.size(), sine.size() / 2);
+  EXPECT_GE(output.size(), sine.size() / 2 - TimeStretch::kSegment);
+
+  // Dropping every other sample would make it 880Hz.
+  EXPECT_NEAR(MeasureFrequency(output), 440, 440 * 0.02);
+
+  // Segments are joined where waveforms match, so there are no clicks, which
+  // would be steeper than the sine.
+  int max_step = 0;
+  for (size_t i = 1; i < output.size(); ++i)
+    max_step = std::max(max_step, std::abs(output[i] - output[i - 1]));
+  EXPECT_LT(max_step, 8000 * 2 * std::numbers::pi * 440 / kFrequency * 1.2);
+}
+
+TEST(TimeStretchTest, ChunksDontMatter) {
+  std::vector<Sample> sine = CreateSine(1000, kFrequency / 2);
+  TimeStretch whole;
+  TimeStretch chunked;
+  whole.SetRatio(3.5);
+  chunked.SetRatio(3.5);
+  EXPECT_EQ(Stretch(whole, sine, sine.size()), Stretch(chunked, sine, 100));
+}
+
+TEST(TimeStretchTest, Reset) {
+  std::vector<Sample> sine = CreateSine(440, kFrequency / 10);
+  TimeStretch time_stretch;
+  time_stretch.SetRatio(2);
+  std::vector<Sample> first = Stretch(time_stretch, sine, kFrameSamples);
+  time_stretch.Reset();
+  EXPECT_EQ(Stretch(time_stretch, sine, kFrameSamples), first);
+}
+
+}  // namespace testing
+}  // namespace nes
+}  // namespace kiwi
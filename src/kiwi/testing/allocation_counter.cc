@@ -0,0 +1,135 @@
+// Copyright (C) 2026 Yisi Yu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#include "kiwi/testing/allocation_counter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+std::atomic<size_t> g_allocation_count{0};
+
+void* Allocate(size_t size) {
+  g_allocation_count.fetch_add(1, std::memory_order_relaxed);
+  if (void* p = std::malloc(size ? size : 1))
+    return p;
+  throw std::bad_alloc();
+}
+
+void* AllocateAligned(size_t size, std::align_val_t alignment) {
+  g_allocation_count.fetch_add(1, std::memory_order_relaxed);
+  size_t align = static_cast<size_t>(alignment);
+#if defined(_MSC_VER)
+  void* p = _aligned_malloc(size ? size : align, align);
+#else
+  // aligned_alloc() takes sizes which are multiples of the alignment only.
+  size = (size + align - 1) / align * align;
+  void* p = std::aligned_alloc(align, size ? size : align);
+#endif
+  if (p)
+    return p;
+  throw std::bad_alloc();
+}
+
+void FreeAligned(void* p) {
+#if defined(_MSC_VER)
+  _aligned_free(p);
+#else
+  std::free(p);
+#endif
+}
+}  // namespace
+
+void* operator new(size_t size) {
+  return Allocate(size);
+}
+
+void* operator new[](size_t size) {
+  return Allocate(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+  try {
+    return Allocate(size);
+  } catch (const std::bad_alloc&) {
+    return nullptr;
+  }
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+  try {
+    return Allocate(size);
+  } catch (const std::bad_alloc&) {
+    return nullptr;
+  }
+}
+
+void* operator new(size_t size, std::align_val_t alignment) {
+  return AllocateAligned(size, alignment);
+}
+
+void* operator new[](size_t size, std::align_val_t alignment) {
+  return AllocateAligned(size, alignment);
+}
+
+void operator delete(void* p) noexcept {
+  std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+  std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+  std::free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept {
+  std::free(p);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept {
+  FreeAligned(p);
+}
+
+void operator delete[](void* p, std::align_val_t) noexcept {
+  FreeAligned(p);
+}
+
+void operator delete(void* p, size_t, std::align_val_t) noexcept {
+  FreeAligned(p);
+}
+
+void operator delete[](void* p, size_t, std::align_val_t) noexcept {
+  FreeAligned(p);
+}
+
+namespace kiwi {
+namespace testing {
+
+AllocationCounter::AllocationCounter() {
+  Reset();
+}
+
+AllocationCounter::~AllocationCounter() = default;
+
+size_t AllocationCounter::count() const {
+  return g_allocation_count.load(std::memory_order_relaxed) - start_;
+}
+
+void AllocationCounter::Reset() {
+  start_ = g_allocation_count.load(std::memory_order_relaxed);
+}
+
+}  // namespace testing
+}  // namespace kiwi
@@ -0,0 +1,44 @@
+// Copyright (C) 2026 Yisi Yu
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#ifndef TESTING_ALLOCATION_COUNTER_H_
+#define TESTING_ALLOCATION_COUNTER_H_
+
+#include <cstddef>
+
+namespace kiwi {
+namespace testing {
+
+// Counts heap allocations made through operator new, on any thread, from when
+// it is created. The test binary replaces the global operator new to count
+// them.
+class AllocationCounter {
+ public:
+  AllocationCounter();
+  ~AllocationCounter();
+
+  AllocationCounter(const AllocationCounter&) = delete;
+  AllocationCounter& operator=(const AllocationCounter&) = delete;
+
+  // Allocations made since this counter was created, or reset.
+  size_t count() const;
+
+  void Reset();
+
+ private:
+  size_t start_;
+};
+
+}  // namespace testing
+}  // namespace kiwi
+
+#endif  // TESTING_ALLOCATION_COUNTER_H_
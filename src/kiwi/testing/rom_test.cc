@@ -12,12 +12,37 @@
 
 #include "kiwi/testing/rom_test.h"
 
+#include <algorithm>
+
 #include "base/files/file_util.h"
 
 namespace kiwi {
 namespace nes {
 namespace testing {
 
+namespace {
+constexpr size_t kPRGSize = 0x4000;
+constexpr size_t kCHRSize = 0x2000;
+}  // namespace
+
+Bytes CreateNROMForTesting(const Byte* program,
+                           size_t size,
+                           Address nmi,
+                           Address reset,
+                           Address irq) {
+  Bytes rom = {'N', 'E', 'S', 0x1a, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+  Bytes prg(kPRGSize, 0);
+  std::copy(program, program + size, prg.begin());
+  const Address vectors[] = {nmi, reset, irq};
+  for (size_t i = 0; i < std::size(vectors); ++i) {
+    prg[kPRGSize - 6 + i * 2] = vectors[i] & 0xff;
+    prg[kPRGSize - 5 + i * 2] = vectors[i] >> 8;
+  }
+  rom.insert(rom.end(), prg.begin(), prg.end());
+  rom.resize(rom.size() + kCHRSize, 0);
+  return rom;
+}
+
 void RomTest::SetUp() {
   // Initialize task executor
   task_executor_ = std::make_unique<base::SingleThreadTaskExecutor>();
@@ -32,6 +32,15 @@ struct RomTestResult {
   std::string output;  // Test output or error message
 };
 
+// Creates an NROM image with a 16KB PRG-ROM mapped at $C000, which starts with
+// |program|, and an empty 8KB CHR-ROM. Vectors are set to |nmi|, |reset| and
+// |irq|.
+Bytes CreateNROMForTesting(const Byte* program,
+                           size_t size,
+                           Address nmi,
+                           Address reset,
+                           Address irq);
+
 // Base class for ROM tests
 // This class assumes the ROM follows the following convention:
 // - $6000: Status register
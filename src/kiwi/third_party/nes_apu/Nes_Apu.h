@@ -85,7 +85,8 @@ public:
 	void treble_eq( const blip_eq_t& );
 	
 	// Set sound output of specific oscillator to buffer. If buffer is NULL,
-	// the specified oscillator is muted and emulation accuracy is reduced.
+	// the specified oscillator is muted and nothing is synthesized, but it
+	// keeps running, so that its state is the same as with a buffer.
 	// The oscillators are indexed as follows: 0) Square 1, 1) Square 2,
 	// 2) Triangle, 3) Noise, 4) DMC.
 	enum { osc_count = 5 };
@@ -108,6 +109,10 @@ public:
 	// 'count_dmc_reads( time )' would result in the same result.
 	int count_dmc_reads( cpu_time_t t, cpu_time_t* last_read = NULL ) const;
 	
+	// Get earliest time that 'run_until( t )' would result in a DMC read, or
+	// no_irq if DMC isn't reading.
+	cpu_time_t next_dmc_read_time() const;
+	
 	// Run APU until specified time, so that any DMC memory reads can be
 	// accounted for (i.e. inserting CPU wait states).
 	void run_until( cpu_time_t );
@@ -115,6 +120,11 @@ public:
 	// Sets or gets audio channels for debugging.
  	void set_audio_channels(int channels);
  	int audio_channels();
+
+	// Sets or gets the amplitude an oscillator output last, so that the output
+	// stays continuous when it is switched to another buffer and back.
+	int osc_last_amp( int index ) const;
+	void set_osc_last_amp( int index, int amp );
 	
 // End of public interface.
 private:
@@ -159,6 +169,18 @@ inline void Nes_Apu::osc_output( int osc, Blip_Buffer* buf )
 	oscs [osc]->output = buf;
 }
 
+inline int Nes_Apu::osc_last_amp( int osc ) const
+{
+	assert(( "Nes_Apu::osc_last_amp(): Index out of range", 0 <= osc && osc < osc_count ));
+	return oscs [osc]->last_amp;
+}
+
+inline void Nes_Apu::set_osc_last_amp( int osc, int amp )
+{
+	assert(( "Nes_Apu::set_osc_last_amp(): Index out of range", 0 <= osc && osc < osc_count ));
+	oscs [osc]->last_amp = amp;
+}
+
 inline cpu_time_t Nes_Apu::earliest_irq() const
 {
 	return earliest_irq_;
@@ -180,6 +202,11 @@ inline int Nes_Apu::count_dmc_reads( cpu_time_t time, cpu_time_t* last_read ) co
 {
 	return dmc.count_reads( time, last_read );
 }
+
+inline cpu_time_t Nes_Apu::next_dmc_read_time() const
+{
+	return dmc.next_read_time();
+}
 	
 #endif
 
@@ -81,9 +81,6 @@ void Nes_Square::clock_sweep( int negative_adjust )
 
 void Nes_Square::run( cpu_time_t time, cpu_time_t end_time )
 {
-	if ( !output )
-		return;
-	
 	const int volume = this->volume();
 	const int period = this->period();
 	int offset = period >> (regs [1] & shift_mask);
@@ -91,10 +88,12 @@ void Nes_Square::run( cpu_time_t time, cpu_time_t end_time )
 		offset = 0;
 	
 	const int timer_period = (period + 1) * 2;
-	if ( volume == 0 || period < 8 || (period + offset) >= 0x800 )
+	// Without output, only the phase is kept, as if muted.
+	if ( !output || volume == 0 || period < 8 || (period + offset) >= 0x800 )
 	{
 		if ( last_amp ) {
-			synth->offset( time, -last_amp, output );
+			if ( output )
+				synth->offset( time, -last_amp, output );
 			last_amp = 0;
 		}
 		
@@ -173,14 +172,11 @@ inline int Nes_Triangle::calc_amp() const
 
 void Nes_Triangle::run( cpu_time_t time, cpu_time_t end_time )
 {
-	if ( !output )
-		return;
-	
 	// to do: track phase when period < 3
 	// to do: Output 7.5 on dac when period < 2? More accurate, but results in more clicks.
 	
 	int delta = update_amp( calc_amp() );
-	if ( delta )
+	if ( delta && output )
 		synth.offset( time, delta, output );
 	
 	time += delay;
@@ -189,6 +185,18 @@ void Nes_Triangle::run( cpu_time_t time, cpu_time_t end_time )
 	{
 		time = end_time;
 	}
+	else if ( !output )
+	{
+		// keep phase without output; it steps down through 1 to phase_range * 2
+		if ( time < end_time )
+		{
+			int count = (end_time - time + timer_period - 1) / timer_period;
+			int range = phase_range * 2;
+			phase = (phase - 1 + range - count % range) % range + 1;
+			time += (long) count * timer_period;
+			last_amp = calc_amp();
+		}
+	}
 	else if ( time < end_time )
 	{
 		Blip_Buffer* const output = this->output;
@@ -279,6 +287,15 @@ int Nes_Dmc::count_reads( cpu_time_t time, cpu_time_t* last_read ) const
 	return count;
 }
 
+cpu_time_t Nes_Dmc::next_read_time() const
+{
+	if ( length_counter == 0 )
+		return Nes_Apu::no_irq; // not reading
+	
+	// earliest time that count_reads() counts a read
+	return apu->last_time + delay + long (bits_remain - 1) * period + 1;
+}
+
 static const short dmc_period_table [2] [16] = {
 	0x1ac, 0x17c, 0x154, 0x140, 0x11e, 0x0fe, 0x0e2, 0x0d6, // NTSC
 	0x0be, 0x0a0, 0x08e, 0x080, 0x06a, 0x054, 0x048, 0x036,
@@ -360,10 +377,9 @@ void Nes_Dmc::fill_buffer()
 
 void Nes_Dmc::run( cpu_time_t time, cpu_time_t end_time )
 {
-	if ( !output )
-		return;
-	
-	int delta = update_amp( dac );
+	// without output, samples are still fetched and IRQ raised, which the CPU
+	// can see; only synthesis is skipped
+	int delta = output ? update_amp( dac ) : 0;
 	if ( delta )
 		synth.offset( time, delta, output );
 	
@@ -392,7 +408,8 @@ void Nes_Dmc::run( cpu_time_t time, cpu_time_t end_time )
 					bits >>= 1;
 					if ( unsigned (dac + step) <= 0x7F ) {
 						dac += step;
-						synth.offset_inline( time, step, output );
+						if ( output )
+							synth.offset_inline( time, step, output );
 					}
 				}
 				
@@ -434,13 +451,10 @@ static const short noise_period_table [16] = {
 
 void Nes_Noise::run( cpu_time_t time, cpu_time_t end_time )
 {
-	if ( !output )
-		return;
-	
 	const int volume = this->volume();
 	int amp = (noise & 1) ? volume : 0;
 	int delta = update_amp( amp );
-	if ( delta )
+	if ( delta && output )
 		synth.offset( time, delta, output );
 	
 	time += delay;
@@ -461,6 +475,25 @@ void Nes_Noise::run( cpu_time_t time, cpu_time_t end_time )
 				noise = (feedback & 0x4000) | (noise >> 1);
 			}
 		}
+		else if ( !output )
+		{
+			// clock noise register without output
+			int noise = this->noise;
+			int delta = amp * 2 - volume;
+			const int tap = (regs [2] & mode_flag ? 8 : 13);
+			
+			do {
+				int feedback = (noise << tap) ^ (noise << 14);
+				time += period;
+				if ( (noise + 1) & 2 )
+					delta = -delta;
+				noise = (feedback & 0x4000) | (noise >> 1);
+			}
+			while ( time < end_time );
+			
+			last_amp = (delta + volume) >> 1;
+			this->noise = noise;
+		}
 		else
 		{
 			Blip_Buffer* const output = this->output;
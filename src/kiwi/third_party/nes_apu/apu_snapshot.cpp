@@ -118,7 +118,22 @@ void Nes_Apu::load_snapshot( apu_snapshot_t const& state )
 	refl::reflect_triangle( st.triangle,    triangle );
 	refl::reflect_noise   ( st.noise,       noise );
 	refl::reflect_dmc     ( st.dmc,         dmc );
+	// dmc started by $4015 above, before its registers were loaded, and may
+	// have run out of its sample and been disabled
+	osc_enables = state.w4015;
 	dmc.recalc_irq();
 	dmc.last_amp = dmc.dac;
+	
+	// frame IRQ time isn't in snapshot, run_until() predicts it a clock after
+	// frame 0 comes next
+	next_irq = no_irq;
+	if ( !(frame_mode & 0xc0) )
+	{
+		cpu_time_t time = frame_delay;
+		for ( int n = frame; n != 0; n = (n + 1) & 3 )
+			time += frame_period;
+		next_irq = time + 1;
+	}
+	irq_changed();
 }
 